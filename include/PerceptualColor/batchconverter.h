@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BATCHCONVERTER_H
+#define BATCHCONVERTER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QString>
+
+#include "PerceptualColor/rgbcolorspace.h"
+
+namespace PerceptualColor {
+
+/** @brief Converts records of colors in chunks
+ * 
+ * This class provides the conversion of the command line tool
+ * <tt>perceptualcolor-convert</tt>, using the same color management as the
+ * widgets of this library.
+ * 
+ * Text records (CSV or TSV) have one color per line. The color comes first:
+ * - <tt>hex</tt>: one field like <tt>#FF8000</tt> (the <tt>#</tt> is optional)
+ * - <tt>rgb</tt>: three fields, range 0..255
+ * - <tt>lab</tt>: three fields L, a, b
+ * - <tt>lch</tt>: three fields L, C, h
+ * 
+ * All fields after the color are passed through unchanged, so that for
+ * example an identifier can be kept together with the color. Lines that
+ * cannot be parsed produce an empty line, so the line numbers of input and
+ * output always correspond.
+ * 
+ * Binary records are three little-endian IEEE 754 double values
+ * (@ref binaryRecordSize bytes) with the same meaning and range as the text
+ * fields. (<tt>hex</tt> is not available for binary records.) Trailing data
+ * at the end of the input that is shorter than a record is invalid.
+ * 
+ * The input is read in chunks by readChunk(). The chunks can be converted
+ * in parallel by convertChunk().
+ * 
+ * The RgbColorSpace object must stay alive as long as the converter is used.
+ */
+class BatchConverter
+{
+public:
+    /** @brief Color representations */
+    enum class ColorFormat {
+        hex, /**< Hexadecimal RGB like <tt>#FF8000</tt> */
+        rgb, /**< RGB, range 0..255 */
+        lab, /**< Lab */
+        lch  /**< LCh */
+    };
+
+    /** @brief Record formats */
+    enum class RecordFormat {
+        csv,   /**< Text, comma-separated fields */
+        tsv,   /**< Text, tab-separated fields */
+        binary /**< Three little-endian IEEE 754 double values */
+    };
+
+    /** @brief Settings for the conversion of a chunk */
+    struct Settings {
+        /** Input color format */
+        ColorFormat from = ColorFormat::hex;
+        /** Output color format */
+        ColorFormat to = ColorFormat::lch;
+        /** Record format of input and output */
+        RecordFormat recordFormat = RecordFormat::csv;
+        /** Map out-of-gamut Lab/LCh input into the gamut by reducing the
+         * chroma instead of clipping the RGB values */
+        bool sacrifyChroma = false;
+    };
+
+    /** @brief Result of the conversion of a chunk */
+    struct ChunkResult {
+        /** The converted records */
+        QByteArray output;
+        /** Number of records, including the invalid ones */
+        int count = 0;
+        /** Number of records that could not be parsed */
+        int invalidCount = 0;
+    };
+
+    /** @brief Number of records per chunk */
+    static constexpr int chunkSize = 4096;
+
+    /** @brief Size of a binary record in byte */
+    static constexpr int binaryRecordSize = 3 * 8;
+
+    explicit BatchConverter(RgbColorSpace *colorSpace);
+    ChunkResult convertChunk(
+        const Settings &settings,
+        const QList<QByteArray> &input
+    ) const;
+    static bool parseColorFormat(const QString &text, ColorFormat *format);
+    static QList<QByteArray> readChunk(
+        QIODevice *input,
+        const RecordFormat recordFormat
+    );
+
+private:
+    /** @brief Pointer to RgbColorSpace() object */
+    RgbColorSpace *m_rgbColorSpace;
+};
+
+}
+
+#endif // BATCHCONVERTER_H
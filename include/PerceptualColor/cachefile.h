@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CACHEFILE_H
+#define CACHEFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+namespace PerceptualColor {
+
+/** @brief A versioned binary cache file
+ * 
+ * Stores data that is expensive to compute (like the results of gamut
+ * searches) in a file below QStandardPaths::CacheLocation, so that it has
+ * not to be computed again at the next start of the process.
+ * 
+ * Each file has a header with a format version, the key and a checksum of
+ * the payload. The key should contain everything the payload depends on
+ * (profile ID, library versions, precision settings…). A file whose header
+ * does not match is simply ignored: The caller falls back to computing the
+ * data and calls write() to replace the file.
+ * 
+ * Reading does not copy the file: It is memory-mapped, and payload()
+ * points directly into the mapping, so only the pages that are actually
+ * used are loaded from disk.
+ * 
+ * @code
+ * CacheFile cache(QStringLiteral("example"), key);
+ * if (cache.isValid()) {
+ *     // use cache.payload()
+ * } else {
+ *     // compute the data, then:
+ *     CacheFile::write(QStringLiteral("example"), key, data);
+ * }
+ * @endcode */
+class CacheFile
+{
+public:
+    CacheFile(const QString &name, const QByteArray &key);
+    ~CacheFile();
+    bool isValid() const;
+    const uchar *payload() const;
+    qint64 payloadSize() const;
+    static QString directory();
+    static QString filePath(const QString &name);
+    static bool write(
+        const QString &name,
+        const QByteArray &key,
+        const QByteArray &payload
+    );
+
+    /** @brief Version of the file format
+     * 
+     * Increase this whenever the layout of the header changes. */
+    static constexpr quint32 formatVersion = 1;
+
+private:
+    Q_DISABLE_COPY(CacheFile)
+    /** @brief The cache file */
+    QFile m_file;
+    /** @brief The memory mapping of the whole file, or @c nullptr */
+    uchar *m_mapping = nullptr;
+    /** @brief Pointer to the payload within m_mapping, or @c nullptr if the
+     * file is not valid */
+    const uchar *m_payload = nullptr;
+    /** @brief Size of the payload in bytes */
+    qint64 m_payloadSize = 0;
+};
+
+}
+
+#endif // CACHEFILE_H
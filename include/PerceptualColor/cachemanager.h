@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CACHEMANAGER_H
+#define CACHEMANAGER_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QWidget>
+
+#include <functional>
+
+namespace PerceptualColor {
+
+/** @brief Library-wide memory budget for the image caches of widgets
+ * 
+ * Widgets like ChromaHueDiagram keep their rendered images in memory, so
+ * that they have not to be generated again on each paint event. With many
+ * long-lived dialogs, this memory adds up. The cache manager keeps track
+ * of these caches and bounds their total size:
+ * 
+ * - When a widget is hidden (for example because its tab in ColorDialog
+ *   is not the current one), its caches are released, unless
+ *   releaseOnHide() is @c false.
+ * - When the total size exceeds budget(), the caches of other widgets are
+ *   released: First those of hidden widgets, then the least recently
+ *   used ones, and finally the shared volumes of
+ *   GamutVolume::forColorSpace(), which also count against the budget.
+ * 
+ * A released cache is simply generated again when the widget is painted
+ * the next time.
+ * 
+ * Widgets call registerWidget() in their constructor, notifyUsed() each
+ * time they have generated their caches, notifyHidden() in their
+ * hideEvent() and unregisterWidget() in their destructor. (Widgets that
+ * do not are unregistered when they emit @c destroyed(), but at this
+ * point the members of derived classes are already destroyed, so the
+ * callbacks must not access them.)
+ * 
+ * The cache manager must only be used in the GUI thread. */
+class CacheManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    static CacheManager *instance();
+    qint64 budget() const;
+    QHash<QString, qint64> generationsByType() const;
+    void notifyHidden(QWidget *widget);
+    void notifyUsed(QWidget *widget);
+    void registerWidget(
+        QWidget *widget,
+        const std::function<qint64()> &byteSize,
+        const std::function<void()> &release
+    );
+    void releaseAll();
+    bool releaseOnHide() const;
+    void setBudget(const qint64 bytes);
+    void setReleaseOnHide(const bool releaseOnHide);
+    void unregisterWidget(QWidget *widget);
+    qint64 usage() const;
+    QHash<QString, qint64> usageByType() const;
+
+    /** @brief Default value for budget(): 64 MiB */
+    static constexpr qint64 defaultBudget = 64 * 1024 * 1024;
+
+private:
+    Q_DISABLE_COPY(CacheManager)
+    CacheManager();
+    void enforceBudget(const QWidget *keep);
+
+    /** @brief A registered widget */
+    struct Entry {
+        /** Returns the current size of the caches in bytes */
+        std::function<qint64()> byteSize;
+        /** Releases the caches */
+        std::function<void()> release;
+        /** Value of m_useCounter at the last notifyUsed() */
+        quint64 lastUse;
+    };
+
+    /** @brief Internal storage of the budget() property */
+    qint64 m_budget = defaultBudget;
+    /** @brief Internal storage for generationsByType() */
+    QHash<QString, qint64> m_generations;
+    /** @brief The registered widgets */
+    QHash<QWidget *, Entry> m_entries;
+    /** @brief Internal storage of the releaseOnHide() property */
+    bool m_releaseOnHide = true;
+    /** @brief Counter for the least-recently-used order of the caches */
+    quint64 m_useCounter = 0;
+};
+
+}
+
+#endif // CACHEMANAGER_H
@@ -27,12 +27,15 @@
 #ifndef CHROMAHUEDIAGRAM_H
 #define CHROMAHUEDIAGRAM_H
 
+#include <QBitArray>
 #include <QImage>
+#include <QTimer>
 #include <QWidget>
 
 #include <lcms2.h>
 
 #include "PerceptualColor/fullcolordescription.h"
+#include "PerceptualColor/gamutvolume.h"
 #include "PerceptualColor/rgbcolorspace.h"
 
 namespace PerceptualColor {
@@ -91,9 +94,20 @@ class ChromaHueDiagram : public QWidget
 
 public:
     explicit ChromaHueDiagram(RgbColorSpace *colorSpace, QWidget *parent = nullptr);
-    virtual ~ChromaHueDiagram() override = default;
+    virtual ~ChromaHueDiagram() override;
     int border() const;
     FullColorDescription color() const;
+    static QImage generateDiagramImage(
+        const RgbColorSpace *colorSpace,
+        const int imageSize,
+        const int maxChroma,
+        const qreal lightness,
+        const int border,
+        const RgbColorSpace::TransformPrecision precision =
+            RgbColorSpace::TransformPrecision::float32,
+        QBitArray *outOfGamutMask = nullptr,
+        const GamutVolume *gamutVolume = nullptr
+    );
     qreal lightness() const;
     int markerRadius() const;
     int markerThickness() const;
@@ -113,6 +127,7 @@ Q_SIGNALS:
     void colorChanged(const PerceptualColor::FullColorDescription &newColor);
 
 protected:
+    virtual void hideEvent(QHideEvent *event) override;
     virtual void keyPressEvent(QKeyEvent *event) override;
     virtual void mouseMoveEvent(QMouseEvent *event) override;
     virtual void mousePressEvent(QMouseEvent *event) override;
@@ -140,6 +155,11 @@ private:
      *  @sa updateDiagramCache()
      *  @sa m_diagramCacheReady */
     QImage m_diagramImage;
+    /** @brief The out-of-gamut mask of @ref m_diagramImage. Might be
+     *  outdated.
+     *  @sa updateDiagramCache()
+     *  @sa m_diagramCacheReady */
+    QBitArray m_diagramOutOfGamutMask;
     /** Holds wether or not m_diagramImage() is up-to-date.
      *  @sa updateDiagramCache() */
     bool m_diagramCacheReady = false;
@@ -150,6 +170,13 @@ private:
     /** Holds wether or not m_wheelImage() is up-to-date.
      *  @sa updateWheelCache() */
     bool m_wheelCacheReady = false;
+    /** @brief Timer for resize debouncing
+     * 
+     * Active while the widget is being resized. Meanwhile, paintEvent()
+     * draws the previous cache scaled to the new geometry. On timeout,
+     * the widget is repainted with a regenerated cache.
+     * @sa Helper::resizeDebounceInterval */
+    QTimer m_resizeTimer;
     /** @brief Internal storage of the markerRadius() property */
     int m_markerRadius;
     /** @brief Internal storage of the markerThickness() property */
@@ -180,13 +207,6 @@ private:
     static constexpr qreal m_pageStepChroma = 10 * m_singleStepChroma;
     static constexpr qreal m_pageStepHue = 10 * m_singleStepHue;
 
-    static QImage generateDiagramImage(
-        const RgbColorSpace *colorSpace,
-        const int imageSize,
-        const int maxChroma,
-        const qreal lightness,
-        const int border
-    );
     QPoint currentImageCoordinates();
     QPointF fromImageCoordinatesToAB(const QPoint imageCoordinates);
     bool imageCoordinatesInGamut(const QPoint imageCoordinates);
@@ -27,12 +27,15 @@
 #ifndef CHROMALIGHTNESSDIAGRAM_H
 #define CHROMALIGHTNESSDIAGRAM_H
 
+#include <QBitArray>
 #include <QImage>
+#include <QTimer>
 #include <QWidget>
 
 #include <lcms2.h>
 
 #include "PerceptualColor/fullcolordescription.h"
+#include "PerceptualColor/gamutvolume.h"
 #include "PerceptualColor/rgbcolorspace.h"
 
 namespace PerceptualColor {
@@ -96,9 +99,18 @@ class ChromaLightnessDiagram : public QWidget
 
 public:
     explicit ChromaLightnessDiagram(RgbColorSpace *colorSpace, QWidget *parent = nullptr);
-    virtual ~ChromaLightnessDiagram() override = default;
+    virtual ~ChromaLightnessDiagram() override;
     int border() const;
     FullColorDescription color() const;
+    static QImage generateDiagramImage(
+        const RgbColorSpace *colorSpace,
+        const qreal imageHue,
+        const QSize imageSize,
+        const RgbColorSpace::TransformPrecision precision =
+            RgbColorSpace::TransformPrecision::float32,
+        QBitArray *outOfGamutMask = nullptr,
+        const GamutVolume *gamutVolume = nullptr
+    );
     qreal hue() const;
     int markerRadius() const;
     int markerThickness() const;
@@ -118,6 +130,7 @@ Q_SIGNALS:
     void colorChanged(const PerceptualColor::FullColorDescription &newColor);
 
 protected:
+    virtual void hideEvent(QHideEvent *event) override;
     virtual void keyPressEvent(QKeyEvent *event) override;
     virtual void mouseMoveEvent(QMouseEvent *event) override;
     virtual void mousePressEvent(QMouseEvent *event) override;
@@ -142,10 +155,20 @@ private:
     FullColorDescription m_color;
     /** @brief A cache for the diagram as QImage. @sa updateDiagramCache() */
     QImage m_diagramImage;
+    /** @brief The out-of-gamut mask of @ref m_diagramImage.
+     * @sa updateDiagramCache() */
+    QBitArray m_diagramOutOfGamutMask;
     /** True if the m_diagramImage cache is up-to-date. False otherwise.
      * @sa m_diagramImage
      * @sa updateDiagramCache */
     bool m_diagramCacheReady = false;
+    /** @brief Timer for resize debouncing
+     * 
+     * Active while the widget is being resized. Meanwhile, paintEvent()
+     * draws the previous cache scaled to the new geometry. On timeout,
+     * the widget is repainted with a regenerated cache.
+     * @sa Helper::resizeDebounceInterval */
+    QTimer m_resizeTimer;
     /** @brief Internal storage of the markerRadius() property */
     int m_markerRadius;
     /** @brief Internal storage of the markerThickness() property */
@@ -161,10 +184,8 @@ private:
     /** @brief Pointer to RgbColorSpace() object */
     RgbColorSpace *m_rgbColorSpace;
 
-    QImage diagramImage(
-        const qreal imageHue,
-        const QSize imageSize) const;
     QPoint currentImageCoordinates();
+    QSize diagramSize() const;
     QPointF fromImageCoordinatesToChromaLightness(const QPoint imageCoordinates);
     QPoint fromWidgetCoordinatesToImageCoordinates(const QPoint widgetCoordinates) const;
     bool imageCoordinatesInGamut(const QPoint imageCoordinates);
@@ -42,6 +42,7 @@
 #include <QLineEdit>
 #include <QObject>
 #include <QPointer>
+#include <QTabWidget>
 
 namespace PerceptualColor {
 
@@ -213,6 +214,8 @@ private:
      * 
      * @sa currentColor() */
     FullColorDescription m_currentOpaqueColor;
+    /** @brief Pointer to the QTabWidget with the graphical selectors. */
+    QTabWidget *m_graphicalTabWidget;
     /** @brief Pointer to the GradientSelector for LCh lightness. */
     GradientSelector *m_lchLightnessSelector;
     /** @brief Pointer to the QLineEdit that represents the HLC value. */
@@ -223,6 +226,14 @@ private:
     QDoubleSpinBox *m_hsvSaturationSpinbox;
     /** @brief Pointer to the QSpinbox for HSV value. */
     QDoubleSpinBox *m_hsvValueSpinbox;
+    /** @brief Holds wether the “Hue first” tab has not yet received
+     * the current color.
+     * @sa updateCurrentGraphicalTab() */
+    bool m_hueFirstTabOutdated = false;
+    /** @brief Holds wether the “Lightness first” tab has not yet received
+     * the current color.
+     * @sa updateCurrentGraphicalTab() */
+    bool m_lightnessFirstTabOutdated = false;
     /** @brief Holds the receiver slot (if any) to be disconnected
      *  automatically after closing the dialog.
      * 
@@ -275,6 +286,7 @@ private Q_SLOTS:
         const PerceptualColor::FullColorDescription &color
     );
     void setCurrentOpaqueQColor(const QColor &color);
+    void updateCurrentGraphicalTab();
 };
 
 }
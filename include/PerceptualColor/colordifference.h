@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef COLORDIFFERENCE_H
+#define COLORDIFFERENCE_H
+
+#include <lcms2.h>
+
+namespace PerceptualColor {
+
+/** @brief Color difference metrics
+ * 
+ * Provides the CIE color difference formulas ΔE*76, ΔE*94 (with the
+ * weighting factors for graphic arts) and ΔE*00 (CIEDE2000) for Lab
+ * values.
+ * 
+ * The functions for a single pair of colors are the scalar reference
+ * implementations. The batch functions work on contiguous arrays, either
+ * one-to-many (one reference color against many other colors) or pairwise
+ * (element by element). Where SSE2 is available, the batch functions
+ * process two colors at once. For ΔE*00, they use polynomial and rational
+ * approximations of the trigonometric and exponential functions, for which
+ * there are no SIMD instructions. They agree with the scalar implementation
+ * within about 10⁻¹² ΔE.
+ * 
+ * All functions are thread-safe and do not allocate memory.
+ */
+namespace ColorDifference {
+
+    cmsFloat64Number deltaE76(const cmsCIELab &first, const cmsCIELab &second);
+    void deltaE76(
+        const cmsCIELab &reference,
+        const cmsCIELab *colors,
+        cmsFloat64Number *result,
+        const int count
+    );
+    void deltaE76(
+        const cmsCIELab *first,
+        const cmsCIELab *second,
+        cmsFloat64Number *result,
+        const int count
+    );
+
+    cmsFloat64Number deltaE94(const cmsCIELab &reference, const cmsCIELab &sample);
+    void deltaE94(
+        const cmsCIELab &reference,
+        const cmsCIELab *samples,
+        cmsFloat64Number *result,
+        const int count
+    );
+    void deltaE94(
+        const cmsCIELab *references,
+        const cmsCIELab *samples,
+        cmsFloat64Number *result,
+        const int count
+    );
+
+    cmsFloat64Number deltaE2000(const cmsCIELab &first, const cmsCIELab &second);
+    void deltaE2000(
+        const cmsCIELab &reference,
+        const cmsCIELab *colors,
+        cmsFloat64Number *result,
+        const int count
+    );
+    void deltaE2000(
+        const cmsCIELab *first,
+        const cmsCIELab *second,
+        cmsFloat64Number *result,
+        const int count
+    );
+
+}
+
+}
+
+#endif // COLORDIFFERENCE_H
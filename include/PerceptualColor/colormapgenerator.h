@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef COLORMAPGENERATOR_H
+#define COLORMAPGENERATOR_H
+
+#include <QVector>
+
+#include <lcms2.h>
+
+#include "PerceptualColor/fullcolordescription.h"
+#include "PerceptualColor/helper.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+namespace PerceptualColor {
+
+/** @brief Generator for perceptual colormaps
+ * 
+ * Generates lookup tables with an arbitrary number of entries that
+ * interpolate linearly in LCh between two or more stops. The stops are
+ * equidistant. Like in GradientSelector, the hue takes the shorter way
+ * around the color wheel between two stops.
+ * 
+ * The generate() functions write packed RGB values (three values per entry,
+ * without padding) to a buffer provided by the caller. They do not allocate
+ * memory on the heap: The entries are interpolated and converted in chunks
+ * on the stack, using the batch conversion functions of RgbColorSpace. So
+ * it is cheap to regenerate colormaps frequently.
+ * 
+ * The RgbColorSpace object must stay alive as long as the generator is used.
+ */
+class ColormapGenerator
+{
+public:
+    explicit ColormapGenerator(RgbColorSpace *colorSpace);
+    void generate(const int entryCount, quint8 *rgb) const;
+    void generate(const int entryCount, quint16 *rgb) const;
+    void generate(const int entryCount, float *rgb) const;
+    FullColorDescription::outOfGamutBehaviour gamutBehaviour() const;
+    void setGamutBehaviour(
+        const FullColorDescription::outOfGamutBehaviour behaviour
+    );
+    bool setStops(const QVector<cmsCIELCh> &stops);
+    QVector<cmsCIELCh> stops() const;
+
+private:
+    /** @brief Number of entries that are converted at once */
+    static constexpr int chunkSize = 256;
+
+    void generateChunk(
+        const int entryCount,
+        const int firstEntry,
+        const int chunkCount,
+        Helper::cmsRGB *rgb
+    ) const;
+    template <typename T>
+    void generateEntries(const int entryCount, T *rgb) const;
+
+    /** @brief Internal storage of the gamutBehaviour() property */
+    FullColorDescription::outOfGamutBehaviour m_gamutBehaviour =
+        FullColorDescription::outOfGamutBehaviour::preserve;
+    /** @brief Pointer to RgbColorSpace() object */
+    RgbColorSpace *m_rgbColorSpace;
+    /** @brief Internal storage of the stops() property */
+    QVector<cmsCIELCh> m_stops;
+    /** @brief The stops, with the hue unwrapped so that linear
+     * interpolation takes the shorter way around the color wheel. */
+    QVector<cmsCIELCh> m_unwrappedStops;
+};
+
+}
+
+#endif // COLORMAPGENERATOR_H
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CONVERSIONCLIENT_H
+#define CONVERSIONCLIENT_H
+
+#include <QString>
+
+#include "PerceptualColor/conversionprotocol.h"
+
+class QLocalSocket;
+
+namespace PerceptualColor {
+
+/** @brief Client for ConversionServer
+ * 
+ * Converts colors in another process, which runs a ConversionServer (for
+ * example <tt>perceptualcolor-daemon</tt>). This class depends only on
+ * QtCore and QtNetwork; it is part of the small
+ * <tt>perceptualcolorclient</tt> library, so that tools that do not need
+ * widgets can use the color management of this library without loading
+ * QtWidgets and LittleCMS.
+ * 
+ * The connection stays open until disconnectFromServer() is called or this
+ * object is destroyed. All functions are blocking, and do not need an
+ * event loop. Large conversions are split into batches of batchSize()
+ * colors. Up to pipelineDepth() batches are sent before the first result
+ * is read, so that the server can work while the results of earlier
+ * batches are transferred.
+ * 
+ * An object of this class must only be used by one thread at a time.
+ * 
+ * @code
+ * PerceptualColor::ConversionClient client;
+ * if (client.connectToServer()) {
+ *     client.convert(
+ *         PerceptualColor::ConversionProtocol::Operation::lchToRgb,
+ *         lch,   // 3 * count values
+ *         rgb,   // 3 * count values
+ *         count,
+ *         PerceptualColor::ConversionProtocol::sacrifyChroma
+ *     );
+ * }
+ * @endcode */
+class ConversionClient
+{
+public:
+    ConversionClient();
+    ~ConversionClient();
+    int batchSize() const;
+    bool connectToServer(
+        const QString &name =
+            QString::fromLatin1(ConversionProtocol::defaultServerName),
+        const int timeout = 3000
+    );
+    bool convert(
+        const ConversionProtocol::Operation operation,
+        const double *input,
+        double *output,
+        const int count,
+        const quint16 flags = 0,
+        const int timeout = 30000
+    );
+    void disconnectFromServer();
+    bool isConnected() const;
+    int pipelineDepth() const;
+    void setBatchSize(const int newBatchSize);
+    void setPipelineDepth(const int newPipelineDepth);
+
+private:
+    Q_DISABLE_COPY(ConversionClient)
+    bool readResponse(
+        const quint32 id,
+        double *output,
+        const int count,
+        const int timeout
+    );
+    bool waitForBytes(const qint64 size, const int timeout);
+
+    /** @brief Internal storage for batchSize() */
+    int m_batchSize = 65536;
+    /** @brief Id of the next request */
+    quint32 m_nextId = 1;
+    /** @brief Internal storage for pipelineDepth() */
+    int m_pipelineDepth = 4;
+    /** @brief The connection */
+    QLocalSocket *m_socket;
+};
+
+}
+
+#endif // CONVERSIONCLIENT_H
@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CONVERSIONPROTOCOL_H
+#define CONVERSIONPROTOCOL_H
+
+#include <QtEndian>
+#include <QtGlobal>
+
+#include <cstring>
+
+namespace PerceptualColor {
+
+/** @brief Wire format of the conversion daemon
+ * 
+ * ConversionServer and ConversionClient talk over a local socket
+ * (QLocalServer, QLocalSocket). Both sides send frames. Each frame is a
+ * header of headerSize bytes, followed by @c count colors of
+ * colorSize bytes each. All values are little-endian.
+ * 
+ * Request header:
+ * | Offset | Type    | Meaning                        |
+ * | ------ | ------- | ------------------------------ |
+ * | 0      | quint32 | request id, chosen by client   |
+ * | 4      | quint16 | @ref Operation                 |
+ * | 6      | quint16 | @ref Flag values               |
+ * | 8      | quint32 | @c count                       |
+ * | 12     | quint32 | reserved, must be @c 0         |
+ * 
+ * Response header:
+ * | Offset | Type    | Meaning                        |
+ * | ------ | ------- | ------------------------------ |
+ * | 0      | quint32 | request id of the request      |
+ * | 4      | quint16 | @ref Status                    |
+ * | 6      | quint16 | reserved, always @c 0          |
+ * | 8      | quint32 | @c count (@c 0 on error)       |
+ * | 12     | quint32 | reserved, always @c 0          |
+ * 
+ * A color is three IEEE 754 double values: RGB in the range 0..1,
+ * L*a*b* or LCh.
+ * 
+ * Requests are pipelined: A client can send any number of requests
+ * without waiting for the responses. The server answers the requests of
+ * a connection in the order it has received them.
+ * 
+ * This header depends only on QtCore, so that clients need neither
+ * QtWidgets nor LittleCMS. */
+namespace ConversionProtocol {
+
+    /** @brief Default name of the local server */
+    constexpr const char *defaultServerName = "perceptualcolor-daemon";
+
+    /** @brief Size of the header of a frame in bytes */
+    constexpr int headerSize = 16;
+
+    /** @brief Size of a color in bytes */
+    constexpr int colorSize = 3 * 8;
+
+    /** @brief Maximum number of colors in a frame
+     * 
+     * Larger requests are answered with Status::tooLarge, and the
+     * connection is closed, because the server does not read the payload. */
+    constexpr quint32 maximumCount = 1 << 20;
+
+    /** @brief The conversions that the server provides */
+    enum class Operation : quint16 {
+        rgbToLab = 1, /**< RGB to L*a*b* */
+        rgbToLch = 2, /**< RGB to LCh */
+        labToRgb = 3, /**< L*a*b* to RGB */
+        lchToRgb = 4  /**< LCh to RGB */
+    };
+
+    /** @brief Flags for requests */
+    enum Flag : quint16 {
+        /** For labToRgb and lchToRgb: Map out-of-gamut colors into the gamut
+         * by reducing the chroma (see
+         * FullColorDescription::outOfGamutBehaviour::sacrifyChroma). Without
+         * this flag, out-of-gamut colors are clipped to the RGB range. */
+        sacrifyChroma = 1
+    };
+
+    /** @brief Status of a response */
+    enum class Status : quint16 {
+        ok = 0,              /**< Success */
+        unknownOperation = 1, /**< The operation is not supported. */
+        tooLarge = 2         /**< The request exceeds maximumCount. */
+    };
+
+    /** @brief Header of a frame, in host representation
+     * 
+     * For requests, @c code is the Operation, for responses the Status. */
+    struct Header {
+        quint32 id;
+        quint16 code;
+        quint16 flags;
+        quint32 count;
+    };
+
+    /** @brief Writes a header
+     * 
+     * @param header the header
+     * @param data pointer to headerSize bytes */
+    inline void writeHeader(const Header &header, uchar *data)
+    {
+        qToLittleEndian<quint32>(header.id, data);
+        qToLittleEndian<quint16>(header.code, data + 4);
+        qToLittleEndian<quint16>(header.flags, data + 6);
+        qToLittleEndian<quint32>(header.count, data + 8);
+        qToLittleEndian<quint32>(0, data + 12);
+    }
+
+    /** @brief Reads a header
+     * 
+     * @param data pointer to headerSize bytes
+     * @returns the header */
+    inline Header readHeader(const uchar *data)
+    {
+        Header result;
+        result.id = qFromLittleEndian<quint32>(data);
+        result.code = qFromLittleEndian<quint16>(data + 4);
+        result.flags = qFromLittleEndian<quint16>(data + 6);
+        result.count = qFromLittleEndian<quint32>(data + 8);
+        return result;
+    }
+
+    /** @brief Writes double values
+     * 
+     * @param values the values
+     * @param count the number of values
+     * @param data pointer to <tt>8 * count</tt> bytes */
+    inline void writeValues(const double *values, const int count, uchar *data)
+    {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        std::memcpy(data, values, static_cast<size_t>(count) * 8);
+#else
+        quint64 bits;
+        for (int i = 0; i < count; ++i) {
+            std::memcpy(&bits, values + i, 8);
+            qToLittleEndian<quint64>(bits, data + 8 * i);
+        }
+#endif
+    }
+
+    /** @brief Reads double values
+     * 
+     * @param data pointer to <tt>8 * count</tt> bytes
+     * @param count the number of values
+     * @param values the values that will be written */
+    inline void readValues(const uchar *data, const int count, double *values)
+    {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        std::memcpy(values, data, static_cast<size_t>(count) * 8);
+#else
+        quint64 bits;
+        for (int i = 0; i < count; ++i) {
+            bits = qFromLittleEndian<quint64>(data + 8 * i);
+            std::memcpy(values + i, &bits, 8);
+        }
+#endif
+    }
+
+}
+
+}
+
+#endif // CONVERSIONPROTOCOL_H
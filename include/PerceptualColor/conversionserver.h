@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CONVERSIONSERVER_H
+#define CONVERSIONSERVER_H
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+#include "PerceptualColor/conversionprotocol.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+namespace PerceptualColor {
+
+/** @brief Serves color conversions to other processes
+ * 
+ * Listens on a local socket (QLocalServer) and answers batched conversion
+ * requests with the color management of this library. The wire format is
+ * described in ConversionProtocol; ConversionClient is the corresponding
+ * client.
+ * 
+ * All requests are converted in the background, and large requests also
+ * in parallel on QThreadPool::globalInstance(), so that they do not block
+ * the other connections. Each connection has at most one request in conversion at a
+ * time, so its requests are answered in order. The sockets are served by
+ * the thread of this object, so it needs a running event loop.
+ * 
+ * The RgbColorSpace object must stay alive as long as the server is used.
+ */
+class ConversionServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ConversionServer(
+        RgbColorSpace *colorSpace,
+        QObject *parent = nullptr
+    );
+    virtual ~ConversionServer() override;
+    void close();
+    bool listen(const QString &name);
+    QString serverName() const;
+
+private Q_SLOTS:
+    void acceptConnections();
+    void readRequests();
+    void removeConnection(QObject *socket);
+    void sendResponse();
+
+private:
+    Q_DISABLE_COPY(ConversionServer)
+    void processRequests(QLocalSocket *socket);
+    QByteArray response(
+        const ConversionProtocol::Header &request,
+        const QByteArray &payload
+    ) const;
+
+    /** @brief Pointer to RgbColorSpace() object */
+    RgbColorSpace *m_rgbColorSpace;
+    /** @brief The local server */
+    QLocalServer *m_server;
+    /** @brief Runs the background conversions
+     * 
+     * A pool of its own, so that the destructor can wait for the
+     * conversions that are still running. */
+    QThreadPool m_threadPool;
+    /** @brief The background conversion of each connection */
+    QHash<QLocalSocket *, QFutureWatcher<QByteArray> *> m_watchers;
+};
+
+}
+
+#endif // CONVERSIONSERVER_H
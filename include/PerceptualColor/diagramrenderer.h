@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DIAGRAMRENDERER_H
+#define DIAGRAMRENDERER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QString>
+
+#include "PerceptualColor/helper.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+namespace PerceptualColor {
+
+/** @brief Renders the diagrams of this library without any widget
+ * 
+ * This class provides access to the image generators of ChromaHueDiagram,
+ * ChromaLightnessDiagram and SimpleColorWheel for arbitrary parameters.
+ * It does not create any QWidget and it does not use QPixmap, so it works
+ * also without a window system, for example on servers with the
+ * <tt>offscreen</tt> platform plugin of QGuiApplication.
+ * 
+ * Batch jobs are distributed on QThreadPool::globalInstance() by means of
+ * QtConcurrent. Use QThreadPool::setMaxThreadCount() to control the number
+ * of threads. Large batches build a GamutVolume first, which makes the
+ * diagrams faster without changing them.
+ * 
+ * The RgbColorSpace object must stay alive as long as the renderer is used.
+ */
+class DiagramRenderer
+{
+public:
+    /** @brief The diagram types */
+    enum class DiagramType {
+        chromaHue,       /**< ChromaHueDiagram::generateDiagramImage() */
+        chromaLightness, /**< ChromaLightnessDiagram::generateDiagramImage() */
+        colorWheel       /**< SimpleColorWheel::generateWheelImage() */
+    };
+
+    /** @brief File formats for writeImage() */
+    enum class OutputFormat {
+        png, /**< PNG file */
+        raw  /**< Raw buffer as returned by rawBuffer(), without any header */
+    };
+
+    /** @brief Parameters of a rendering job
+     * 
+     * Parameters that are not used by the diagram type are ignored. */
+    struct Job {
+        /** The diagram type */
+        DiagramType type = DiagramType::chromaHue;
+        /** The image size. Chroma-hue diagrams and color wheels are square;
+         * they use the smaller one of width and height. */
+        QSize size = QSize(256, 256);
+        /** LCh lightness for chroma-hue diagrams and color wheels */
+        qreal lightness = Helper::LchBoundaries::defaultLightness;
+        /** LCh hue for chroma-lightness diagrams */
+        qreal hue = Helper::LchBoundaries::defaultHue;
+        /** LCh chroma for color wheels */
+        qreal chroma = Helper::LchBoundaries::versatileSrgbChroma;
+        /** Chroma at the border of chroma-hue diagrams */
+        int maxChroma = static_cast<int>(Helper::LchBoundaries::maxSrgbChroma);
+        /** Border (in pixel) for chroma-hue diagrams and color wheels */
+        int border = 0;
+        /** Thickness (in pixel) of color wheels */
+        int wheelThickness = 16;
+        /** File name for writeBatch() */
+        QString fileName;
+    };
+
+    explicit DiagramRenderer(const RgbColorSpace *colorSpace);
+    QImage render(const Job &job) const;
+    QList<QImage> renderBatch(const QList<Job> &jobs) const;
+    int writeBatch(const QList<Job> &jobs, const OutputFormat format) const;
+    static QByteArray rawBuffer(const QImage &image);
+    static bool writeImage(
+        const QImage &image,
+        const QString &fileName,
+        const OutputFormat format
+    );
+
+private:
+    void prepareGamutVolume(const QList<Job> &jobs) const;
+
+    /** @brief Pointer to RgbColorSpace() object */
+    const RgbColorSpace *m_rgbColorSpace;
+};
+
+}
+
+#endif // DIAGRAMRENDERER_H
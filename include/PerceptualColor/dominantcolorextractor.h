@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DOMINANTCOLOREXTRACTOR_H
+#define DOMINANTCOLOREXTRACTOR_H
+
+#include <QImage>
+#include <QVector>
+
+#include <lcms2.h>
+
+#include "PerceptualColor/fullcolordescription.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+namespace PerceptualColor {
+
+/** @brief Extracts the dominant colors of an image
+ * 
+ * Clusters the colors of an image with k-means in the Lab color space
+ * (k-means++ seeding, followed by Lloyd iterations).
+ * 
+ * Large images are subsampled on a regular grid, so that at most
+ * maximumSamples() pixels are used. The sampled rows are read and
+ * converted to Lab in parallel, with the batch conversion of
+ * RgbColorSpace; no Lab copy of the whole image is created. The Lloyd
+ * iterations are parallelized too. All parallel work is done on
+ * QThreadPool::globalInstance() by means of QtConcurrent.
+ * 
+ * Fully transparent pixels are ignored. The results are deterministic.
+ * 
+ * The RgbColorSpace object must stay alive as long as the extractor is
+ * used. */
+class DominantColorExtractor
+{
+public:
+    /** @brief A cluster of similar colors */
+    struct Cluster {
+        /** The mean color of the cluster */
+        FullColorDescription color;
+        /** The share of the (sampled) pixels that belong to this cluster.
+         * The weights of all clusters add up to 1. */
+        qreal weight;
+    };
+
+    explicit DominantColorExtractor(RgbColorSpace *colorSpace);
+    QVector<Cluster> extract(const QImage &image, const int clusterCount) const;
+    int maximumIterations() const;
+    int maximumSamples() const;
+    void setMaximumIterations(const int maximumIterations);
+    void setMaximumSamples(const int maximumSamples);
+
+private:
+    QVector<cmsCIELab> samples(const QImage &image) const;
+
+    /** @brief Internal storage of the maximumIterations() property */
+    int m_maximumIterations = 20;
+    /** @brief Internal storage of the maximumSamples() property */
+    int m_maximumSamples = 250000;
+    /** @brief Pointer to RgbColorSpace() object */
+    RgbColorSpace *m_rgbColorSpace;
+};
+
+}
+
+#endif // DOMINANTCOLOREXTRACTOR_H
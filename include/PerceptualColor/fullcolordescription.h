@@ -19,6 +19,7 @@
 
 #include "PerceptualColor/helper.h"
 #include "PerceptualColor/rgbcolorspace.h"
+#include <QColor>
 #include <QDebug>
 
 namespace PerceptualColor {
@@ -31,10 +32,27 @@ namespace PerceptualColor {
  * modified anymore (except the alpha value, which does not depend on color
  * management).
  * 
- * Contains an RGB, LCh and Lab representation of the color and the alpha
+ * Provides an RGB, LCh and Lab representation of the color and the alpha
  * channel. The data types are compatible with LittleCMS. The LCh value is
  * normalized.
  * 
+ * This is a compact value type that is copied by value through all the
+ * signals and slots of this library. Therefore, it stores only the canonical
+ * LCh value, the alpha channel and the RGB value. (The RGB value has to be
+ * stored because it is the result of color management: The RgbColorSpace()
+ * object is not available anymore after the constructor call.) If the
+ * object was constructed from a QColor with HSV spec, also this original
+ * HSV value is stored, because converting it to RGB and back would lose
+ * the hue of achromatic colors and some precision.
+ * 
+ * All other representations (Lab, QColor for RGB, QColor for HSV if
+ * not constructed from HSV) are simple arithmetic on the stored values
+ * and are calculated again on each access. They are intentionally
+ * <em>not</em> cached: A cache would need mutable members for all these
+ * representations, which would make the object as big as before and
+ * would make each copy through signals and slots expensive again, while
+ * the calculation itself costs less than copying the cached values.
+ * 
  * This class is declared as type to Qt's type system:
  * Q_DECLARE_METATYPE(PerceptualColor::FullColorDescription).
  * Depending on your use case (for example if you want
@@ -100,21 +118,27 @@ public:
     void setAlpha(qreal alpha);
 
 private:
-    /** RGB representation. */
-    Helper::cmsRGB m_rgb;
-    /** RGB representation within a QColor object */
-    QColor m_rgbQColor;
-    /** Lab representation. */
-    cmsCIELab m_lab;
-    /** LCh representation. */
-    cmsCIELCh m_lch;
-    /** HSV representation within a QColor object */
+    /** @brief LCh representation.
+     * 
+     * This is the canonical representation of this object. */
+    cmsCIELCh m_lch {0, 0, 0};
+    /** @brief RGB representation.
+     * 
+     * Result of the color management at construction time. */
+    Helper::cmsRGB m_rgb {0, 0, 0};
+    /** @brief Alpha channel.
+     * 
+     * The range is 0 (fully transparent) to 1 (fully opaque). */
+    qreal m_alpha = 0;
+    /** @brief Original HSV value.
+     * 
+     * Only valid if this object was constructed from a QColor with HSV
+     * spec. Its alpha channel is ignored; @ref m_alpha is used instead. */
     QColor m_hsvQColor;
-    /** The range is 0 (fully transparent) to 1 (fully opaque). */
-    qreal m_alpha;
     /** Validity of this object. */
-    bool m_valid;
+    bool m_valid = false;
 
+    void convertLch(RgbColorSpace *colorSpace, outOfGamutBehaviour behaviour);
     void moveChromaIntoGamut(RgbColorSpace *colorSpace);
     void normalizeLch();
 };
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAMUTMAPPER_H
+#define GAMUTMAPPER_H
+
+#include <QImage>
+#include <QSize>
+
+#include <lcms2.h>
+
+#include "PerceptualColor/helper.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+namespace PerceptualColor {
+
+/** @brief Gamut mapping of whole images
+ * 
+ * Maps Lab buffers into the gamut of an RgbColorSpace with the same
+ * semantics as FullColorDescription::outOfGamutBehaviour::sacrifyChroma:
+ * Lightness and hue are preserved, and the chroma is reduced until the
+ * color is within the gamut.
+ * 
+ * The buffer is split into tiles of tileSize pixels, which are processed
+ * in parallel on QThreadPool::globalInstance() by means of QtConcurrent.
+ * Within a tile, all pixels are converted with a single LittleCMS
+ * transform call. Only the out-of-gamut pixels need the gamut boundary
+ * search, and its results are memorized per tile, so that repeated
+ * colors (which are frequent in photos and artwork) are mapped only once.
+ * 
+ * The RgbColorSpace object must stay alive as long as the mapper is used.
+ */
+class GamutMapper
+{
+public:
+    explicit GamutMapper(RgbColorSpace *colorSpace);
+    void map(
+        const cmsCIELab *Lab,
+        Helper::cmsRGB *rgb,
+        const int count
+    ) const;
+    QImage mapToImage(const cmsCIELab *Lab, const QSize size) const;
+
+    /** @brief Number of pixels per tile
+     * 
+     * A tile of Lab input and RGB output (each three cmsFloat64Number per
+     * pixel) fits into a typical L2 cache. */
+    static constexpr int tileSize = 4096;
+
+private:
+    void mapTile(
+        const cmsCIELab *Lab,
+        Helper::cmsRGB *rgb,
+        const int count
+    ) const;
+
+    /** @brief Pointer to RgbColorSpace() object */
+    RgbColorSpace *m_rgbColorSpace;
+};
+
+}
+
+#endif // GAMUTMAPPER_H
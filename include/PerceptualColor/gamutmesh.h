@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAMUTMESH_H
+#define GAMUTMESH_H
+
+#include <QString>
+#include <QVector>
+
+#include <lcms2.h>
+
+#include "PerceptualColor/helper.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+namespace PerceptualColor {
+
+/** @brief A triangulated surface of the gamut of an RgbColorSpace
+ * 
+ * The gamut boundary is the image of the surface of the RGB cube. The
+ * mesh starts as a coarse triangulation of the six faces of the cube.
+ * It is refined adaptively: An edge is split if the L*a*b* value of the
+ * RGB midpoint of the edge is more than the tolerance away from the
+ * midpoint of the straight edge in L*a*b*. This refines where the
+ * surface is curved, and in particular along the edges of the cube,
+ * which contain the cusps of the gamut. A triangle with two split edges
+ * gets its third edge split, too, so triangles are split either in two
+ * or in four. The mesh stays closed and consistently oriented (with
+ * outward normals); all its vertices lie exactly on the gamut boundary.
+ * The transforms of each refinement pass are done in parallel on
+ * QThreadPool::globalInstance() by means of QtConcurrent.
+ * 
+ * Apart from the export to PLY and OBJ files, the mesh is a fast
+ * boundary intersection structure: The triangles are binned by lightness
+ * and hue, so boundaryChroma() and isInGamut() only test a few triangles
+ * and need no transform. Like all gamut boundary search in this library,
+ * this assumes that the gamut is continuous between the neutral axis and
+ * the boundary.
+ * 
+ * Instances are immutable and thread-safe.
+ * 
+ * @sa Helper::gamutMeshSize */
+class GamutMesh
+{
+public:
+    explicit GamutMesh(
+        const RgbColorSpace *colorSpace,
+        const qreal tolerance = defaultTolerance,
+        const int initialSubdivisions = 4,
+        const int maximumDepth = 8
+    );
+    cmsFloat64Number boundaryChroma(
+        const cmsFloat64Number lightness,
+        const cmsFloat64Number hue
+    ) const;
+    bool exportObj(const QString &fileName) const;
+    bool exportPly(const QString &fileName) const;
+    bool isInGamut(const cmsCIELab &Lab) const;
+    int triangleCount() const;
+    const QVector<int> &triangles() const;
+    int vertexCount() const;
+    const QVector<Helper::cmsRGB> &vertexRgb() const;
+    const QVector<cmsCIELab> &vertices() const;
+
+    /** @brief Default tolerance of the adaptive refinement
+     * 
+     * Maximum Euclidean distance in L*a*b* between the exact gamut
+     * boundary and the mesh at the midpoints of the edges. */
+    static constexpr qreal defaultTolerance = 0.5;
+
+private:
+    void initializeBins();
+
+    /** @brief Triangles of each lightness-hue bin, for boundaryChroma() */
+    QVector<QVector<int>> m_bins;
+    /** @brief Vertex indices, three for each triangle, counter-clockwise
+     * seen from outside the gamut. */
+    QVector<int> m_triangles;
+    /** @brief Internal storage of the vertexRgb() property */
+    QVector<Helper::cmsRGB> m_vertexRgb;
+    /** @brief Internal storage of the vertices() property */
+    QVector<cmsCIELab> m_vertices;
+};
+
+}
+
+#endif // GAMUTMESH_H
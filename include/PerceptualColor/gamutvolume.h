@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAMUTVOLUME_H
+#define GAMUTVOLUME_H
+
+#include <QSharedPointer>
+#include <QVector>
+
+#include <lcms2.h>
+
+#include "PerceptualColor/rgbcolorspace.h"
+
+namespace PerceptualColor {
+
+/** @brief A precomputed bit volume of the gamut of an RgbColorSpace
+ * 
+ * The L*a*b* space is sampled on a regular grid with resolution() points
+ * on each axis: L* from 0 to 100, and a* and b* from −abRange() to
+ * abRange(), which is a little bit more than the highest chroma of the
+ * gamut. For each grid point, a single bit tells if the color is within
+ * the gamut. Another bit for each grid cell tells if the cell might
+ * contain a part of the gamut boundary. With the default resolution, the
+ * whole volume needs 512 KiB. It is built in parallel, one L* plane per
+ * task, on QThreadPool::globalInstance() by means of QtConcurrent.
+ * 
+ * Lookups interpolate the eight surrounding bits trilinearly (see
+ * coverage()). A color is considered in-gamut if the interpolated value
+ * is at least 0.5. This is much faster than a LittleCMS transform, so
+ * renderScanLine() uses the volume to skip the transforms of colors that
+ * are out of gamut and not close to the gamut boundary. Its result is the
+ * same as without volume. The static generateDiagramImage() functions of
+ * ChromaHueDiagram and ChromaLightnessDiagram accept a volume for this.
+ * The gamut boundary of the volume itself is only as precise as the grid;
+ * accuracyReport() measures this against the exact boundary.
+ * 
+ * Building the volume with the default resolution takes about a second
+ * on a single core. Therefore, the widgets do not build it themselves.
+ * They use RgbColorSpace::gamutVolume(), which builds it in the
+ * background, and render without volume until it is ready. Both ways
+ * give the same image. DiagramRenderer builds it only for large batches.
+ * 
+ * forColorSpace() shares a single volume for each profile and
+ * resolution. It also stores the volume in a CacheFile, so that it is
+ * built only once and not again at each start of the process. The shared
+ * volumes shared volumes count against the budget of
+ * CacheManager, which calls clearCache() when the budget is exceeded.
+ * Instances are immutable and thread-safe. */
+class GamutVolume
+{
+public:
+    /** @brief Accuracy of the volume compared to the exact gamut
+     * 
+     * @sa accuracyReport() */
+    struct AccuracyReport {
+        /** Number of lightness-hue pairs where the boundary chroma has
+            been compared. */
+        int boundarySamples;
+        /** Mean absolute difference between the boundary chroma of the
+            volume and the exact boundary chroma. */
+        qreal meanChromaError;
+        /** Maximum absolute difference between the boundary chroma of the
+            volume and the exact boundary chroma. */
+        qreal maximumChromaError;
+        /** Number of colors that have been classified as in-gamut or
+            out-of-gamut, both by isInGamut() and by a transform. */
+        int classifiedColors;
+        /** Number of colors where isInGamut() and the transform do not
+            agree. */
+        int misclassifiedColors;
+    };
+
+    explicit GamutVolume(
+        const RgbColorSpace *colorSpace,
+        const int resolution = defaultResolution
+    );
+    AccuracyReport accuracyReport(
+        const RgbColorSpace *colorSpace,
+        const int lightnessSteps = 21,
+        const int hueSteps = 72
+    ) const;
+    cmsFloat64Number abRange() const;
+    qint64 byteSize() const;
+    qreal coverage(const cmsCIELab &Lab) const;
+    bool isInGamut(const cmsCIELab &Lab) const;
+    void maskScanLine(
+        const cmsCIELab &first,
+        const cmsCIELab &step,
+        quint8 *outOfGamutMask,
+        const int count
+    ) const;
+    void renderScanLine(
+        const RgbColorSpace *colorSpace,
+        const cmsCIELab &first,
+        const cmsCIELab &step,
+        QRgb *pixels,
+        const int count,
+        const RgbColorSpace::TransformPrecision precision =
+            RgbColorSpace::TransformPrecision::float32,
+        quint8 *outOfGamutMask = nullptr
+    ) const;
+    int resolution() const;
+    static qint64 cacheByteSize();
+    static QSharedPointer<const GamutVolume> cachedForColorSpace(
+        const RgbColorSpace *colorSpace,
+        const int resolution = defaultResolution
+    );
+    static void clearCache();
+    static QSharedPointer<const GamutVolume> forColorSpace(
+        const RgbColorSpace *colorSpace,
+        const int resolution = defaultResolution
+    );
+
+    /** @brief Default number of grid points on each axis
+     * 
+     * For sRGB, this is a grid spacing of about 2.2 on the a* and b*
+     * axes, and of about 0.8 on the L* axis. */
+    static constexpr int defaultResolution = 128;
+
+private:
+    Q_DISABLE_COPY(GamutVolume)
+    GamutVolume() = default;
+    bool readCacheFile(
+        const RgbColorSpace *colorSpace,
+        const int resolution
+    );
+    void writeCacheFile(const RgbColorSpace *colorSpace) const;
+    bool bit(const int lightnessIndex, const int aIndex, const int bIndex) const;
+    int cellIndex(const cmsCIELab &Lab) const;
+    bool isBoundaryCell(const cmsCIELab &Lab) const;
+    void markBoundaryCells(const QVector<cmsCIELab> &surface);
+    qreal surfaceSpacing(
+        const QVector<cmsCIELab> &surface,
+        const int subdivisions
+    ) const;
+    qreal volumeBoundaryChroma(
+        const cmsFloat64Number lightness,
+        const cmsFloat64Number hue
+    ) const;
+
+    /** @brief The bits, plane by plane. Each L* plane starts with a new
+     * word, so that planes can be written in parallel. */
+    QVector<quint64> m_bits;
+    /** @brief One bit for each grid cell that might contain a part of the
+     * gamut boundary, in the order of cellIndex()
+     * 
+     * @sa markBoundaryCells() */
+    QVector<quint64> m_boundaryCells;
+    /** @brief Internal storage of the abRange() property */
+    cmsFloat64Number m_abRange;
+    /** @brief Internal storage of the resolution() property */
+    int m_resolution;
+    /** @brief Number of words of each L* plane in @ref m_bits */
+    int m_wordsPerPlane;
+};
+
+}
+
+#endif // GAMUTVOLUME_H
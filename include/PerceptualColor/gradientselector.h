@@ -30,6 +30,7 @@
 #include <PerceptualColor/fullcolordescription.h>
 #include <PerceptualColor/rgbcolorspace.h>
 
+#include <QTimer>
 #include <QWidget>
 
 namespace PerceptualColor {
@@ -100,6 +101,7 @@ class GradientSelector : public QWidget
 public:
     explicit GradientSelector(RgbColorSpace *colorSpace, QWidget *parent = nullptr);
     explicit GradientSelector(RgbColorSpace *colorSpace, Qt::Orientation orientation, QWidget *parent = nullptr);
+    virtual ~GradientSelector() override;
 
     virtual QSize sizeHint() const;
 
@@ -132,6 +134,8 @@ protected:
 
     virtual void wheelEvent(QWheelEvent* event);
 
+    virtual void hideEvent(QHideEvent *event) override;
+
     virtual void keyPressEvent(QKeyEvent* event);
 
     virtual void paintEvent(QPaintEvent* event);
@@ -156,6 +160,9 @@ private:
      * at the left is the first calor, always at the right is the second color.
      * So when painting, it might be necessary to rotate the image.
      * 
+     * On high-dpi screens, the image has a device pixel ratio as returned
+     * by Helper::cacheDevicePixelRatio().
+     * 
      * This is a cache. Before using it, check if it's up-to-date with
      * m_gradientImageReady(). If not, use updateGradientImage() to
      * update it.
@@ -177,6 +184,13 @@ private:
      * \sa updateGradientImage()
      * \sa m_gradientImage() */
     bool m_gradientImageReady = false;
+    /** @brief Timer for resize debouncing
+     * 
+     * Active while the widget is being resized. Meanwhile, paintEvent()
+     * draws the previous cache scaled to the new geometry. On timeout,
+     * the widget is repainted with a regenerated cache.
+     * @sa Helper::resizeDebounceInterval */
+    QTimer m_resizeTimer;
     /** @brief The transform for painting on the widget.
      * 
      * Depends on layoutDirection() and orientation() */
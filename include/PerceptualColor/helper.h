@@ -30,6 +30,7 @@
 // TODO use forward-declarations instead of including too many headers?
 
 #include <QImage>
+#include <QSize>
 #include <QVersionNumber>
 #include <QWheelEvent>
 
@@ -92,12 +93,32 @@ namespace Helper {
      * 
      * In short: Smaller values mean better precision and slower processing.
      * 
+     * For a triangulated surface of the whole gamut, that allows a boundary
+     * search without transforms, see GamutMesh.
+     * 
      * \sa gamutPrecision */
     static constexpr qreal gamutMeshSize = 0.01;
     /** @brief precision for gamut boundary search
      * 
      * For details, see gamutMeshSize() documentation. */
     static constexpr qreal gamutPrecision = 0.001;
+    /** @brief Render-cost budget for widget caches
+     * 
+     * The maximum number of device pixels of a single image cache (like
+     * the diagram image of ChromaHueDiagram). On high-dpi screens, the
+     * caches are rendered at the native resolution of the screen as long
+     * as this budget is not exceeded. Otherwise, they are rendered at
+     * logical resolution and upscaled by Qt.
+     * 
+     * \sa cacheDevicePixelRatio() */
+    static constexpr qint64 renderCostBudget = 2048 * 2048;
+    /** @brief Debounce interval for resize events, in milliseconds
+     * 
+     * While a widget is resized interactively, its image caches are not
+     * regenerated on each resize event. Instead, the previous cache is
+     * drawn scaled to the new geometry. Only when the size has been
+     * stable for this interval, the exact image is regenerated. */
+    static constexpr int resizeDebounceInterval = 150;
 
     /** @brief Template function to test if a value is in a certain range
      * @param low the low limit
@@ -185,6 +206,35 @@ namespace Helper {
         cmsFloat64Number blue;
     };
 
+    /** @brief An RGB color in single precision.
+     * 
+     * Memory layout of the LittleCMS format TYPE_RGB_FLT. The range is 0..1
+     * 
+     * @sa RgbColorSpace::TransformPrecision */
+    struct cmsRGBFloat32 {
+        /** The red value. */
+        cmsFloat32Number red;
+        /** The green value. */
+        cmsFloat32Number green;
+        /** The blue value. */
+        cmsFloat32Number blue;
+    };
+
+    /** @brief A L*a*b* color in single precision.
+     * 
+     * Memory layout of the LittleCMS format TYPE_Lab_FLT. Same ranges as
+     * cmsCIELab.
+     * 
+     * @sa RgbColorSpace::TransformPrecision */
+    struct cmsLabFloat32 {
+        /** The lightness value. */
+        cmsFloat32Number L;
+        /** The a value. */
+        cmsFloat32Number a;
+        /** The b value. */
+        cmsFloat32Number b;
+    };
+
     cmsCIELab toLab(const cmsCIELCh &lch);
 
     cmsCIELCh toLch(const cmsCIELab &lab);
@@ -196,6 +246,10 @@ namespace Helper {
     QPoint nearestNeighborSearch(const QPoint originalPoint, const QImage &image);
 
     qreal wheelSteps(QWheelEvent *event);
+
+    qreal discCoverage(const qreal distance, const qreal radius);
+
+    qreal cacheDevicePixelRatio(const QPaintDevice *device, const QSize logicalSize);
 }
 
 }
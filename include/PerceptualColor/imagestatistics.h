@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef IMAGESTATISTICS_H
+#define IMAGESTATISTICS_H
+
+#include <QImage>
+#include <QVector>
+
+#include <lcms2.h>
+
+#include "PerceptualColor/helper.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+namespace PerceptualColor {
+
+/** @brief Streaming LCh statistics of images
+ * 
+ * Accumulates, scanline by scanline:
+ * - histograms of LCh lightness, chroma and hue,
+ * - the share of pixels near the gamut boundary,
+ * - the maximum chroma per hue sector.
+ * 
+ * The pixels are converted to LCh with the batch conversion of
+ * RgbColorSpace, in chunks on the stack. Memory usage is independent of
+ * the image size.
+ * 
+ * An object is not thread-safe. To accumulate from various threads, use one
+ * object per thread and merge() them at the end. addImage() does exactly
+ * this on QThreadPool::globalInstance() by means of QtConcurrent.
+ * 
+ * The RgbColorSpace object must stay alive as long as this object is
+ * used. */
+class ImageStatistics
+{
+public:
+    /** @brief Number of bins of lightnessHistogram(): One bin per
+     * lightness unit, from 0 to 100 */
+    static constexpr int lightnessBinCount = 101;
+    /** @brief Number of bins of chromaHistogram(): One bin per chroma
+     * unit, from 0 to Helper::LchBoundaries::physicalMaximumChroma */
+    static constexpr int chromaBinCount =
+        Helper::LchBoundaries::physicalMaximumChroma + 1;
+    /** @brief Number of bins of hueHistogram(): One bin per degree */
+    static constexpr int hueBinCount = 360;
+    /** @brief Number of sectors of maximumChromaPerHueSector() */
+    static constexpr int hueSectorCount = 36;
+    /** @brief Pixels with a lower chroma are considered as achromatic. Their
+     * hue is meaningless, so they are not counted in hueHistogram() and
+     * maximumChromaPerHueSector(). */
+    static constexpr qreal achromaticChroma = 1;
+    /** @brief Threshold for nearBoundaryShare()
+     * 
+     * In RGB, the gamut boundary is the surface of the RGB cube. A pixel
+     * counts as near the gamut boundary if at least one RGB channel is
+     * closer than this (range 0..1) to 0 or 1. Note that black and white
+     * are on the gamut boundary. */
+    static constexpr qreal nearBoundaryThreshold = 2.0 / 255;
+    /** @brief Maximum number of pixels that addImage() converts at once
+     * for images that are neither QImage::Format_RGB32 nor
+     * QImage::Format_ARGB32 */
+    static constexpr int conversionPixelCount = 65536;
+
+    explicit ImageStatistics(RgbColorSpace *colorSpace);
+    void addImage(const QImage &image);
+    void addScanLine(const QRgb *pixels, const int count);
+    QVector<quint64> chromaHistogram() const;
+    QVector<quint64> hueHistogram() const;
+    QVector<quint64> lightnessHistogram() const;
+    QVector<qreal> maximumChromaPerHueSector() const;
+    void merge(const ImageStatistics &other);
+    qreal nearBoundaryShare() const;
+    quint64 pixelCount() const;
+    void reset();
+
+private:
+    /** @brief The accumulated statistics
+     * 
+     * This is a plain default-constructible type (unlike ImageStatistics,
+     * which needs a color space), so that addImage() can use it as result
+     * type of QtConcurrent::blockingMapped(). A default-constructed object
+     * is empty. */
+    struct Accumulator {
+        Accumulator();
+        void merge(const Accumulator &other);
+        /** @brief Internal storage of the chromaHistogram() property */
+        QVector<quint64> chromaHistogram;
+        /** @brief Internal storage of the hueHistogram() property */
+        QVector<quint64> hueHistogram;
+        /** @brief Internal storage of the lightnessHistogram() property */
+        QVector<quint64> lightnessHistogram;
+        /** @brief Internal storage of the maximumChromaPerHueSector()
+         * property */
+        QVector<qreal> maximumChromaPerHueSector;
+        /** @brief Number of pixels near the gamut boundary
+         * @sa nearBoundaryShare() */
+        quint64 nearBoundaryCount = 0;
+        /** @brief Internal storage of the pixelCount() property */
+        quint64 pixelCount = 0;
+    };
+
+    void accumulate(
+        const QRgb *pixels,
+        const int count,
+        Accumulator *accumulator
+    ) const;
+
+    /** @brief The statistics of this object */
+    Accumulator m_accumulator;
+    /** @brief Pointer to RgbColorSpace() object */
+    RgbColorSpace *m_rgbColorSpace;
+};
+
+}
+
+#endif // IMAGESTATISTICS_H
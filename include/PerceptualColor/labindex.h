@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LABINDEX_H
+#define LABINDEX_H
+
+#include <QVector>
+
+#include <lcms2.h>
+
+#include "PerceptualColor/fullcolordescription.h"
+
+namespace PerceptualColor {
+
+/** @brief Spatial index for nearest-color queries in the Lab color space
+ * 
+ * A balanced k-d tree over Lab values, for example for matching a color
+ * against a large palette. Building the index takes <em>O(n log n)</em>,
+ * a query typically <em>O(log n)</em>.
+ * 
+ * The distance metric of the index is ΔE*76 (the euclidean distance in
+ * Lab). nearestDeltaE2000() re-ranks a larger candidate set from the
+ * index by CIEDE2000.
+ * 
+ * The index is immutable after construction, so queries are thread-safe.
+ * 
+ * @sa ColorDifference */
+class LabIndex
+{
+public:
+    /** @brief Result of a query */
+    struct Match {
+        /** Index of the color in the list given to the constructor */
+        int index;
+        /** Color difference to the query color */
+        cmsFloat64Number deltaE;
+    };
+
+    LabIndex() = default;
+    explicit LabIndex(const QVector<cmsCIELab> &colors);
+    explicit LabIndex(const QVector<FullColorDescription> &colors);
+    cmsCIELab color(const int index) const;
+    int count() const;
+    QVector<Match> nearest(const cmsCIELab &lab, const int k) const;
+    QVector<Match> nearestDeltaE2000(
+        const cmsCIELab &lab,
+        const int k,
+        const int candidates = 0
+    ) const;
+    QVector<Match> withinRadius(
+        const cmsCIELab &lab,
+        const cmsFloat64Number radius
+    ) const;
+
+private:
+    void build(const int begin, const int end, const int depth);
+    void searchNearest(
+        const cmsCIELab &lab,
+        const int k,
+        const int begin,
+        const int end,
+        const int depth,
+        QVector<Match> *heap
+    ) const;
+    void searchRadius(
+        const cmsCIELab &lab,
+        const cmsFloat64Number radiusSquared,
+        const int begin,
+        const int end,
+        const int depth,
+        QVector<Match> *result
+    ) const;
+
+    /** @brief The original colors, in the order given to the constructor */
+    QVector<cmsCIELab> m_colors;
+    /** @brief The k-d tree
+     * 
+     * Indices into m_colors. The tree is implicit: The node of the range
+     * <tt>[begin, end)</tt> is at <tt>(begin + end) / 2</tt>; its left
+     * subtree is <tt>[begin, node)</tt>, its right subtree is
+     * <tt>[node + 1, end)</tt>. The split axis is L, a, b, L, a, b, … by
+     * depth. */
+    QVector<int> m_tree;
+};
+
+}
+
+#endif // LABINDEX_H
@@ -27,14 +27,28 @@
 #ifndef RGBCOLORSPACE_H
 #define RGBCOLORSPACE_H
 
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
 #include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <functional>
 
 #include <lcms2.h>
 
 #include <PerceptualColor/helper.h>
 
+class QSharedMemory;
+
 namespace PerceptualColor {
 
+class GamutVolume;
+
 /** @brief Interface to LittleCMS for working with an RGB color space
  */
 class RgbColorSpace : public QObject
@@ -42,35 +56,214 @@ class RgbColorSpace : public QObject
     Q_OBJECT
 
 public:
+    /** @brief Result of a conversion from LCh
+     * 
+     * This is what the conversion cache stores.
+     * 
+     * @sa lookupConversion()
+     * @sa storeConversion() */
+    struct LchConversion {
+        /** The LCh value, after gamut mapping if requested. */
+        cmsCIELCh lch;
+        /** The corresponding RGB value, forced into the gamut. */
+        Helper::cmsRGB rgb;
+    };
+
+    /** @brief Algorithms for the search of the gamut boundary
+     * 
+     * @sa boundaryChroma() */
+    enum class BoundarySearch {
+        bisection, /**< Plain bisection. Robust, but needs many transforms. */
+        illinois   /**< Regula falsi with the Illinois modification on the
+                        RGB clip distance, with bisection as safeguard.
+                        Needs only a few transforms. */
+    };
+
+    /** @brief Precision of the LittleCMS transforms for rendering
+     * 
+     * LittleCMS evaluates floating point pipelines internally in single
+     * precision anyway; the double precision formats only change how the
+     * values are packed. Measured with the build-in sRGB profile on a grid
+     * over the whole L*a*b* range, compared to float64:
+     * - Maximum RGB difference of in-gamut colors: 2.2·10⁻⁶
+     * - Maximum RGB difference of out-of-gamut colors: 7.6·10⁻⁶
+     * - Colors classified differently as in-gamut/out-of-gamut: none
+     * - 8 bit RGB values that differ after rounding: 15 of 416610 colors
+     *   (by one step)
+     * - Transform speed: the same (about 300 ns per color on a single
+     *   core, for both)
+     * 
+     * So float32 does not make the transform itself faster, but it halves
+     * the size of the buffers, which keeps larger batches in the cache. It
+     * is the default for rendering (see colorRgbScanLine()). Functions that
+     * return exact values always use float64. */
+    enum class TransformPrecision {
+        float32, /**< TYPE_Lab_FLT to TYPE_RGB_FLT */
+        float64  /**< TYPE_Lab_DBL to TYPE_RGB_DBL */
+    };
+
     RgbColorSpace(QObject *parent = nullptr);
+    explicit RgbColorSpace(
+        const QString &profileFileName,
+        QObject *parent = nullptr
+    );
     virtual ~RgbColorSpace();
     qreal blackpointL() const;
+    cmsFloat64Number boundaryChroma(
+        const cmsCIELCh &LCh,
+        const BoundarySearch algorithm = BoundarySearch::illinois,
+        int *transformCount = nullptr
+    ) const;
     QColor colorRgb(const cmsCIELab &Lab) const;
     QColor colorRgb(const cmsCIELCh &LCh) const;
+    void colorRgbUnbounded(
+        const cmsCIELab *Lab,
+        Helper::cmsRGB *rgb,
+        const int count
+    ) const;
+    void colorRgbUnbounded(
+        const Helper::cmsLabFloat32 *Lab,
+        Helper::cmsRGBFloat32 *rgb,
+        const int count
+    ) const;
+    void colorRgbScanLine(
+        const cmsCIELab *Lab,
+        QRgb *pixels,
+        const int count,
+        const TransformPrecision precision = TransformPrecision::float32,
+        quint8 *outOfGamutMask = nullptr
+    ) const;
+    void colorRgbScanLine(
+        const cmsCIELab &first,
+        const cmsCIELab &step,
+        QRgb *pixels,
+        const int count,
+        const TransformPrecision precision = TransformPrecision::float32,
+        quint8 *outOfGamutMask = nullptr
+    ) const;
+    void antialiasGamutBoundary(
+        QImage *image,
+        const QVector<quint8> &outOfGamutMask,
+        const std::function<cmsCIELab(const qreal x, const qreal y)> &pixelToLab,
+        const TransformPrecision precision = TransformPrecision::float32
+    ) const;
     Helper::cmsRGB colorRgbBoundSimple(const cmsCIELab &Lab) const;
+    void colorRgbBoundSimple(
+        const cmsCIELab *Lab,
+        Helper::cmsRGB *rgb,
+        const int count
+    ) const;
     QColor colorRgbBound(const cmsCIELab &Lab) const;
     QColor colorRgbBound(const cmsCIELCh &LCh) const;
     cmsCIELab colorLab(const QColor &rgbColor) const;
     cmsCIELab colorLab(const Helper::cmsRGB &rgb) const;
+    void colorLab(
+        const Helper::cmsRGB *rgb,
+        cmsCIELab *Lab,
+        const int count
+    ) const;
     QString description() const;
+    cmsFloat64Number gamutDistance(const cmsCIELCh &LCh) const;
+    QSharedPointer<const GamutVolume> gamutVolume() const;
+    QByteArray profileId() const;
+    QByteArray cacheKey() const;
+    static void clearTransformCache();
+    static quint64 transformCacheHits();
+    static quint64 transformCacheMisses();
+    static bool isDeviceLinkCacheEnabled();
+    static void setDeviceLinkCacheEnabled(bool enabled);
+    bool isGamutTableShared() const;
+    static bool isSharedGamutTableEnabled();
+    static void setSharedGamutTableEnabled(bool enabled);
     bool inGamut(
         const cmsFloat64Number lightness,
         const cmsFloat64Number chroma,
         const cmsFloat64Number hue
     );
     bool inGamut(const cmsCIELCh &LCh);
+    bool usesDeviceLinks() const;
     qreal whitepointL() const;
+    bool lookupConversion(
+        const cmsCIELCh &lch,
+        const bool sacrifyChroma,
+        LchConversion *result
+    ) const;
+    void storeConversion(
+        const cmsCIELCh &lch,
+        const bool sacrifyChroma,
+        const LchConversion &conversion
+    ) const;
+    quint64 conversionCacheHits() const;
+    quint64 conversionCacheMisses() const;
+    void resetConversionCacheStatistics();
+
+    /** @brief Quantization step of the conversion cache keys
+     * 
+     * LCh values that are equal after rounding to this step share the same
+     * cache entry. This is an order of magnitude finer than
+     * Helper::gamutPrecision, so cache hits do not change the precision
+     * guarantees of the gamut mapping. */
+    static constexpr qreal conversionCacheQuantum = 0.0001;
+
+    /** @brief Number of samples on each axis of a pixel for
+     * antialiasGamutBoundary() */
+    static constexpr int antialiasingSamples = 4;
 
 private:
     Q_DISABLE_COPY(RgbColorSpace)
+    struct Transforms;
     qreal m_blackpointL;
+    /** @brief Number of cache hits of lookupConversion() */
+    mutable QAtomicInteger<quint64> m_conversionCacheHits {0};
+    /** @brief Number of cache misses of lookupConversion() */
+    mutable QAtomicInteger<quint64> m_conversionCacheMisses {0};
+    /** @brief Unique id of this object, used as part of the conversion cache
+     * key. Unlike the object address, it is never reused. */
+    quint64 m_instanceId;
     /** internal storage for description() property. */
     QString m_description;
-    cmsHTRANSFORM m_transformLabToRgb16Handle;
-    cmsHTRANSFORM m_transformLabToRgbHandle;
-    cmsHTRANSFORM m_transformRgbToLabHandle;
+    /** @brief The gamut table, or @c nullptr
+     * 
+     * Points either into m_sharedMemory or into m_localGamutTable.
+     * 
+     * @sa setSharedGamutTableEnabled() */
+    const float *m_gamutTable = nullptr;
+    /** @brief Local storage for the gamut table if shared memory is not
+     * available */
+    QVector<float> m_localGamutTable;
+    /** @brief Shared memory segment with the gamut table, or @c nullptr */
+    QSharedMemory *m_sharedMemory = nullptr;
+    /** @brief The background build of gamutVolume()
+     * 
+     * Protected by @ref m_gamutVolumeMutex. */
+    mutable QFuture<void> m_gamutVolumeBuild;
+    /** @brief Protects @ref m_gamutVolumeBuild */
+    mutable QMutex m_gamutVolumeMutex;
+    /** internal storage for profileId() property. */
+    QByteArray m_profileId;
+    /** @brief The LittleCMS transforms. They might be shared with other
+     * RgbColorSpace objects that use the same profile.
+     * 
+     * @sa transformsForProfile() */
+    QSharedPointer<const Transforms> m_transforms;
     qreal m_whitepointL;
+    void computeGamutTable(float *table) const;
+    cmsFloat64Number gamutTableChroma(
+        const cmsFloat64Number lightness,
+        const cmsFloat64Number hue
+    ) const;
     static QString getInformationFromProfile(cmsHPROFILE profileHandle, cmsInfoType infoType);
+    static QByteArray getProfileId(cmsHPROFILE profileHandle);
+    void initialize(cmsHPROFILE rgbProfileHandle);
+    void initializeGamutTable();
+    void initializeGrayAxis();
+    void loadGamutTable(float *table) const;
+    static QHash<QByteArray, QSharedPointer<const Transforms>> &
+        transformCache();
+    static QSharedPointer<const Transforms> transformsForProfile(
+        cmsHPROFILE rgbProfileHandle,
+        const QByteArray &profileId
+    );
 };
 
 }
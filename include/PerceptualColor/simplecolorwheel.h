@@ -27,7 +27,9 @@
 #ifndef SIMPLECOLORWHEEL_H
 #define SIMPLECOLORWHEEL_H
 
+#include <QBitArray>
 #include <QImage>
+#include <QTimer>
 #include <QWidget>
 
 #include "PerceptualColor/polarpointf.h"
@@ -101,7 +103,7 @@ class SimpleColorWheel : public QWidget
 
 public:
     explicit SimpleColorWheel(RgbColorSpace *colorSpace, QWidget *parent = nullptr);
-    virtual ~SimpleColorWheel() override = default;
+    virtual ~SimpleColorWheel() override;
     int border() const;
     virtual bool hasHeightForWidth() const override;
     virtual int	heightForWidth(int width) const override;
@@ -112,12 +114,15 @@ public:
     int wheelThickness() const;
     qreal wheelRibbonChroma() const;
     static QImage generateWheelImage(
-        RgbColorSpace *colorSpace,
+        const RgbColorSpace *colorSpace,
         const int outerDiameter,
         const int border,
         const int thickness,
         const qreal lightness,
-        const qreal chroma
+        const qreal chroma,
+        const RgbColorSpace::TransformPrecision precision =
+            RgbColorSpace::TransformPrecision::float32,
+        QBitArray *outOfGamutMask = nullptr
     );
 
 Q_SIGNALS:
@@ -135,6 +140,7 @@ public Q_SLOTS:
     void setWheelThickness(const int newMarkerThickness);
 
 protected:
+    virtual void hideEvent(QHideEvent *event) override;
     virtual void keyPressEvent(QKeyEvent *event) override;
     virtual void mouseMoveEvent(QMouseEvent *event) override;
     virtual void mousePressEvent(QMouseEvent *event) override;
@@ -163,6 +169,13 @@ private:
      *  @sa refreshWheelImage()
      *  @sa updateWheelImage */
     bool m_wheelImageReady = false;
+    /** @brief Timer for resize debouncing
+     * 
+     * Active while the widget is being resized. Meanwhile, paintEvent()
+     * draws the previous cache scaled to the new geometry. On timeout,
+     * the widget is repainted with a regenerated cache.
+     * @sa Helper::resizeDebounceInterval */
+    QTimer m_resizeTimer;
     /** @brief Internal storage of the hue() property */
     qreal m_hue;
     /** @brief Internal storage of the markerThickness() property */
@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/batchconverter.h"
+
+#include "PerceptualColor/fullcolordescription.h"
+#include "PerceptualColor/helper.h"
+
+#include <cstring>
+
+#include <QtEndian>
+#include <QVector>
+
+namespace PerceptualColor {
+
+namespace {
+
+/** @returns if the color format is RGB-based */
+bool isRgbFormat(const BatchConverter::ColorFormat format)
+{
+    return (format == BatchConverter::ColorFormat::hex)
+        || (format == BatchConverter::ColorFormat::rgb);
+}
+
+/** @returns a little-endian IEEE 754 double value */
+cmsFloat64Number readDouble(const char *data)
+{
+    const quint64 bits = qFromLittleEndian<quint64>(
+        reinterpret_cast<const uchar *>(data)
+    );
+    cmsFloat64Number result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+/** @brief Appends a little-endian IEEE 754 double value */
+void appendDouble(QByteArray *output, const cmsFloat64Number value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uchar data[8];
+    qToLittleEndian<quint64>(bits, data);
+    output->append(reinterpret_cast<const char *>(data), 8);
+}
+
+/** @brief Parses a text record
+ * 
+ * @param line the line, without line break
+ * @param separator the field separator
+ * @param format the color format
+ * @param values the three values of the color (for <tt>hex</tt> in the
+ * range 0..255, like for <tt>rgb</tt>)
+ * @param rest the fields after the color, including the leading separator
+ * @returns @c true on success */
+bool parseTextRecord(
+    const QByteArray &line,
+    const char separator,
+    const BatchConverter::ColorFormat format,
+    cmsFloat64Number values[3],
+    QByteArray *rest
+)
+{
+    const QList<QByteArray> fields = line.split(separator);
+    int colorFieldCount = 3;
+    if (format == BatchConverter::ColorFormat::hex) {
+        colorFieldCount = 1;
+        QByteArray hex = fields.at(0).trimmed();
+        if (hex.startsWith('#')) {
+            hex.remove(0, 1);
+        }
+        if (hex.size() != 6) {
+            return false;
+        }
+        bool ok;
+        const uint number = hex.toUInt(&ok, 16);
+        if (!ok) {
+            return false;
+        }
+        values[0] = (number >> 16) & 0xFF;
+        values[1] = (number >> 8) & 0xFF;
+        values[2] = number & 0xFF;
+    } else {
+        if (fields.count() < 3) {
+            return false;
+        }
+        bool ok;
+        for (int i = 0; i < 3; ++i) {
+            values[i] = fields.at(i).trimmed().toDouble(&ok);
+            if (!ok) {
+                return false;
+            }
+        }
+    }
+    rest->clear();
+    for (int i = colorFieldCount; i < fields.count(); ++i) {
+        rest->append(separator);
+        rest->append(fields.at(i));
+    }
+    return true;
+}
+
+}
+
+/** @brief Constructor
+ * 
+ * @param colorSpace the color space. Must stay alive as long as this
+ * object is used. */
+BatchConverter::BatchConverter(RgbColorSpace *colorSpace)
+{
+    m_rgbColorSpace = colorSpace;
+}
+
+/** @brief Parses the name of a color format
+ * 
+ * @param text the name: <tt>hex</tt>, <tt>rgb</tt>, <tt>lab</tt> or
+ * <tt>lch</tt>
+ * @param format the parsed color format
+ * @returns @c true on success */
+bool BatchConverter::parseColorFormat(const QString &text, ColorFormat *format)
+{
+    if (text == QStringLiteral("hex")) {
+        *format = ColorFormat::hex;
+    } else if (text == QStringLiteral("rgb")) {
+        *format = ColorFormat::rgb;
+    } else if (text == QStringLiteral("lab")) {
+        *format = ColorFormat::lab;
+    } else if (text == QStringLiteral("lch")) {
+        *format = ColorFormat::lch;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/** @brief Converts a chunk of records
+ * 
+ * This function is thread-safe. It uses the batch conversion functions of
+ * RgbColorSpace whenever possible. Only gamut mapping (sacrifyChroma) is
+ * done color by color.
+ * 
+ * @param settings the conversion settings
+ * @param input Text: A list of lines. Binary: A single entry with the raw
+ * records, as returned by readChunk().
+ * @returns the converted records. An incomplete binary record at the end of
+ * the input is counted as invalid record; it produces no output. */
+BatchConverter::ChunkResult BatchConverter::convertChunk(
+    const Settings &settings,
+    const QList<QByteArray> &input
+) const
+{
+    ChunkResult result;
+    const bool binary = (settings.recordFormat == RecordFormat::binary);
+    const char separator =
+        (settings.recordFormat == RecordFormat::tsv) ? '\t' : ',';
+
+    // Parse
+    QVector<bool> valid;
+    QVector<QByteArray> rest;
+    QVector<Helper::cmsRGB> rgb;
+    QVector<cmsCIELab> lab;
+    cmsFloat64Number values[3];
+    // Trailing data that is shorter than a record (only possible at the
+    // end of the input)
+    bool truncated = false;
+    if (binary) {
+        result.count = input.value(0).size() / binaryRecordSize;
+        truncated = ((input.value(0).size() % binaryRecordSize) != 0);
+    } else {
+        result.count = input.count();
+    }
+    valid.resize(result.count);
+    rest.resize(result.count);
+    rgb.resize(result.count);
+    lab.resize(result.count);
+    for (int i = 0; i < result.count; ++i) {
+        if (binary) {
+            const char *record = input.at(0).constData() + i * binaryRecordSize;
+            values[0] = readDouble(record);
+            values[1] = readDouble(record + 8);
+            values[2] = readDouble(record + 16);
+            valid[i] = true;
+        } else {
+            valid[i] = parseTextRecord(
+                input.at(i),
+                separator,
+                settings.from,
+                values,
+                &rest[i]
+            );
+        }
+        if (!valid.at(i)) {
+            values[0] = 0;
+            values[1] = 0;
+            values[2] = 0;
+        }
+        switch (settings.from) {
+        case ColorFormat::hex:
+        case ColorFormat::rgb:
+            rgb[i].red = qBound<cmsFloat64Number>(0, values[0] / 255, 1);
+            rgb[i].green = qBound<cmsFloat64Number>(0, values[1] / 255, 1);
+            rgb[i].blue = qBound<cmsFloat64Number>(0, values[2] / 255, 1);
+            break;
+        case ColorFormat::lab:
+            lab[i].L = values[0];
+            lab[i].a = values[1];
+            lab[i].b = values[2];
+            break;
+        case ColorFormat::lch:
+            lab[i] = Helper::toLab(
+                cmsCIELCh {values[0], values[1], values[2]}
+            );
+            break;
+        }
+    }
+
+    // Convert
+    if (isRgbFormat(settings.from)) {
+        if (!isRgbFormat(settings.to)) {
+            m_rgbColorSpace->colorLab(
+                rgb.constData(),
+                lab.data(),
+                result.count
+            );
+        }
+    } else {
+        if (settings.sacrifyChroma) {
+            // Gamut mapping is done color by color. Its results are
+            // cached by RgbColorSpace, which helps with repeated colors.
+            FullColorDescription color;
+            for (int i = 0; i < result.count; ++i) {
+                color = FullColorDescription(
+                    m_rgbColorSpace,
+                    lab.at(i),
+                    FullColorDescription::outOfGamutBehaviour::sacrifyChroma
+                );
+                lab[i] = color.toLab();
+                rgb[i] = color.toRgb();
+            }
+        } else if (isRgbFormat(settings.to)) {
+            m_rgbColorSpace->colorRgbBoundSimple(
+                lab.constData(),
+                rgb.data(),
+                result.count
+            );
+        }
+    }
+
+    // Format
+    for (int i = 0; i < result.count; ++i) {
+        switch (settings.to) {
+        case ColorFormat::hex:
+        case ColorFormat::rgb:
+            values[0] = rgb.at(i).red * 255;
+            values[1] = rgb.at(i).green * 255;
+            values[2] = rgb.at(i).blue * 255;
+            break;
+        case ColorFormat::lab:
+            values[0] = lab.at(i).L;
+            values[1] = lab.at(i).a;
+            values[2] = lab.at(i).b;
+            break;
+        case ColorFormat::lch: {
+            const cmsCIELCh lch = Helper::toLch(lab.at(i));
+            values[0] = lch.L;
+            values[1] = lch.C;
+            values[2] = lch.h;
+            break;
+        }
+        }
+        if (binary) {
+            appendDouble(&result.output, values[0]);
+            appendDouble(&result.output, values[1]);
+            appendDouble(&result.output, values[2]);
+            continue;
+        }
+        if (!valid.at(i)) {
+            ++result.invalidCount;
+            result.output.append('\n');
+            continue;
+        }
+        if (settings.to == ColorFormat::hex) {
+            result.output.append('#');
+            for (int j = 0; j < 3; ++j) {
+                result.output.append(
+                    QByteArray::number(qRound(values[j]), 16)
+                        .rightJustified(2, '0')
+                        .toUpper()
+                );
+            }
+        } else if (settings.to == ColorFormat::rgb) {
+            result.output.append(QByteArray::number(qRound(values[0])));
+            result.output.append(separator);
+            result.output.append(QByteArray::number(qRound(values[1])));
+            result.output.append(separator);
+            result.output.append(QByteArray::number(qRound(values[2])));
+        } else {
+            result.output.append(QByteArray::number(values[0], 'f', 4));
+            result.output.append(separator);
+            result.output.append(QByteArray::number(values[1], 'f', 4));
+            result.output.append(separator);
+            result.output.append(QByteArray::number(values[2], 'f', 4));
+        }
+        result.output.append(rest.at(i));
+        result.output.append('\n');
+    }
+    if (truncated) {
+        // The incomplete record cannot be converted and produces no output.
+        ++result.count;
+        ++result.invalidCount;
+    }
+    return result;
+}
+
+/** @brief Reads the next chunk from the input
+ * 
+ * Binary chunks contain only complete records, except at the end of the
+ * input.
+ * 
+ * @param input the input device, opened for reading
+ * @param recordFormat the record format
+ * @returns Text: A list of lines, without line breaks. Binary: A single
+ * entry with the raw records. An empty list at the end of the input. */
+QList<QByteArray> BatchConverter::readChunk(
+    QIODevice *input,
+    const RecordFormat recordFormat
+)
+{
+    QList<QByteArray> result;
+    if (recordFormat == RecordFormat::binary) {
+        // Reading from a pipe might return less data than requested.
+        QByteArray data;
+        QByteArray part;
+        do {
+            part = input->read(chunkSize * binaryRecordSize - data.size());
+            data.append(part);
+        } while (!part.isEmpty() && (data.size() < chunkSize * binaryRecordSize));
+        if (!data.isEmpty()) {
+            result.append(data);
+        }
+        return result;
+    }
+    QByteArray line;
+    while (result.count() < chunkSize) {
+        line = input->readLine();
+        if (line.isEmpty()) {
+            // End of input. (Empty lines within the input are returned
+            // as "\n" by readLine().)
+            break;
+        }
+        if (line.endsWith('\n')) {
+            line.chop(1);
+        }
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        result.append(line);
+    }
+    return result;
+}
+
+}
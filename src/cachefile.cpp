@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/cachefile.h"
+
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+
+namespace PerceptualColor {
+
+namespace {
+
+/** @brief The header at the beginning of each cache file
+ * 
+ * It is followed by the key, padding up to the next multiple of 8 bytes,
+ * and finally the payload. All values are stored in native byte order;
+ * the magic number detects files from machines with another byte
+ * order. */
+struct CacheFileHeader {
+    /** Always cacheFileMagic */
+    quint32 magic;
+    /** CacheFile::formatVersion */
+    quint32 version;
+    /** Size of the key in bytes */
+    quint32 keySize;
+    /** qChecksum() of the payload */
+    quint32 checksum;
+    /** Size of the payload in bytes */
+    quint64 payloadSize;
+};
+static_assert(sizeof(CacheFileHeader) == 24, "Unexpected padding");
+
+/** @brief Magic number at the beginning of each cache file ("PCCF") */
+constexpr quint32 cacheFileMagic = 0x50434346;
+
+/** @brief Offset of the payload within the file
+ * 
+ * @param keySize the size of the key in bytes */
+qint64 payloadOffset(const qint64 keySize)
+{
+    const qint64 end = static_cast<qint64>(sizeof(CacheFileHeader)) + keySize;
+    return (end + 7) / 8 * 8;
+}
+
+/** @brief Checksum of the payload */
+quint32 payloadChecksum(const uchar *data, const qint64 size)
+{
+    return qChecksum(
+        reinterpret_cast<const char *>(data),
+        static_cast<uint>(size)
+    );
+}
+
+}
+
+/** @brief Constructor
+ * 
+ * Opens and validates the cache file. If the file does not exist, or if
+ * its header, key or checksum does not match, isValid() will return
+ * @c false.
+ * 
+ * @param name the name of the cache file, without directory. See
+ * filePath().
+ * @param key the key that must match the key stored in the file */
+CacheFile::CacheFile(const QString &name, const QByteArray &key)
+    : m_file(filePath(name))
+{
+    if (directory().isEmpty() || !m_file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const qint64 offset = payloadOffset(key.size());
+    const qint64 fileSize = m_file.size();
+    if (fileSize < offset) {
+        return;
+    }
+    m_mapping = m_file.map(0, fileSize);
+    if (m_mapping == nullptr) {
+        return;
+    }
+    CacheFileHeader header;
+    std::memcpy(&header, m_mapping, sizeof(CacheFileHeader));
+    if ((header.magic != cacheFileMagic)
+        || (header.version != formatVersion)
+        || (header.keySize != static_cast<quint32>(key.size()))
+        || (header.payloadSize != static_cast<quint64>(fileSize - offset))
+    ) {
+        return;
+    }
+    if (std::memcmp(
+            m_mapping + sizeof(CacheFileHeader),
+            key.constData(),
+            static_cast<size_t>(key.size())
+        ) != 0
+    ) {
+        return;
+    }
+    const uchar *payload = m_mapping + offset;
+    const qint64 payloadSize = fileSize - offset;
+    if (header.checksum != payloadChecksum(payload, payloadSize)) {
+        return;
+    }
+    m_payload = payload;
+    m_payloadSize = payloadSize;
+}
+
+/** @brief Destructor */
+CacheFile::~CacheFile()
+{
+    if (m_mapping != nullptr) {
+        m_file.unmap(m_mapping);
+    }
+}
+
+/** @brief If the file exists and matches the key
+ * 
+ * @returns @c true if payload() can be used */
+bool CacheFile::isValid() const
+{
+    return (m_payload != nullptr);
+}
+
+/** @brief The payload
+ * 
+ * @returns a pointer to the first byte of the payload (aligned to 8 bytes
+ * relative to the beginning of the file, and therefore suitable for
+ * reading qreal values). It is valid as long as this object exists.
+ * @c nullptr if isValid() is @c false. */
+const uchar *CacheFile::payload() const
+{
+    return m_payload;
+}
+
+/** @brief Size of the payload in bytes */
+qint64 CacheFile::payloadSize() const
+{
+    return m_payloadSize;
+}
+
+/** @brief The directory of the cache files
+ * 
+ * @returns a subdirectory of QStandardPaths::CacheLocation, or an empty
+ * string if there is no cache location on this system. */
+QString CacheFile::directory()
+{
+    const QString location = QStandardPaths::writableLocation(
+        QStandardPaths::CacheLocation
+    );
+    if (location.isEmpty()) {
+        return QString();
+    }
+    return location + QStringLiteral("/perceptualcolor");
+}
+
+/** @brief The full path of a cache file
+ * 
+ * @param name the name of the cache file, without directory */
+QString CacheFile::filePath(const QString &name)
+{
+    return directory() + QStringLiteral("/") + name;
+}
+
+/** @brief Writes a cache file
+ * 
+ * An existing file is replaced atomically, so that other processes never
+ * see a partially written file.
+ * 
+ * @param name the name of the cache file, without directory
+ * @param key the key of the cache file
+ * @param payload the data to store
+ * @returns @c true on success. Failure is not critical: The data will
+ * simply be computed again at the next start. */
+bool CacheFile::write(
+    const QString &name,
+    const QByteArray &key,
+    const QByteArray &payload
+)
+{
+    const QString path = directory();
+    if (path.isEmpty() || !QDir().mkpath(path)) {
+        return false;
+    }
+    CacheFileHeader header;
+    header.magic = cacheFileMagic;
+    header.version = formatVersion;
+    header.keySize = static_cast<quint32>(key.size());
+    header.checksum = payloadChecksum(
+        reinterpret_cast<const uchar *>(payload.constData()),
+        payload.size()
+    );
+    header.payloadSize = static_cast<quint64>(payload.size());
+    QByteArray data(reinterpret_cast<const char *>(&header), sizeof(header));
+    data.append(key);
+    data.append(
+        static_cast<int>(payloadOffset(key.size()) - data.size()),
+        '\0'
+    );
+    data.append(payload);
+
+    QSaveFile file(filePath(name));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    if (file.write(data) != data.size()) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+}
@@ -0,0 +1,282 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/cachemanager.h"
+
+#include "PerceptualColor/gamutvolume.h"
+
+#include <QList>
+#include <QMetaObject>
+
+#include <algorithm>
+
+namespace PerceptualColor {
+
+/** @brief Private constructor
+ * 
+ * Use instance() instead. */
+CacheManager::CacheManager() : QObject(nullptr)
+{
+}
+
+/** @brief The library-wide instance
+ * 
+ * @returns the instance. It is created on the first call. */
+CacheManager *CacheManager::instance()
+{
+    static CacheManager manager;
+    return &manager;
+}
+
+/** @brief Maximum total size of all registered caches, in bytes
+ * 
+ * The caches of the widget that has been used most recently are never
+ * released, so the usage might exceed the budget if this widget alone
+ * needs more memory.
+ * 
+ * @returns the budget
+ * @sa setBudget()
+ * @sa defaultBudget */
+qint64 CacheManager::budget() const
+{
+    return m_budget;
+}
+
+/** @brief Setter for budget()
+ * 
+ * If the current usage exceeds the new budget, caches are released
+ * immediately.
+ * 
+ * @param bytes the new budget. Negative values are treated as @c 0. */
+void CacheManager::setBudget(const qint64 bytes)
+{
+    m_budget = qMax<qint64>(bytes, 0);
+    enforceBudget(nullptr);
+}
+
+/** @brief If the caches of a widget are released when it is hidden
+ * 
+ * @returns @c true if the caches are released on hide (default), @c false
+ * if they are only released when the budget is exceeded
+ * @sa setReleaseOnHide() */
+bool CacheManager::releaseOnHide() const
+{
+    return m_releaseOnHide;
+}
+
+/** @brief Setter for releaseOnHide()
+ * 
+ * @param releaseOnHide the new value */
+void CacheManager::setReleaseOnHide(const bool releaseOnHide)
+{
+    m_releaseOnHide = releaseOnHide;
+}
+
+/** @brief Registers a widget
+ * 
+ * Registering a widget that is already registered replaces its functions.
+ * 
+ * @param widget the widget. It is unregistered automatically when it is
+ * destroyed.
+ * @param byteSize returns the current size of the caches of the widget in
+ * bytes
+ * @param release releases the caches of the widget, so that they are
+ * generated again at the next paint event */
+void CacheManager::registerWidget(
+    QWidget *widget,
+    const std::function<qint64()> &byteSize,
+    const std::function<void()> &release
+)
+{
+    if (widget == nullptr) {
+        return;
+    }
+    if (!m_entries.contains(widget)) {
+        connect(
+            widget, &QObject::destroyed,
+            this, [this, widget]() { unregisterWidget(widget); }
+        );
+    }
+    Entry entry;
+    entry.byteSize = byteSize;
+    entry.release = release;
+    entry.lastUse = m_useCounter;
+    m_entries.insert(widget, entry);
+}
+
+/** @brief Unregisters a widget
+ * 
+ * Its caches are not released.
+ * 
+ * @param widget the widget */
+void CacheManager::unregisterWidget(QWidget *widget)
+{
+    if (m_entries.remove(widget) > 0) {
+        disconnect(widget, &QObject::destroyed, this, nullptr);
+    }
+}
+
+/** @brief To be called when a widget has generated its caches
+ * 
+ * Marks the caches of the widget as most recently used. If the budget is
+ * exceeded, the caches of other widgets are released.
+ * 
+ * @param widget the widget */
+void CacheManager::notifyUsed(QWidget *widget)
+{
+    auto iterator = m_entries.find(widget);
+    if (iterator == m_entries.end()) {
+        return;
+    }
+    ++m_useCounter;
+    iterator->lastUse = m_useCounter;
+    m_generations[QString::fromLatin1(widget->metaObject()->className())] += 1;
+    enforceBudget(widget);
+}
+
+/** @brief To be called when a widget is hidden
+ * 
+ * Releases the caches of the widget if releaseOnHide() is @c true.
+ * 
+ * @param widget the widget */
+void CacheManager::notifyHidden(QWidget *widget)
+{
+    if (!m_releaseOnHide) {
+        return;
+    }
+    auto iterator = m_entries.constFind(widget);
+    if (iterator != m_entries.constEnd()) {
+        iterator->release();
+    }
+}
+
+/** @brief Releases the caches of all registered widgets and the shared
+ * volumes of GamutVolume::forColorSpace() */
+void CacheManager::releaseAll()
+{
+    for (const Entry &entry : qAsConst(m_entries)) {
+        entry.release();
+    }
+    GamutVolume::clearCache();
+}
+
+/** @returns the current total size of all registered caches and of the
+ * shared volumes of GamutVolume::forColorSpace(), in bytes */
+qint64 CacheManager::usage() const
+{
+    qint64 result = GamutVolume::cacheByteSize();
+    for (const Entry &entry : m_entries) {
+        result += entry.byteSize();
+    }
+    return result;
+}
+
+/** @brief Current usage per widget type
+ * 
+ * @returns the current size of the registered caches, in bytes, for each
+ * class name (like <tt>PerceptualColor::ChromaHueDiagram</tt>). The shared
+ * volumes of GamutVolume::forColorSpace() are listed as
+ * <tt>PerceptualColor::GamutVolume</tt>. */
+QHash<QString, qint64> CacheManager::usageByType() const
+{
+    QHash<QString, qint64> result;
+    const qint64 volumeBytes = GamutVolume::cacheByteSize();
+    if (volumeBytes > 0) {
+        result.insert(QStringLiteral("PerceptualColor::GamutVolume"), volumeBytes);
+    }
+    for (auto iterator = m_entries.constBegin();
+         iterator != m_entries.constEnd();
+         ++iterator
+    ) {
+        result[QString::fromLatin1(iterator.key()->metaObject()->className())]
+            += iterator->byteSize();
+    }
+    return result;
+}
+
+/** @brief Number of cache generations per widget type
+ * 
+ * Counts the calls of notifyUsed() since the start of the process, also
+ * for widgets that have been destroyed meanwhile. This allows to verify
+ * that no work is done for widgets that are not visible.
+ * 
+ * @returns the number of cache generations for each class name (like
+ * <tt>PerceptualColor::ChromaHueDiagram</tt>) */
+QHash<QString, qint64> CacheManager::generationsByType() const
+{
+    return m_generations;
+}
+
+/** @brief Releases caches until the usage is within the budget
+ * 
+ * The caches of hidden widgets are released first, then the least
+ * recently used ones. The shared volumes of GamutVolume::forColorSpace()
+ * are released last, because they are the most expensive to build.
+ * 
+ * @param keep a widget whose caches are never released, or @c nullptr */
+void CacheManager::enforceBudget(const QWidget *keep)
+{
+    qint64 currentUsage = usage();
+    if (currentUsage <= m_budget) {
+        return;
+    }
+    QList<QWidget *> candidates;
+    for (auto iterator = m_entries.constBegin();
+         iterator != m_entries.constEnd();
+         ++iterator
+    ) {
+        if ((iterator.key() != keep) && (iterator->byteSize() > 0)) {
+            candidates.append(iterator.key());
+        }
+    }
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [this](QWidget *first, QWidget *second) {
+            if (first->isVisible() != second->isVisible()) {
+                return !first->isVisible();
+            }
+            return m_entries.value(first).lastUse
+                < m_entries.value(second).lastUse;
+        }
+    );
+    qint64 sizeBefore;
+    for (QWidget *candidate : qAsConst(candidates)) {
+        if (currentUsage <= m_budget) {
+            return;
+        }
+        const Entry &entry = m_entries[candidate];
+        sizeBefore = entry.byteSize();
+        entry.release();
+        currentUsage -= sizeBefore - entry.byteSize();
+    }
+    if (currentUsage > m_budget) {
+        GamutVolume::clearCache();
+    }
+}
+
+}
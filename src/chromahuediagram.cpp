@@ -27,15 +27,18 @@
 // Own header
 #include "PerceptualColor/chromahuediagram.h"
 
+#include "PerceptualColor/cachemanager.h"
 #include "PerceptualColor/helper.h"
 #include "PerceptualColor/polarpointf.h"
 #include <PerceptualColor/simplecolorwheel.h>
 
 #include <math.h>
 
+#include <QBitArray>
 #include <QDebug>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QVector>
 #include <QtMath>
 
 #include <lcms2.h>
@@ -73,6 +76,41 @@ ChromaHueDiagram::ChromaHueDiagram(RgbColorSpace *colorSpace, QWidget *parent) :
     // Focus by mouse click is handeled manually by mousePressEvent().
     setFocusPolicy(Qt::FocusPolicy::TabFocus);
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+    // Resize debouncing
+    m_resizeTimer.setSingleShot(true);
+    m_resizeTimer.setInterval(Helper::resizeDebounceInterval);
+    connect(
+        &m_resizeTimer, &QTimer::timeout,
+        this, QOverload<>::of(&QWidget::update)
+    );
+
+    // Memory budget
+    CacheManager::instance()->registerWidget(
+        this,
+        [this]() -> qint64 {
+            return m_diagramImage.sizeInBytes()
+                + m_diagramOutOfGamutMask.size() / 8
+                + m_wheelImage.sizeInBytes();
+        },
+        [this]() {
+            m_diagramImage = QImage();
+            m_diagramOutOfGamutMask.clear();
+            m_diagramCacheReady = false;
+            m_wheelImage = QImage();
+            m_wheelCacheReady = false;
+        }
+    );
+}
+
+/** @brief Destructor
+ * 
+ * Unregisters the caches from CacheManager. This cannot wait for the
+ * @c destroyed() signal, because when it is emitted, the members that
+ * the callbacks of CacheManager access are already destroyed. */
+ChromaHueDiagram::~ChromaHueDiagram()
+{
+    CacheManager::instance()->unregisterWidget(this);
 }
 
 /** @brief Updates the border() property.
@@ -86,12 +124,6 @@ void ChromaHueDiagram::updateBorder()
     m_border = 8 * m_markerThickness;
 }
 
-// TODO It might be better (here and in the other classes) that when cache is invalidated, the images are
-// deleted to free memory. We could just set them to an invalid QImage(). The problem is this would be
-// identical to a valid 0-size image, which could then lead to unexpected results (recursion...)...?
-
-// TODO high-dpi support
-
 // TODO automatically scale marker radius and thickness with widget size
 
 // TODO reasonable boundary for markerWidth and markerRadius and minimumSizeHint: How to make sure the diagram has at least a few pixels? And if it's very low: For precision wouldn't it be better to internally calculate with a higher-resolution pixmap for more precision? Alternative: for the border() property: better quint16? No, that's not a good idea...
@@ -245,7 +277,19 @@ void ChromaHueDiagram::paintEvent(QPaintEvent* event)
     //       the platform independent QImage as paint device; i.e. using QImage
     //       will ensure that the result has an identical pixel representation
     //       on any platform.”
-    QImage paintBuffer(m_diameter, m_diameter, QImage::Format_ARGB32);
+    //
+    // On high-dpi screens, the buffer has the native resolution of the
+    // screen (within the render-cost budget), and QPainter works on it
+    // with logical coordinates.
+    const qreal ratio = Helper::cacheDevicePixelRatio(
+        this,
+        QSize(m_diameter, m_diameter)
+    );
+    QImage paintBuffer(
+        QSize(m_diameter, m_diameter) * ratio,
+        QImage::Format_ARGB32
+    );
+    paintBuffer.setDevicePixelRatio(ratio);
     paintBuffer.fill(Qt::transparent);
     QPainter painter(&paintBuffer);
 
@@ -268,17 +312,33 @@ void ChromaHueDiagram::paintEvent(QPaintEvent* event)
         m_diameter - 2 * m_border       // height
     );
     painter.setRenderHint(QPainter::Antialiasing, false);
-    // Paint the diagram itself as available in the cache.
-    updateDiagramCache();
-    painter.drawImage(0, 0, m_diagramImage);
+    // Paint the diagram itself as available in the cache. While the
+    // widget is being resized, the previous cache is scaled to the new
+    // geometry instead of regenerating it.
+    const bool useStaleCache = m_resizeTimer.isActive()
+        && !m_diagramImage.isNull()
+        && !m_wheelImage.isNull();
+    const QRectF diagramRect(0, 0, m_diameter, m_diameter);
+    if (useStaleCache) {
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.drawImage(diagramRect, m_diagramImage);
+    } else {
+        updateDiagramCache();
+        painter.drawImage(0, 0, m_diagramImage);
+    }
 
     // Paint a thin color wheel for better orientation
-    updateWheelCache();
-    painter.drawImage(
-        0,
-        0,
-        m_wheelImage
-    );
+    if (useStaleCache) {
+        painter.drawImage(diagramRect, m_wheelImage);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    } else {
+        updateWheelCache();
+        painter.drawImage(
+            0,
+            0,
+            m_wheelImage
+        );
+    }
 
     // paint also an additional marker indicating the hue
     if (m_mouseEventActive) {
@@ -507,18 +567,21 @@ QPoint ChromaHueDiagram::currentImageCoordinates()
  */
 bool ChromaHueDiagram::imageCoordinatesInGamut(const QPoint imageCoordinates)
 {
-    // variables
-    bool temp;
-    QColor diagramPixelColor;
-
-    // code
     updateDiagramCache();
-    temp = false;
-    if (m_diagramImage.valid(imageCoordinates)) {
-        diagramPixelColor = m_diagramImage.pixelColor(imageCoordinates);
-        temp = ((diagramPixelColor.alpha() != 0));
+    // The image coordinates are logical pixels, but the diagram image
+    // might have a higher resolution. Test the device pixel at the
+    // center of the logical pixel.
+    const qreal ratio = m_diagramImage.devicePixelRatio();
+    const QPoint devicePixel(
+        qFloor((imageCoordinates.x() + 0.5) * ratio),
+        qFloor((imageCoordinates.y() + 0.5) * ratio)
+    );
+    if (!m_diagramImage.valid(devicePixel)) {
+        return false;
     }
-    return temp;
+    return !m_diagramOutOfGamutMask.testBit(
+        devicePixel.y() * m_diagramImage.width() + devicePixel.x()
+    );
 }
 
 qreal ChromaHueDiagram::lightness() const
@@ -572,6 +635,21 @@ void ChromaHueDiagram::setColor(const FullColorDescription &newColor)
     Q_EMIT colorChanged(newColor);
 }
 
+/** @brief React on a hide event.
+ * 
+ * Reimplemented from base class.
+ * 
+ * Releases the caches by means of CacheManager, so that hidden widgets do
+ * not occupy memory.
+ * 
+ * @param event the hide event
+ */
+void ChromaHueDiagram::hideEvent(QHideEvent *event)
+{
+    CacheManager::instance()->notifyHidden(this);
+    QWidget::hideEvent(event);
+}
+
 /** @brief React on a resive event.
  *
  * Reimplemented from base class.
@@ -597,6 +675,7 @@ void ChromaHueDiagram::resizeEvent(QResizeEvent* event)
         m_diagramOffset = (m_diameter - 1) / 2;
         m_diagramCacheReady = false;
         m_wheelCacheReady = false;
+        m_resizeTimer.start();
         // As by Qt documentation: The widget will be erased and receive a paint event immediately after processing the resize event. No drawing need be (or should be) done inside this handler.
     }
 }
@@ -704,16 +783,40 @@ FullColorDescription ChromaHueDiagram::color() const
     return m_color;
 }
 
-/** @brief in image of a-b plane of the color space at a given lightness */
+/** @brief in image of a-b plane of the color space at a given lightness
+ * 
+ * This function does not need a widget instance and is thread-safe.
+ * 
+ * @param colorSpace the color space
+ * @param imageSize the width and the height of the (square) image
+ * @param maxChroma the chroma that is displayed at the border of the circle
+ * @param lightness the (LCh) lightness of the image
+ * @param border the border between the image border and the circle
+ * @param precision the precision of the color transforms
+ * @param outOfGamutMask If not a null pointer, this bit array is resized
+ * to <tt>imageSize * imageSize</tt> bits, one for each pixel, row by row.
+ * A bit is set for pixels that are out-of-gamut or outside the circle.
+ * @param gamutVolume If not a null pointer, this volume of the color space
+ * is used to skip the transforms of colors that are clearly out-of-gamut.
+ * The result is the same. See GamutVolume::renderScanLine().
+ * @returns A square image. Everything outside the circle is transparent;
+ * out-of-gamut colors inside the circle also. The border of the circle
+ * and the gamut boundary are anti-aliased. */
 QImage ChromaHueDiagram::generateDiagramImage(
     const RgbColorSpace *colorSpace,
     const int imageSize,
     const int maxChroma,
     const qreal lightness,
-    const int border
+    const int border,
+    const RgbColorSpace::TransformPrecision precision,
+    QBitArray *outOfGamutMask,
+    const GamutVolume *gamutVolume
 )
 {
     int maxIndex = imageSize - 1;
+    if (outOfGamutMask != nullptr) {
+        outOfGamutMask->fill(true, qMax(imageSize, 0) * qMax(imageSize, 0));
+    }
     // Test if image size is too small.
     if (maxIndex < 1) {
         // maxIndex must be at least >= 1 for our algorithm. If they are 0, this would crash (division by 0). // TODO how to solve this?
@@ -721,48 +824,116 @@ QImage ChromaHueDiagram::generateDiagramImage(
     }
     
     // Setup
-    cmsCIELab lab; // uses cmsFloat64Number internally
     int x;
     int y;
-    QColor tempColor;
-    QImage tempImage = QImage(
+    QImage result = QImage(
         QSize(imageSize, imageSize),
         QImage::Format_ARGB32
     );
-    tempImage.fill(Qt::transparent); // Initialize the image with transparency
+    result.fill(Qt::transparent); // Initialize the image with transparency
+    if (imageSize - 2 * border < 1) {
+        return result;
+    }
     const qreal scaleFactor = static_cast<qreal>(2 * maxChroma) / (imageSize - 2 * border);
-
-    // Paint the gamut.
-    lab.L = lightness;
-    for (y = border; y <= maxIndex - border; ++y) {
-        lab.b = maxChroma - (y - border) * scaleFactor; // floating point division thanks to static_cast to cmsFloat64Number
-        for (x = border; x <= maxIndex - border; ++x) {
-            lab.a = (x - border) * scaleFactor - maxChroma;
-            tempColor = colorSpace->colorRgb(lab);
-            if (tempColor.isValid()) {
-                // The pixel is within the gamut
-                tempImage.setPixelColor(x, y, tempColor);
-            }
+    const qreal center = imageSize / static_cast<qreal>(2);
+    const qreal radius = (imageSize - 2 * border) / static_cast<qreal>(2);
+    // Pixels outside the circle are not rendered. They are marked in the
+    // mask so that antialiasGamutBoundary() ignores them.
+    constexpr quint8 notRendered = 2;
+    QVector<quint8> mask(imageSize * imageSize, notRendered);
+    QVector<int> spanBegin(imageSize, 0);
+    QVector<int> spanEnd(imageSize, -1);
+
+    // Paint the gamut. Only the pixels that are at least partially
+    // covered by the circle are rendered. Within a row, a* grows by a
+    // constant step, so the Lab values are generated incrementally
+    // during the transform.
+    cmsCIELab first; // uses cmsFloat64Number internally
+    cmsCIELab step;
+    first.L = lightness;
+    step.L = 0;
+    step.a = scaleFactor;
+    step.b = 0;
+    qreal deltaY;
+    qreal halfWidth;
+    int count;
+    QRgb *scanLine;
+    for (y = 0; y <= maxIndex; ++y) {
+        deltaY = y + 0.5 - center;
+        if (qAbs(deltaY) >= radius + 0.5) {
+            continue;
+        }
+        halfWidth = qSqrt(qPow(radius + 0.5, 2) - qPow(deltaY, 2));
+        spanBegin[y] = qMax(0, qFloor(center - halfWidth - 0.5));
+        spanEnd[y] = qMin(maxIndex, qCeil(center + halfWidth - 0.5));
+        count = spanEnd.at(y) - spanBegin.at(y) + 1;
+        first.a = (spanBegin.at(y) - border) * scaleFactor - maxChroma;
+        first.b = maxChroma - (y - border) * scaleFactor; // floating point division thanks to static_cast to cmsFloat64Number
+        scanLine = reinterpret_cast<QRgb *>(result.scanLine(y)) + spanBegin.at(y);
+        if (gamutVolume == nullptr) {
+            colorSpace->colorRgbScanLine(
+                first,
+                step,
+                scanLine,
+                count,
+                precision,
+                mask.data() + y * imageSize + spanBegin.at(y)
+            );
+        } else {
+            gamutVolume->renderScanLine(
+                colorSpace,
+                first,
+                step,
+                scanLine,
+                count,
+                precision,
+                mask.data() + y * imageSize + spanBegin.at(y)
+            );
         }
     }
 
-    QImage result = QImage(
-        QSize(imageSize, imageSize),
-        QImage::Format_ARGB32
-    );
-    result.fill(Qt::transparent);
-    // Cut of everything outside the circle
-    QPainter myPainter(&result);
-    myPainter.setRenderHint(QPainter::Antialiasing, true);
-    myPainter.setPen(QPen(Qt::NoPen));
-    myPainter.setBrush(QBrush(tempImage));
-    myPainter.drawEllipse(
-        border, // x
-        border, // y
-        imageSize - 2 * border,      // width
-        imageSize - 2 * border       // height
+    // Anti-aliasing of the gamut boundary
+    colorSpace->antialiasGamutBoundary(
+        &result,
+        mask,
+        [lightness, border, scaleFactor, maxChroma](const qreal x, const qreal y) {
+            cmsCIELab Lab;
+            Lab.L = lightness;
+            Lab.a = (x - border) * scaleFactor - maxChroma;
+            Lab.b = maxChroma - (y - border) * scaleFactor;
+            return Lab;
+        },
+        precision
     );
 
+    // Anti-aliasing of the circle: The analytic coverage is applied to
+    // the alpha channel.
+    qreal distance;
+    qreal coverage;
+    QRgb pixel;
+    for (y = 0; y <= maxIndex; ++y) {
+        scanLine = reinterpret_cast<QRgb *>(result.scanLine(y));
+        for (x = spanBegin.at(y); x <= spanEnd.at(y); ++x) {
+            distance = qSqrt(qPow(x + 0.5 - center, 2) + qPow(y + 0.5 - center, 2));
+            coverage = Helper::discCoverage(distance, radius);
+            if (coverage < 1) {
+                pixel = scanLine[x];
+                scanLine[x] = qRgba(
+                    qRed(pixel),
+                    qGreen(pixel),
+                    qBlue(pixel),
+                    qRound(qAlpha(pixel) * coverage)
+                );
+            }
+            if ((outOfGamutMask != nullptr) &&
+                (mask.at(y * imageSize + x) == 0) &&
+                (distance <= radius)
+            ) {
+                outOfGamutMask->clearBit(y * imageSize + x);
+            }
+        }
+    }
+
     return result;
 }
 
@@ -770,6 +941,7 @@ QImage ChromaHueDiagram::generateDiagramImage(
  * 
  * This class has a cache of various data related to the diagram
  * - @ref m_diagramImage
+ * - @ref m_diagramOutOfGamutMask
  * 
  * This data is cached because it is often needed and it would be expensive to calculate it
  * again and again on the fly.
@@ -782,21 +954,35 @@ QImage ChromaHueDiagram::generateDiagramImage(
  */
 void ChromaHueDiagram::updateDiagramCache()
 {
-    if (m_diagramCacheReady) {
+    const qreal ratio = Helper::cacheDevicePixelRatio(
+        this,
+        QSize(m_diameter, m_diameter)
+    );
+    // The device pixel ratio changes when the widget is moved to another
+    // screen.
+    if (m_diagramCacheReady && (m_diagramImage.devicePixelRatio() == ratio)) {
         return;
     }
 
-    // Update QImage
+    // Update QImage. Until the gamut volume has been built in the
+    // background, the image is rendered without it.
+    const QSharedPointer<const GamutVolume> gamutVolume =
+        m_rgbColorSpace->gamutVolume();
     m_diagramImage = generateDiagramImage(
         m_rgbColorSpace,
-        m_diameter,
+        qRound(m_diameter * ratio),
         m_maxChroma,
         m_color.toLch().L,
-        m_border
+        qRound(m_border * ratio),
+        RgbColorSpace::TransformPrecision::float32,
+        &m_diagramOutOfGamutMask,
+        gamutVolume.data()
     );
+    m_diagramImage.setDevicePixelRatio(ratio);
 
     // Mark cache as ready
     m_diagramCacheReady = true;
+    CacheManager::instance()->notifyUsed(this);
 }
 
 /** @brief Refresh the wheel and associated data
@@ -815,22 +1001,28 @@ void ChromaHueDiagram::updateDiagramCache()
  */
 void ChromaHueDiagram::updateWheelCache()
 {
-    if (m_wheelCacheReady) {
+    const qreal ratio = Helper::cacheDevicePixelRatio(
+        this,
+        QSize(m_diameter, m_diameter)
+    );
+    if (m_wheelCacheReady && (m_wheelImage.devicePixelRatio() == ratio)) {
         return;
     }
 
     // Update QImage
     m_wheelImage = SimpleColorWheel::generateWheelImage(
         m_rgbColorSpace,
-        m_diameter,                                 // diameter
-        2 * m_markerThickness,                      // border
-        4 * m_markerThickness,                      // thickness
+        qRound(m_diameter * ratio),                 // diameter
+        qRound(2 * m_markerThickness * ratio),      // border
+        qRound(4 * m_markerThickness * ratio),      // thickness
         Helper::LchBoundaries::defaultLightness,    // lightness
         Helper::LchBoundaries::versatileSrgbChroma      // chroma
     );
+    m_wheelImage.setDevicePixelRatio(ratio);
 
     // Mark cache as ready
     m_wheelCacheReady = true;
+    CacheManager::instance()->notifyUsed(this);
 }
 
 }
@@ -27,14 +27,17 @@
 // Own header
 #include "PerceptualColor/chromalightnessdiagram.h"
 
+#include "PerceptualColor/cachemanager.h"
 #include "PerceptualColor/helper.h"
 #include "PerceptualColor/polarpointf.h"
 
 #include <math.h>
 
+#include <QBitArray>
 #include <QDebug>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QVector>
 #include <QtMath>
 
 #include <lcms2.h>
@@ -72,6 +75,38 @@ ChromaLightnessDiagram::ChromaLightnessDiagram(RgbColorSpace *colorSpace, QWidge
     // Focus by mouse click is handeled manually by mousePressEvent().
     setFocusPolicy(Qt::FocusPolicy::TabFocus);
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+    // Resize debouncing
+    m_resizeTimer.setSingleShot(true);
+    m_resizeTimer.setInterval(Helper::resizeDebounceInterval);
+    connect(
+        &m_resizeTimer, &QTimer::timeout,
+        this, QOverload<>::of(&QWidget::update)
+    );
+
+    // Memory budget
+    CacheManager::instance()->registerWidget(
+        this,
+        [this]() -> qint64 {
+            return m_diagramImage.sizeInBytes()
+                + m_diagramOutOfGamutMask.size() / 8;
+        },
+        [this]() {
+            m_diagramImage = QImage();
+            m_diagramOutOfGamutMask.clear();
+            m_diagramCacheReady = false;
+        }
+    );
+}
+
+/** @brief Destructor
+ * 
+ * Unregisters the caches from CacheManager. This cannot wait for the
+ * @c destroyed() signal, because when it is emitted, the members that
+ * the callbacks of CacheManager access are already destroyed. */
+ChromaLightnessDiagram::~ChromaLightnessDiagram()
+{
+    CacheManager::instance()->unregisterWidget(this);
 }
 
 /** @brief Updates the border() property.
@@ -85,8 +120,6 @@ void ChromaLightnessDiagram::updateBorder()
     m_border = qRound(m_markerRadius + (m_markerThickness / static_cast<qreal>(2)));
 }
 
-// TODO high-dpi support
-
 // TODO automatically scale marker radius and thickness with widget size
 
 // TODO reasonable boundary for markerWidth and markerRadius and minimumSizeHint: How to make sure the diagram has at least a few pixels? And if it's very low: For precision wouldn't it be better to internally calculate with a higher-resolution pixmap for more precision? Alternative: for the border() property: better quint16? No, that's not a good idea...
@@ -101,14 +134,45 @@ void ChromaLightnessDiagram::updateBorder()
  * \post If the coordinates are within the gamut diagram, then
  * the corresponding values are set. If the coordinates
  * are outside the gamut diagram, then a nearest-neigbbour-search is done,
- * searching for the pixel that is less far from the cursor.
+ * searching for the pixel that is less far from the cursor. (If the
+ * diagram cache is outdated, it is not generated for this search; instead,
+ * the chroma is reduced until the color is in-gamut.)
  */
 void ChromaLightnessDiagram::setImageCoordinates(const QPoint newImageCoordinates)
 {
-    updateDiagramCache();
-    QPoint correctedImageCoordinates = Helper::nearestNeighborSearch(newImageCoordinates, m_diagramImage);
     QPointF chromaLightness;
     cmsCIELCh lch;
+    if (!m_diagramCacheReady) {
+        // The cache is only generated in paintEvent(). Until then, the
+        // chroma is reduced to the gamut boundary with LittleCMS.
+        chromaLightness = fromImageCoordinatesToChromaLightness(newImageCoordinates);
+        lch.L = qBound<cmsFloat64Number>(0, chromaLightness.y(), 100);
+        lch.C = qMax<cmsFloat64Number>(0, chromaLightness.x());
+        lch.h = m_color.toLch().h;
+        lch.C = qMax<cmsFloat64Number>(0, m_rgbColorSpace->boundaryChroma(lch));
+        setColor(
+            FullColorDescription(
+                m_rgbColorSpace,
+                lch,
+                FullColorDescription::outOfGamutBehaviour::preserve
+            )
+        );
+        return;
+    }
+    // The search is done on the device pixels of the diagram image, which
+    // might have a higher resolution than the image coordinates.
+    const qreal ratio = m_diagramImage.devicePixelRatio();
+    const QPoint correctedDevicePixel = Helper::nearestNeighborSearch(
+        QPoint(
+            qFloor((newImageCoordinates.x() + 0.5) * ratio),
+            qFloor((newImageCoordinates.y() + 0.5) * ratio)
+        ),
+        m_diagramImage
+    );
+    QPoint correctedImageCoordinates(
+        qFloor(correctedDevicePixel.x() / ratio),
+        qFloor(correctedDevicePixel.y() / ratio)
+    );
     if (correctedImageCoordinates != currentImageCoordinates()) {
         chromaLightness = fromImageCoordinatesToChromaLightness(correctedImageCoordinates);
         lch.C = chromaLightness.x();
@@ -247,15 +311,32 @@ void ChromaLightnessDiagram::paintEvent(QPaintEvent* event)
     //       the platform independent QImage as paint device; i.e. using QImage
     //       will ensure that the result has an identical pixel representation
     //       on any platform.”
-    QImage paintBuffer(size(), QImage::Format_ARGB32);
+    //
+    // On high-dpi screens, the buffer has the native resolution of the
+    // screen (within the render-cost budget), and QPainter works on it
+    // with logical coordinates.
+    const qreal ratio = Helper::cacheDevicePixelRatio(this, size());
+    QImage paintBuffer(size() * ratio, QImage::Format_ARGB32);
+    paintBuffer.setDevicePixelRatio(ratio);
     paintBuffer.fill(Qt::transparent);
     QPainter painter(&paintBuffer);
 
     QPen pen;
 
-    // Paint the diagram itself as available in the cache.
-    updateDiagramCache();
-    painter.drawImage(m_border, m_border, m_diagramImage);
+    // Paint the diagram itself as available in the cache. While the
+    // widget is being resized, the previous cache is scaled to the new
+    // geometry instead of regenerating it.
+    if (m_resizeTimer.isActive() && !m_diagramImage.isNull()) {
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.drawImage(
+            QRectF(QPointF(m_border, m_border), diagramSize()),
+            m_diagramImage
+        );
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    } else {
+        updateDiagramCache();
+        painter.drawImage(m_border, m_border, m_diagramImage);
+    }
 
     /* Paint a focus indicator.
      * 
@@ -367,7 +448,6 @@ void ChromaLightnessDiagram::keyPressEvent(QKeyEvent *event)
     // values, not in pixel. And the same values accross all widgets!
     
     QPoint newImageCoordinates = currentImageCoordinates();
-    updateDiagramCache();
     switch (event->key()) {
         case Qt::Key_Up: 
             if (imageCoordinatesInGamut(newImageCoordinates + QPoint(0, -1))) {
@@ -396,7 +476,7 @@ void ChromaLightnessDiagram::keyPressEvent(QKeyEvent *event)
             }
             break;
         case Qt::Key_PageDown:
-            newImageCoordinates.setY(m_diagramImage.height() - 1);
+            newImageCoordinates.setY(diagramSize().height() - 1);
             while (!imageCoordinatesInGamut(newImageCoordinates + QPoint(0, -1))) {
                 newImageCoordinates += QPoint(0, -1);
             }
@@ -408,7 +488,7 @@ void ChromaLightnessDiagram::keyPressEvent(QKeyEvent *event)
             }
             break;
         case Qt::Key_End:
-            newImageCoordinates.setX(m_diagramImage.width() - 1);
+            newImageCoordinates.setX(diagramSize().width() - 1);
             while (!imageCoordinatesInGamut(newImageCoordinates + QPoint(-1, 0))) {
                 newImageCoordinates += QPoint(-1, 0);
             }
@@ -438,10 +518,9 @@ void ChromaLightnessDiagram::keyPressEvent(QKeyEvent *event)
  */
 QPointF ChromaLightnessDiagram::fromImageCoordinatesToChromaLightness(const QPoint imageCoordinates)
 {
-    updateDiagramCache();
     return QPointF(
-        static_cast<qreal>(imageCoordinates.x()) * 100 / (m_diagramImage.height() - 1),
-        static_cast<qreal>(imageCoordinates.y()) * 100 / (m_diagramImage.height() - 1) * (-1) + 100
+        static_cast<qreal>(imageCoordinates.x()) * 100 / (diagramSize().height() - 1),
+        static_cast<qreal>(imageCoordinates.y()) * 100 / (diagramSize().height() - 1) * (-1) + 100
     );
 }
 
@@ -450,30 +529,57 @@ QPointF ChromaLightnessDiagram::fromImageCoordinatesToChromaLightness(const QPoi
  */
 QPoint ChromaLightnessDiagram::currentImageCoordinates()
 {
-    updateDiagramCache();
     return QPoint(
-        qRound(m_color.toLch().C * (m_diagramImage.height() - 1) / 100),
-        qRound(m_color.toLch().L * (m_diagramImage.height() - 1) / 100 * (-1) + (m_diagramImage.height() - 1))
+        qRound(m_color.toLch().C * (diagramSize().height() - 1) / 100),
+        qRound(m_color.toLch().L * (diagramSize().height() - 1) / 100 * (-1) + (diagramSize().height() - 1))
     );
 }
 
+/** @brief The size of the diagram in logical pixels
+ * 
+ * The image coordinates are expressed in this size, even if
+ * @ref m_diagramImage has a higher resolution on high-dpi screens or
+ * is outdated while the widget is being resized.
+ * 
+ * @returns the widget size without the border */
+QSize ChromaLightnessDiagram::diagramSize() const
+{
+    return QSize(size().width() - 2 * m_border, size().height() - 2 * m_border);
+}
+
 /** @brief Tests if image coordinates are in gamut.
  *  @returns @c true if the image coordinates are within the displayed gamut. Otherwise @c false.
  */
 bool ChromaLightnessDiagram::imageCoordinatesInGamut(const QPoint imageCoordinates)
 {
-    // variables
-    bool temp;
-    QColor diagramPixelColor;
-
-    // code
-    updateDiagramCache();
-    temp = false;
-    if (m_diagramImage.valid(imageCoordinates)) {
-        diagramPixelColor = m_diagramImage.pixelColor(imageCoordinates);
-        temp = ((diagramPixelColor.alpha() != 0));
+    if (!m_diagramCacheReady) {
+        // The cache is only generated in paintEvent(). Until then, the
+        // test is done with LittleCMS.
+        if (!QRect(QPoint(0, 0), diagramSize()).contains(imageCoordinates)) {
+            return false;
+        }
+        const QPointF chromaLightness =
+            fromImageCoordinatesToChromaLightness(imageCoordinates);
+        return m_rgbColorSpace->inGamut(
+            chromaLightness.y(),
+            chromaLightness.x(),
+            m_color.toLch().h
+        );
+    }
+    // The image coordinates are logical pixels, but the diagram image
+    // might have a higher resolution. Test the device pixel at the
+    // center of the logical pixel.
+    const qreal ratio = m_diagramImage.devicePixelRatio();
+    const QPoint devicePixel(
+        qFloor((imageCoordinates.x() + 0.5) * ratio),
+        qFloor((imageCoordinates.y() + 0.5) * ratio)
+    );
+    if (!m_diagramImage.valid(devicePixel)) {
+        return false;
     }
-    return temp;
+    return !m_diagramOutOfGamutMask.testBit(
+        devicePixel.y() * m_diagramImage.width() + devicePixel.x()
+    );
 }
 
 qreal ChromaLightnessDiagram::hue() const
@@ -525,6 +631,21 @@ void ChromaLightnessDiagram::setColor(const FullColorDescription &newColor)
     Q_EMIT colorChanged(newColor);
 }
 
+/** @brief React on a hide event.
+ * 
+ * Reimplemented from base class.
+ * 
+ * Releases the caches by means of CacheManager, so that hidden widgets do
+ * not occupy memory.
+ * 
+ * @param event the hide event
+ */
+void ChromaLightnessDiagram::hideEvent(QHideEvent *event)
+{
+    CacheManager::instance()->notifyHidden(this);
+    QWidget::hideEvent(event);
+}
+
 /** @brief React on a resive event.
  *
  * Reimplemented from base class.
@@ -534,6 +655,7 @@ void ChromaLightnessDiagram::setColor(const FullColorDescription &newColor)
 void ChromaLightnessDiagram::resizeEvent(QResizeEvent* event)
 {
     m_diagramCacheReady = false;
+    m_resizeTimer.start();
     // As by Qt documentation: The widget will be erased and receive a paint event immediately after processing the resize event. No drawing need be (or should be) done inside this handler.
 }
 
@@ -644,15 +766,21 @@ FullColorDescription ChromaLightnessDiagram::color() const
 /** @brief Generates an image of a chroma-lightness diagram.
  * 
  * This function generates images of chroma-lightness diagrams in the Lch color space.
- * This function should be thread-save as long as you do not use the same LittleCMS
- * transform from different threads. (Also, out of the Qt library, it uses only QImage,
- * and not QPixmap, to make sure the result can be passed around between threads.)
+ * It does not need a widget instance. It is thread-safe: The color space is
+ * only used through its const, floating point conversions. (Also, out of the
+ * Qt library, it uses only QImage, and not QPixmap, to make sure the result
+ * can be passed around between threads.)
  * 
+ * @param colorSpace the color space
  * @param imageHue the (Lch) hue of the image
  * @param imageSize the size of the requested image
- * @param colorTransform the LittleCMS color transform to use. The input profile must be based on
- * cmsCreateLab4ProfileTHR() or cmsCreateLab4Profile(). The output profile must be an RGB
- * profile.
+ * @param precision the precision of the color transforms
+ * @param outOfGamutMask If not a null pointer, this bit array is resized
+ * to one bit for each pixel, row by row. A bit is set for pixels that
+ * are out-of-gamut.
+ * @param gamutVolume If not a null pointer, this volume of the color space
+ * is used to skip the transforms of colors that are clearly out-of-gamut.
+ * The result is the same. See GamutVolume::renderScanLine().
  * @returns A chroma-lightness diagram for the given hue. For the y axis, its heigth covers
  * the lightness range 0..100. [Pixel (0) corresponds to value 100. Pixel (height-1) corresponds
  * to value 0.] Its x axis uses always the same scale as the y axis. So if the size
@@ -661,17 +789,26 @@ FullColorDescription ChromaLightnessDiagram::color() const
  * the Lch values that are within the gamut of the RGB profile. All other values are
  * Qt::transparent. Intentionally there is no anti-aliasing.
  */
-QImage ChromaLightnessDiagram::diagramImage(
-        const qreal imageHue,
-        const QSize imageSize) const
+QImage ChromaLightnessDiagram::generateDiagramImage(
+    const RgbColorSpace *colorSpace,
+    const qreal imageHue,
+    const QSize imageSize,
+    const RgbColorSpace::TransformPrecision precision,
+    QBitArray *outOfGamutMask,
+    const GamutVolume *gamutVolume
+)
 {
-    cmsCIELCh LCh; // uses cmsFloat64Number internally
-    QColor rgbColor;
     int x;
     int y;
     QImage temp_image = QImage(imageSize, QImage::Format_ARGB32);
     const int maxHeight = imageSize.height() - 1;
     const int maxWidth = imageSize.width() - 1;
+    if (outOfGamutMask != nullptr) {
+        outOfGamutMask->fill(
+            true,
+            qMax(imageSize.width(), 0) * qMax(imageSize.height(), 0)
+        );
+    }
     
     // Test if image size is too small.
     if ((maxHeight < 1) || (maxWidth < 1)) {
@@ -683,32 +820,58 @@ QImage ChromaLightnessDiagram::diagramImage(
     // Initialize the image with transparency.
     temp_image.fill(Qt::transparent);
 
-    // Paint the gamut.
-    LCh.h = PolarPointF::normalizedAngleDegree(imageHue);
+    // Paint the gamut. Within a row, chroma grows by a constant step. At
+    // constant hue, this is also a constant step of a* and b*, so the Lab
+    // values are generated incrementally during the transform.
+    /* If color is out-of-gamut: We have chroma on the x axis and
+    * lightness on the y axis. We are drawing the pixmap line per
+    * line, so we go for given lightness from low chroma to high
+    * chroma. Because of the nature of most gamuts, if once in a
+    * line we have an out-of-gamut value, all other pixels that
+    * are more at the right will be out-of-gamut also. So we
+    * could optimize our code and break here. But as we are not
+    * sure about this (we do not know the gamut at compile time)
+    * for the moment we do not optimize the code.
+    */
+    cmsCIELCh stepLCh; // uses cmsFloat64Number internally
+    stepLCh.L = 0;
+    // Using the same scale as on the y axis. floating point
+    // division thanks to 100 which is a "cmsFloat64Number"
+    stepLCh.C = static_cast<cmsFloat64Number>(100) / maxHeight;
+    stepLCh.h = PolarPointF::normalizedAngleDegree(imageHue);
+    cmsCIELab step; // uses cmsFloat64Number internally
+    cmsLCh2Lab(&step, &stepLCh);
+    cmsCIELab first;
+    first.a = 0;
+    first.b = 0;
+    QVector<quint8> rowMask(maxWidth + 1);
     for (y = 0; y <= maxHeight; ++y) {
-        LCh.L = y * static_cast<cmsFloat64Number>(100) / maxHeight; // floating point division thanks to 100 which is a "cmsFloat64Number"
-        for (x = 0; x <= maxWidth; ++x) {
-            // Using the same scale as on the y axis. floating point
-            // division thanks to 100 which is a "cmsFloat64Number"
-            LCh.C = x * static_cast<cmsFloat64Number>(100) / maxHeight;
-            rgbColor = m_rgbColorSpace->colorRgb(LCh);
-            if (rgbColor.isValid()) {
-                // The pixel is within the gamut
-                temp_image.setPixelColor(
-                    x,
-                    maxHeight - y,
-                    rgbColor
-                );
-                /* If color is out-of-gamut: We have chroma on the x axis and
-                * lightness on the y axis. We are drawing the pixmap line per
-                * line, so we go for given lightness from low chroma to high
-                * chroma. Because of the nature of most gamuts, if once in a
-                * line we have an out-of-gamut value, all other pixels that
-                * are more at the right will be out-of-gamut also. So we
-                * could optimize our code and break here. But as we are not
-                * sure about this (we do not know the gamut at compile time)
-                * for the moment we do not optimize the code.
-                */
+        first.L = y * static_cast<cmsFloat64Number>(100) / maxHeight; // floating point division thanks to 100 which is a "cmsFloat64Number"
+        if (gamutVolume == nullptr) {
+            colorSpace->colorRgbScanLine(
+                first,
+                step,
+                reinterpret_cast<QRgb *>(temp_image.scanLine(maxHeight - y)),
+                maxWidth + 1,
+                precision,
+                rowMask.data()
+            );
+        } else {
+            gamutVolume->renderScanLine(
+                colorSpace,
+                first,
+                step,
+                reinterpret_cast<QRgb *>(temp_image.scanLine(maxHeight - y)),
+                maxWidth + 1,
+                precision,
+                rowMask.data()
+            );
+        }
+        if (outOfGamutMask != nullptr) {
+            for (x = 0; x <= maxWidth; ++x) {
+                if (rowMask.at(x) == 0) {
+                    outOfGamutMask->clearBit((maxHeight - y) * (maxWidth + 1) + x);
+                }
             }
         }
     }
@@ -720,6 +883,7 @@ QImage ChromaLightnessDiagram::diagramImage(
  * 
  * This class has a cache of various data related to the diagram
  * - @ref m_diagramImage
+ * - @ref m_diagramOutOfGamutMask
  * - @ref m_diagramPixmap
  * - @ref m_maxY
  * - @ref m_minY
@@ -736,18 +900,30 @@ QImage ChromaLightnessDiagram::diagramImage(
  */
 void ChromaLightnessDiagram::updateDiagramCache()
 {
-    if (m_diagramCacheReady) {
+    const qreal ratio = Helper::cacheDevicePixelRatio(this, diagramSize());
+    // The device pixel ratio changes when the widget is moved to another
+    // screen.
+    if (m_diagramCacheReady && (m_diagramImage.devicePixelRatio() == ratio)) {
         return;
     }
 
-    // Update QImage
-    m_diagramImage = diagramImage(
+    // Update QImage. Until the gamut volume has been built in the
+    // background, the image is rendered without it.
+    const QSharedPointer<const GamutVolume> gamutVolume =
+        m_rgbColorSpace->gamutVolume();
+    m_diagramImage = generateDiagramImage(
+        m_rgbColorSpace,
         m_color.toLch().h,
-        QSize(size().width() - 2 * m_border, size().height() - 2 * m_border)
+        diagramSize() * ratio,
+        RgbColorSpace::TransformPrecision::float32,
+        &m_diagramOutOfGamutMask,
+        gamutVolume.data()
     );
+    m_diagramImage.setDevicePixelRatio(ratio);
 
     // Mark cache as ready
     m_diagramCacheReady = true;
+    CacheManager::instance()->notifyUsed(this);
 }
 
 }
@@ -174,9 +174,14 @@ void ColorDialog::setCurrentOpaqueColor(const FullColorDescription& color)
     m_rgbRedSpinbox->setValue(tempRgbQColor.redF() * 255);
     m_rgbGreenSpinbox->setValue(tempRgbQColor.greenF() * 255);
     m_rgbBlueSpinbox->setValue(tempRgbQColor.blueF() * 255);
-    m_hsvHueSpinbox->setValue(color.toHsvQColor().hsvHueF() * 360);
-    m_hsvSaturationSpinbox->setValue(color.toHsvQColor().hsvSaturationF() * 255);
-    m_hsvValueSpinbox->setValue(color.toHsvQColor().valueF() * 255);
+    const QColor tempHsvQColor = color.toHsvQColor();
+    // Achromatic colors have no HSV hue (QColor returns -1). Keep the
+    // previous hue in this case instead of jumping to 0.
+    if (tempHsvQColor.hsvHueF() >= 0) {
+        m_hsvHueSpinbox->setValue(tempHsvQColor.hsvHueF() * 360);
+    }
+    m_hsvSaturationSpinbox->setValue(tempHsvQColor.hsvSaturationF() * 255);
+    m_hsvValueSpinbox->setValue(tempHsvQColor.valueF() * 255);
     m_colorPatch->setColor(tempRgbQColor);
     m_hlcLineEdit->setText(
         QString(QStringLiteral(u"%1 %2 %3"))
@@ -185,9 +190,12 @@ void ColorDialog::setCurrentOpaqueColor(const FullColorDescription& color)
             .arg(color.toLch().C, 0, 'f', 0)
     );
     m_rgbLineEdit->setText(tempRgbQColor.name());
-    m_lchLightnessSelector->setFraction(color.toLch().L / static_cast<qreal>(100));
-    m_chromaHueDiagram->setColor(color);
-    m_wheelColorPicker->setCurrentColor(m_currentOpaqueColor);
+    // Only one of the graphical tabs is visible at a time. The other one
+    // is only marked as outdated, and receives the color when it becomes
+    // the current tab.
+    m_hueFirstTabOutdated = true;
+    m_lightnessFirstTabOutdated = true;
+    updateCurrentGraphicalTab();
     m_alphaSelector->setColor(m_currentOpaqueColor);
 
     // Emit signal currentColorChanged() only if necessary
@@ -199,6 +207,36 @@ void ColorDialog::setCurrentOpaqueColor(const FullColorDescription& color)
     m_isColorChangeInProgress = false;
 }
 
+/** @brief Passes m_currentOpaqueColor to the widgets of the current
+ * graphical tab, if they are outdated.
+ * 
+ * The widgets of the graphical tabs are expensive to update. So
+ * setCurrentOpaqueColor() updates only the current tab, and this function
+ * is called again when the user switches to another tab. */
+void ColorDialog::updateCurrentGraphicalTab()
+{
+    // The widgets emit signals when their color changes. Block the
+    // recursive calls of setCurrentOpaqueColor(), because the widgets
+    // only follow the color of the dialog here.
+    const bool wasColorChangeInProgress = m_isColorChangeInProgress;
+    m_isColorChangeInProgress = true;
+    if (m_graphicalTabWidget->currentWidget() == m_wheelColorPicker) {
+        if (m_hueFirstTabOutdated) {
+            m_hueFirstTabOutdated = false;
+            m_wheelColorPicker->setCurrentColor(m_currentOpaqueColor);
+        }
+    } else {
+        if (m_lightnessFirstTabOutdated) {
+            m_lightnessFirstTabOutdated = false;
+            m_lchLightnessSelector->setFraction(
+                m_currentOpaqueColor.toLch().L / static_cast<qreal>(100)
+            );
+            m_chromaHueDiagram->setColor(m_currentOpaqueColor);
+        }
+    }
+    m_isColorChangeInProgress = wasColorChangeInProgress;
+}
+
 ///////// ##################################
 
 void ColorDialog::readLightnessValue()
@@ -268,6 +306,7 @@ void ColorDialog::initialize()
     // create the graphical selectors
     m_wheelColorPicker = new WheelColorPicker(m_rgbColorSpace);
     m_currentOpaqueColor = m_wheelColorPicker->currentColor();
+    m_lightnessFirstTabOutdated = true;
     m_lchLightnessSelector = new GradientSelector(m_rgbColorSpace);
     m_lchLightnessSelector->setColors(
         FullColorDescription(m_rgbColorSpace, Qt::black),
@@ -279,14 +318,14 @@ void ColorDialog::initialize()
     tempLightnesFirstLayout->addWidget(m_chromaHueDiagram);
     QWidget *tempWidget = new QWidget();
     tempWidget->setLayout(tempLightnesFirstLayout);
-    QTabWidget *tempGraphicalTabWidget = new QTabWidget;
+    m_graphicalTabWidget = new QTabWidget;
     // TODO the second tab has GradientSelector + ChromaHueDiagram, and the ChromaHueDiagram
     // is smaller than WheelColorPicker on the first tab. That's because of the GradientSelector
     // of the second tab, who takes away space compared to the first tab. The good solution
     // would be to have a larger tab widget, that allows for ChromaHueDiagram to get at
     // least the size from its sizeHint().
-    tempGraphicalTabWidget->addTab(m_wheelColorPicker, tr("&Hue first")); // TODO Use an icon instead of text
-    tempGraphicalTabWidget->addTab(tempWidget, tr("&Lightness first")); // TODO Use an icon instead of text
+    m_graphicalTabWidget->addTab(m_wheelColorPicker, tr("&Hue first")); // TODO Use an icon instead of text
+    m_graphicalTabWidget->addTab(tempWidget, tr("&Lightness first")); // TODO Use an icon instead of text
     
     // create the ColorPatch
     m_colorPatch = new ColorPatch();
@@ -297,7 +336,7 @@ void ColorDialog::initialize()
 
     // Create layout for graphical and numerical selectors
     QHBoxLayout *tempSelectorLayout = new QHBoxLayout();
-    tempSelectorLayout->addWidget(tempGraphicalTabWidget);
+    tempSelectorLayout->addWidget(m_graphicalTabWidget);
     tempSelectorLayout->addWidget(tempNumericalWidget);
 
     // Create alpha selector
@@ -395,6 +434,12 @@ void ColorDialog::initialize()
         this,
         &ColorDialog::setCurrentOpaqueColor
     );
+    connect(
+        m_graphicalTabWidget,
+        &QTabWidget::currentChanged,
+        this,
+        &ColorDialog::updateCurrentGraphicalTab
+    );
 }
 
 void ColorDialog::handleFocusChange(QWidget *old, QWidget *now)
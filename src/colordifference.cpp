@@ -0,0 +1,947 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/colordifference.h"
+
+#include <cmath>
+#include <cstddef>
+
+#include <QtGlobal>
+#include <QtMath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PERCEPTUALCOLOR_COLORDIFFERENCE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace PerceptualColor {
+
+namespace ColorDifference {
+
+namespace {
+
+    /** @brief 25⁷, used by CIEDE2000 */
+    constexpr cmsFloat64Number pow25To7 = 6103515625.0;
+
+    /** @brief Tolerance (in degree) for hue differences of 180°
+     * 
+     * For a hue difference of exactly 180°, CIEDE2000 defines the mean hue
+     * as the arithmetic mean of both hues. Without a tolerance, the rounding
+     * errors of the hue calculation decide between this mean and the mean
+     * in the opposite direction, which differs by 180°. (The test data of
+     * Sharma, Wu and Dalal contains such pairs.) */
+    constexpr cmsFloat64Number hueDifferenceTolerance = 1e-9;
+
+#ifdef PERCEPTUALCOLOR_COLORDIFFERENCE_SSE2
+    static_assert(
+        sizeof(cmsCIELab) == 3 * sizeof(cmsFloat64Number),
+        "loadLab() requires cmsCIELab to be three packed doubles."
+    );
+
+    /** @brief Loads two consecutive colors in SoA layout
+     * 
+     * The six values of two consecutive colors are contiguous in memory.
+     * They are read with three contiguous loads and deinterleaved within
+     * the registers, so that each register holds the same component of
+     * both colors.
+     * 
+     * @param colors pointer to the first of two colors
+     * @param L the L values of both colors
+     * @param a the a values of both colors
+     * @param b the b values of both colors */
+    inline void loadLab(
+        const cmsCIELab *colors,
+        __m128d *L,
+        __m128d *a,
+        __m128d *b
+    )
+    {
+        const cmsFloat64Number *data = &colors->L;
+        const __m128d L0a0 = _mm_loadu_pd(data);
+        const __m128d b0L1 = _mm_loadu_pd(data + 2);
+        const __m128d a1b1 = _mm_loadu_pd(data + 4);
+        *L = _mm_shuffle_pd(L0a0, b0L1, _MM_SHUFFLE2(1, 0));
+        *a = _mm_shuffle_pd(L0a0, a1b1, _MM_SHUFFLE2(0, 1));
+        *b = _mm_shuffle_pd(b0L1, a1b1, _MM_SHUFFLE2(1, 0));
+    }
+
+    /** @brief Loads the colors for the next two color differences
+     * 
+     * @param colors the colors
+     * @param stride @c 1 to advance in @em colors for each color, @c 0 to
+     * use always the same color
+     * @param index index of the first color difference
+     * @param L the L values
+     * @param a the a values
+     * @param b the b values */
+    inline void loadLab(
+        const cmsCIELab *colors,
+        const int stride,
+        const int index,
+        __m128d *L,
+        __m128d *a,
+        __m128d *b
+    )
+    {
+        if (stride == 0) {
+            *L = _mm_set1_pd(colors->L);
+            *a = _mm_set1_pd(colors->a);
+            *b = _mm_set1_pd(colors->b);
+        } else {
+            loadLab(colors + index, L, a, b);
+        }
+    }
+
+    /** @returns for each element @em ifTrue where @em mask is set,
+     * otherwise @em ifFalse */
+    inline __m128d select(
+        const __m128d mask,
+        const __m128d ifTrue,
+        const __m128d ifFalse
+    )
+    {
+        return _mm_or_pd(
+            _mm_and_pd(mask, ifTrue),
+            _mm_andnot_pd(mask, ifFalse)
+        );
+    }
+
+    /** @brief Evaluates a polynomial by Horner’s method
+     * 
+     * @param x the variable
+     * @param coefficients the coefficients, starting with the highest
+     * degree
+     * @returns the value of the polynomial */
+    template <std::size_t N>
+    inline __m128d polynomial(
+        const __m128d x,
+        const cmsFloat64Number (&coefficients)[N]
+    )
+    {
+        __m128d result = _mm_set1_pd(coefficients[0]);
+        for (std::size_t i = 1; i < N; ++i) {
+            result = _mm_add_pd(
+                _mm_mul_pd(result, x),
+                _mm_set1_pd(coefficients[i])
+            );
+        }
+        return result;
+    }
+
+    // The following approximations use the coefficients of the Cephes
+    // Mathematical Library by Stephen L. Moshier. On the ranges that are
+    // used here, their error is of the order of the double precision.
+
+    /** @brief Numerator coefficients for atan() on [-0.66, 0.66] */
+    constexpr cmsFloat64Number atanP[] = {
+        -8.750608600031904122785E-1,
+        -1.615753718733365076637E1,
+        -7.500855792314704667340E1,
+        -1.228866684490136173410E2,
+        -6.485021904942025371773E1
+    };
+    /** @brief Denominator coefficients for atan() on [-0.66, 0.66] */
+    constexpr cmsFloat64Number atanQ[] = {
+        1,
+        2.485846490142306297962E1,
+        1.650270098316988542046E2,
+        4.328810604912902668951E2,
+        4.853903996359136964868E2,
+        1.945506571482613964425E2
+    };
+    /** @brief Coefficients for sin() on [-π/4, π/4] */
+    constexpr cmsFloat64Number sinCoefficients[] = {
+        1.58962301576546568060E-10,
+        -2.50507477628578072866E-8,
+        2.75573136213857245213E-6,
+        -1.98412698295895385996E-4,
+        8.33333333332211858878E-3,
+        -1.66666666666666307295E-1
+    };
+    /** @brief Coefficients for cos() on [-π/4, π/4] */
+    constexpr cmsFloat64Number cosCoefficients[] = {
+        -1.13585365213876817300E-11,
+        2.08757008419747316778E-9,
+        -2.75573141792967388112E-7,
+        2.48015872888517045348E-5,
+        -1.38888888888730564116E-3,
+        4.16666666666665929218E-2
+    };
+    /** @brief Numerator coefficients for exp() on [-ln(2)/2, ln(2)/2] */
+    constexpr cmsFloat64Number expP[] = {
+        1.26177193074810590878E-4,
+        3.02994407707441961300E-2,
+        9.99999999999999999910E-1
+    };
+    /** @brief Denominator coefficients for exp() on [-ln(2)/2, ln(2)/2] */
+    constexpr cmsFloat64Number expQ[] = {
+        3.00198505138664455042E-6,
+        2.52448340349684104192E-3,
+        2.27265548208155028766E-1,
+        2.00000000000000000009E0
+    };
+
+    /** @brief Four-quadrant arc tangent
+     * 
+     * @param y the y values
+     * @param x the x values
+     * @returns the angle in degree, range [0, 360[, like
+     * <tt>std::atan2()</tt> converted to degree and normalized. (As
+     * <tt>std::atan2()</tt> returns 0 for x = y = 0, so does this
+     * function.) */
+    inline __m128d atan2Degree(const __m128d y, const __m128d x)
+    {
+        const __m128d signMask = _mm_set1_pd(-0.0);
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d absX = _mm_andnot_pd(signMask, x);
+        const __m128d absY = _mm_andnot_pd(signMask, y);
+        // Reduce to an argument in [0, 1]
+        const __m128d swap = _mm_cmpgt_pd(absY, absX);
+        const __m128d numerator = _mm_min_pd(absX, absY);
+        const __m128d denominator = _mm_max_pd(absX, absY);
+        __m128d z = _mm_div_pd(
+            numerator,
+            // Avoid 0 / 0. The result for x = y = 0 is 0.
+            select(_mm_cmpeq_pd(denominator, zero), _mm_set1_pd(1), denominator)
+        );
+        // Reduce further to [-0.66, 0.66] by means of
+        // atan(z) = π/4 + atan((z - 1) / (z + 1))
+        const __m128d one = _mm_set1_pd(1);
+        const __m128d big = _mm_cmpgt_pd(z, _mm_set1_pd(0.66));
+        z = select(
+            big,
+            _mm_div_pd(_mm_sub_pd(z, one), _mm_add_pd(z, one)),
+            z
+        );
+        const __m128d z2 = _mm_mul_pd(z, z);
+        __m128d angle = _mm_add_pd(
+            z,
+            _mm_mul_pd(
+                _mm_mul_pd(z, z2),
+                _mm_div_pd(polynomial(z2, atanP), polynomial(z2, atanQ))
+            )
+        );
+        angle = _mm_add_pd(
+            angle,
+            _mm_and_pd(big, _mm_set1_pd(M_PI / 4))
+        );
+        // Back to the original octant and quadrant
+        angle = select(swap, _mm_sub_pd(_mm_set1_pd(M_PI / 2), angle), angle);
+        angle = select(
+            _mm_cmplt_pd(x, zero),
+            _mm_sub_pd(_mm_set1_pd(M_PI), angle),
+            angle
+        );
+        angle = _mm_mul_pd(angle, _mm_set1_pd(180 / M_PI));
+        // Negative y: 360° - angle, but 0 stays 0.
+        return select(
+            _mm_and_pd(_mm_cmplt_pd(y, zero), _mm_cmpgt_pd(angle, zero)),
+            _mm_sub_pd(_mm_set1_pd(360), angle),
+            angle
+        );
+    }
+
+    /** @brief Sine and cosine
+     * 
+     * @param x the angles in degree. The argument reduction is exact for
+     * angles of moderate size.
+     * @param sine the sine values
+     * @param cosine the cosine values */
+    inline void sinCosDegree(const __m128d x, __m128d *sine, __m128d *cosine)
+    {
+        // Reduce to r ∈ [-45°, 45°] with x = r + 90° × quadrant
+        const __m128i quadrant = _mm_cvtpd_epi32(
+            _mm_mul_pd(x, _mm_set1_pd(1.0 / 90))
+        );
+        const __m128d r = _mm_mul_pd(
+            _mm_sub_pd(
+                x,
+                _mm_mul_pd(_mm_cvtepi32_pd(quadrant), _mm_set1_pd(90))
+            ),
+            _mm_set1_pd(M_PI / 180)
+        );
+        const __m128d r2 = _mm_mul_pd(r, r);
+        const __m128d sinR = _mm_add_pd(
+            r,
+            _mm_mul_pd(_mm_mul_pd(r, r2), polynomial(r2, sinCoefficients))
+        );
+        const __m128d cosR = _mm_add_pd(
+            _mm_sub_pd(_mm_set1_pd(1), _mm_mul_pd(_mm_set1_pd(0.5), r2)),
+            _mm_mul_pd(_mm_mul_pd(r2, r2), polynomial(r2, cosCoefficients))
+        );
+        // Expand the two 32-bit quadrants to masks for the 64-bit elements
+        const __m128i quadrant64 =
+            _mm_shuffle_epi32(quadrant, _MM_SHUFFLE(1, 1, 0, 0));
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i two = _mm_set1_epi32(2);
+        const __m128d swap = _mm_castsi128_pd(
+            _mm_cmpeq_epi32(_mm_and_si128(quadrant64, one), one)
+        );
+        const __m128d negateSine = _mm_castsi128_pd(
+            _mm_cmpeq_epi32(_mm_and_si128(quadrant64, two), two)
+        );
+        const __m128d negateCosine = _mm_castsi128_pd(_mm_cmpeq_epi32(
+            _mm_and_si128(_mm_add_epi32(quadrant64, one), two),
+            two
+        ));
+        const __m128d signMask = _mm_set1_pd(-0.0);
+        *sine = _mm_xor_pd(
+            select(swap, cosR, sinR),
+            _mm_and_pd(negateSine, signMask)
+        );
+        *cosine = _mm_xor_pd(
+            select(swap, sinR, cosR),
+            _mm_and_pd(negateCosine, signMask)
+        );
+    }
+
+    /** @brief Exponential function
+     * 
+     * @param x the values. Values below -708 are treated as -708.
+     * @returns eˣ for x ≤ 0. */
+    inline __m128d exponential(const __m128d x)
+    {
+        const __m128d clamped = _mm_max_pd(x, _mm_set1_pd(-708));
+        // x = r + n × ln(2), with ln(2) split in two parts to keep r exact
+        const __m128i n = _mm_cvtpd_epi32(
+            _mm_mul_pd(clamped, _mm_set1_pd(M_LOG2E))
+        );
+        const __m128d nDouble = _mm_cvtepi32_pd(n);
+        const __m128d r = _mm_sub_pd(
+            _mm_sub_pd(
+                clamped,
+                _mm_mul_pd(nDouble, _mm_set1_pd(6.93145751953125E-1))
+            ),
+            _mm_mul_pd(nDouble, _mm_set1_pd(1.42860682030941723212E-6))
+        );
+        const __m128d r2 = _mm_mul_pd(r, r);
+        const __m128d p = _mm_mul_pd(r, polynomial(r2, expP));
+        const __m128d expR = _mm_add_pd(
+            _mm_set1_pd(1),
+            _mm_mul_pd(
+                _mm_set1_pd(2),
+                _mm_div_pd(p, _mm_sub_pd(polynomial(r2, expQ), p))
+            )
+        );
+        // 2ⁿ, constructed directly as IEEE 754 bit pattern
+        const __m128i biasedExponent = _mm_add_epi32(
+            _mm_shuffle_epi32(n, _MM_SHUFFLE(3, 1, 2, 0)),
+            _mm_set1_epi32(1023)
+        );
+        const __m128d powerOfTwo =
+            _mm_castsi128_pd(_mm_slli_epi64(biasedExponent, 52));
+        return _mm_mul_pd(expR, powerOfTwo);
+    }
+
+    /** @returns x⁷ */
+    inline __m128d pow7(const __m128d x)
+    {
+        const __m128d x2 = _mm_mul_pd(x, x);
+        const __m128d x3 = _mm_mul_pd(x2, x);
+        return _mm_mul_pd(_mm_mul_pd(x3, x3), x);
+    }
+
+    /** @brief CIEDE2000 for two color pairs
+     * 
+     * Vectorized version of ColorDifference::deltaE2000(). Each register
+     * holds the same component of two colors. */
+    inline __m128d deltaE2000Simd(
+        const __m128d L1,
+        const __m128d a1,
+        const __m128d b1,
+        const __m128d L2,
+        const __m128d a2,
+        const __m128d b2
+    )
+    {
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1);
+        const __m128d half = _mm_set1_pd(0.5);
+        const __m128d d180 = _mm_set1_pd(180);
+        const __m128d d360 = _mm_set1_pd(360);
+        const __m128d pow25To7Simd = _mm_set1_pd(pow25To7);
+
+        const __m128d c1 = _mm_sqrt_pd(
+            _mm_add_pd(_mm_mul_pd(a1, a1), _mm_mul_pd(b1, b1))
+        );
+        const __m128d c2 = _mm_sqrt_pd(
+            _mm_add_pd(_mm_mul_pd(a2, a2), _mm_mul_pd(b2, b2))
+        );
+        const __m128d meanC7 = pow7(_mm_mul_pd(_mm_add_pd(c1, c2), half));
+        const __m128d g = _mm_mul_pd(
+            half,
+            _mm_sub_pd(
+                one,
+                _mm_sqrt_pd(
+                    _mm_div_pd(meanC7, _mm_add_pd(meanC7, pow25To7Simd))
+                )
+            )
+        );
+        const __m128d a1Prime = _mm_mul_pd(_mm_add_pd(one, g), a1);
+        const __m128d a2Prime = _mm_mul_pd(_mm_add_pd(one, g), a2);
+        const __m128d c1Prime = _mm_sqrt_pd(
+            _mm_add_pd(_mm_mul_pd(a1Prime, a1Prime), _mm_mul_pd(b1, b1))
+        );
+        const __m128d c2Prime = _mm_sqrt_pd(
+            _mm_add_pd(_mm_mul_pd(a2Prime, a2Prime), _mm_mul_pd(b2, b2))
+        );
+        const __m128d chromaProduct = _mm_mul_pd(c1Prime, c2Prime);
+        const __m128d h1Prime = _mm_andnot_pd(
+            _mm_cmpeq_pd(c1Prime, zero),
+            atan2Degree(b1, a1Prime)
+        );
+        const __m128d h2Prime = _mm_andnot_pd(
+            _mm_cmpeq_pd(c2Prime, zero),
+            atan2Degree(b2, a2Prime)
+        );
+        const __m128d achromatic = _mm_cmpeq_pd(chromaProduct, zero);
+
+        const __m128d dLPrime = _mm_sub_pd(L2, L1);
+        const __m128d dCPrime = _mm_sub_pd(c2Prime, c1Prime);
+        __m128d dhPrime = _mm_sub_pd(h2Prime, h1Prime);
+        dhPrime = _mm_sub_pd(
+            dhPrime,
+            _mm_and_pd(_mm_cmpgt_pd(dhPrime, d180), d360)
+        );
+        dhPrime = _mm_add_pd(
+            dhPrime,
+            _mm_and_pd(_mm_cmplt_pd(dhPrime, _mm_set1_pd(-180)), d360)
+        );
+        dhPrime = _mm_andnot_pd(achromatic, dhPrime);
+        __m128d sinHalfDhPrime;
+        __m128d unused;
+        sinCosDegree(_mm_mul_pd(dhPrime, half), &sinHalfDhPrime, &unused);
+        const __m128d dHPrime = _mm_mul_pd(
+            _mm_mul_pd(_mm_set1_pd(2), _mm_sqrt_pd(chromaProduct)),
+            sinHalfDhPrime
+        );
+
+        const __m128d meanLPrime = _mm_mul_pd(_mm_add_pd(L1, L2), half);
+        const __m128d meanCPrime = _mm_mul_pd(_mm_add_pd(c1Prime, c2Prime), half);
+        const __m128d hueSum = _mm_add_pd(h1Prime, h2Prime);
+        const __m128d hueDistance = _mm_andnot_pd(
+            _mm_set1_pd(-0.0),
+            _mm_sub_pd(h1Prime, h2Prime)
+        );
+        const __m128d hueCorrection = _mm_andnot_pd(
+            _mm_cmple_pd(
+                hueDistance,
+                _mm_set1_pd(180 + hueDifferenceTolerance)
+            ),
+            select(_mm_cmplt_pd(hueSum, d360), d360, _mm_set1_pd(-360))
+        );
+        const __m128d meanHPrime = select(
+            achromatic,
+            hueSum,
+            _mm_mul_pd(_mm_add_pd(hueSum, hueCorrection), half)
+        );
+        // The four cosines of T are calculated from the sine and cosine
+        // of meanHPrime by means of the multiple-angle formulas.
+        __m128d sinH;
+        __m128d cosH;
+        sinCosDegree(meanHPrime, &sinH, &cosH);
+        const __m128d cos2H = _mm_sub_pd(
+            _mm_mul_pd(_mm_set1_pd(2), _mm_mul_pd(cosH, cosH)),
+            one
+        );
+        const __m128d sin2H =
+            _mm_mul_pd(_mm_set1_pd(2), _mm_mul_pd(sinH, cosH));
+        const __m128d cos3H = _mm_sub_pd(
+            _mm_mul_pd(cos2H, cosH),
+            _mm_mul_pd(sin2H, sinH)
+        );
+        const __m128d sin3H = _mm_add_pd(
+            _mm_mul_pd(sin2H, cosH),
+            _mm_mul_pd(cos2H, sinH)
+        );
+        const __m128d cos4H = _mm_sub_pd(
+            _mm_mul_pd(_mm_set1_pd(2), _mm_mul_pd(cos2H, cos2H)),
+            one
+        );
+        const __m128d sin4H =
+            _mm_mul_pd(_mm_set1_pd(2), _mm_mul_pd(sin2H, cos2H));
+        // cos(h - 30°)
+        const __m128d cosHMinus30 = _mm_add_pd(
+            _mm_mul_pd(cosH, _mm_set1_pd(std::sqrt(3.0) / 2)),
+            _mm_mul_pd(sinH, half)
+        );
+        // cos(3h + 6°)
+        const __m128d cos3HPlus6 = _mm_sub_pd(
+            _mm_mul_pd(cos3H, _mm_set1_pd(std::cos(6 * M_PI / 180))),
+            _mm_mul_pd(sin3H, _mm_set1_pd(std::sin(6 * M_PI / 180)))
+        );
+        // cos(4h - 63°)
+        const __m128d cos4HMinus63 = _mm_add_pd(
+            _mm_mul_pd(cos4H, _mm_set1_pd(std::cos(63 * M_PI / 180))),
+            _mm_mul_pd(sin4H, _mm_set1_pd(std::sin(63 * M_PI / 180)))
+        );
+        const __m128d t = _mm_add_pd(
+            _mm_sub_pd(
+                _mm_add_pd(
+                    _mm_sub_pd(one, _mm_mul_pd(_mm_set1_pd(0.17), cosHMinus30)),
+                    _mm_mul_pd(_mm_set1_pd(0.24), cos2H)
+                ),
+                _mm_mul_pd(_mm_set1_pd(0.20), cos4HMinus63)
+            ),
+            _mm_mul_pd(_mm_set1_pd(0.32), cos3HPlus6)
+        );
+        const __m128d hueOffset = _mm_div_pd(
+            _mm_sub_pd(meanHPrime, _mm_set1_pd(275)),
+            _mm_set1_pd(25)
+        );
+        const __m128d dTheta = _mm_mul_pd(
+            _mm_set1_pd(30),
+            exponential(_mm_sub_pd(zero, _mm_mul_pd(hueOffset, hueOffset)))
+        );
+        const __m128d meanCPrime7 = pow7(meanCPrime);
+        const __m128d rC = _mm_mul_pd(
+            _mm_set1_pd(2),
+            _mm_sqrt_pd(
+                _mm_div_pd(meanCPrime7, _mm_add_pd(meanCPrime7, pow25To7Simd))
+            )
+        );
+        const __m128d lightnessOffset = _mm_sub_pd(meanLPrime, _mm_set1_pd(50));
+        const __m128d lightnessOffset2 =
+            _mm_mul_pd(lightnessOffset, lightnessOffset);
+        const __m128d sL = _mm_add_pd(
+            one,
+            _mm_div_pd(
+                _mm_mul_pd(_mm_set1_pd(0.015), lightnessOffset2),
+                _mm_sqrt_pd(_mm_add_pd(_mm_set1_pd(20), lightnessOffset2))
+            )
+        );
+        const __m128d sC =
+            _mm_add_pd(one, _mm_mul_pd(_mm_set1_pd(0.045), meanCPrime));
+        const __m128d sH = _mm_add_pd(
+            one,
+            _mm_mul_pd(_mm_mul_pd(_mm_set1_pd(0.015), meanCPrime), t)
+        );
+        __m128d sin2DTheta;
+        sinCosDegree(_mm_mul_pd(_mm_set1_pd(2), dTheta), &sin2DTheta, &unused);
+        const __m128d rT = _mm_sub_pd(zero, _mm_mul_pd(sin2DTheta, rC));
+
+        const __m128d termL = _mm_div_pd(dLPrime, sL);
+        const __m128d termC = _mm_div_pd(dCPrime, sC);
+        const __m128d termH = _mm_div_pd(dHPrime, sH);
+        return _mm_sqrt_pd(_mm_add_pd(
+            _mm_add_pd(
+                _mm_add_pd(_mm_mul_pd(termL, termL), _mm_mul_pd(termC, termC)),
+                _mm_mul_pd(termH, termH)
+            ),
+            _mm_mul_pd(rT, _mm_mul_pd(termC, termH))
+        ));
+    }
+#endif
+
+    /** @brief ΔE*76 for contiguous arrays
+     * 
+     * @param first the first colors
+     * @param firstStride @c 1 to advance in @em first for each color,
+     * @c 0 to use always the same first color
+     * @param second the second colors
+     * @param result the color differences
+     * @param count the number of color differences */
+    void deltaE76Batch(
+        const cmsCIELab *first,
+        const int firstStride,
+        const cmsCIELab *second,
+        cmsFloat64Number *result,
+        const int count
+    )
+    {
+        int i = 0;
+#ifdef PERCEPTUALCOLOR_COLORDIFFERENCE_SSE2
+        __m128d L1;
+        __m128d a1;
+        __m128d b1;
+        __m128d L2;
+        __m128d a2;
+        __m128d b2;
+        for (; i + 1 < count; i += 2) {
+            loadLab(first, firstStride, i, &L1, &a1, &b1);
+            loadLab(second + i, &L2, &a2, &b2);
+            const __m128d dL = _mm_sub_pd(L1, L2);
+            const __m128d da = _mm_sub_pd(a1, a2);
+            const __m128d db = _mm_sub_pd(b1, b2);
+            const __m128d sum = _mm_add_pd(
+                _mm_add_pd(_mm_mul_pd(dL, dL), _mm_mul_pd(da, da)),
+                _mm_mul_pd(db, db)
+            );
+            _mm_storeu_pd(result + i, _mm_sqrt_pd(sum));
+        }
+#endif
+        for (; i < count; ++i) {
+            result[i] = deltaE76(first[i * firstStride], second[i]);
+        }
+    }
+
+    /** @brief ΔE*94 for contiguous arrays
+     * 
+     * @param references the reference colors
+     * @param referenceStride @c 1 to advance in @em references for each
+     * color, @c 0 to use always the same reference color
+     * @param samples the sample colors
+     * @param result the color differences
+     * @param count the number of color differences */
+    void deltaE94Batch(
+        const cmsCIELab *references,
+        const int referenceStride,
+        const cmsCIELab *samples,
+        cmsFloat64Number *result,
+        const int count
+    )
+    {
+        int i = 0;
+#ifdef PERCEPTUALCOLOR_COLORDIFFERENCE_SSE2
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1);
+        const __m128d k1 = _mm_set1_pd(0.045);
+        const __m128d k2 = _mm_set1_pd(0.015);
+        __m128d L1;
+        __m128d a1;
+        __m128d b1;
+        __m128d L2;
+        __m128d a2;
+        __m128d b2;
+        for (; i + 1 < count; i += 2) {
+            loadLab(references, referenceStride, i, &L1, &a1, &b1);
+            loadLab(samples + i, &L2, &a2, &b2);
+            const __m128d dL = _mm_sub_pd(L1, L2);
+            const __m128d da = _mm_sub_pd(a1, a2);
+            const __m128d db = _mm_sub_pd(b1, b2);
+            const __m128d c1 = _mm_sqrt_pd(
+                _mm_add_pd(_mm_mul_pd(a1, a1), _mm_mul_pd(b1, b1))
+            );
+            const __m128d c2 = _mm_sqrt_pd(
+                _mm_add_pd(_mm_mul_pd(a2, a2), _mm_mul_pd(b2, b2))
+            );
+            const __m128d dC = _mm_sub_pd(c1, c2);
+            const __m128d dH2 = _mm_max_pd(
+                zero,
+                _mm_sub_pd(
+                    _mm_add_pd(_mm_mul_pd(da, da), _mm_mul_pd(db, db)),
+                    _mm_mul_pd(dC, dC)
+                )
+            );
+            const __m128d sC = _mm_add_pd(one, _mm_mul_pd(k1, c1));
+            const __m128d sH = _mm_add_pd(one, _mm_mul_pd(k2, c1));
+            const __m128d termC = _mm_div_pd(dC, sC);
+            const __m128d sum = _mm_add_pd(
+                _mm_add_pd(_mm_mul_pd(dL, dL), _mm_mul_pd(termC, termC)),
+                _mm_div_pd(dH2, _mm_mul_pd(sH, sH))
+            );
+            _mm_storeu_pd(result + i, _mm_sqrt_pd(sum));
+        }
+#endif
+        for (; i < count; ++i) {
+            result[i] = deltaE94(references[i * referenceStride], samples[i]);
+        }
+    }
+
+
+    /** @brief CIEDE2000 for contiguous arrays
+     * 
+     * @param first the first colors
+     * @param firstStride @c 1 to advance in @em first for each color,
+     * @c 0 to use always the same first color
+     * @param second the second colors
+     * @param result the color differences
+     * @param count the number of color differences */
+    void deltaE2000Batch(
+        const cmsCIELab *first,
+        const int firstStride,
+        const cmsCIELab *second,
+        cmsFloat64Number *result,
+        const int count
+    )
+    {
+        int i = 0;
+#ifdef PERCEPTUALCOLOR_COLORDIFFERENCE_SSE2
+        __m128d L1;
+        __m128d a1;
+        __m128d b1;
+        __m128d L2;
+        __m128d a2;
+        __m128d b2;
+        for (; i + 1 < count; i += 2) {
+            loadLab(first, firstStride, i, &L1, &a1, &b1);
+            loadLab(second + i, &L2, &a2, &b2);
+            _mm_storeu_pd(
+                result + i,
+                deltaE2000Simd(L1, a1, b1, L2, a2, b2)
+            );
+        }
+#endif
+        for (; i < count; ++i) {
+            result[i] = deltaE2000(first[i * firstStride], second[i]);
+        }
+    }
+
+}
+
+    /** @brief CIE ΔE*76 color difference
+     * 
+     * The euclidean distance in the Lab color space.
+     * 
+     * @param first the first color
+     * @param second the second color
+     * @returns the color difference */
+    cmsFloat64Number deltaE76(const cmsCIELab &first, const cmsCIELab &second)
+    {
+        const cmsFloat64Number dL = first.L - second.L;
+        const cmsFloat64Number da = first.a - second.a;
+        const cmsFloat64Number db = first.b - second.b;
+        return std::sqrt(dL * dL + da * da + db * db);
+    }
+
+    /** @brief CIE ΔE*76 color differences of one color to many colors
+     * 
+     * @param reference the reference color
+     * @param colors pointer to the first of @em count colors
+     * @param result pointer to the first of @em count results
+     * @param count the number of colors */
+    void deltaE76(
+        const cmsCIELab &reference,
+        const cmsCIELab *colors,
+        cmsFloat64Number *result,
+        const int count
+    )
+    {
+        deltaE76Batch(&reference, 0, colors, result, count);
+    }
+
+    /** @brief Pairwise CIE ΔE*76 color differences
+     * 
+     * @param first pointer to the first of @em count colors
+     * @param second pointer to the first of @em count colors
+     * @param result pointer to the first of @em count results. Each
+     * result is the color difference between the elements with the same
+     * index in @em first and @em second.
+     * @param count the number of color pairs */
+    void deltaE76(
+        const cmsCIELab *first,
+        const cmsCIELab *second,
+        cmsFloat64Number *result,
+        const int count
+    )
+    {
+        deltaE76Batch(first, 1, second, result, count);
+    }
+
+    /** @brief CIE ΔE*94 color difference
+     * 
+     * Uses the weighting factors for graphic arts (k<sub>L</sub> = 1,
+     * K<sub>1</sub> = 0.045, K<sub>2</sub> = 0.015). ΔE*94 is not
+     * symmetric: The chroma of the reference color is used for the
+     * weighting functions.
+     * 
+     * @param reference the reference color
+     * @param sample the sample color
+     * @returns the color difference */
+    cmsFloat64Number deltaE94(const cmsCIELab &reference, const cmsCIELab &sample)
+    {
+        const cmsFloat64Number dL = reference.L - sample.L;
+        const cmsFloat64Number da = reference.a - sample.a;
+        const cmsFloat64Number db = reference.b - sample.b;
+        const cmsFloat64Number c1 = std::sqrt(
+            reference.a * reference.a + reference.b * reference.b
+        );
+        const cmsFloat64Number c2 = std::sqrt(
+            sample.a * sample.a + sample.b * sample.b
+        );
+        const cmsFloat64Number dC = c1 - c2;
+        // Might become slightly negative because of rounding errors.
+        const cmsFloat64Number dH2 = qMax<cmsFloat64Number>(
+            0,
+            da * da + db * db - dC * dC
+        );
+        const cmsFloat64Number sC = 1 + 0.045 * c1;
+        const cmsFloat64Number sH = 1 + 0.015 * c1;
+        const cmsFloat64Number termC = dC / sC;
+        return std::sqrt(dL * dL + termC * termC + dH2 / (sH * sH));
+    }
+
+    /** @brief CIE ΔE*94 color differences of one color to many colors
+     * 
+     * @param reference the reference color
+     * @param samples pointer to the first of @em count sample colors
+     * @param result pointer to the first of @em count results
+     * @param count the number of colors */
+    void deltaE94(
+        const cmsCIELab &reference,
+        const cmsCIELab *samples,
+        cmsFloat64Number *result,
+        const int count
+    )
+    {
+        deltaE94Batch(&reference, 0, samples, result, count);
+    }
+
+    /** @brief Pairwise CIE ΔE*94 color differences
+     * 
+     * @param references pointer to the first of @em count reference colors
+     * @param samples pointer to the first of @em count sample colors
+     * @param result pointer to the first of @em count results. Each
+     * result is the color difference between the elements with the same
+     * index in @em references and @em samples.
+     * @param count the number of color pairs */
+    void deltaE94(
+        const cmsCIELab *references,
+        const cmsCIELab *samples,
+        cmsFloat64Number *result,
+        const int count
+    )
+    {
+        deltaE94Batch(references, 1, samples, result, count);
+    }
+
+    /** @brief CIEDE2000 color difference
+     * 
+     * Implementation following Sharma, Wu, Dalal: “The CIEDE2000
+     * Color-Difference Formula: Implementation Notes, Supplementary Test
+     * Data, and Mathematical Observations”, with k<sub>L</sub> =
+     * k<sub>C</sub> = k<sub>H</sub> = 1.
+     * 
+     * @param first the first color
+     * @param second the second color
+     * @returns the color difference */
+    cmsFloat64Number deltaE2000(const cmsCIELab &first, const cmsCIELab &second)
+    {
+        const cmsFloat64Number c1 = std::sqrt(first.a * first.a + first.b * first.b);
+        const cmsFloat64Number c2 = std::sqrt(second.a * second.a + second.b * second.b);
+        const cmsFloat64Number meanC = (c1 + c2) / 2;
+        const cmsFloat64Number meanC7 =
+            meanC * meanC * meanC * meanC * meanC * meanC * meanC;
+        const cmsFloat64Number g = 0.5 * (1 - std::sqrt(meanC7 / (meanC7 + pow25To7)));
+        const cmsFloat64Number a1Prime = (1 + g) * first.a;
+        const cmsFloat64Number a2Prime = (1 + g) * second.a;
+        const cmsFloat64Number c1Prime = std::sqrt(a1Prime * a1Prime + first.b * first.b);
+        const cmsFloat64Number c2Prime = std::sqrt(a2Prime * a2Prime + second.b * second.b);
+        const cmsFloat64Number chromaProduct = c1Prime * c2Prime;
+        cmsFloat64Number h1Prime = 0;
+        if (c1Prime != 0) {
+            h1Prime = qRadiansToDegrees(std::atan2(first.b, a1Prime));
+            if (h1Prime < 0) {
+                h1Prime += 360;
+            }
+        }
+        cmsFloat64Number h2Prime = 0;
+        if (c2Prime != 0) {
+            h2Prime = qRadiansToDegrees(std::atan2(second.b, a2Prime));
+            if (h2Prime < 0) {
+                h2Prime += 360;
+            }
+        }
+
+        const cmsFloat64Number dLPrime = second.L - first.L;
+        const cmsFloat64Number dCPrime = c2Prime - c1Prime;
+        cmsFloat64Number dhPrime = 0;
+        if (chromaProduct != 0) {
+            dhPrime = h2Prime - h1Prime;
+            if (dhPrime > 180) {
+                dhPrime -= 360;
+            } else if (dhPrime < -180) {
+                dhPrime += 360;
+            }
+        }
+        const cmsFloat64Number dHPrime = 2 * std::sqrt(chromaProduct)
+            * std::sin(qDegreesToRadians(dhPrime / 2));
+
+        const cmsFloat64Number meanLPrime = (first.L + second.L) / 2;
+        const cmsFloat64Number meanCPrime = (c1Prime + c2Prime) / 2;
+        cmsFloat64Number meanHPrime = h1Prime + h2Prime;
+        if (chromaProduct != 0) {
+            if (qAbs(h1Prime - h2Prime) <= 180 + hueDifferenceTolerance) {
+                meanHPrime = (h1Prime + h2Prime) / 2;
+            } else if (h1Prime + h2Prime < 360) {
+                meanHPrime = (h1Prime + h2Prime + 360) / 2;
+            } else {
+                meanHPrime = (h1Prime + h2Prime - 360) / 2;
+            }
+        }
+        const cmsFloat64Number t = 1
+            - 0.17 * std::cos(qDegreesToRadians(meanHPrime - 30))
+            + 0.24 * std::cos(qDegreesToRadians(2 * meanHPrime))
+            + 0.32 * std::cos(qDegreesToRadians(3 * meanHPrime + 6))
+            - 0.20 * std::cos(qDegreesToRadians(4 * meanHPrime - 63));
+        const cmsFloat64Number hueOffset = (meanHPrime - 275) / 25;
+        const cmsFloat64Number dTheta = 30 * std::exp(-hueOffset * hueOffset);
+        const cmsFloat64Number meanCPrime7 = meanCPrime * meanCPrime * meanCPrime
+            * meanCPrime * meanCPrime * meanCPrime * meanCPrime;
+        const cmsFloat64Number rC = 2 * std::sqrt(meanCPrime7 / (meanCPrime7 + pow25To7));
+        const cmsFloat64Number lightnessOffset2 = (meanLPrime - 50) * (meanLPrime - 50);
+        const cmsFloat64Number sL = 1
+            + 0.015 * lightnessOffset2 / std::sqrt(20 + lightnessOffset2);
+        const cmsFloat64Number sC = 1 + 0.045 * meanCPrime;
+        const cmsFloat64Number sH = 1 + 0.015 * meanCPrime * t;
+        const cmsFloat64Number rT = -std::sin(qDegreesToRadians(2 * dTheta)) * rC;
+
+        const cmsFloat64Number termL = dLPrime / sL;
+        const cmsFloat64Number termC = dCPrime / sC;
+        const cmsFloat64Number termH = dHPrime / sH;
+        return std::sqrt(
+            termL * termL + termC * termC + termH * termH + rT * termC * termH
+        );
+    }
+
+    /** @brief CIEDE2000 color differences of one color to many colors
+     * 
+     * @param reference the reference color
+     * @param colors pointer to the first of @em count colors
+     * @param result pointer to the first of @em count results
+     * @param count the number of colors */
+    void deltaE2000(
+        const cmsCIELab &reference,
+        const cmsCIELab *colors,
+        cmsFloat64Number *result,
+        const int count
+    )
+    {
+        deltaE2000Batch(&reference, 0, colors, result, count);
+    }
+
+    /** @brief Pairwise CIEDE2000 color differences
+     * 
+     * @param first pointer to the first of @em count colors
+     * @param second pointer to the first of @em count colors
+     * @param result pointer to the first of @em count results. Each
+     * result is the color difference between the elements with the same
+     * index in @em first and @em second.
+     * @param count the number of color pairs */
+    void deltaE2000(
+        const cmsCIELab *first,
+        const cmsCIELab *second,
+        cmsFloat64Number *result,
+        const int count
+    )
+    {
+        deltaE2000Batch(first, 1, second, result, count);
+    }
+
+}
+
+}
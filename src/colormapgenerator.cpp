@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/colormapgenerator.h"
+
+namespace PerceptualColor {
+
+namespace {
+
+/** @brief Stores a channel value (range 0..1) with 8 bit */
+void storeChannel(const cmsFloat64Number value, quint8 *channel)
+{
+    *channel = static_cast<quint8>(qRound(value * 255));
+}
+
+/** @brief Stores a channel value (range 0..1) with 16 bit */
+void storeChannel(const cmsFloat64Number value, quint16 *channel)
+{
+    *channel = static_cast<quint16>(qRound(value * 65535));
+}
+
+/** @brief Stores a channel value (range 0..1) as floating point value */
+void storeChannel(const cmsFloat64Number value, float *channel)
+{
+    *channel = static_cast<float>(value);
+}
+
+}
+
+/** @brief Constructor
+ * 
+ * The default stops go from black to white.
+ * 
+ * @param colorSpace the color space. Must stay alive as long as this
+ * object is used. */
+ColormapGenerator::ColormapGenerator(RgbColorSpace *colorSpace)
+{
+    m_rgbColorSpace = colorSpace;
+    setStops(QVector<cmsCIELCh> {{0, 0, 0}, {100, 0, 0}});
+}
+
+/** @brief Setter for the stops() property
+ * 
+ * @param stops at least two LCh values
+ * @returns @c true on success. @c false if there are less than two stops;
+ * the stops remain unchanged in this case. */
+bool ColormapGenerator::setStops(const QVector<cmsCIELCh> &stops)
+{
+    if (stops.count() < 2) {
+        return false;
+    }
+    m_stops = stops;
+    m_unwrappedStops = stops;
+    for (int i = 1; i < m_unwrappedStops.count(); ++i) {
+        // Take the shorter way around the color wheel, like in
+        // GradientSelector.
+        while (m_unwrappedStops.at(i).h - m_unwrappedStops.at(i - 1).h > 180) {
+            m_unwrappedStops[i].h -= 360;
+        }
+        while (m_unwrappedStops.at(i).h - m_unwrappedStops.at(i - 1).h < -180) {
+            m_unwrappedStops[i].h += 360;
+        }
+    }
+    return true;
+}
+
+/** @brief The stops of the colormap
+ * 
+ * The first stop corresponds to the first entry of the colormap, the last
+ * stop to the last entry. All other stops are equidistant in between.
+ * 
+ * @sa setStops() */
+QVector<cmsCIELCh> ColormapGenerator::stops() const
+{
+    return m_stops;
+}
+
+/** @brief How out-of-gamut colors are treated
+ * 
+ * Default is FullColorDescription::outOfGamutBehaviour::preserve, which
+ * simply clips the RGB values.
+ * 
+ * @sa setGamutBehaviour() */
+FullColorDescription::outOfGamutBehaviour ColormapGenerator::gamutBehaviour() const
+{
+    return m_gamutBehaviour;
+}
+
+/** @brief Setter for the gamutBehaviour() property */
+void ColormapGenerator::setGamutBehaviour(
+    const FullColorDescription::outOfGamutBehaviour behaviour
+)
+{
+    m_gamutBehaviour = behaviour;
+}
+
+/** @brief Generates a chunk of the colormap
+ * 
+ * @param entryCount the total number of entries of the colormap
+ * @param firstEntry the index of the first entry of this chunk
+ * @param chunkCount the number of entries of this chunk (at most
+ * chunkSize)
+ * @param rgb buffer for @em chunkCount RGB values */
+void ColormapGenerator::generateChunk(
+    const int entryCount,
+    const int firstEntry,
+    const int chunkCount,
+    Helper::cmsRGB *rgb
+) const
+{
+    cmsCIELab lab[chunkSize];
+    cmsCIELCh lch;
+    const int lastStop = m_unwrappedStops.count() - 1;
+    const qreal scale = (entryCount > 1)
+        ? static_cast<qreal>(lastStop) / (entryCount - 1)
+        : 0;
+    qreal position;
+    qreal fraction;
+    int stop;
+    for (int i = 0; i < chunkCount; ++i) {
+        position = (firstEntry + i) * scale;
+        stop = qBound(0, static_cast<int>(position), lastStop - 1);
+        fraction = position - stop;
+        const cmsCIELCh &first = m_unwrappedStops.at(stop);
+        const cmsCIELCh &second = m_unwrappedStops.at(stop + 1);
+        lch.L = first.L + (second.L - first.L) * fraction;
+        lch.C = first.C + (second.C - first.C) * fraction;
+        lch.h = first.h + (second.h - first.h) * fraction;
+        lab[i] = Helper::toLab(lch);
+    }
+
+    if (m_gamutBehaviour == FullColorDescription::outOfGamutBehaviour::preserve) {
+        m_rgbColorSpace->colorRgbBoundSimple(lab, rgb, chunkCount);
+        return;
+    }
+
+    // Gamut mapping: Only out-of-gamut entries need the boundary search.
+    m_rgbColorSpace->colorRgbUnbounded(lab, rgb, chunkCount);
+    for (int i = 0; i < chunkCount; ++i) {
+        if (Helper::inRange<cmsFloat64Number>(0, rgb[i].red, 1)
+            && Helper::inRange<cmsFloat64Number>(0, rgb[i].green, 1)
+            && Helper::inRange<cmsFloat64Number>(0, rgb[i].blue, 1)
+        ) {
+            continue;
+        }
+        rgb[i] = FullColorDescription(
+            m_rgbColorSpace,
+            lab[i],
+            FullColorDescription::outOfGamutBehaviour::sacrifyChroma
+        ).toRgb();
+    }
+}
+
+/** @brief Generates the colormap
+ * 
+ * Common implementation of the generate() overloads.
+ * 
+ * @param entryCount the number of entries
+ * @param rgb buffer for <tt>3 × entryCount</tt> values (red, green, blue
+ * for each entry) */
+template <typename T>
+void ColormapGenerator::generateEntries(const int entryCount, T *rgb) const
+{
+    const int maximumChunkCount = chunkSize;
+    Helper::cmsRGB chunk[chunkSize];
+    int chunkCount;
+    for (int start = 0; start < entryCount; start += maximumChunkCount) {
+        chunkCount = qMin(maximumChunkCount, entryCount - start);
+        generateChunk(entryCount, start, chunkCount, chunk);
+        for (int i = 0; i < chunkCount; ++i) {
+            storeChannel(chunk[i].red, rgb + 3 * (start + i));
+            storeChannel(chunk[i].green, rgb + 3 * (start + i) + 1);
+            storeChannel(chunk[i].blue, rgb + 3 * (start + i) + 2);
+        }
+    }
+}
+
+/** @brief Generates the colormap with 8 bit per channel
+ * 
+ * @param entryCount the number of entries
+ * @param rgb buffer for <tt>3 × entryCount</tt> values (red, green, blue
+ * for each entry) */
+void ColormapGenerator::generate(const int entryCount, quint8 *rgb) const
+{
+    generateEntries(entryCount, rgb);
+}
+
+/** @brief Generates the colormap with 16 bit per channel
+ * 
+ * @param entryCount the number of entries
+ * @param rgb buffer for <tt>3 × entryCount</tt> values (red, green, blue
+ * for each entry) */
+void ColormapGenerator::generate(const int entryCount, quint16 *rgb) const
+{
+    generateEntries(entryCount, rgb);
+}
+
+/** @brief Generates the colormap with floating point values
+ * 
+ * @param entryCount the number of entries
+ * @param rgb buffer for <tt>3 × entryCount</tt> values (red, green, blue
+ * for each entry, range 0..1) */
+void ColormapGenerator::generate(const int entryCount, float *rgb) const
+{
+    generateEntries(entryCount, rgb);
+}
+
+}
@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/conversionclient.h"
+
+#include <QByteArray>
+#include <QLocalSocket>
+#include <QQueue>
+
+namespace PerceptualColor {
+
+/** @brief Constructor
+ * 
+ * The client is not connected. Call connectToServer(). */
+ConversionClient::ConversionClient()
+{
+    m_socket = new QLocalSocket();
+}
+
+/** @brief Destructor
+ * 
+ * Closes the connection. */
+ConversionClient::~ConversionClient()
+{
+    delete m_socket;
+}
+
+/** @brief Maximum number of colors per request
+ * 
+ * Default value is 65536.
+ * 
+ * @sa setBatchSize() */
+int ConversionClient::batchSize() const
+{
+    return m_batchSize;
+}
+
+/** @brief Setter for batchSize()
+ * 
+ * @param newBatchSize the new value. It is bound to the range from @c 1 to
+ * ConversionProtocol::maximumCount. */
+void ConversionClient::setBatchSize(const int newBatchSize)
+{
+    m_batchSize = qBound(
+        1,
+        newBatchSize,
+        static_cast<int>(ConversionProtocol::maximumCount)
+    );
+}
+
+/** @brief Maximum number of requests that are sent before the first
+ * response is read
+ * 
+ * Default value is 4.
+ * 
+ * @sa setPipelineDepth() */
+int ConversionClient::pipelineDepth() const
+{
+    return m_pipelineDepth;
+}
+
+/** @brief Setter for pipelineDepth()
+ * 
+ * @param newPipelineDepth the new value. Values smaller than @c 1 are
+ * treated as @c 1. */
+void ConversionClient::setPipelineDepth(const int newPipelineDepth)
+{
+    m_pipelineDepth = qMax(1, newPipelineDepth);
+}
+
+/** @brief Connects to a server
+ * 
+ * An existing connection is closed first.
+ * 
+ * @param name the name of the server
+ * @param timeout timeout in milliseconds
+ * @returns @c true on success */
+bool ConversionClient::connectToServer(const QString &name, const int timeout)
+{
+    disconnectFromServer();
+    m_socket->connectToServer(name);
+    return m_socket->waitForConnected(timeout);
+}
+
+/** @brief Closes the connection */
+void ConversionClient::disconnectFromServer()
+{
+    m_socket->abort();
+}
+
+/** @brief If the client is connected */
+bool ConversionClient::isConnected() const
+{
+    return (m_socket->state() == QLocalSocket::ConnectedState);
+}
+
+/** @brief Converts colors
+ * 
+ * @param operation the conversion
+ * @param input pointer to the first of <tt>3 * count</tt> values
+ * @param output pointer to the first of <tt>3 * count</tt> values that
+ * will be written. It may be identical to @em input.
+ * @param count the number of colors
+ * @param flags ConversionProtocol::Flag values
+ * @param timeout timeout in milliseconds for each network operation
+ * @returns @c true on success. On failure, the content of @em output is
+ * undefined, and the connection is closed, because its state is
+ * unknown. */
+bool ConversionClient::convert(
+    const ConversionProtocol::Operation operation,
+    const double *input,
+    double *output,
+    const int count,
+    const quint16 flags,
+    const int timeout
+)
+{
+    if (!isConnected()) {
+        return false;
+    }
+    // Requests that have been sent, but whose response has not yet been
+    // read: id, start and count.
+    struct Pending {
+        quint32 id;
+        int start;
+        int count;
+    };
+    QQueue<Pending> pending;
+    int nextStart = 0;
+    QByteArray frame;
+    ConversionProtocol::Header header;
+    Pending request;
+    while ((nextStart < count) || !pending.isEmpty()) {
+        while ((nextStart < count) && (pending.count() < m_pipelineDepth)) {
+            request.id = m_nextId++;
+            request.start = nextStart;
+            request.count = qMin(m_batchSize, count - nextStart);
+            header.id = request.id;
+            header.code = static_cast<quint16>(operation);
+            header.flags = flags;
+            header.count = static_cast<quint32>(request.count);
+            frame.resize(
+                ConversionProtocol::headerSize
+                    + request.count * ConversionProtocol::colorSize
+            );
+            uchar *data = reinterpret_cast<uchar *>(frame.data());
+            ConversionProtocol::writeHeader(header, data);
+            ConversionProtocol::writeValues(
+                input + 3 * request.start,
+                3 * request.count,
+                data + ConversionProtocol::headerSize
+            );
+            if (m_socket->write(frame) != frame.size()) {
+                disconnectFromServer();
+                return false;
+            }
+            // Start sending without blocking.
+            m_socket->flush();
+            pending.enqueue(request);
+            nextStart += request.count;
+        }
+        request = pending.dequeue();
+        if (!readResponse(
+                request.id,
+                output + 3 * request.start,
+                request.count,
+                timeout
+            )
+        ) {
+            disconnectFromServer();
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Waits until enough data is available
+ * 
+ * Pending data is written meanwhile.
+ * 
+ * @param size the number of bytes that are needed
+ * @param timeout timeout in milliseconds for each wait
+ * @returns @c true if @em size bytes are available */
+bool ConversionClient::waitForBytes(const qint64 size, const int timeout)
+{
+    while (m_socket->bytesAvailable() < size) {
+        if (!m_socket->waitForReadyRead(timeout)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Reads a response
+ * 
+ * @param id the expected request id
+ * @param output pointer to the first of <tt>3 * count</tt> values that
+ * will be written
+ * @param count the expected number of colors
+ * @param timeout timeout in milliseconds for each wait
+ * @returns @c true on success */
+bool ConversionClient::readResponse(
+    const quint32 id,
+    double *output,
+    const int count,
+    const int timeout
+)
+{
+    if (!waitForBytes(ConversionProtocol::headerSize, timeout)) {
+        return false;
+    }
+    const QByteArray headerData = m_socket->read(ConversionProtocol::headerSize);
+    const ConversionProtocol::Header header = ConversionProtocol::readHeader(
+        reinterpret_cast<const uchar *>(headerData.constData())
+    );
+    if ((header.id != id)
+        || (header.code != static_cast<quint16>(ConversionProtocol::Status::ok))
+        || (header.count != static_cast<quint32>(count))
+    ) {
+        return false;
+    }
+    const qint64 payloadSize =
+        static_cast<qint64>(count) * ConversionProtocol::colorSize;
+    if (!waitForBytes(payloadSize, timeout)) {
+        return false;
+    }
+    const QByteArray payload = m_socket->read(payloadSize);
+    ConversionProtocol::readValues(
+        reinterpret_cast<const uchar *>(payload.constData()),
+        3 * count,
+        output
+    );
+    return true;
+}
+
+}
@@ -0,0 +1,402 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/conversionserver.h"
+
+#include "PerceptualColor/conversionprotocol.h"
+#include "PerceptualColor/gamutmapper.h"
+#include "PerceptualColor/helper.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <functional>
+
+namespace PerceptualColor {
+
+namespace {
+
+static_assert(
+    sizeof(cmsCIELab) == ConversionProtocol::colorSize,
+    "cmsCIELab must consist of exactly three double values"
+);
+static_assert(
+    sizeof(Helper::cmsRGB) == ConversionProtocol::colorSize,
+    "Helper::cmsRGB must consist of exactly three double values"
+);
+
+/** @brief Number of colors that are converted together by one thread */
+constexpr int blockSize = 4096;
+
+/** @brief Calls a function for all blocks of a range, in parallel
+ * 
+ * @param count the size of the range
+ * @param function a function that takes the start and the size of a
+ * block */
+void forEachBlock(
+    const int count,
+    const std::function<void(const int, const int)> &function
+)
+{
+    if (count <= blockSize) {
+        function(0, count);
+        return;
+    }
+    QVector<int> blockStarts;
+    for (int start = 0; start < count; start += blockSize) {
+        blockStarts.append(start);
+    }
+    QtConcurrent::blockingMap(
+        blockStarts,
+        [&function, count](const int &start) {
+            function(start, qMin(blockSize, count - start));
+        }
+    );
+}
+
+}
+
+/** @brief Constructor
+ * 
+ * @param colorSpace pointer to the color space that is used for the
+ * conversions
+ * @param parent the parent object */
+ConversionServer::ConversionServer(
+    RgbColorSpace *colorSpace,
+    QObject *parent
+) : QObject(parent)
+{
+    m_rgbColorSpace = colorSpace;
+    m_server = new QLocalServer(this);
+    connect(
+        m_server,
+        &QLocalServer::newConnection,
+        this,
+        &ConversionServer::acceptConnections
+    );
+}
+
+/** @brief Destructor
+ * 
+ * Waits until the conversions that are still running have finished. */
+ConversionServer::~ConversionServer()
+{
+    m_threadPool.waitForDone();
+}
+
+/** @brief Starts listening
+ * 
+ * @param name the name of the server. A stale socket file with the same
+ * name (from a crashed server) is removed.
+ * @returns @c true on success */
+bool ConversionServer::listen(const QString &name)
+{
+    QLocalServer::removeServer(name);
+    return m_server->listen(name);
+}
+
+/** @brief Stops listening
+ * 
+ * Existing connections are not closed. */
+void ConversionServer::close()
+{
+    m_server->close();
+}
+
+/** @brief The name of the server
+ * 
+ * @returns the name of the server, or an empty string if it is not
+ * listening. */
+QString ConversionServer::serverName() const
+{
+    return m_server->serverName();
+}
+
+/** @brief Accepts pending connections */
+void ConversionServer::acceptConnections()
+{
+    QLocalSocket *socket;
+    while (m_server->hasPendingConnections()) {
+        socket = m_server->nextPendingConnection();
+        QFutureWatcher<QByteArray> *watcher =
+            new QFutureWatcher<QByteArray>(this);
+        m_watchers.insert(socket, watcher);
+        connect(
+            watcher,
+            &QFutureWatcher<QByteArray>::finished,
+            this,
+            &ConversionServer::sendResponse
+        );
+        connect(
+            socket,
+            &QObject::destroyed,
+            this,
+            &ConversionServer::removeConnection
+        );
+        connect(
+            socket,
+            &QLocalSocket::readyRead,
+            this,
+            &ConversionServer::readRequests
+        );
+        connect(
+            socket,
+            &QLocalSocket::disconnected,
+            socket,
+            &QLocalSocket::deleteLater
+        );
+        // Data might have arrived before the connection to readyRead.
+        processRequests(socket);
+    }
+}
+
+/** @brief Reads requests from the socket that has emitted readyRead */
+void ConversionServer::readRequests()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if (socket != nullptr) {
+        processRequests(socket);
+    }
+}
+
+/** @brief Forgets a connection
+ * 
+ * A running conversion cannot be cancelled. Its result is discarded.
+ * 
+ * @param socket the socket of the connection, which is being destroyed */
+void ConversionServer::removeConnection(QObject *socket)
+{
+    QFutureWatcher<QByteArray> *watcher =
+        m_watchers.take(static_cast<QLocalSocket *>(socket));
+    if (watcher == nullptr) {
+        return;
+    }
+    disconnect(watcher, nullptr, this, nullptr);
+    if (watcher->isRunning()) {
+        connect(
+            watcher,
+            &QFutureWatcher<QByteArray>::finished,
+            watcher,
+            &QObject::deleteLater
+        );
+    } else {
+        watcher->deleteLater();
+    }
+}
+
+/** @brief Sends the result of a conversion
+ * 
+ * Called by the QFutureWatcher of the connection. Afterwards, the next
+ * requests of the connection are processed. */
+void ConversionServer::sendResponse()
+{
+    QFutureWatcher<QByteArray> *watcher =
+        static_cast<QFutureWatcher<QByteArray> *>(sender());
+    QLocalSocket *socket = m_watchers.key(watcher, nullptr);
+    if (socket == nullptr) {
+        return;
+    }
+    socket->write(watcher->result());
+    processRequests(socket);
+}
+
+/** @brief Answers the complete requests that are available on a socket
+ * 
+ * The conversion of the first complete request is started in the
+ * background and this function returns; sendResponse() continues with
+ * the remaining requests when the conversion has finished. Incomplete requests stay in the buffer of the
+ * socket until more data has arrived.
+ * 
+ * @param socket the socket */
+void ConversionServer::processRequests(QLocalSocket *socket)
+{
+    QFutureWatcher<QByteArray> *watcher = m_watchers.value(socket, nullptr);
+    if ((watcher == nullptr) || watcher->isRunning()) {
+        // The next requests are processed by sendResponse().
+        return;
+    }
+    uchar headerData[ConversionProtocol::headerSize];
+    ConversionProtocol::Header header;
+    qint64 frameSize;
+    QByteArray payload;
+    while (socket->bytesAvailable() >= ConversionProtocol::headerSize) {
+        socket->peek(
+            reinterpret_cast<char *>(headerData),
+            ConversionProtocol::headerSize
+        );
+        header = ConversionProtocol::readHeader(headerData);
+        if (header.count > ConversionProtocol::maximumCount) {
+            ConversionProtocol::Header error {
+                header.id,
+                static_cast<quint16>(ConversionProtocol::Status::tooLarge),
+                0,
+                0
+            };
+            ConversionProtocol::writeHeader(error, headerData);
+            socket->write(
+                reinterpret_cast<const char *>(headerData),
+                ConversionProtocol::headerSize
+            );
+            // The payload is not read, so the stream cannot be
+            // synchronized anymore.
+            socket->disconnectFromServer();
+            return;
+        }
+        frameSize = ConversionProtocol::headerSize
+            + static_cast<qint64>(header.count) * ConversionProtocol::colorSize;
+        if (socket->bytesAvailable() < frameSize) {
+            return;
+        }
+        socket->read(ConversionProtocol::headerSize); // already peeked
+        payload = socket->read(frameSize - ConversionProtocol::headerSize);
+        // Even small requests can take long (for example with
+        // sacrifyChroma), so no conversion runs in the thread of the
+        // sockets.
+        watcher->setFuture(QtConcurrent::run(
+            &m_threadPool,
+            this,
+            &ConversionServer::response,
+            header,
+            payload
+        ));
+        return;
+    }
+}
+
+/** @brief Converts a request
+ * 
+ * @param request the header of the request
+ * @param payload the colors of the request
+ * @returns the response frame, including its header */
+QByteArray ConversionServer::response(
+    const ConversionProtocol::Header &request,
+    const QByteArray &payload
+) const
+{
+    const int count = static_cast<int>(request.count);
+    const ConversionProtocol::Operation operation =
+        static_cast<ConversionProtocol::Operation>(request.code);
+    const bool sacrifyChroma =
+        (request.flags & ConversionProtocol::sacrifyChroma) != 0;
+    ConversionProtocol::Header header {request.id, 0, 0, request.count};
+    QByteArray result;
+    QVector<cmsCIELab> lab(count);
+    QVector<Helper::cmsRGB> rgb(count);
+    const uchar *input = reinterpret_cast<const uchar *>(payload.constData());
+
+    switch (operation) {
+    case ConversionProtocol::Operation::rgbToLab:
+    case ConversionProtocol::Operation::rgbToLch:
+        ConversionProtocol::readValues(
+            input,
+            3 * count,
+            reinterpret_cast<double *>(rgb.data())
+        );
+        forEachBlock(
+            count,
+            [this, &lab, &rgb, operation](const int start, const int blockCount) {
+                Helper::cmsRGB *const blockRgb = rgb.data() + start;
+                cmsCIELab *const blockLab = lab.data() + start;
+                for (int i = 0; i < blockCount; ++i) {
+                    blockRgb[i].red = qBound<cmsFloat64Number>(0, blockRgb[i].red, 1);
+                    blockRgb[i].green = qBound<cmsFloat64Number>(0, blockRgb[i].green, 1);
+                    blockRgb[i].blue = qBound<cmsFloat64Number>(0, blockRgb[i].blue, 1);
+                }
+                m_rgbColorSpace->colorLab(blockRgb, blockLab, blockCount);
+                if (operation == ConversionProtocol::Operation::rgbToLch) {
+                    cmsCIELCh lch;
+                    for (int i = 0; i < blockCount; ++i) {
+                        lch = Helper::toLch(blockLab[i]);
+                        blockLab[i].L = lch.L;
+                        blockLab[i].a = lch.C;
+                        blockLab[i].b = lch.h;
+                    }
+                }
+            }
+        );
+        result.resize(ConversionProtocol::headerSize + count * ConversionProtocol::colorSize);
+        ConversionProtocol::writeValues(
+            reinterpret_cast<const double *>(lab.constData()),
+            3 * count,
+            reinterpret_cast<uchar *>(result.data()) + ConversionProtocol::headerSize
+        );
+        break;
+    case ConversionProtocol::Operation::labToRgb:
+    case ConversionProtocol::Operation::lchToRgb:
+        ConversionProtocol::readValues(
+            input,
+            3 * count,
+            reinterpret_cast<double *>(lab.data())
+        );
+        if (operation == ConversionProtocol::Operation::lchToRgb) {
+            for (int i = 0; i < count; ++i) {
+                lab[i] = Helper::toLab(
+                    cmsCIELCh {lab.at(i).L, lab.at(i).a, lab.at(i).b}
+                );
+            }
+        }
+        if (sacrifyChroma) {
+            // Parallel itself
+            GamutMapper(m_rgbColorSpace).map(lab.constData(), rgb.data(), count);
+        } else {
+            forEachBlock(
+                count,
+                [this, &lab, &rgb](const int start, const int blockCount) {
+                    m_rgbColorSpace->colorRgbBoundSimple(
+                        lab.constData() + start,
+                        rgb.data() + start,
+                        blockCount
+                    );
+                }
+            );
+        }
+        result.resize(ConversionProtocol::headerSize + count * ConversionProtocol::colorSize);
+        ConversionProtocol::writeValues(
+            reinterpret_cast<const double *>(rgb.constData()),
+            3 * count,
+            reinterpret_cast<uchar *>(result.data()) + ConversionProtocol::headerSize
+        );
+        break;
+    default:
+        header.code = static_cast<quint16>(
+            ConversionProtocol::Status::unknownOperation
+        );
+        header.count = 0;
+        result.resize(ConversionProtocol::headerSize);
+        break;
+    }
+
+    ConversionProtocol::writeHeader(
+        header,
+        reinterpret_cast<uchar *>(result.data())
+    );
+    return result;
+}
+
+}
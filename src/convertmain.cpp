@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/batchconverter.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QQueue>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+/** @file
+ * 
+ * Command line tool that converts colors from stdin to stdout, using the
+ * same color management as the widgets of this library. See BatchConverter
+ * for the color formats and record formats.
+ * 
+ * The input is read in chunks. The chunks are converted in parallel on a
+ * thread pool and written in input order, so arbitrarily large input can be
+ * streamed with constant memory usage.
+ */
+
+using PerceptualColor::BatchConverter;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("perceptualcolor-convert"));
+    QTextStream errorStream(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Converts colors from stdin to stdout.")
+    );
+    parser.addHelpOption();
+    parser.addOptions({
+        {
+            QStringLiteral("from"),
+            QStringLiteral("Input color format: hex, rgb, lab or lch."),
+            QStringLiteral("format"),
+            QStringLiteral("hex")
+        },
+        {
+            QStringLiteral("to"),
+            QStringLiteral("Output color format: hex, rgb, lab or lch."),
+            QStringLiteral("format"),
+            QStringLiteral("lch")
+        },
+        {
+            QStringLiteral("records"),
+            QStringLiteral("Record format: csv, tsv or binary."),
+            QStringLiteral("format"),
+            QStringLiteral("csv")
+        },
+        {
+            QStringLiteral("sacrify-chroma"),
+            QStringLiteral(
+                "Map out-of-gamut Lab/LCh input into the gamut by reducing "
+                "the chroma. Default: clip the RGB values."
+            )
+        },
+        {
+            QStringLiteral("threads"),
+            QStringLiteral("Maximum number of worker threads."),
+            QStringLiteral("count")
+        },
+        {
+            QStringLiteral("stats"),
+            QStringLiteral("Report the throughput on stderr.")
+        }
+    });
+    parser.process(app);
+
+    BatchConverter::Settings settings;
+    if (!BatchConverter::parseColorFormat(
+            parser.value(QStringLiteral("from")),
+            &settings.from
+        )
+    ) {
+        errorStream << "Invalid value for --from\n";
+        errorStream.flush();
+        return 1;
+    }
+    if (!BatchConverter::parseColorFormat(
+            parser.value(QStringLiteral("to")),
+            &settings.to
+        )
+    ) {
+        errorStream << "Invalid value for --to\n";
+        errorStream.flush();
+        return 1;
+    }
+    const QString records = parser.value(QStringLiteral("records"));
+    if (records == QStringLiteral("csv")) {
+        settings.recordFormat = BatchConverter::RecordFormat::csv;
+    } else if (records == QStringLiteral("tsv")) {
+        settings.recordFormat = BatchConverter::RecordFormat::tsv;
+    } else if (records == QStringLiteral("binary")) {
+        settings.recordFormat = BatchConverter::RecordFormat::binary;
+    } else {
+        errorStream << "Invalid value for --records\n";
+        errorStream.flush();
+        return 1;
+    }
+    if ((settings.recordFormat == BatchConverter::RecordFormat::binary)
+        && ((settings.from == BatchConverter::ColorFormat::hex)
+            || (settings.to == BatchConverter::ColorFormat::hex))
+    ) {
+        errorStream << "hex is not available for binary records\n";
+        errorStream.flush();
+        return 1;
+    }
+    settings.sacrifyChroma = parser.isSet(QStringLiteral("sacrify-chroma"));
+    if (parser.isSet(QStringLiteral("threads"))) {
+        bool ok;
+        const int threads = parser.value(QStringLiteral("threads")).toInt(&ok);
+        if ((!ok) || (threads < 1)) {
+            errorStream << "Invalid value for --threads\n";
+            errorStream.flush();
+            return 1;
+        }
+        QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    }
+
+    QFile input;
+    QFile output;
+    if (!input.open(stdin, QIODevice::ReadOnly)
+        || !output.open(stdout, QIODevice::WriteOnly)
+    ) {
+        errorStream << "Cannot open stdin or stdout\n";
+        errorStream.flush();
+        return 1;
+    }
+
+    PerceptualColor::RgbColorSpace colorSpace;
+    const BatchConverter converter(&colorSpace);
+    QElapsedTimer timer;
+    timer.start();
+
+    // Chunks are converted in parallel, but written in input order. The
+    // number of chunks in flight is limited to keep the memory usage
+    // constant.
+    const int maxPendingChunks =
+        2 * qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    QQueue<QFuture<BatchConverter::ChunkResult> > pendingChunks;
+    qint64 totalCount = 0;
+    qint64 totalInvalidCount = 0;
+    const auto writeNextChunk = [&]() {
+        const BatchConverter::ChunkResult result =
+            pendingChunks.dequeue().result();
+        output.write(result.output);
+        totalCount += result.count;
+        totalInvalidCount += result.invalidCount;
+    };
+    QList<QByteArray> chunk =
+        BatchConverter::readChunk(&input, settings.recordFormat);
+    while (!chunk.isEmpty()) {
+        pendingChunks.enqueue(QtConcurrent::run(
+            &converter,
+            &BatchConverter::convertChunk,
+            settings,
+            chunk
+        ));
+        while (pendingChunks.count() >= maxPendingChunks) {
+            writeNextChunk();
+        }
+        chunk = BatchConverter::readChunk(&input, settings.recordFormat);
+    }
+    while (!pendingChunks.isEmpty()) {
+        writeNextChunk();
+    }
+    output.flush();
+
+    if (parser.isSet(QStringLiteral("stats"))) {
+        const qreal seconds = qMax<qint64>(timer.nsecsElapsed(), 1) / 1e9;
+        errorStream << totalCount << " colors in " << seconds << " s ("
+            << qRound64(totalCount / seconds) << " colors/s)\n";
+        errorStream.flush();
+        if (settings.sacrifyChroma) {
+            errorStream << "Conversion cache: "
+                << colorSpace.conversionCacheHits() << " hits, "
+                << colorSpace.conversionCacheMisses() << " misses\n";
+            errorStream.flush();
+        }
+    }
+    if (totalInvalidCount > 0) {
+        errorStream << totalInvalidCount
+            << " records could not be parsed or are incomplete\n";
+        errorStream.flush();
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/conversionprotocol.h"
+#include "PerceptualColor/conversionserver.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QThreadPool>
+
+/** @file
+ * 
+ * Daemon that serves color conversions to other processes over a local
+ * socket. See ConversionServer for the details, and ConversionClient for
+ * the client library.
+ */
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("perceptualcolor-daemon"));
+    QTextStream errorStream(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Serves color conversions over a local socket.")
+    );
+    parser.addHelpOption();
+    parser.addOptions({
+        {
+            QStringLiteral("name"),
+            QStringLiteral("Name of the local socket."),
+            QStringLiteral("name"),
+            QString::fromLatin1(
+                PerceptualColor::ConversionProtocol::defaultServerName
+            )
+        },
+        {
+            QStringLiteral("profile"),
+            QStringLiteral("RGB ICC profile. Default: the build-in sRGB."),
+            QStringLiteral("file")
+        },
+        {
+            QStringLiteral("threads"),
+            QStringLiteral("Maximum number of worker threads."),
+            QStringLiteral("count")
+        }
+    });
+    parser.process(app);
+
+    if (parser.isSet(QStringLiteral("threads"))) {
+        bool ok;
+        const int threads = parser.value(QStringLiteral("threads")).toInt(&ok);
+        if ((!ok) || (threads < 1)) {
+            errorStream << "Invalid value for --threads\n";
+            errorStream.flush();
+            return 1;
+        }
+        QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    }
+
+    PerceptualColor::RgbColorSpace *colorSpace;
+    try {
+        if (parser.isSet(QStringLiteral("profile"))) {
+            colorSpace = new PerceptualColor::RgbColorSpace(
+                parser.value(QStringLiteral("profile")),
+                &app
+            );
+        } else {
+            colorSpace = new PerceptualColor::RgbColorSpace(&app);
+        }
+    } catch (int) {
+        errorStream << "Cannot load the color space\n";
+        errorStream.flush();
+        return 1;
+    }
+
+    PerceptualColor::ConversionServer server(colorSpace);
+    if (!server.listen(parser.value(QStringLiteral("name")))) {
+        errorStream << "Cannot listen on "
+            << parser.value(QStringLiteral("name")) << '\n';
+        errorStream.flush();
+        return 1;
+    }
+    return app.exec();
+}
@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/diagramrenderer.h"
+
+#include "PerceptualColor/chromahuediagram.h"
+#include "PerceptualColor/chromalightnessdiagram.h"
+#include "PerceptualColor/gamutvolume.h"
+#include "PerceptualColor/simplecolorwheel.h"
+
+#include <functional>
+
+#include <QFile>
+#include <QtConcurrent>
+
+namespace PerceptualColor {
+
+namespace {
+
+/** @brief Number of diagram pixels from which a batch builds the gamut
+ * volume
+ * 
+ * With sRGB, the volume saves about 0.24 µs per pixel, and building it
+ * takes about 1.2 s on a single core.
+ * 
+ * @sa DiagramRenderer::prepareGamutVolume() */
+constexpr qint64 gamutVolumeBatchPixels = 5 * 1024 * 1024;
+
+}
+
+/** @brief Constructor
+ * 
+ * @param colorSpace the color space. Must stay alive as long as this
+ * object is used. */
+DiagramRenderer::DiagramRenderer(const RgbColorSpace *colorSpace)
+{
+    m_rgbColorSpace = colorSpace;
+}
+
+/** @brief Renders a single diagram
+ * 
+ * This function is thread-safe.
+ * 
+ * @param job the parameters of the diagram
+ * @returns The diagram, or a null image if the size is too small. */
+QImage DiagramRenderer::render(const Job &job) const
+{
+    const int squareSize = qMin(job.size.width(), job.size.height());
+    switch (job.type) {
+    case DiagramType::chromaHue:
+        return ChromaHueDiagram::generateDiagramImage(
+            m_rgbColorSpace,
+            squareSize,
+            job.maxChroma,
+            job.lightness,
+            job.border,
+            RgbColorSpace::TransformPrecision::float32,
+            nullptr,
+            GamutVolume::cachedForColorSpace(m_rgbColorSpace).data()
+        );
+    case DiagramType::chromaLightness:
+        if ((job.size.width() < 2) || (job.size.height() < 2)) {
+            return QImage();
+        }
+        return ChromaLightnessDiagram::generateDiagramImage(
+            m_rgbColorSpace,
+            job.hue,
+            job.size,
+            RgbColorSpace::TransformPrecision::float32,
+            nullptr,
+            GamutVolume::cachedForColorSpace(m_rgbColorSpace).data()
+        );
+    case DiagramType::colorWheel:
+        return SimpleColorWheel::generateWheelImage(
+            m_rgbColorSpace,
+            squareSize,
+            job.border,
+            job.wheelThickness,
+            job.lightness,
+            job.chroma
+        );
+    }
+    return QImage();
+}
+
+/** @brief Renders various diagrams in parallel
+ * 
+ * The jobs are distributed on QThreadPool::globalInstance(). This function
+ * blocks until all diagrams are rendered.
+ * 
+ * @param jobs the parameters of the diagrams
+ * @returns The diagrams, in the same order as @em jobs. */
+QList<QImage> DiagramRenderer::renderBatch(const QList<Job> &jobs) const
+{
+    prepareGamutVolume(jobs);
+    const std::function<QImage(const Job &)> renderFunction =
+        [this](const Job &job) {
+            return render(job);
+        };
+    return QtConcurrent::blockingMapped<QList<QImage> >(jobs, renderFunction);
+}
+
+/** @brief Renders various diagrams in parallel and writes them to files
+ * 
+ * Each job is rendered and written in the same worker thread, so that
+ * not all images have to be kept in memory at the same time. This function
+ * blocks until all jobs are done.
+ * 
+ * @param jobs the parameters of the diagrams, including Job::fileName
+ * @param format the file format
+ * @returns The number of files that have been written successfully. */
+int DiagramRenderer::writeBatch(
+    const QList<Job> &jobs,
+    const OutputFormat format
+) const
+{
+    prepareGamutVolume(jobs);
+    const std::function<bool(const Job &)> writeFunction =
+        [this, format](const Job &job) {
+            return writeImage(render(job), job.fileName, format);
+        };
+    const QList<bool> results =
+        QtConcurrent::blockingMapped<QList<bool> >(jobs, writeFunction);
+    return results.count(true);
+}
+
+/** @brief Builds the gamut volume for large batches
+ * 
+ * render() uses the shared volume of GamutVolume::forColorSpace() if it
+ * has already been built, but never builds it itself, because a single
+ * diagram is faster without. This function builds it if the chroma-hue and
+ * chroma-lightness diagrams of @em jobs have at least
+ * @ref gamutVolumeBatchPixels pixels together.
+ * 
+ * @param jobs the parameters of the diagrams */
+void DiagramRenderer::prepareGamutVolume(const QList<Job> &jobs) const
+{
+    qint64 pixels = 0;
+    for (const Job &job : jobs) {
+        if (job.type != DiagramType::colorWheel) {
+            pixels += static_cast<qint64>(job.size.width()) * job.size.height();
+        }
+    }
+    if (pixels >= gamutVolumeBatchPixels) {
+        GamutVolume::forColorSpace(m_rgbColorSpace);
+    }
+}
+
+/** @brief Raw pixel data of an image
+ * 
+ * @param image the image
+ * @returns The pixels of @em image row by row, from top to bottom, without
+ * any padding. Each pixel has four bytes: red, green, blue and alpha
+ * (not premultiplied). The size is <tt>4 × width × height</tt> bytes. */
+QByteArray DiagramRenderer::rawBuffer(const QImage &image)
+{
+    const QImage rgbaImage = image.convertToFormat(QImage::Format_RGBA8888);
+    const int bytesPerRow = 4 * rgbaImage.width();
+    QByteArray result;
+    result.reserve(bytesPerRow * rgbaImage.height());
+    for (int y = 0; y < rgbaImage.height(); ++y) {
+        result.append(
+            reinterpret_cast<const char *>(rgbaImage.constScanLine(y)),
+            bytesPerRow
+        );
+    }
+    return result;
+}
+
+/** @brief Writes an image to a file
+ * 
+ * This function is thread-safe.
+ * 
+ * @param image the image
+ * @param fileName the file name
+ * @param format the file format
+ * @returns @c true on success, @c false otherwise (also if @em image is
+ * a null image). */
+bool DiagramRenderer::writeImage(
+    const QImage &image,
+    const QString &fileName,
+    const OutputFormat format
+)
+{
+    if (image.isNull()) {
+        return false;
+    }
+    if (format == OutputFormat::png) {
+        return image.save(fileName, "PNG");
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    const QByteArray buffer = rawBuffer(image);
+    return (file.write(buffer) == buffer.size());
+}
+
+}
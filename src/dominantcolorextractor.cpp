@@ -0,0 +1,353 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/dominantcolorextractor.h"
+
+#include "PerceptualColor/helper.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+
+#include <QtConcurrent>
+#include <QtMath>
+
+namespace PerceptualColor {
+
+namespace {
+
+/** @brief Number of samples per block of the parallel Lloyd iterations */
+constexpr int blockSize = 16384;
+
+/** @brief Convergence threshold of the Lloyd iterations
+ * 
+ * The iterations stop once no cluster center moves farther than this
+ * euclidean distance in Lab (ΔE*76). Far below any visible difference. */
+constexpr cmsFloat64Number convergenceDistance = 0.001;
+
+/** @brief Partial sums of a block of samples during a Lloyd iteration */
+struct BlockSums {
+    QVector<cmsCIELab> sums;
+    QVector<int> counts;
+};
+
+cmsFloat64Number distanceSquared(const cmsCIELab &first, const cmsCIELab &second)
+{
+    const cmsFloat64Number dL = first.L - second.L;
+    const cmsFloat64Number da = first.a - second.a;
+    const cmsFloat64Number db = first.b - second.b;
+    return dL * dL + da * da + db * db;
+}
+
+int nearestCenter(const cmsCIELab &sample, const QVector<cmsCIELab> &centers)
+{
+    int result = 0;
+    cmsFloat64Number bestDistance = distanceSquared(sample, centers.at(0));
+    cmsFloat64Number distance;
+    for (int i = 1; i < centers.count(); ++i) {
+        distance = distanceSquared(sample, centers.at(i));
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            result = i;
+        }
+    }
+    return result;
+}
+
+/** @brief k-means++ seeding
+ * 
+ * @param samples the samples (not empty)
+ * @param clusterCount the requested number of centers
+ * @returns The centers. Less than @em clusterCount if there are less
+ * distinct samples. */
+QVector<cmsCIELab> seedCenters(
+    const QVector<cmsCIELab> &samples,
+    const int clusterCount
+)
+{
+    // Fixed seed: The results should be reproducible.
+    std::mt19937 generator(1);
+    QVector<cmsCIELab> centers;
+    centers.append(
+        samples.at(
+            std::uniform_int_distribution<int>(0, samples.count() - 1)(generator)
+        )
+    );
+    QVector<cmsFloat64Number> distances(samples.count());
+    for (int i = 0; i < samples.count(); ++i) {
+        distances[i] = distanceSquared(samples.at(i), centers.at(0));
+    }
+    cmsFloat64Number total;
+    cmsFloat64Number threshold;
+    int chosen;
+    while (centers.count() < clusterCount) {
+        total = 0;
+        for (const cmsFloat64Number distance : distances) {
+            total += distance;
+        }
+        if (total <= 0) {
+            // All samples are identical to one of the centers.
+            break;
+        }
+        // Choose a sample with a probability proportional to its squared
+        // distance to the nearest center.
+        threshold = std::uniform_real_distribution<cmsFloat64Number>(0, total)(generator);
+        chosen = samples.count() - 1;
+        for (int i = 0; i < samples.count(); ++i) {
+            threshold -= distances.at(i);
+            if (threshold < 0) {
+                chosen = i;
+                break;
+            }
+        }
+        centers.append(samples.at(chosen));
+        for (int i = 0; i < samples.count(); ++i) {
+            distances[i] = qMin(
+                distances.at(i),
+                distanceSquared(samples.at(i), centers.last())
+            );
+        }
+    }
+    return centers;
+}
+
+}
+
+/** @brief Constructor
+ * 
+ * @param colorSpace the color space. Must stay alive as long as this
+ * object is used. */
+DominantColorExtractor::DominantColorExtractor(RgbColorSpace *colorSpace)
+{
+    m_rgbColorSpace = colorSpace;
+}
+
+/** @brief Maximum number of Lloyd iterations
+ * 
+ * The iterations stop earlier when the centers do not move anymore.
+ * Default is 20.
+ * 
+ * @sa setMaximumIterations() */
+int DominantColorExtractor::maximumIterations() const
+{
+    return m_maximumIterations;
+}
+
+/** @brief Setter for the maximumIterations() property */
+void DominantColorExtractor::setMaximumIterations(const int maximumIterations)
+{
+    m_maximumIterations = qMax(0, maximumIterations);
+}
+
+/** @brief Maximum number of pixels that are sampled from an image
+ * 
+ * Default is 250000.
+ * 
+ * @sa setMaximumSamples() */
+int DominantColorExtractor::maximumSamples() const
+{
+    return m_maximumSamples;
+}
+
+/** @brief Setter for the maximumSamples() property */
+void DominantColorExtractor::setMaximumSamples(const int maximumSamples)
+{
+    m_maximumSamples = qMax(1, maximumSamples);
+}
+
+/** @brief The Lab values of the sampled pixels
+ * 
+ * The pixels are sampled on a regular grid. Rows are read and converted
+ * in parallel, row by row, so memory usage depends only on the number of
+ * samples, and not on the image size. */
+QVector<cmsCIELab> DominantColorExtractor::samples(const QImage &image) const
+{
+    const int width = image.width();
+    const qint64 pixelCount = static_cast<qint64>(width) * image.height();
+    int step = 1;
+    if (pixelCount > m_maximumSamples) {
+        step = qCeil(qSqrt(static_cast<qreal>(pixelCount) / m_maximumSamples));
+    }
+    QVector<int> rows;
+    for (int y = step / 2; y < image.height(); y += step) {
+        rows.append(y);
+    }
+    const bool directAccess = (image.format() == QImage::Format_RGB32)
+        || (image.format() == QImage::Format_ARGB32)
+        || (image.format() == QImage::Format_ARGB32_Premultiplied);
+    const bool premultiplied =
+        (image.format() == QImage::Format_ARGB32_Premultiplied);
+    const std::function<QVector<cmsCIELab>(const int &)> convertRow =
+        [this, &image, width, step, directAccess, premultiplied](const int &y) {
+            QImage rowImage;
+            const QRgb *pixels;
+            if (directAccess) {
+                pixels = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            } else {
+                rowImage = image.copy(0, y, width, 1)
+                    .convertToFormat(QImage::Format_ARGB32);
+                pixels = reinterpret_cast<const QRgb *>(rowImage.constScanLine(0));
+            }
+            QVector<Helper::cmsRGB> rgb;
+            rgb.reserve(width / step + 1);
+            QRgb pixel;
+            for (int x = step / 2; x < width; x += step) {
+                pixel = premultiplied ? qUnpremultiply(pixels[x]) : pixels[x];
+                if (qAlpha(pixel) == 0) {
+                    continue;
+                }
+                rgb.append(Helper::cmsRGB {
+                    qRed(pixel) / static_cast<cmsFloat64Number>(255),
+                    qGreen(pixel) / static_cast<cmsFloat64Number>(255),
+                    qBlue(pixel) / static_cast<cmsFloat64Number>(255)
+                });
+            }
+            QVector<cmsCIELab> lab(rgb.count());
+            m_rgbColorSpace->colorLab(rgb.constData(), lab.data(), rgb.count());
+            return lab;
+        };
+    const QList<QVector<cmsCIELab> > rowSamples =
+        QtConcurrent::blockingMapped<QList<QVector<cmsCIELab> > >(rows, convertRow);
+    QVector<cmsCIELab> result;
+    for (const QVector<cmsCIELab> &row : rowSamples) {
+        result += row;
+    }
+    return result;
+}
+
+/** @brief Extracts the dominant colors of an image
+ * 
+ * This function blocks until the work is done.
+ * 
+ * @param image the image
+ * @param clusterCount the requested number of colors
+ * @returns The dominant colors, sorted by descending weight. There might
+ * be less than @em clusterCount colors if the image has less distinct
+ * colors. An empty list if the image has no opaque pixels. */
+QVector<DominantColorExtractor::Cluster> DominantColorExtractor::extract(
+    const QImage &image,
+    const int clusterCount
+) const
+{
+    QVector<Cluster> result;
+    const QVector<cmsCIELab> sampleList = samples(image);
+    if (sampleList.isEmpty() || (clusterCount < 1)) {
+        return result;
+    }
+
+    QVector<cmsCIELab> centers = seedCenters(sampleList, clusterCount);
+    QVector<int> blockStarts;
+    for (int start = 0; start < sampleList.count(); start += blockSize) {
+        blockStarts.append(start);
+    }
+    const std::function<BlockSums(const int &)> sumBlock =
+        [&sampleList, &centers](const int &start) {
+            BlockSums block;
+            block.sums.fill(cmsCIELab {0, 0, 0}, centers.count());
+            block.counts.fill(0, centers.count());
+            const int end = qMin(start + blockSize, sampleList.count());
+            int center;
+            for (int i = start; i < end; ++i) {
+                center = nearestCenter(sampleList.at(i), centers);
+                block.sums[center].L += sampleList.at(i).L;
+                block.sums[center].a += sampleList.at(i).a;
+                block.sums[center].b += sampleList.at(i).b;
+                ++block.counts[center];
+            }
+            return block;
+        };
+
+    // Lloyd iterations. The last pass is only for the final counts.
+    QVector<int> counts;
+    cmsFloat64Number maximumMove;
+    cmsCIELab newCenter;
+    for (int iteration = 0; iteration <= m_maximumIterations; ++iteration) {
+        const QList<BlockSums> blocks =
+            QtConcurrent::blockingMapped<QList<BlockSums> >(blockStarts, sumBlock);
+        QVector<cmsCIELab> sums(centers.count(), cmsCIELab {0, 0, 0});
+        counts.fill(0, centers.count());
+        for (const BlockSums &block : blocks) {
+            for (int i = 0; i < centers.count(); ++i) {
+                sums[i].L += block.sums.at(i).L;
+                sums[i].a += block.sums.at(i).a;
+                sums[i].b += block.sums.at(i).b;
+                counts[i] += block.counts.at(i);
+            }
+        }
+        if (iteration == m_maximumIterations) {
+            break;
+        }
+        maximumMove = 0;
+        for (int i = 0; i < centers.count(); ++i) {
+            if (counts.at(i) == 0) {
+                // Empty cluster: Keep the center.
+                continue;
+            }
+            newCenter.L = sums.at(i).L / counts.at(i);
+            newCenter.a = sums.at(i).a / counts.at(i);
+            newCenter.b = sums.at(i).b / counts.at(i);
+            maximumMove = qMax(maximumMove, distanceSquared(newCenter, centers.at(i)));
+            centers[i] = newCenter;
+        }
+        if (maximumMove < convergenceDistance * convergenceDistance) {
+            // Converged. Do one more pass for the final counts.
+            const QList<BlockSums> finalBlocks =
+                QtConcurrent::blockingMapped<QList<BlockSums> >(blockStarts, sumBlock);
+            counts.fill(0, centers.count());
+            for (const BlockSums &block : finalBlocks) {
+                for (int i = 0; i < centers.count(); ++i) {
+                    counts[i] += block.counts.at(i);
+                }
+            }
+            break;
+        }
+    }
+
+    for (int i = 0; i < centers.count(); ++i) {
+        if (counts.at(i) == 0) {
+            continue;
+        }
+        result.append(Cluster {
+            FullColorDescription(
+                m_rgbColorSpace,
+                centers.at(i),
+                FullColorDescription::outOfGamutBehaviour::sacrifyChroma
+            ),
+            static_cast<qreal>(counts.at(i)) / sampleList.count()
+        });
+    }
+    std::stable_sort(
+        result.begin(),
+        result.end(),
+        [](const Cluster &first, const Cluster &second) {
+            return first.weight > second.weight;
+        }
+    );
+    return result;
+}
+
+}
@@ -26,7 +26,7 @@ namespace PerceptualColor {
 /** @brief Constructor for an invalid object. */
 FullColorDescription::FullColorDescription()
 {
-    m_valid = false;
+    // All data members are initialized in the class declaration.
 }
 
 // TODO The LCh-hue (and so the graphical widgets) jumps forward and backward
@@ -49,13 +49,8 @@ FullColorDescription::FullColorDescription()
 FullColorDescription::FullColorDescription(RgbColorSpace *colorSpace, const Helper::cmsRGB &rgb, qreal alpha)
 {
     m_rgb = rgb;
-    m_rgbQColor = QColor::fromRgbF(m_rgb.red, m_rgb.green, m_rgb.blue, alpha);
-    m_hsvQColor = m_rgbQColor.toHsv();
-    m_lab = colorSpace->colorLab(rgb);
-    m_lch = Helper::toLch(m_lab);
+    m_lch = Helper::toLch(colorSpace->colorLab(rgb));
     m_alpha = alpha;
-    m_rgbQColor.setAlphaF(alpha);
-    m_hsvQColor.setAlphaF(alpha);
     m_valid = true;
 }
 
@@ -69,28 +64,19 @@ FullColorDescription::FullColorDescription(RgbColorSpace *colorSpace, const Help
 FullColorDescription::FullColorDescription(RgbColorSpace *colorSpace, QColor color)
 {
     if (!color.isValid()) {
-        m_valid = false;
         return;
     }
-    switch (color.spec()) {
-        case QColor::Spec::Hsv:
-            m_hsvQColor = color;
-            m_rgbQColor = color.toRgb();
-            break;
-        case QColor::Spec::Rgb:
-            m_rgbQColor = color;
-            m_hsvQColor = color.toHsv();
-            break;
-        default:
-            m_rgbQColor = color.toRgb();
-            m_hsvQColor = color.toHsv();
-            break;
+    if (color.spec() == QColor::Spec::Hsv) {
+        // Keep the original HSV value, which cannot be recovered from RGB
+        // for achromatic colors.
+        m_hsvQColor = color;
     }
-    m_rgb.red = m_rgbQColor.redF();
-    m_rgb.green = m_rgbQColor.greenF();
-    m_rgb.blue = m_rgbQColor.blueF();
-    m_lab = colorSpace->colorLab(m_rgbQColor);
-    m_lch = Helper::toLch(m_lab);
+    // QColor::redF() and friends convert automatically from other
+    // color specs (HSV, CMYK…) to RGB.
+    m_rgb.red = color.redF();
+    m_rgb.green = color.greenF();
+    m_rgb.blue = color.blueF();
+    m_lch = Helper::toLch(colorSpace->colorLab(m_rgb));
     m_alpha = color.alphaF();
     m_valid = true;
 }
@@ -106,13 +92,7 @@ FullColorDescription::FullColorDescription(RgbColorSpace *colorSpace, const cmsC
 {
     m_lch = Helper::toLch(lab);
     normalizeLch();
-    if (behaviour == outOfGamutBehaviour::sacrifyChroma) {
-        moveChromaIntoGamut(colorSpace);
-    }
-    m_lab = Helper::toLab(m_lch);
-    m_rgb = colorSpace->colorRgbBoundSimple(m_lab);
-    m_rgbQColor = QColor::fromRgbF(m_rgb.red, m_rgb.green, m_rgb.blue, alpha);
-    m_hsvQColor = m_rgbQColor.toHsv();
+    convertLch(colorSpace, behaviour);
     m_alpha = alpha;
     m_valid = true;
 }
@@ -133,56 +113,64 @@ FullColorDescription::FullColorDescription(
 {
     m_lch = lch;
     normalizeLch();
-    if (behaviour == outOfGamutBehaviour::sacrifyChroma) {
-        moveChromaIntoGamut(colorSpace);
-    }
-    m_lab = Helper::toLab(m_lch);
-    m_rgb = colorSpace->colorRgbBoundSimple(m_lab);
-    m_rgbQColor = QColor::fromRgbF(m_rgb.red, m_rgb.green, m_rgb.blue, alpha);
-    m_hsvQColor = m_rgbQColor.toHsv();
+    convertLch(colorSpace, behaviour);
     m_alpha = alpha;
-    m_rgbQColor.setAlphaF(alpha);
-    m_hsvQColor.setAlphaF(alpha);
     m_valid = true;
 }
 
+/** @brief Calculates m_rgb from m_lch
+ * 
+ * Applies also the gamut mapping to m_lch if requested. Uses the
+ * conversion cache of the color space, because during interactive use
+ * the same conversions are done again and again.
+ * 
+ * @param colorSpace the color space
+ * @param behaviour the out-of-gamut behaviour
+ * @pre m_lch is normalized. */
+void FullColorDescription::convertLch(
+    RgbColorSpace *colorSpace,
+    outOfGamutBehaviour behaviour
+)
+{
+    const bool sacrifyChroma =
+        (behaviour == outOfGamutBehaviour::sacrifyChroma);
+    RgbColorSpace::LchConversion conversion;
+    if (colorSpace->lookupConversion(m_lch, sacrifyChroma, &conversion)) {
+        m_lch = conversion.lch;
+        m_rgb = conversion.rgb;
+        return;
+    }
+    const cmsCIELCh requestedLch = m_lch;
+    if (sacrifyChroma) {
+        moveChromaIntoGamut(colorSpace);
+    }
+    m_rgb = colorSpace->colorRgbBoundSimple(Helper::toLab(m_lch));
+    conversion.lch = m_lch;
+    conversion.rgb = m_rgb;
+    colorSpace->storeConversion(requestedLch, sacrifyChroma, conversion);
+}
+
 /** Makes sure that m_lch() will be within the gamut.
- * Implements outOfGamutBehaviour::sacrifyChroma */
+ * Implements outOfGamutBehaviour::sacrifyChroma
+ * 
+ * The search for the gamut boundary is done by
+ * RgbColorSpace::boundaryChroma(). */
 void FullColorDescription::moveChromaIntoGamut(RgbColorSpace *colorSpace)
 {
-    // Test special case: If we are yet in-gamut…
-    if (colorSpace->inGamut(m_lch)) {
+    const cmsFloat64Number chroma = colorSpace->boundaryChroma(m_lch);
+    if (chroma >= 0) {
+        m_lch.C = chroma;
         return;
     }
 
-    // Now we know: We are out-of-gamut…
-    cmsCIELCh lowerChroma {m_lch.L, 0, m_lch.h};
-    cmsCIELCh upperChroma {m_lch};
-    cmsCIELCh candidate;
-    if (colorSpace->inGamut(lowerChroma)) {
-        // Now we know for sure that lowerChroma is in-gamut and upperChroma is out-of-gamut…
-        candidate = upperChroma;
-        while (upperChroma.C - lowerChroma.C > Helper::gamutPrecision) {
-            // Our test candidate is half the way between lowerChroma and upperChroma:
-            candidate.C = (
-                (lowerChroma.C + upperChroma.C) / 2
-            );
-            if (colorSpace->inGamut(candidate)) {
-                lowerChroma = candidate;
-            } else {
-                upperChroma = candidate;
-            }
-        }
-        m_lch = lowerChroma;
+    // Even chroma 0 is out-of-gamut at this lightness…
+    if (m_lch.L < colorSpace->blackpointL()) {
+        m_lch.L = colorSpace->blackpointL();
+        m_lch.C = 0;
     } else {
-        if (m_lch.L < colorSpace->blackpointL()) {
-            m_lch.L = colorSpace->blackpointL();
+        if (m_lch.L > colorSpace->whitepointL()) {
+            m_lch.L = colorSpace->whitepointL();
             m_lch.C = 0;
-        } else {
-            if (m_lch.L > colorSpace->whitepointL()) {
-                m_lch.L = colorSpace->blackpointL();
-                m_lch.C = 0;
-            }
         }
     }
 }
@@ -191,29 +179,28 @@ void FullColorDescription::moveChromaIntoGamut(RgbColorSpace *colorSpace)
 void FullColorDescription::setAlpha(qreal alpha)
 {
     m_alpha = alpha;
-    m_hsvQColor.setAlphaF(alpha);
-    m_rgbQColor.setAlphaF(alpha);
 }
 
 /**
+ * Compares only the canonical data (LCh and alpha) and the validity. All
+ * other representations are derived from these.
+ * 
  * @returns true if equal, otherwise false.
  */
 bool FullColorDescription::operator==(const FullColorDescription& other) const
 {
+    if (m_valid != other.m_valid) {
+        return false;
+    }
+    if (!m_valid) {
+        // All invalid objects are considered equal.
+        return true;
+    }
     return (
-        (m_rgb.red == other.m_rgb.red) &&
-        (m_rgb.green == other.m_rgb.green) &&
-        (m_rgb.blue == other.m_rgb.blue) &&
-        (m_lab.L == other.m_lab.L) &&
-        (m_lab.a == other.m_lab.a) &&
-        (m_lab.b == other.m_lab.b) &&
         (m_lch.L == other.m_lch.L) &&
         (m_lch.C == other.m_lch.C) &&
         (m_lch.h == other.m_lch.h) &&
-        (m_alpha == other.m_alpha) &&
-        (m_rgbQColor == other.m_rgbQColor) &&
-        (m_hsvQColor == other.m_hsvQColor) &&
-        (m_valid == other.m_valid)
+        (m_alpha == other.m_alpha)
     );
 }
 
@@ -235,20 +222,36 @@ Helper::cmsRGB FullColorDescription::toRgb() const
 }
 
 /**
- * @returns QColor object corresponding at rgb()
+ * @returns QColor object corresponding at rgb(), including the alpha
+ * channel. If this object is invalid, an invalid QColor.
  */
 QColor FullColorDescription::toRgbQColor() const
 {
-    return m_rgbQColor;
+    if (!m_valid) {
+        return QColor();
+    }
+    return QColor::fromRgbF(m_rgb.red, m_rgb.green, m_rgb.blue, m_alpha);
 }
 
 
 /**
- * @returns QColor object corresponding at hsv
+ * @returns QColor object corresponding at hsv, including the alpha
+ * channel. If this object is invalid, an invalid QColor. If this object
+ * was constructed from a QColor with HSV spec, exactly this HSV value.
+ * Otherwise, the HSV value is derived from RGB; note that in this case
+ * for achromatic colors, QColor::hsvHueF() is <tt>-1</tt>.
  */
 QColor FullColorDescription::toHsvQColor() const
 {
-    return m_hsvQColor;
+    if (!m_valid) {
+        return QColor();
+    }
+    if (m_hsvQColor.isValid()) {
+        QColor result = m_hsvQColor;
+        result.setAlphaF(m_alpha);
+        return result;
+    }
+    return toRgbQColor().toHsv();
 }
 
 /**
@@ -256,7 +259,7 @@ QColor FullColorDescription::toHsvQColor() const
  */
 cmsCIELab FullColorDescription::toLab() const
 {
-    return m_lab;
+    return Helper::toLab(m_lch);
 }
 
 /**
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/gamutmapper.h"
+
+#include "PerceptualColor/fullcolordescription.h"
+
+#include <QHash>
+#include <QVector>
+#include <QtConcurrent>
+
+namespace PerceptualColor {
+
+namespace {
+
+/** @brief Key of the per-tile memo of GamutMapper
+ * 
+ * The Lab value, quantized with RgbColorSpace::conversionCacheQuantum,
+ * like the keys of the conversion cache of RgbColorSpace. */
+struct MemoKey {
+    qint64 lightness;
+    qint64 a;
+    qint64 b;
+};
+
+bool operator==(const MemoKey &first, const MemoKey &second)
+{
+    return (first.lightness == second.lightness)
+        && (first.a == second.a)
+        && (first.b == second.b);
+}
+
+uint qHash(const MemoKey &key, uint seed = 0)
+{
+    return ::qHash(key.lightness, seed)
+        ^ ::qHash(key.a, seed + 1)
+        ^ ::qHash(key.b, seed + 2);
+}
+
+MemoKey memoKey(const cmsCIELab &Lab)
+{
+    return MemoKey {
+        qRound64(Lab.L / RgbColorSpace::conversionCacheQuantum),
+        qRound64(Lab.a / RgbColorSpace::conversionCacheQuantum),
+        qRound64(Lab.b / RgbColorSpace::conversionCacheQuantum)
+    };
+}
+
+bool inGamut(const Helper::cmsRGB &rgb)
+{
+    return Helper::inRange<cmsFloat64Number>(0, rgb.red, 1)
+        && Helper::inRange<cmsFloat64Number>(0, rgb.green, 1)
+        && Helper::inRange<cmsFloat64Number>(0, rgb.blue, 1);
+}
+
+}
+
+/** @brief Constructor
+ * 
+ * @param colorSpace the color space. Must stay alive as long as this
+ * object is used. */
+GamutMapper::GamutMapper(RgbColorSpace *colorSpace)
+{
+    m_rgbColorSpace = colorSpace;
+}
+
+/** @brief Maps a single tile
+ * 
+ * This function is thread-safe.
+ * 
+ * @param Lab pointer to the first of @em count Lab values
+ * @param rgb pointer to the first of @em count RGB values that will be
+ * written
+ * @param count the number of pixels */
+void GamutMapper::mapTile(
+    const cmsCIELab *Lab,
+    Helper::cmsRGB *rgb,
+    const int count
+) const
+{
+    // Fast path for all in-gamut pixels: A single transform call.
+    m_rgbColorSpace->colorRgbUnbounded(Lab, rgb, count);
+
+    // Slow path for the out-of-gamut pixels.
+    QHash<MemoKey, Helper::cmsRGB> memo;
+    MemoKey key;
+    for (int i = 0; i < count; ++i) {
+        if (inGamut(rgb[i])) {
+            continue;
+        }
+        key = memoKey(Lab[i]);
+        const auto memorized = memo.constFind(key);
+        if (memorized != memo.constEnd()) {
+            rgb[i] = memorized.value();
+            continue;
+        }
+        rgb[i] = FullColorDescription(
+            m_rgbColorSpace,
+            Lab[i],
+            FullColorDescription::outOfGamutBehaviour::sacrifyChroma
+        ).toRgb();
+        memo.insert(key, rgb[i]);
+    }
+}
+
+/** @brief Maps a buffer into the gamut
+ * 
+ * The work is done in parallel. This function blocks until it is finished.
+ * 
+ * @param Lab pointer to the first of @em count Lab values
+ * @param rgb pointer to the first of @em count RGB values that will be
+ * written. All values are within the range 0..1.
+ * @param count the number of pixels */
+void GamutMapper::map(
+    const cmsCIELab *Lab,
+    Helper::cmsRGB *rgb,
+    const int count
+) const
+{
+    const int maximumTileCount = tileSize;
+    QVector<int> tileStarts;
+    for (int start = 0; start < count; start += maximumTileCount) {
+        tileStarts.append(start);
+    }
+    QtConcurrent::blockingMap(
+        tileStarts,
+        [this, Lab, rgb, count, maximumTileCount](const int &start) {
+            mapTile(Lab + start, rgb + start, qMin(maximumTileCount, count - start));
+        }
+    );
+}
+
+/** @brief Maps a Lab image into the gamut
+ * 
+ * The work is done in parallel. This function blocks until it is finished.
+ * Unlike map(), no RGB buffer for the whole image is needed.
+ * 
+ * @param Lab pointer to the Lab values of the image, row by row, from top
+ * to bottom, without any padding
+ * @param size the size of the image
+ * @returns An image of format QImage::Format_RGB32, or a null image if
+ * @em size is empty. */
+QImage GamutMapper::mapToImage(const cmsCIELab *Lab, const QSize size) const
+{
+    if (size.isEmpty()) {
+        return QImage();
+    }
+    QImage result(size, QImage::Format_RGB32);
+    // bits() detaches; call it once here, and not in the worker threads.
+    uchar *const bits = result.bits();
+    const int bytesPerLine = result.bytesPerLine();
+    const int width = size.width();
+    const int count = width * size.height();
+    const int maximumTileCount = tileSize;
+    QVector<int> tileStarts;
+    for (int start = 0; start < count; start += maximumTileCount) {
+        tileStarts.append(start);
+    }
+    QtConcurrent::blockingMap(
+        tileStarts,
+        [this, Lab, bits, bytesPerLine, width, count, maximumTileCount](
+            const int &start
+        ) {
+            const int tileCount = qMin(maximumTileCount, count - start);
+            QVector<Helper::cmsRGB> rgb(tileCount);
+            mapTile(Lab + start, rgb.data(), tileCount);
+            int index;
+            for (int i = 0; i < tileCount; ++i) {
+                index = start + i;
+                reinterpret_cast<QRgb *>(
+                    bits + (index / width) * bytesPerLine
+                )[index % width] = qRgb(
+                    qRound(rgb.at(i).red * 255),
+                    qRound(rgb.at(i).green * 255),
+                    qRound(rgb.at(i).blue * 255)
+                );
+            }
+        }
+    );
+    return result;
+}
+
+}
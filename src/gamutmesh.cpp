@@ -0,0 +1,699 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/gamutmesh.h"
+
+#include "PerceptualColor/polarpointf.h"
+
+#include <QHash>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <QtMath>
+
+#include <algorithm>
+
+namespace PerceptualColor {
+
+namespace {
+
+/** @brief A point on the surface of the RGB cube
+ * 
+ * In integer units, so that the midpoints of edges can be identified
+ * exactly. */
+struct GridPoint {
+    qint32 red;
+    qint32 green;
+    qint32 blue;
+};
+
+bool operator==(const GridPoint &first, const GridPoint &second)
+{
+    return (first.red == second.red)
+        && (first.green == second.green)
+        && (first.blue == second.blue);
+}
+
+uint qHash(const GridPoint &point, uint seed = 0)
+{
+    return ::qHash(point.red, seed)
+        ^ ::qHash(point.green, seed + 1)
+        ^ ::qHash(point.blue, seed + 2);
+}
+
+/** @brief An edge of the mesh while it is refined */
+struct Edge {
+    /** Midpoint of the edge */
+    GridPoint midpoint;
+    /** If the edge will be split in the current refinement pass */
+    bool split;
+};
+
+/** @brief Number of colors per transform call while building the mesh */
+constexpr int transformBlockSize = 4096;
+
+/** @brief Number of lightness bins of GamutMesh::boundaryChroma() */
+constexpr int lightnessBinCount = 50;
+
+/** @brief Number of hue bins of GamutMesh::boundaryChroma() */
+constexpr int hueBinCount = 90;
+
+/** @brief Vertices with less chroma are considered on the neutral axis,
+ * where the hue is undefined. */
+constexpr cmsFloat64Number neutralChroma = 0.001;
+
+/** @brief Tolerance of the ray-triangle intersection in barycentric
+ * coordinates, so that rays through shared edges hit at least one of the
+ * triangles. */
+constexpr cmsFloat64Number barycentricTolerance = 1e-9;
+
+/** @brief Key of an undirected edge */
+quint64 edgeKey(const int first, const int second)
+{
+    return (static_cast<quint64>(qMin(first, second)) << 32)
+        | static_cast<quint32>(qMax(first, second));
+}
+
+/** @brief Converts RGB to Lab in parallel
+ * 
+ * @param colorSpace the color space
+ * @param rgb the RGB values
+ * @returns the Lab values */
+QVector<cmsCIELab> toLab(
+    const RgbColorSpace *colorSpace,
+    const QVector<Helper::cmsRGB> &rgb
+)
+{
+    const int count = rgb.count();
+    QVector<cmsCIELab> result(count);
+    QVector<int> blocks;
+    for (int start = 0; start < count; start += transformBlockSize) {
+        blocks.append(start);
+    }
+    const Helper::cmsRGB *input = rgb.constData();
+    cmsCIELab *output = result.data();
+    QtConcurrent::blockingMap(
+        blocks,
+        [colorSpace, input, output, count](const int &start) {
+            colorSpace->colorLab(
+                input + start,
+                output + start,
+                qMin(transformBlockSize, count - start)
+            );
+        }
+    );
+    return result;
+}
+
+/** @brief Euclidean distance in Lab */
+cmsFloat64Number distance(const cmsCIELab &first, const cmsCIELab &second)
+{
+    return qSqrt(
+        qPow(first.L - second.L, 2)
+            + qPow(first.a - second.a, 2)
+            + qPow(first.b - second.b, 2)
+    );
+}
+
+}
+
+/** @brief Constructor
+ * 
+ * Builds the mesh. The work is done in parallel. This function blocks
+ * until it is finished.
+ * 
+ * @param colorSpace the color space. It is not used anymore after the
+ * constructor has returned.
+ * @param tolerance the tolerance of the adaptive refinement. See
+ * @ref defaultTolerance.
+ * @param initialSubdivisions Each face of the RGB cube starts as a grid
+ * of <em>initialSubdivisions × initialSubdivisions</em> squares, each of
+ * them split into two triangles. Range: 1..64
+ * @param maximumDepth the maximum number of times that an edge of the
+ * initial mesh can be halved. Range: 0..16 */
+GamutMesh::GamutMesh(
+    const RgbColorSpace *colorSpace,
+    const qreal tolerance,
+    const int initialSubdivisions,
+    const int maximumDepth
+)
+{
+    const int subdivisions = qBound(1, initialSubdivisions, 64);
+    const int depth = qBound(0, maximumDepth, 16);
+    // The RGB value 1 in grid units. After depth halvings, the
+    // coordinates of the midpoints are not integers anymore, which
+    // limits the refinement.
+    const qint32 scale = subdivisions << depth;
+    QVector<GridPoint> gridPoints;
+    QHash<GridPoint, int> gridPointIndex;
+    QVector<Helper::cmsRGB> newRgb;
+    auto vertexIndex = [&gridPoints, &gridPointIndex, &newRgb, scale](
+        const GridPoint &point
+    ) {
+        const auto iterator = gridPointIndex.constFind(point);
+        if (iterator != gridPointIndex.constEnd()) {
+            return iterator.value();
+        }
+        const int index = gridPoints.count();
+        gridPoints.append(point);
+        gridPointIndex.insert(point, index);
+        Helper::cmsRGB rgb;
+        rgb.red = static_cast<cmsFloat64Number>(point.red) / scale;
+        rgb.green = static_cast<cmsFloat64Number>(point.green) / scale;
+        rgb.blue = static_cast<cmsFloat64Number>(point.blue) / scale;
+        newRgb.append(rgb);
+        return index;
+    };
+    // Converts the vertices that have been added since the last call.
+    auto convertNewVertices = [this, colorSpace, &newRgb]() {
+        m_vertexRgb.append(newRgb);
+        m_vertices.append(toLab(colorSpace, newRgb));
+        newRgb.clear();
+    };
+
+    // The coarse mesh. The corners of each square are in counter-clockwise
+    // order seen from outside the cube.
+    constexpr int cornerU[4] = {0, 1, 1, 0};
+    constexpr int cornerV[4] = {0, 0, 1, 1};
+    int corners[4];
+    qint32 coordinates[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int side = 0; side < 2; ++side) {
+            for (int u = 0; u < subdivisions; ++u) {
+                for (int v = 0; v < subdivisions; ++v) {
+                    for (int corner = 0; corner < 4; ++corner) {
+                        coordinates[axis] = side * scale;
+                        coordinates[(axis + 1) % 3] = (u + cornerU[corner]) << depth;
+                        coordinates[(axis + 2) % 3] = (v + cornerV[corner]) << depth;
+                        corners[corner] = vertexIndex(
+                            GridPoint {coordinates[0], coordinates[1], coordinates[2]}
+                        );
+                    }
+                    if (side == 1) {
+                        m_triangles << corners[0] << corners[1] << corners[2];
+                        m_triangles << corners[0] << corners[2] << corners[3];
+                    } else {
+                        m_triangles << corners[0] << corners[2] << corners[1];
+                        m_triangles << corners[0] << corners[3] << corners[2];
+                    }
+                }
+            }
+        }
+    }
+    convertNewVertices();
+
+    // Adaptive refinement. The decision for an edge depends only on its
+    // vertices, so it is memorized across the passes.
+    QHash<quint64, bool> refinementMemo;
+    QHash<quint64, Edge> edges;
+    QVector<quint64> pendingKeys;
+    QVector<Helper::cmsRGB> pendingRgb;
+    int first;
+    int second;
+    int splitCount;
+    quint64 key;
+    bool changed;
+    bool anySplit = true;
+    while (anySplit) {
+        // Collect the edges that can be split.
+        edges.clear();
+        pendingKeys.clear();
+        pendingRgb.clear();
+        for (int triangle = 0; triangle < m_triangles.count(); triangle += 3) {
+            for (int k = 0; k < 3; ++k) {
+                first = m_triangles.at(triangle + k);
+                second = m_triangles.at(triangle + (k + 1) % 3);
+                key = edgeKey(first, second);
+                if (edges.contains(key)) {
+                    continue;
+                }
+                const GridPoint &p = gridPoints.at(first);
+                const GridPoint &q = gridPoints.at(second);
+                if (((p.red + q.red) % 2 != 0) ||
+                    ((p.green + q.green) % 2 != 0) ||
+                    ((p.blue + q.blue) % 2 != 0)) {
+                    // Maximum depth reached
+                    continue;
+                }
+                Edge edge;
+                edge.midpoint = GridPoint {
+                    (p.red + q.red) / 2,
+                    (p.green + q.green) / 2,
+                    (p.blue + q.blue) / 2
+                };
+                edge.split = refinementMemo.value(key, false);
+                edges.insert(key, edge);
+                if (!refinementMemo.contains(key)) {
+                    pendingKeys.append(key);
+                    Helper::cmsRGB rgb;
+                    rgb.red = static_cast<cmsFloat64Number>(edge.midpoint.red) / scale;
+                    rgb.green = static_cast<cmsFloat64Number>(edge.midpoint.green) / scale;
+                    rgb.blue = static_cast<cmsFloat64Number>(edge.midpoint.blue) / scale;
+                    pendingRgb.append(rgb);
+                }
+            }
+        }
+
+        // Decide about the new edges.
+        const QVector<cmsCIELab> pendingLab = toLab(colorSpace, pendingRgb);
+        for (int i = 0; i < pendingKeys.count(); ++i) {
+            key = pendingKeys.at(i);
+            const cmsCIELab &p = m_vertices.at(static_cast<int>(key >> 32));
+            const cmsCIELab &q = m_vertices.at(static_cast<int>(key & 0xFFFFFFFF));
+            cmsCIELab straightMidpoint;
+            straightMidpoint.L = (p.L + q.L) / 2;
+            straightMidpoint.a = (p.a + q.a) / 2;
+            straightMidpoint.b = (p.b + q.b) / 2;
+            const bool split =
+                (distance(pendingLab.at(i), straightMidpoint) > tolerance);
+            refinementMemo.insert(key, split);
+            edges[key].split = split;
+        }
+
+        // Closure: Triangles with two split edges get the third one split.
+        changed = true;
+        while (changed) {
+            changed = false;
+            for (int triangle = 0; triangle < m_triangles.count(); triangle += 3) {
+                splitCount = 0;
+                for (int k = 0; k < 3; ++k) {
+                    key = edgeKey(
+                        m_triangles.at(triangle + k),
+                        m_triangles.at(triangle + (k + 1) % 3)
+                    );
+                    if (edges.value(key, Edge {GridPoint {0, 0, 0}, false}).split) {
+                        ++splitCount;
+                    }
+                }
+                if (splitCount != 2) {
+                    continue;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    key = edgeKey(
+                        m_triangles.at(triangle + k),
+                        m_triangles.at(triangle + (k + 1) % 3)
+                    );
+                    auto iterator = edges.find(key);
+                    if ((iterator != edges.end()) && !iterator->split) {
+                        iterator->split = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        // Split the triangles.
+        anySplit = false;
+        QVector<int> refined;
+        refined.reserve(m_triangles.count() * 2);
+        int vertex[3];
+        int midpoint[3];
+        int rotation;
+        for (int triangle = 0; triangle < m_triangles.count(); triangle += 3) {
+            splitCount = 0;
+            for (int k = 0; k < 3; ++k) {
+                const auto iterator = edges.constFind(edgeKey(
+                    m_triangles.at(triangle + k),
+                    m_triangles.at(triangle + (k + 1) % 3)
+                ));
+                if ((iterator != edges.constEnd()) && iterator->split) {
+                    midpoint[k] = vertexIndex(iterator->midpoint);
+                    ++splitCount;
+                } else {
+                    midpoint[k] = -1;
+                }
+            }
+            // Rotate the triangle into a canonical position: For a single
+            // split edge, it is the first edge. For two split edges (only
+            // possible at the maximum depth), the unsplit one is the last.
+            rotation = 0;
+            for (int k = 0; k < 3; ++k) {
+                if (((splitCount == 1) && (midpoint[k] != -1)) ||
+                    ((splitCount == 2) && (midpoint[k] == -1))) {
+                    rotation = (splitCount == 1) ? k : (k + 1) % 3;
+                }
+            }
+            for (int k = 0; k < 3; ++k) {
+                vertex[k] = m_triangles.at(triangle + (k + rotation) % 3);
+            }
+            if (rotation != 0) {
+                std::rotate(midpoint, midpoint + rotation, midpoint + 3);
+            }
+            switch (splitCount) {
+            case 0:
+                refined << vertex[0] << vertex[1] << vertex[2];
+                break;
+            case 1:
+                refined << vertex[0] << midpoint[0] << vertex[2];
+                refined << midpoint[0] << vertex[1] << vertex[2];
+                break;
+            case 2:
+                refined << midpoint[0] << vertex[1] << midpoint[1];
+                refined << vertex[0] << midpoint[0] << midpoint[1];
+                refined << vertex[0] << midpoint[1] << vertex[2];
+                break;
+            default:
+                refined << vertex[0] << midpoint[0] << midpoint[2];
+                refined << midpoint[0] << vertex[1] << midpoint[1];
+                refined << midpoint[2] << midpoint[1] << vertex[2];
+                refined << midpoint[0] << midpoint[1] << midpoint[2];
+                break;
+            }
+            if (splitCount > 0) {
+                anySplit = true;
+            }
+        }
+        m_triangles = refined;
+        convertNewVertices();
+    }
+
+    // The triangles are counter-clockwise seen from outside the RGB cube.
+    // Depending on the profile, the conversion to Lab might mirror this.
+    // A negative signed volume tells that this is the case.
+    cmsFloat64Number volume = 0;
+    for (int triangle = 0; triangle < m_triangles.count(); triangle += 3) {
+        const cmsCIELab &p = m_vertices.at(m_triangles.at(triangle));
+        const cmsCIELab &q = m_vertices.at(m_triangles.at(triangle + 1));
+        const cmsCIELab &r = m_vertices.at(m_triangles.at(triangle + 2));
+        volume += p.L * (q.a * r.b - q.b * r.a)
+            - p.a * (q.L * r.b - q.b * r.L)
+            + p.b * (q.L * r.a - q.a * r.L);
+    }
+    if (volume < 0) {
+        for (int triangle = 0; triangle < m_triangles.count(); triangle += 3) {
+            std::swap(m_triangles[triangle + 1], m_triangles[triangle + 2]);
+        }
+    }
+
+    initializeBins();
+}
+
+/** @brief Sorts the triangles into lightness-hue bins
+ * 
+ * A triangle goes into all bins that its lightness range and its hue
+ * range touch. Triangles that touch or enclose the neutral axis cover
+ * all hues. */
+void GamutMesh::initializeBins()
+{
+    m_bins = QVector<QVector<int>>(lightnessBinCount * hueBinCount);
+    constexpr qreal hueBinWidth = static_cast<qreal>(360) / hueBinCount;
+    qreal hue[3];
+    qreal minimumLightness;
+    qreal maximumLightness;
+    qreal largestGap;
+    qreal arcStart;
+    qreal arcLength;
+    bool allHues;
+    int firstHueBin;
+    int hueBinSpan;
+    for (int triangle = 0; triangle < m_triangles.count(); triangle += 3) {
+        minimumLightness = 100;
+        maximumLightness = 0;
+        allHues = false;
+        for (int k = 0; k < 3; ++k) {
+            const cmsCIELab &vertex = m_vertices.at(m_triangles.at(triangle + k));
+            minimumLightness = qMin<qreal>(minimumLightness, vertex.L);
+            maximumLightness = qMax<qreal>(maximumLightness, vertex.L);
+            if (qSqrt(qPow(vertex.a, 2) + qPow(vertex.b, 2)) < neutralChroma) {
+                allHues = true;
+            }
+            hue[k] = PolarPointF(QPointF(vertex.a, vertex.b)).angleDegree();
+        }
+        if (!allHues) {
+            // The smallest arc that contains all three hues is the
+            // complement of the largest gap between them.
+            std::sort(hue, hue + 3);
+            largestGap = 360 - hue[2] + hue[0];
+            arcStart = hue[0];
+            for (int k = 0; k < 2; ++k) {
+                if (hue[k + 1] - hue[k] > largestGap) {
+                    largestGap = hue[k + 1] - hue[k];
+                    arcStart = hue[k + 1];
+                }
+            }
+            arcLength = 360 - largestGap;
+            // An arc of more than 180° means that the triangle encloses
+            // the neutral axis.
+            allHues = (arcLength > 180);
+        }
+        if (allHues) {
+            firstHueBin = 0;
+            hueBinSpan = hueBinCount;
+        } else {
+            firstHueBin = qMin(static_cast<int>(arcStart / hueBinWidth), hueBinCount - 1);
+            hueBinSpan = qMin(
+                static_cast<int>((arcStart + arcLength) / hueBinWidth) - firstHueBin + 1,
+                hueBinCount
+            );
+        }
+        const int firstLightnessBin = qBound(
+            0,
+            static_cast<int>(minimumLightness * lightnessBinCount / 100),
+            lightnessBinCount - 1
+        );
+        const int lastLightnessBin = qBound(
+            0,
+            static_cast<int>(maximumLightness * lightnessBinCount / 100),
+            lightnessBinCount - 1
+        );
+        for (int lightnessBin = firstLightnessBin; lightnessBin <= lastLightnessBin; ++lightnessBin) {
+            for (int i = 0; i < hueBinSpan; ++i) {
+                m_bins[
+                    lightnessBin * hueBinCount + (firstHueBin + i) % hueBinCount
+                ].append(triangle / 3);
+            }
+        }
+    }
+}
+
+/** @brief Intersection of the mesh with a ray from the neutral axis
+ * 
+ * @param lightness the lightness of the ray
+ * @param hue the hue of the ray
+ * @returns The chroma where the ray from the neutral axis at @em lightness
+ * in the direction of @em hue leaves the mesh for the first time, or
+ * @c −1 if it does not leave the mesh (which happens for lightness values
+ * that are outside the gamut). Like RgbColorSpace::boundaryChroma(), this
+ * ignores parts of the gamut beyond a concavity. */
+cmsFloat64Number GamutMesh::boundaryChroma(
+    const cmsFloat64Number lightness,
+    const cmsFloat64Number hue
+) const
+{
+    if (!Helper::inRange<cmsFloat64Number>(0, lightness, 100)) {
+        return -1;
+    }
+    const qreal normalizedHue = PolarPointF::normalizedAngleDegree(hue);
+    const int lightnessBin = qMin(
+        static_cast<int>(lightness * lightnessBinCount / 100),
+        lightnessBinCount - 1
+    );
+    const int hueBin = qMin(
+        static_cast<int>(normalizedHue * hueBinCount / 360),
+        hueBinCount - 1
+    );
+    // Möller-Trumbore intersection in the coordinates (L, a, b), with
+    // the ray origin (lightness, 0, 0) and the ray direction
+    // (0, cos hue, sin hue).
+    const cmsFloat64Number directionA = qCos(qDegreesToRadians(normalizedHue));
+    const cmsFloat64Number directionB = qSin(qDegreesToRadians(normalizedHue));
+    cmsFloat64Number result = -1;
+    for (const int triangle : m_bins.at(lightnessBin * hueBinCount + hueBin)) {
+        const cmsCIELab &v0 = m_vertices.at(m_triangles.at(3 * triangle));
+        const cmsCIELab &v1 = m_vertices.at(m_triangles.at(3 * triangle + 1));
+        const cmsCIELab &v2 = m_vertices.at(m_triangles.at(3 * triangle + 2));
+        const cmsFloat64Number e1L = v1.L - v0.L;
+        const cmsFloat64Number e1a = v1.a - v0.a;
+        const cmsFloat64Number e1b = v1.b - v0.b;
+        const cmsFloat64Number e2L = v2.L - v0.L;
+        const cmsFloat64Number e2a = v2.a - v0.a;
+        const cmsFloat64Number e2b = v2.b - v0.b;
+        // p = direction × e2
+        const cmsFloat64Number pL = directionA * e2b - directionB * e2a;
+        const cmsFloat64Number pa = directionB * e2L;
+        const cmsFloat64Number pb = -directionA * e2L;
+        const cmsFloat64Number determinant = e1L * pL + e1a * pa + e1b * pb;
+        // The determinant is the negative dot product of the direction
+        // and the outward normal e1 × e2. Only triangles where the ray
+        // leaves the mesh count; the others are either parallel to the
+        // ray or where it enters the mesh again (the gamut is not convex).
+        if (determinant > -1e-12) {
+            continue;
+        }
+        const cmsFloat64Number sL = lightness - v0.L;
+        const cmsFloat64Number sa = -v0.a;
+        const cmsFloat64Number sb = -v0.b;
+        const cmsFloat64Number u = (sL * pL + sa * pa + sb * pb) / determinant;
+        if (!Helper::inRange<cmsFloat64Number>(
+            -barycentricTolerance,
+            u,
+            1 + barycentricTolerance
+        )) {
+            continue;
+        }
+        // q = s × e1
+        const cmsFloat64Number qL = sa * e1b - sb * e1a;
+        const cmsFloat64Number qa = sb * e1L - sL * e1b;
+        const cmsFloat64Number qb = sL * e1a - sa * e1L;
+        const cmsFloat64Number v = (directionA * qa + directionB * qb) / determinant;
+        if ((v < -barycentricTolerance) || (u + v > 1 + barycentricTolerance)) {
+            continue;
+        }
+        const cmsFloat64Number t = (e2L * qL + e2a * qa + e2b * qb) / determinant;
+        if ((t >= 0) && ((result < 0) || (t < result))) {
+            result = t;
+        }
+    }
+    return result;
+}
+
+/** @brief If a color is within the mesh
+ * 
+ * @param Lab the color
+ * @returns @c true if the chroma of the color is not more than
+ * boundaryChroma() at its lightness and hue */
+bool GamutMesh::isInGamut(const cmsCIELab &Lab) const
+{
+    const PolarPointF polar(QPointF(Lab.a, Lab.b));
+    const cmsFloat64Number boundary = boundaryChroma(Lab.L, polar.angleDegree());
+    return (boundary >= 0) && (polar.radial() <= boundary);
+}
+
+/** @brief Number of triangles */
+int GamutMesh::triangleCount() const
+{
+    return m_triangles.count() / 3;
+}
+
+/** @brief The triangles
+ * 
+ * @returns Vertex indices, three for each triangle, counter-clockwise seen
+ * from outside the gamut. */
+const QVector<int> &GamutMesh::triangles() const
+{
+    return m_triangles;
+}
+
+/** @brief Number of vertices */
+int GamutMesh::vertexCount() const
+{
+    return m_vertices.count();
+}
+
+/** @brief RGB values of the vertices
+ * 
+ * @returns The RGB value of each vertex. At least one channel is @c 0
+ * or @c 1. */
+const QVector<Helper::cmsRGB> &GamutMesh::vertexRgb() const
+{
+    return m_vertexRgb;
+}
+
+/** @brief Lab values of the vertices */
+const QVector<cmsCIELab> &GamutMesh::vertices() const
+{
+    return m_vertices;
+}
+
+/** @brief Exports the mesh as Wavefront OBJ file
+ * 
+ * The coordinates are x = a*, y = b*, z = L*.
+ * 
+ * @param fileName the file name
+ * @returns @c true on success */
+bool GamutMesh::exportObj(const QString &fileName) const
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream stream(&file);
+    stream.setRealNumberNotation(QTextStream::FixedNotation);
+    stream.setRealNumberPrecision(6);
+    stream << "# Gamut boundary in CIELab: x = a*, y = b*, z = L*\n";
+    for (const cmsCIELab &vertex : m_vertices) {
+        stream << "v " << vertex.a << " " << vertex.b << " " << vertex.L << "\n";
+    }
+    for (int triangle = 0; triangle < m_triangles.count(); triangle += 3) {
+        // OBJ indices start with 1.
+        stream << "f "
+            << m_triangles.at(triangle) + 1 << " "
+            << m_triangles.at(triangle + 1) + 1 << " "
+            << m_triangles.at(triangle + 2) + 1 << "\n";
+    }
+    stream.flush();
+    return (stream.status() == QTextStream::Ok) && file.commit();
+}
+
+/** @brief Exports the mesh as ASCII PLY file
+ * 
+ * The coordinates are x = a*, y = b*, z = L*. The vertices have the
+ * colors that they represent.
+ * 
+ * @param fileName the file name
+ * @returns @c true on success */
+bool GamutMesh::exportPly(const QString &fileName) const
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream stream(&file);
+    stream.setRealNumberNotation(QTextStream::FixedNotation);
+    stream.setRealNumberPrecision(6);
+    stream << "ply\n"
+        << "format ascii 1.0\n"
+        << "comment Gamut boundary in CIELab: x = a*, y = b*, z = L*\n"
+        << "element vertex " << m_vertices.count() << "\n"
+        << "property float x\n"
+        << "property float y\n"
+        << "property float z\n"
+        << "property uchar red\n"
+        << "property uchar green\n"
+        << "property uchar blue\n"
+        << "element face " << triangleCount() << "\n"
+        << "property list uchar int vertex_indices\n"
+        << "end_header\n";
+    for (int i = 0; i < m_vertices.count(); ++i) {
+        const cmsCIELab &vertex = m_vertices.at(i);
+        const Helper::cmsRGB &rgb = m_vertexRgb.at(i);
+        stream << vertex.a << " " << vertex.b << " " << vertex.L << " "
+            << qRound(rgb.red * 255) << " "
+            << qRound(rgb.green * 255) << " "
+            << qRound(rgb.blue * 255) << "\n";
+    }
+    for (int triangle = 0; triangle < m_triangles.count(); triangle += 3) {
+        stream << "3 "
+            << m_triangles.at(triangle) << " "
+            << m_triangles.at(triangle + 1) << " "
+            << m_triangles.at(triangle + 2) << "\n";
+    }
+    stream.flush();
+    return (stream.status() == QTextStream::Ok) && file.commit();
+}
+
+}
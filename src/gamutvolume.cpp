@@ -0,0 +1,901 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/gamutvolume.h"
+
+#include "PerceptualColor/cachefile.h"
+#include "PerceptualColor/helper.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <QtMath>
+
+#include <cstring>
+
+namespace PerceptualColor {
+
+namespace {
+
+/** @brief Number of colors per transform call in
+ * GamutVolume::renderScanLine() */
+constexpr int chunkSize = 256;
+
+/** @brief Number of bisection steps of
+ * GamutVolume::volumeBoundaryChroma() */
+constexpr int boundaryBisectionSteps = 20;
+
+/** @brief Initial number of subdivisions of each face of the RGB cube
+ * when the gamut boundary is sampled */
+constexpr int initialFaceSubdivisions = 64;
+
+/** @brief Maximum number of subdivisions of each face of the RGB cube
+ * when the gamut boundary is sampled */
+constexpr int maximumFaceSubdivisions = 1024;
+
+/** @brief Version of the data that GamutVolume stores in its CacheFile.
+ * 
+ * Increase this whenever the layout of the payload or the algorithm that
+ * builds the volume changes. */
+constexpr quint32 cacheVersion = 1;
+
+/** @brief File name of a volume in the CacheFile directory
+ * 
+ * @param colorSpace the color space
+ * @param resolution the resolution of the volume */
+QString cacheFileName(const RgbColorSpace *colorSpace, const int resolution)
+{
+    return QStringLiteral("gamutvolume-%1-%2.cache").arg(
+        QString::fromLatin1(colorSpace->profileId().toHex())
+    ).arg(resolution);
+}
+
+/** @brief Key of the volume cache files
+ * 
+ * Contains RgbColorSpace::cacheKey(), the version of this class and the
+ * resolution. */
+QByteArray cacheFileKey(const RgbColorSpace *colorSpace, const int resolution)
+{
+    QByteArray result = colorSpace->cacheKey();
+    result.append(QByteArrayLiteral("GamutVolume"));
+    result.append(
+        reinterpret_cast<const char *>(&cacheVersion),
+        sizeof(cacheVersion)
+    );
+    const qint32 storedResolution = resolution;
+    result.append(
+        reinterpret_cast<const char *>(&storedResolution),
+        sizeof(storedResolution)
+    );
+    return result;
+}
+
+/** @brief Samples the surface of the RGB cube
+ * 
+ * @param colorSpace the color space
+ * @param subdivisions the number of subdivisions of each edge of the cube
+ * @returns the Lab values of <tt>(subdivisions + 1)²</tt> equidistant
+ * samples on each of the six faces, face by face and row by row */
+QVector<cmsCIELab> surfaceSamples(
+    const RgbColorSpace *colorSpace,
+    const int subdivisions
+)
+{
+    const int side = subdivisions + 1;
+    QVector<cmsCIELab> result(6 * side * side);
+    cmsCIELab *const Lab = result.data();
+    QVector<int> faces;
+    for (int face = 0; face < 6; ++face) {
+        faces.append(face);
+    }
+    QtConcurrent::blockingMap(
+        faces,
+        [colorSpace, subdivisions, side, Lab](const int &face) {
+            // Each face has one channel that is fixed at 0 or 1.
+            const int fixedChannel = face / 2;
+            QVector<Helper::cmsRGB> rgb(side * side);
+            cmsFloat64Number channels[3];
+            channels[fixedChannel] = face % 2;
+            for (int v = 0; v < side; ++v) {
+                for (int u = 0; u < side; ++u) {
+                    channels[(fixedChannel + 1) % 3] =
+                        static_cast<cmsFloat64Number>(u) / subdivisions;
+                    channels[(fixedChannel + 2) % 3] =
+                        static_cast<cmsFloat64Number>(v) / subdivisions;
+                    rgb[v * side + u].red = channels[0];
+                    rgb[v * side + u].green = channels[1];
+                    rgb[v * side + u].blue = channels[2];
+                }
+            }
+            colorSpace->colorLab(
+                rgb.constData(),
+                Lab + face * side * side,
+                rgb.count()
+            );
+        }
+    );
+    return result;
+}
+
+/** @brief Protects gamutVolumeCache() */
+QMutex gamutVolumeCacheMutex;
+
+/** @brief The volumes that GamutVolume::forColorSpace() shares
+ * 
+ * The key is the profile id followed by the resolution. */
+QHash<QByteArray, QSharedPointer<const GamutVolume>> &gamutVolumeCache()
+{
+    static QHash<QByteArray, QSharedPointer<const GamutVolume>> cache;
+    return cache;
+}
+
+}
+
+/** @brief Constructor
+ * 
+ * Builds the volume. The work is done in parallel. This function blocks
+ * until it is finished. RgbColorSpace::gamutVolume() builds the volume in
+ * the background instead.
+ * 
+ * @param colorSpace the color space. It is not used anymore after the
+ * constructor has returned.
+ * @param resolution the number of grid points on each axis. Values
+ * smaller than @c 2 are treated as @c 2. */
+GamutVolume::GamutVolume(
+    const RgbColorSpace *colorSpace,
+    const int resolution
+) :
+    m_resolution(qMax(resolution, 2))
+{
+    // The gamut boundary is the image of the surface of the RGB cube.
+    // Sample it so densely that neighbour samples are less than half a
+    // grid cell apart on each axis. The range of a* and b* is taken from
+    // the samples, with a safety margin.
+    QVector<cmsCIELab> surface;
+    cmsFloat64Number maximumAb;
+    int subdivisions = initialFaceSubdivisions;
+    qreal spacing = 1;
+    while (spacing >= 0.5) {
+        surface = surfaceSamples(colorSpace, subdivisions);
+        maximumAb = 0;
+        for (const cmsCIELab &sample : qAsConst(surface)) {
+            maximumAb = qMax(maximumAb, qMax(qAbs(sample.a), qAbs(sample.b)));
+        }
+        m_abRange = qMin<cmsFloat64Number>(
+            maximumAb * 1.05 + 2,
+            Helper::LchBoundaries::physicalMaximumChroma
+        );
+        spacing = surfaceSpacing(surface, subdivisions);
+        if (subdivisions >= maximumFaceSubdivisions) {
+            break;
+        }
+        // The spacing is roughly inversely proportional to the number of
+        // subdivisions.
+        subdivisions = qMin(
+            maximumFaceSubdivisions,
+            qCeil(subdivisions * spacing / 0.45)
+        );
+    }
+    markBoundaryCells(surface);
+
+    const int size = m_resolution;
+    const cmsFloat64Number abRange = m_abRange;
+    m_wordsPerPlane = (size * size + 63) / 64;
+    m_bits.fill(0, m_wordsPerPlane * size);
+    const int wordsPerPlane = m_wordsPerPlane;
+    quint64 *bits = m_bits.data();
+    QVector<int> planes;
+    for (int plane = 0; plane < size; ++plane) {
+        planes.append(plane);
+    }
+    QtConcurrent::blockingMap(
+        planes,
+        [colorSpace, size, abRange, wordsPerPlane, bits](const int &plane) {
+            QVector<cmsCIELab> Lab(size * size);
+            QVector<Helper::cmsRGB> rgb(size * size);
+            int index;
+            for (int bIndex = 0; bIndex < size; ++bIndex) {
+                for (int aIndex = 0; aIndex < size; ++aIndex) {
+                    index = bIndex * size + aIndex;
+                    Lab[index].L = plane * static_cast<cmsFloat64Number>(100) / (size - 1);
+                    Lab[index].a = aIndex * 2 * abRange / (size - 1) - abRange;
+                    Lab[index].b = bIndex * 2 * abRange / (size - 1) - abRange;
+                }
+            }
+            colorSpace->colorRgbUnbounded(Lab.constData(), rgb.data(), Lab.count());
+            // Each plane starts with a new word, so no other task writes
+            // to the words of this plane.
+            quint64 *planeBits = bits + plane * wordsPerPlane;
+            for (index = 0; index < rgb.count(); ++index) {
+                if (Helper::inRange<cmsFloat64Number>(0, rgb.at(index).red, 1) &&
+                    Helper::inRange<cmsFloat64Number>(0, rgb.at(index).green, 1) &&
+                    Helper::inRange<cmsFloat64Number>(0, rgb.at(index).blue, 1)) {
+                    planeBits[index / 64] |= static_cast<quint64>(1) << (index % 64);
+                }
+            }
+        }
+    );
+}
+
+/** @brief Range of a* and b*
+ * 
+ * @returns The volume covers a* and b* from −abRange() to abRange().
+ * Colors outside this range are out-of-gamut. */
+cmsFloat64Number GamutVolume::abRange() const
+{
+    return m_abRange;
+}
+
+/** @brief Size of the bits of the volume in memory
+ * 
+ * @returns the size in bytes */
+qint64 GamutVolume::byteSize() const
+{
+    return static_cast<qint64>(m_bits.count() + m_boundaryCells.count())
+        * static_cast<qint64>(sizeof(quint64));
+}
+
+/** @brief Number of grid points on each axis */
+int GamutVolume::resolution() const
+{
+    return m_resolution;
+}
+
+/** @brief A single bit of the volume
+ * 
+ * @returns @c true if the grid point is within the gamut */
+bool GamutVolume::bit(
+    const int lightnessIndex,
+    const int aIndex,
+    const int bIndex
+) const
+{
+    const int index = bIndex * m_resolution + aIndex;
+    return (
+        m_bits.at(lightnessIndex * m_wordsPerPlane + index / 64)
+            >> (index % 64)
+    ) & 1;
+}
+
+/** @brief Index of the grid cell of a color
+ * 
+ * Colors outside the volume are moved to the nearest cell.
+ * 
+ * @param Lab the color
+ * @returns the index of the cell, L* plane by L* plane, row by row */
+int GamutVolume::cellIndex(const cmsCIELab &Lab) const
+{
+    const int cells = m_resolution - 1;
+    const qreal lightness = Lab.L * cells / 100;
+    const qreal a = (Lab.a + m_abRange) * cells / (2 * m_abRange);
+    const qreal b = (Lab.b + m_abRange) * cells / (2 * m_abRange);
+    // Like in coverage(), the upper border of the volume belongs to the
+    // last cell.
+    const int l0 = qBound(0, qFloor(lightness), cells - 1);
+    const int a0 = qBound(0, qFloor(a), cells - 1);
+    const int b0 = qBound(0, qFloor(b), cells - 1);
+    return (l0 * cells + b0) * cells + a0;
+}
+
+/** @brief If the grid cell of a color might contain the gamut boundary
+ * 
+ * @param Lab the color
+ * @returns @c true if the cell of the color (see cellIndex()) or one of
+ * its neighbours contains a sample of the gamut boundary */
+bool GamutVolume::isBoundaryCell(const cmsCIELab &Lab) const
+{
+    const int index = cellIndex(Lab);
+    return (m_boundaryCells.at(index / 64) >> (index % 64)) & 1;
+}
+
+/** @brief Largest distance between neighbour samples of the RGB cube
+ * surface
+ * 
+ * @param surface the samples, as returned by surfaceSamples()
+ * @param subdivisions the subdivisions of the samples
+ * @returns the largest difference between horizontal or vertical
+ * neighbours on any of the L*, a* and b* axes, in grid cells */
+qreal GamutVolume::surfaceSpacing(
+    const QVector<cmsCIELab> &surface,
+    const int subdivisions
+) const
+{
+    const int side = subdivisions + 1;
+    const qreal lightnessScale = static_cast<qreal>(m_resolution - 1) / 100;
+    const qreal abScale = (m_resolution - 1) / (2 * m_abRange);
+    qreal result = 0;
+    auto compare = [&result, lightnessScale, abScale](
+        const cmsCIELab &first,
+        const cmsCIELab &second
+    ) {
+        result = qMax(result, qAbs(second.L - first.L) * lightnessScale);
+        result = qMax(result, qAbs(second.a - first.a) * abScale);
+        result = qMax(result, qAbs(second.b - first.b) * abScale);
+    };
+    int index;
+    for (int face = 0; face < 6; ++face) {
+        for (int v = 0; v < side; ++v) {
+            for (int u = 0; u < side; ++u) {
+                index = (face * side + v) * side + u;
+                if (u > 0) {
+                    compare(surface.at(index - 1), surface.at(index));
+                }
+                if (v > 0) {
+                    compare(surface.at(index - side), surface.at(index));
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/** @brief Builds @ref m_boundaryCells
+ * 
+ * Marks the cell of each sample, and then all the neighbours of marked
+ * cells. With samples that are less than half a cell apart on each axis,
+ * each point of the boundary is less than one cell away from a sample (as
+ * long as the transform is approximately linear at the scale of the
+ * samples), so its cell is marked.
+ * 
+ * @param surface the samples of the gamut boundary, as returned by
+ * surfaceSamples() */
+void GamutVolume::markBoundaryCells(const QVector<cmsCIELab> &surface)
+{
+    const int cells = m_resolution - 1;
+    const int cellCount = cells * cells * cells;
+    QVector<quint8> marks(cellCount, 0);
+    for (const cmsCIELab &sample : surface) {
+        marks[cellIndex(sample)] = 1;
+    }
+    // Dilate by one cell, one axis after the other. The strides of the
+    // a*, b* and L* axes are 1, cells and cells².
+    QVector<quint8> dilated(cellCount, 0);
+    int stride = 1;
+    int coordinate;
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int index = 0; index < cellCount; ++index) {
+            if (marks.at(index) == 0) {
+                continue;
+            }
+            dilated[index] = 1;
+            coordinate = (index / stride) % cells;
+            if (coordinate > 0) {
+                dilated[index - stride] = 1;
+            }
+            if (coordinate < cells - 1) {
+                dilated[index + stride] = 1;
+            }
+        }
+        marks.swap(dilated);
+        dilated.fill(0);
+        stride *= cells;
+    }
+    m_boundaryCells.fill(0, (cellCount + 63) / 64);
+    for (int index = 0; index < cellCount; ++index) {
+        if (marks.at(index) != 0) {
+            m_boundaryCells[index / 64] |= static_cast<quint64>(1) << (index % 64);
+        }
+    }
+}
+
+/** @brief Trilinear interpolation of the bits
+ * 
+ * @param Lab the color
+ * @returns A value from @c 0 (all eight surrounding grid points are
+ * out-of-gamut) to @c 1 (all of them are in-gamut). @c 0 for colors
+ * outside of the volume. */
+qreal GamutVolume::coverage(const cmsCIELab &Lab) const
+{
+    const int maxIndex = m_resolution - 1;
+    const qreal lightness = Lab.L * maxIndex / 100;
+    const qreal a = (Lab.a + m_abRange) * maxIndex / (2 * m_abRange);
+    const qreal b = (Lab.b + m_abRange) * maxIndex / (2 * m_abRange);
+    if (!Helper::inRange<qreal>(0, lightness, maxIndex) ||
+        !Helper::inRange<qreal>(0, a, maxIndex) ||
+        !Helper::inRange<qreal>(0, b, maxIndex)) {
+        return 0;
+    }
+    // The lower corner of the cell. At the upper border of the volume,
+    // take the last cell.
+    const int l0 = qMin(static_cast<int>(lightness), maxIndex - 1);
+    const int a0 = qMin(static_cast<int>(a), maxIndex - 1);
+    const int b0 = qMin(static_cast<int>(b), maxIndex - 1);
+    const qreal tl = lightness - l0;
+    const qreal ta = a - a0;
+    const qreal tb = b - b0;
+    qreal result = 0;
+    for (int corner = 0; corner < 8; ++corner) {
+        const int dl = corner & 1;
+        const int da = (corner >> 1) & 1;
+        const int db = (corner >> 2) & 1;
+        if (bit(l0 + dl, a0 + da, b0 + db)) {
+            result += (dl ? tl : 1 - tl)
+                * (da ? ta : 1 - ta)
+                * (db ? tb : 1 - tb);
+        }
+    }
+    return result;
+}
+
+/** @brief If a color is within the gamut, according to the volume
+ * 
+ * @param Lab the color
+ * @returns @c true if coverage() is at least 0.5 */
+bool GamutVolume::isInGamut(const cmsCIELab &Lab) const
+{
+    return coverage(Lab) >= 0.5;
+}
+
+/** @brief Out-of-gamut mask of a scan line of equidistant colors
+ * 
+ * @param first the first Lab value
+ * @param step the difference between two neighbour Lab values
+ * @param outOfGamutMask pointer to the first of @em count mask values that
+ * will be written: @c 1 for out-of-gamut colors, @c 0 for in-gamut colors
+ * @param count the number of colors
+ * 
+ * @sa RgbColorSpace::colorRgbScanLine() */
+void GamutVolume::maskScanLine(
+    const cmsCIELab &first,
+    const cmsCIELab &step,
+    quint8 *outOfGamutMask,
+    const int count
+) const
+{
+    cmsCIELab current = first;
+    for (int i = 0; i < count; ++i) {
+        outOfGamutMask[i] = isInGamut(current) ? 0 : 1;
+        current.L += step.L;
+        current.a += step.a;
+        current.b += step.b;
+    }
+}
+
+/** @brief Renders a scan line of equidistant colors
+ * 
+ * Like RgbColorSpace::colorRgbScanLine(), but only the colors between
+ * the first and the last color that the volume does not exclude are
+ * transformed. A color is excluded if all eight surrounding grid points
+ * are out-of-gamut (see coverage()) and its grid cell does not contain
+ * the gamut boundary. Such a cell cannot contain in-gamut colors either,
+ * so even thin parts of the gamut between the grid points are
+ * transformed. The transformed colors are classified exactly, like in
+ * RgbColorSpace::colorRgbScanLine(), so the result is the same, and
+ * RgbColorSpace::antialiasGamutBoundary() supersamples the same pixels.
+ * 
+ * @param colorSpace the color space of this volume
+ * @param first the first Lab value
+ * @param step the difference between two neighbour Lab values
+ * @param pixels pointer to the first of @em count pixels that will be
+ * written (QImage::Format_ARGB32). In-gamut colors become opaque pixels,
+ * out-of-gamut colors become transparent pixels.
+ * @param count the number of colors
+ * @param precision the precision of the transform
+ * @param outOfGamutMask If not a null pointer, pointer to the first of
+ * @em count mask values that will be written */
+void GamutVolume::renderScanLine(
+    const RgbColorSpace *colorSpace,
+    const cmsCIELab &first,
+    const cmsCIELab &step,
+    QRgb *pixels,
+    const int count,
+    const RgbColorSpace::TransformPrecision precision,
+    quint8 *outOfGamutMask
+) const
+{
+    if (count <= 0) {
+        return;
+    }
+    QVector<quint8> localMask;
+    quint8 *mask = outOfGamutMask;
+    if (mask == nullptr) {
+        localMask.resize(count);
+        mask = localMask.data();
+    }
+    // Only colors where all eight surrounding grid points are out-of-gamut,
+    // and where the grid cell does not contain the gamut boundary, are
+    // taken from the volume. All others are transformed.
+    cmsCIELab current = first;
+    for (int i = 0; i < count; ++i) {
+        mask[i] = ((coverage(current) > 0) || isBoundaryCell(current)) ? 0 : 1;
+        current.L += step.L;
+        current.a += step.a;
+        current.b += step.b;
+    }
+
+    // Find the span that has to be transformed.
+    int begin = 0;
+    while ((begin < count) && (mask[begin] != 0)) {
+        ++begin;
+    }
+    int end = count;
+    while ((end > begin) && (mask[end - 1] != 0)) {
+        --end;
+    }
+    for (int i = 0; i < begin; ++i) {
+        pixels[i] = qRgba(0, 0, 0, 0);
+    }
+    for (int i = end; i < count; ++i) {
+        pixels[i] = qRgba(0, 0, 0, 0);
+    }
+
+    QVector<Helper::cmsLabFloat32> labFloat32(chunkSize);
+    QVector<Helper::cmsRGBFloat32> rgbFloat32(chunkSize);
+    QVector<cmsCIELab> Lab(chunkSize);
+    QVector<Helper::cmsRGB> rgb(chunkSize);
+    int chunkCount;
+    int index;
+    for (int start = begin; start < end; start += chunkSize) {
+        chunkCount = qMin(chunkSize, end - start);
+        for (int i = 0; i < chunkCount; ++i) {
+            // Multiplication instead of incremental addition, because
+            // the span does not start at the first color.
+            Lab[i].L = first.L + (start + i) * step.L;
+            Lab[i].a = first.a + (start + i) * step.a;
+            Lab[i].b = first.b + (start + i) * step.b;
+        }
+        if (precision == RgbColorSpace::TransformPrecision::float32) {
+            for (int i = 0; i < chunkCount; ++i) {
+                labFloat32[i].L = static_cast<cmsFloat32Number>(Lab.at(i).L);
+                labFloat32[i].a = static_cast<cmsFloat32Number>(Lab.at(i).a);
+                labFloat32[i].b = static_cast<cmsFloat32Number>(Lab.at(i).b);
+            }
+            colorSpace->colorRgbUnbounded(
+                labFloat32.constData(),
+                rgbFloat32.data(),
+                chunkCount
+            );
+            for (int i = 0; i < chunkCount; ++i) {
+                rgb[i].red = rgbFloat32.at(i).red;
+                rgb[i].green = rgbFloat32.at(i).green;
+                rgb[i].blue = rgbFloat32.at(i).blue;
+            }
+        } else {
+            colorSpace->colorRgbUnbounded(Lab.constData(), rgb.data(), chunkCount);
+        }
+        for (int i = 0; i < chunkCount; ++i) {
+            index = start + i;
+            // Same criterion as RgbColorSpace::colorRgbScanLine()
+            if (Helper::inRange<cmsFloat64Number>(0, rgb.at(i).red, 1) &&
+                Helper::inRange<cmsFloat64Number>(0, rgb.at(i).green, 1) &&
+                Helper::inRange<cmsFloat64Number>(0, rgb.at(i).blue, 1)) {
+                mask[index] = 0;
+                pixels[index] = qRgb(
+                    qRound(rgb.at(i).red * 255),
+                    qRound(rgb.at(i).green * 255),
+                    qRound(rgb.at(i).blue * 255)
+                );
+            } else {
+                mask[index] = 1;
+                pixels[index] = qRgba(0, 0, 0, 0);
+            }
+        }
+    }
+}
+
+/** @brief Highest in-gamut chroma, according to the volume
+ * 
+ * Searches along the chroma axis for the first out-of-gamut color, with
+ * a step of a quarter of the grid spacing, and refines it by bisection.
+ * 
+ * @param lightness the lightness
+ * @param hue the hue
+ * @returns the highest chroma that isInGamut(), or @c −1 if even
+ * chroma @c 0 is out-of-gamut */
+qreal GamutVolume::volumeBoundaryChroma(
+    const cmsFloat64Number lightness,
+    const cmsFloat64Number hue
+) const
+{
+    cmsCIELCh lch;
+    cmsCIELab Lab;
+    lch.L = lightness;
+    lch.h = hue;
+    auto inGamut = [this, &lch, &Lab](const qreal chroma) {
+        lch.C = chroma;
+        cmsLCh2Lab(&Lab, &lch);
+        return isInGamut(Lab);
+    };
+    if (!inGamut(0)) {
+        return -1;
+    }
+    const qreal stepSize = m_abRange / (2 * (m_resolution - 1));
+    const qreal maximum = m_abRange * M_SQRT2;
+    qreal low = 0;
+    qreal high = stepSize;
+    while ((high < maximum) && inGamut(high)) {
+        low = high;
+        high += stepSize;
+    }
+    if (high >= maximum) {
+        return low;
+    }
+    qreal middle;
+    for (int i = 0; i < boundaryBisectionSteps; ++i) {
+        middle = (low + high) / 2;
+        if (inGamut(middle)) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/** @brief Compares the volume with the exact gamut
+ * 
+ * The boundary chroma is compared on a grid of lightness and hue values,
+ * using RgbColorSpace::boundaryChroma() as reference. Lightness-hue pairs
+ * where one of them has no in-gamut chroma at all are skipped. The
+ * classification is compared on the centers of the grid cells, which are
+ * the points where the interpolation is least precise.
+ * 
+ * @param colorSpace the color space of this volume
+ * @param lightnessSteps number of lightness values, from 0 to 100
+ * @param hueSteps number of hue values, from 0 to 360 (exclusive)
+ * @returns the report */
+GamutVolume::AccuracyReport GamutVolume::accuracyReport(
+    const RgbColorSpace *colorSpace,
+    const int lightnessSteps,
+    const int hueSteps
+) const
+{
+    AccuracyReport report;
+    report.boundarySamples = 0;
+    report.meanChromaError = 0;
+    report.maximumChromaError = 0;
+    report.classifiedColors = 0;
+    report.misclassifiedColors = 0;
+
+    cmsCIELCh lch;
+    qreal exact;
+    qreal approximated;
+    qreal error;
+    for (int lightnessIndex = 0; lightnessIndex < lightnessSteps; ++lightnessIndex) {
+        lch.L = (lightnessSteps > 1)
+            ? lightnessIndex * static_cast<qreal>(100) / (lightnessSteps - 1)
+            : 50;
+        for (int hueIndex = 0; hueIndex < hueSteps; ++hueIndex) {
+            lch.h = hueIndex * static_cast<qreal>(360) / hueSteps;
+            lch.C = Helper::LchBoundaries::physicalMaximumChroma;
+            exact = colorSpace->boundaryChroma(lch);
+            approximated = volumeBoundaryChroma(lch.L, lch.h);
+            if ((exact < 0) || (approximated < 0)) {
+                continue;
+            }
+            error = qAbs(approximated - exact);
+            report.meanChromaError += error;
+            report.maximumChromaError = qMax(report.maximumChromaError, error);
+            ++report.boundarySamples;
+        }
+    }
+    if (report.boundarySamples > 0) {
+        report.meanChromaError /= report.boundarySamples;
+    }
+
+    const int cells = m_resolution - 1;
+    QVector<cmsCIELab> Lab;
+    Lab.reserve(cells * cells);
+    QVector<Helper::cmsRGB> rgb(cells * cells);
+    cmsCIELab temp;
+    bool exactInGamut;
+    for (int lightnessIndex = 0; lightnessIndex < cells; ++lightnessIndex) {
+        Lab.clear();
+        temp.L = (lightnessIndex + 0.5) * 100 / cells;
+        for (int bIndex = 0; bIndex < cells; ++bIndex) {
+            for (int aIndex = 0; aIndex < cells; ++aIndex) {
+                temp.a = (aIndex + 0.5) * 2 * m_abRange / cells - m_abRange;
+                temp.b = (bIndex + 0.5) * 2 * m_abRange / cells - m_abRange;
+                Lab.append(temp);
+            }
+        }
+        colorSpace->colorRgbUnbounded(Lab.constData(), rgb.data(), Lab.count());
+        for (int i = 0; i < Lab.count(); ++i) {
+            exactInGamut =
+                Helper::inRange<cmsFloat64Number>(0, rgb.at(i).red, 1) &&
+                Helper::inRange<cmsFloat64Number>(0, rgb.at(i).green, 1) &&
+                Helper::inRange<cmsFloat64Number>(0, rgb.at(i).blue, 1);
+            if (exactInGamut != isInGamut(Lab.at(i))) {
+                ++report.misclassifiedColors;
+            }
+            ++report.classifiedColors;
+        }
+    }
+
+    return report;
+}
+
+/** @brief Reads the volume from its CacheFile
+ * 
+ * Only used on objects that have been created with the default
+ * constructor.
+ * 
+ * @param colorSpace the color space
+ * @param resolution the number of grid points on each axis
+ * @returns @c true if the CacheFile contained a valid volume for
+ * @p colorSpace and @p resolution. Otherwise, @c false, and the object
+ * must not be used. */
+bool GamutVolume::readCacheFile(
+    const RgbColorSpace *colorSpace,
+    const int resolution
+)
+{
+    m_resolution = qMax(resolution, 2);
+    m_wordsPerPlane = (m_resolution * m_resolution + 63) / 64;
+    const int cells = m_resolution - 1;
+    const int bitCount = m_wordsPerPlane * m_resolution;
+    const int boundaryCount = (cells * cells * cells + 63) / 64;
+    const size_t abRangeSize = sizeof(m_abRange);
+    const size_t bitSize = static_cast<size_t>(bitCount) * sizeof(quint64);
+    const size_t boundarySize =
+        static_cast<size_t>(boundaryCount) * sizeof(quint64);
+    CacheFile cache(
+        cacheFileName(colorSpace, m_resolution),
+        cacheFileKey(colorSpace, m_resolution)
+    );
+    if (!cache.isValid()
+        || (cache.payloadSize()
+            != static_cast<qint64>(abRangeSize + bitSize + boundarySize))
+    ) {
+        return false;
+    }
+    const uchar *payload = cache.payload();
+    std::memcpy(&m_abRange, payload, abRangeSize);
+    m_bits.resize(bitCount);
+    std::memcpy(m_bits.data(), payload + abRangeSize, bitSize);
+    m_boundaryCells.resize(boundaryCount);
+    std::memcpy(
+        m_boundaryCells.data(),
+        payload + abRangeSize + bitSize,
+        boundarySize
+    );
+    return (m_abRange > 0);
+}
+
+/** @brief Stores the volume in its CacheFile
+ * 
+ * @param colorSpace the color space that the volume has been built for */
+void GamutVolume::writeCacheFile(const RgbColorSpace *colorSpace) const
+{
+    QByteArray payload;
+    payload.append(
+        reinterpret_cast<const char *>(&m_abRange),
+        sizeof(m_abRange)
+    );
+    payload.append(
+        reinterpret_cast<const char *>(m_bits.constData()),
+        m_bits.count() * static_cast<int>(sizeof(quint64))
+    );
+    payload.append(
+        reinterpret_cast<const char *>(m_boundaryCells.constData()),
+        m_boundaryCells.count() * static_cast<int>(sizeof(quint64))
+    );
+    CacheFile::write(
+        cacheFileName(colorSpace, m_resolution),
+        cacheFileKey(colorSpace, m_resolution),
+        payload
+    );
+}
+
+/** @brief Shared volume for a color space
+ * 
+ * On the first call for a given profile and resolution, the volume is
+ * read from its CacheFile, or built and stored in the CacheFile if the
+ * file does not exist or does not match. It is shared with all later
+ * calls, also from other
+ * RgbColorSpace objects with the same profile. This function is
+ * thread-safe. The cache is not locked while the volume is read or built, so
+ * cachedForColorSpace() does not wait for it. (If two threads need the
+ * same volume at the same time, both build it, and the first one is
+ * shared.)
+ * 
+ * @param colorSpace the color space
+ * @param resolution the number of grid points on each axis
+ * @returns the volume
+ * 
+ * @sa RgbColorSpace::gamutVolume() */
+QSharedPointer<const GamutVolume> GamutVolume::forColorSpace(
+    const RgbColorSpace *colorSpace,
+    const int resolution
+)
+{
+    const QByteArray id = colorSpace->profileId();
+    if (id.isEmpty()) {
+        // Without profile id, the volume cannot be shared.
+        return QSharedPointer<const GamutVolume>(
+            new GamutVolume(colorSpace, resolution)
+        );
+    }
+    QSharedPointer<const GamutVolume> result =
+        cachedForColorSpace(colorSpace, resolution);
+    if (!result.isNull()) {
+        return result;
+    }
+    GamutVolume *volume = new GamutVolume();
+    if (!volume->readCacheFile(colorSpace, resolution)) {
+        delete volume;
+        volume = new GamutVolume(colorSpace, resolution);
+        volume->writeCacheFile(colorSpace);
+    }
+    result = QSharedPointer<const GamutVolume>(volume);
+    const QByteArray key = id + QByteArray::number(qMax(resolution, 2));
+    QMutexLocker locker(&gamutVolumeCacheMutex);
+    const QSharedPointer<const GamutVolume> other =
+        gamutVolumeCache().value(key);
+    if (!other.isNull()) {
+        return other;
+    }
+    gamutVolumeCache().insert(key, result);
+    return result;
+}
+
+/** @brief Shared volume for a color space, if it has already been built
+ * 
+ * Like forColorSpace(), but never builds the volume. This function is
+ * thread-safe and fast.
+ * 
+ * @param colorSpace the color space
+ * @param resolution the number of grid points on each axis
+ * @returns the volume, or a null pointer if forColorSpace() has not built
+ * it yet, or if it has been removed by clearCache() meanwhile */
+QSharedPointer<const GamutVolume> GamutVolume::cachedForColorSpace(
+    const RgbColorSpace *colorSpace,
+    const int resolution
+)
+{
+    const QByteArray key =
+        colorSpace->profileId() + QByteArray::number(qMax(resolution, 2));
+    QMutexLocker locker(&gamutVolumeCacheMutex);
+    return gamutVolumeCache().value(key);
+}
+
+/** @brief Memory of the cache of forColorSpace()
+ * 
+ * This function is thread-safe.
+ * 
+ * @returns the total size of the shared volumes in bytes */
+qint64 GamutVolume::cacheByteSize()
+{
+    QMutexLocker locker(&gamutVolumeCacheMutex);
+    qint64 result = 0;
+    for (const QSharedPointer<const GamutVolume> &volume : qAsConst(gamutVolumeCache())) {
+        result += volume->byteSize();
+    }
+    return result;
+}
+
+/** @brief Clears the cache of forColorSpace()
+ * 
+ * Volumes that are still in use stay valid. */
+void GamutVolume::clearCache()
+{
+    QMutexLocker locker(&gamutVolumeCacheMutex);
+    gamutVolumeCache().clear();
+}
+
+}
@@ -27,6 +27,9 @@
 // own header
 #include "PerceptualColor/gradientselector.h"
 
+#include "PerceptualColor/cachemanager.h"
+#include "PerceptualColor/helper.h"
+
 #include <QDebug>
 #include <QPainter>
 #include <QStyle>
@@ -63,6 +66,36 @@ void GradientSelector::initialize(RgbColorSpace* colorSpace, Qt::Orientation ori
         FullColorDescription(m_rgbColorSpace, one, FullColorDescription::outOfGamutBehaviour::preserve, 0),
         FullColorDescription(m_rgbColorSpace, two, FullColorDescription::outOfGamutBehaviour::preserve, 1)
     );
+
+    // Resize debouncing
+    m_resizeTimer.setSingleShot(true);
+    m_resizeTimer.setInterval(Helper::resizeDebounceInterval);
+    connect(
+        &m_resizeTimer, &QTimer::timeout,
+        this, QOverload<>::of(&QWidget::update)
+    );
+
+    // Memory budget
+    CacheManager::instance()->registerWidget(
+        this,
+        [this]() -> qint64 {
+            return m_gradientImage.sizeInBytes();
+        },
+        [this]() {
+            m_gradientImage = QImage();
+            m_gradientImageReady = false;
+        }
+    );
+}
+
+/** @brief Destructor
+ * 
+ * Unregisters the caches from CacheManager. This cannot wait for the
+ * @c destroyed() signal, because when it is emitted, the members that
+ * the callbacks of CacheManager access are already destroyed. */
+GradientSelector::~GradientSelector()
+{
+    CacheManager::instance()->unregisterWidget(this);
 }
 
 QSize GradientSelector::sizeHint() const
@@ -244,15 +277,33 @@ void GradientSelector::paintEvent(QPaintEvent* event)
     //       the platform independent QImage as paint device; i.e. using QImage
     //       will ensure that the result has an identical pixel representation
     //       on any platform.”
-    QImage paintBuffer(size(), QImage::Format_ARGB32);
+    //
+    // On high-dpi screens, the buffer has the native resolution of the
+    // screen (within the render-cost budget), and QPainter works on it
+    // with logical coordinates.
+    const qreal ratio = Helper::cacheDevicePixelRatio(this, size());
+    QImage paintBuffer(size() * ratio, QImage::Format_ARGB32);
+    paintBuffer.setDevicePixelRatio(ratio);
     paintBuffer.fill(Qt::transparent);
     QPainter painter(&paintBuffer);
 
     painter.setTransform(getTransform());
-    if (!m_gradientImageReady) {
+    // While the widget is being resized, the previous cache is scaled to
+    // the new geometry instead of regenerating it.
+    if (m_resizeTimer.isActive() && !m_gradientImage.isNull()) {
+        const int length = (m_orientation == Qt::Orientation::Vertical)
+            ? size().height()
+            : size().width();
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.drawImage(
+            QRectF(0, 0, length, m_gradientThickness),
+            m_gradientImage
+        );
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    } else {
         updateGradientImage();
+        painter.drawImage(0, 0, m_gradientImage);
     }
-    painter.drawImage(0, 0, m_gradientImage);
     
 
     int actualLength;
@@ -379,7 +430,18 @@ void GradientSelector::updateGradientImage()
     } else {
         actualLength = size().width();
     }
-    QImage temp(actualLength, 1, QImage::Format_ARGB32);
+    const qreal ratio = Helper::cacheDevicePixelRatio(
+        this,
+        QSize(actualLength, m_gradientThickness)
+    );
+    // The device pixel ratio changes when the widget is moved to another
+    // screen.
+    if (m_gradientImageReady && (m_gradientImage.devicePixelRatio() == ratio)) {
+        return;
+    }
+    // Length of the gradient in device pixels
+    const int deviceLength = qRound(actualLength * ratio);
+    QImage temp(deviceLength, 1, QImage::Format_ARGB32);
     temp.fill(Qt::transparent); // Initialize the image with transparency.
     cmsCIELCh firstColor = m_firstColor.toLch();
     cmsCIELCh secondColor = m_secondColor.toLch();
@@ -392,8 +454,8 @@ void GradientSelector::updateGradientImage()
     }
     QPair<cmsCIELCh, qreal> color;
     FullColorDescription fullColor;
-    for (i = 0; i < actualLength; ++i) {
-        color = intermediateColor(firstColor, secondColor, i / static_cast<qreal>(actualLength));
+    for (i = 0; i < deviceLength; ++i) {
+        color = intermediateColor(firstColor, secondColor, i / static_cast<qreal>(deviceLength));
         // TODO the in-gamut test fails because of rounding errors for full-chroma-colors. How can we support ignore out-of-gamut colors? How should they be rendered? Not identical to transparent, right?
         fullColor = FullColorDescription(
             m_rgbColorSpace,
@@ -403,19 +465,46 @@ void GradientSelector::updateGradientImage()
         );
         temp.setPixelColor(i, 0, fullColor.toRgbQColor());
     }
-    QImage result = QImage(actualLength, m_gradientThickness, QImage::Format_ARGB32);
+    QImage result = QImage(
+        QSize(actualLength, m_gradientThickness) * ratio,
+        QImage::Format_ARGB32
+    );
+    result.setDevicePixelRatio(ratio);
     QPainter painter(&result);
     painter.fillRect(0, 0, actualLength, m_gradientThickness, m_brush);
-    for (i = 0; i < m_gradientThickness; ++i) {
-        painter.drawImage(0, i, temp);
-    }
+    // Stretch the one-pixel-high gradient to the thickness of the result.
+    // Both images have the same device pixel ratio, so this does not
+    // scale horizontally.
+    temp.setDevicePixelRatio(ratio);
+    painter.drawImage(
+        QRectF(0, 0, actualLength, m_gradientThickness),
+        temp
+    );
+    painter.end();
     m_gradientImage = result;
     m_gradientImageReady = true;
+    CacheManager::instance()->notifyUsed(this);
+}
+
+/** @brief React on a hide event.
+ * 
+ * Reimplemented from base class.
+ * 
+ * Releases the caches by means of CacheManager, so that hidden widgets do
+ * not occupy memory.
+ * 
+ * @param event the hide event
+ */
+void GradientSelector::hideEvent(QHideEvent *event)
+{
+    CacheManager::instance()->notifyHidden(this);
+    QWidget::hideEvent(event);
 }
 
 void GradientSelector::resizeEvent(QResizeEvent *event)
 {
     m_gradientImageReady = false;
+    m_resizeTimer.start();
 }
 
 }
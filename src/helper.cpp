@@ -162,6 +162,52 @@ namespace Helper {
     {
         return event->angleDelta().y() / static_cast<qreal>(120);
     }
+
+    /** @brief Analytic anti-aliasing coverage of a pixel by a disc
+     * 
+     * Within a pixel, the border of the disc is treated as a straight
+     * line. Then the covered area of the pixel is a linear function of
+     * the distance of the pixel center from the border. This is exact
+     * for borders that are parallel to the pixel edges, and very close
+     * otherwise, as long as the radius is not smaller than a pixel.
+     * 
+     * Rings can be rendered as the coverage of the outer disc minus the
+     * coverage of the inner disc.
+     * 
+     * @param distance the distance of the pixel center from the center of
+     * the disc, in pixel
+     * @param radius the radius of the disc, in pixel
+     * @returns the covered part of the pixel area, from 0 to 1 */
+    qreal discCoverage(const qreal distance, const qreal radius)
+    {
+        return qBound<qreal>(0, radius - distance + 0.5, 1);
+    }
+
+    /** @brief Device pixel ratio for an image cache of a widget
+     * 
+     * @param device the paint device that paints the cache, usually the
+     * widget itself
+     * @param logicalSize the size of the cache in logical (device-independent)
+     * pixels
+     * @returns the device pixel ratio of the paint device, if
+     * rendering the cache at this ratio does not exceed renderCostBudget.
+     * Otherwise, @c 1, so that the cache is rendered at logical resolution.
+     * Create the cache image with <tt>logicalSize * ratio</tt> pixels, and
+     * call <tt>QImage::setDevicePixelRatio(ratio)</tt> on it, so that
+     * QPainter draws it at its logical size. */
+    qreal cacheDevicePixelRatio(const QPaintDevice *device, const QSize logicalSize)
+    {
+        const qreal ratio = device->devicePixelRatioF();
+        if (ratio <= 1) {
+            return 1;
+        }
+        const qreal deviceWidth = logicalSize.width() * ratio;
+        const qreal deviceHeight = logicalSize.height() * ratio;
+        if (deviceWidth * deviceHeight > renderCostBudget) {
+            return 1;
+        }
+        return ratio;
+    }
 }
 
 }
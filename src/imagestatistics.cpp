@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/imagestatistics.h"
+
+#include <functional>
+
+#include <QThreadPool>
+#include <QtConcurrent>
+
+namespace PerceptualColor {
+
+/** @brief Constructor
+ * 
+ * @param colorSpace the color space. Must stay alive as long as this
+ * object is used. */
+ImageStatistics::ImageStatistics(RgbColorSpace *colorSpace)
+{
+    m_rgbColorSpace = colorSpace;
+    reset();
+}
+
+/** @brief Clears all statistics */
+void ImageStatistics::reset()
+{
+    m_accumulator = Accumulator();
+}
+
+/** @brief Constructor for empty statistics */
+ImageStatistics::Accumulator::Accumulator()
+{
+    chromaHistogram.fill(0, chromaBinCount);
+    hueHistogram.fill(0, hueBinCount);
+    lightnessHistogram.fill(0, lightnessBinCount);
+    maximumChromaPerHueSector.fill(0, hueSectorCount);
+}
+
+/** @brief Merges other statistics into these statistics
+ * 
+ * @param other the other statistics */
+void ImageStatistics::Accumulator::merge(const Accumulator &other)
+{
+    for (int i = 0; i < lightnessBinCount; ++i) {
+        lightnessHistogram[i] += other.lightnessHistogram.at(i);
+    }
+    for (int i = 0; i < chromaBinCount; ++i) {
+        chromaHistogram[i] += other.chromaHistogram.at(i);
+    }
+    for (int i = 0; i < hueBinCount; ++i) {
+        hueHistogram[i] += other.hueHistogram.at(i);
+    }
+    for (int i = 0; i < hueSectorCount; ++i) {
+        maximumChromaPerHueSector[i] = qMax(
+            maximumChromaPerHueSector.at(i),
+            other.maximumChromaPerHueSector.at(i)
+        );
+    }
+    nearBoundaryCount += other.nearBoundaryCount;
+    pixelCount += other.pixelCount;
+}
+
+/** @brief Adds a scanline
+ * 
+ * @param pixels pointer to the first of @em count pixels, in the format
+ * of QImage::Format_ARGB32 (not premultiplied). Fully transparent pixels
+ * are ignored.
+ * @param count the number of pixels */
+void ImageStatistics::addScanLine(const QRgb *pixels, const int count)
+{
+    accumulate(pixels, count, &m_accumulator);
+}
+
+/** @brief Adds pixels to statistics
+ * 
+ * This function is thread-safe.
+ * 
+ * @param pixels pointer to the first of @em count pixels, in the format
+ * of QImage::Format_ARGB32 (not premultiplied). Fully transparent pixels
+ * are ignored.
+ * @param count the number of pixels
+ * @param accumulator the statistics to which the pixels are added */
+void ImageStatistics::accumulate(
+    const QRgb *pixels,
+    const int count,
+    Accumulator *accumulator
+) const
+{
+    constexpr int chunkSize = 256;
+    QVector<Helper::cmsRGB> rgb(chunkSize);
+    QVector<cmsCIELab> lab(chunkSize);
+    cmsCIELCh lch;
+    int chunkCount;
+    int convertedCount;
+    QRgb pixel;
+    cmsFloat64Number margin;
+    for (int start = 0; start < count; start += chunkSize) {
+        chunkCount = qMin(chunkSize, count - start);
+        convertedCount = 0;
+        for (int i = 0; i < chunkCount; ++i) {
+            pixel = pixels[start + i];
+            if (qAlpha(pixel) == 0) {
+                continue;
+            }
+            rgb[convertedCount].red = qRed(pixel) / static_cast<cmsFloat64Number>(255);
+            rgb[convertedCount].green = qGreen(pixel) / static_cast<cmsFloat64Number>(255);
+            rgb[convertedCount].blue = qBlue(pixel) / static_cast<cmsFloat64Number>(255);
+            ++convertedCount;
+        }
+        m_rgbColorSpace->colorLab(rgb.constData(), lab.data(), convertedCount);
+        for (int i = 0; i < convertedCount; ++i) {
+            lch = Helper::toLch(lab.at(i));
+            ++accumulator->lightnessHistogram[qBound(0, qRound(lch.L), lightnessBinCount - 1)];
+            ++accumulator->chromaHistogram[qBound(0, qRound(lch.C), chromaBinCount - 1)];
+            if (lch.C >= achromaticChroma) {
+                ++accumulator->hueHistogram[qBound(0, static_cast<int>(lch.h), hueBinCount - 1)];
+                const int sector = qBound(
+                    0,
+                    static_cast<int>(lch.h * hueSectorCount / 360),
+                    hueSectorCount - 1
+                );
+                accumulator->maximumChromaPerHueSector[sector] = qMax(
+                    accumulator->maximumChromaPerHueSector.at(sector),
+                    static_cast<qreal>(lch.C)
+                );
+            }
+            margin = qMin(
+                qMin(qMin(rgb.at(i).red, 1 - rgb.at(i).red), qMin(rgb.at(i).green, 1 - rgb.at(i).green)),
+                qMin(rgb.at(i).blue, 1 - rgb.at(i).blue)
+            );
+            if (margin < nearBoundaryThreshold) {
+                ++accumulator->nearBoundaryCount;
+            }
+        }
+        accumulator->pixelCount += static_cast<quint64>(convertedCount);
+    }
+}
+
+/** @brief Adds a whole image
+ * 
+ * The image is split into bands of scanlines, which are analyzed in
+ * parallel and merged at the end. The number of bands depends only on the
+ * number of threads. Images in formats other than QImage::Format_RGB32
+ * and QImage::Format_ARGB32 are converted band by band, in slices of at
+ * most @ref conversionPixelCount pixels, so memory usage is independent of
+ * the image size. This function blocks until the work is done.
+ * 
+ * @param image the image */
+void ImageStatistics::addImage(const QImage &image)
+{
+    const int height = image.height();
+    const int width = image.width();
+    if ((height <= 0) || (width <= 0)) {
+        return;
+    }
+    const int bandCount = qMin(
+        height,
+        4 * qMax(1, QThreadPool::globalInstance()->maxThreadCount())
+    );
+    QVector<int> bands;
+    for (int i = 0; i < bandCount; ++i) {
+        bands.append(i);
+    }
+    const bool directAccess = (image.format() == QImage::Format_RGB32)
+        || (image.format() == QImage::Format_ARGB32);
+    const int sliceHeight = qMax(1, conversionPixelCount / width);
+    const std::function<Accumulator(const int &)> analyzeBand =
+        [this, &image, height, width, bandCount, directAccess, sliceHeight](
+            const int &band
+        ) {
+            Accumulator result;
+            const int begin = static_cast<int>(static_cast<qint64>(height) * band / bandCount);
+            const int end = static_cast<int>(static_cast<qint64>(height) * (band + 1) / bandCount);
+            if (directAccess) {
+                for (int y = begin; y < end; ++y) {
+                    accumulate(
+                        reinterpret_cast<const QRgb *>(image.constScanLine(y)),
+                        width,
+                        &result
+                    );
+                }
+                return result;
+            }
+            QImage slice;
+            int rowCount;
+            for (int y = begin; y < end; y += sliceHeight) {
+                rowCount = qMin(sliceHeight, end - y);
+                // A read-only view of the rows, without copying them
+                QImage view(
+                    image.constScanLine(y),
+                    width,
+                    rowCount,
+                    image.bytesPerLine(),
+                    image.format()
+                );
+                view.setColorTable(image.colorTable());
+                slice = view.convertToFormat(QImage::Format_ARGB32);
+                for (int row = 0; row < rowCount; ++row) {
+                    accumulate(
+                        reinterpret_cast<const QRgb *>(slice.constScanLine(row)),
+                        width,
+                        &result
+                    );
+                }
+            }
+            return result;
+        };
+    const QList<Accumulator> results =
+        QtConcurrent::blockingMapped<QList<Accumulator> >(bands, analyzeBand);
+    for (const Accumulator &accumulator : results) {
+        m_accumulator.merge(accumulator);
+    }
+}
+
+/** @brief Merges the statistics of another object into this one
+ * 
+ * @param other the other object */
+void ImageStatistics::merge(const ImageStatistics &other)
+{
+    m_accumulator.merge(other.m_accumulator);
+}
+
+/** @brief Histogram of the LCh chroma
+ * 
+ * @returns chromaBinCount bins. Bin @em i counts the pixels with a
+ * chroma that rounds to @em i. */
+QVector<quint64> ImageStatistics::chromaHistogram() const
+{
+    return m_accumulator.chromaHistogram;
+}
+
+/** @brief Histogram of the LCh hue
+ * 
+ * @returns hueBinCount bins. Bin @em i counts the pixels with a hue in
+ * the range <tt>[i, i + 1[</tt>. Achromatic pixels are not counted.
+ * 
+ * @sa achromaticChroma */
+QVector<quint64> ImageStatistics::hueHistogram() const
+{
+    return m_accumulator.hueHistogram;
+}
+
+/** @brief Histogram of the LCh lightness
+ * 
+ * @returns lightnessBinCount bins. Bin @em i counts the pixels with a
+ * lightness that rounds to @em i. */
+QVector<quint64> ImageStatistics::lightnessHistogram() const
+{
+    return m_accumulator.lightnessHistogram;
+}
+
+/** @brief Maximum chroma per hue sector
+ * 
+ * @returns hueSectorCount values. Value @em i is the maximum chroma of
+ * the pixels with a hue in the sector <tt>[i × 10°, (i + 1) × 10°[</tt>,
+ * or @c 0 if there are no such pixels. */
+QVector<qreal> ImageStatistics::maximumChromaPerHueSector() const
+{
+    return m_accumulator.maximumChromaPerHueSector;
+}
+
+/** @brief Share of the pixels near the gamut boundary
+ * 
+ * @returns a value in the range 0..1, or 0 if there are no pixels.
+ * 
+ * @sa nearBoundaryThreshold */
+qreal ImageStatistics::nearBoundaryShare() const
+{
+    if (m_accumulator.pixelCount == 0) {
+        return 0;
+    }
+    return static_cast<qreal>(m_accumulator.nearBoundaryCount)
+        / m_accumulator.pixelCount;
+}
+
+/** @brief Number of analyzed pixels (without fully transparent pixels) */
+quint64 ImageStatistics::pixelCount() const
+{
+    return m_accumulator.pixelCount;
+}
+
+}
@@ -0,0 +1,312 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Own header
+#include "PerceptualColor/labindex.h"
+
+#include "PerceptualColor/colordifference.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace PerceptualColor {
+
+namespace {
+
+    /** @brief The coordinate of a Lab value on the given axis
+     * 
+     * @param lab the Lab value
+     * @param axis 0 for L, 1 for a, 2 for b */
+    cmsFloat64Number coordinate(const cmsCIELab &lab, const int axis)
+    {
+        switch (axis) {
+        case 0:
+            return lab.L;
+        case 1:
+            return lab.a;
+        default:
+            return lab.b;
+        }
+    }
+
+    cmsFloat64Number distanceSquared(const cmsCIELab &first, const cmsCIELab &second)
+    {
+        const cmsFloat64Number dL = first.L - second.L;
+        const cmsFloat64Number da = first.a - second.a;
+        const cmsFloat64Number db = first.b - second.b;
+        return dL * dL + da * da + db * db;
+    }
+
+    /** @brief Orders matches by ascending color difference, and by index
+     * for equal color differences */
+    bool lessThan(const LabIndex::Match &first, const LabIndex::Match &second)
+    {
+        if (first.deltaE != second.deltaE) {
+            return first.deltaE < second.deltaE;
+        }
+        return first.index < second.index;
+    }
+
+}
+
+/** @brief Constructor
+ * 
+ * @param colors the colors. The indices of the query results refer to
+ * this list. */
+LabIndex::LabIndex(const QVector<cmsCIELab> &colors)
+{
+    m_colors = colors;
+    m_tree.resize(m_colors.count());
+    for (int i = 0; i < m_tree.count(); ++i) {
+        m_tree[i] = i;
+    }
+    build(0, m_tree.count(), 0);
+}
+
+/** @brief Constructor
+ * 
+ * @param colors the colors. The indices of the query results refer to
+ * this list. Invalid colors are indexed with Lab 0, 0, 0. */
+LabIndex::LabIndex(const QVector<FullColorDescription> &colors)
+    : LabIndex(
+        [&colors]() {
+            QVector<cmsCIELab> lab;
+            lab.reserve(colors.count());
+            for (const FullColorDescription &color : colors) {
+                lab.append(color.toLab());
+            }
+            return lab;
+        }()
+    )
+{
+}
+
+/** @brief Builds the subtree of the range <tt>[begin, end)</tt> */
+void LabIndex::build(const int begin, const int end, const int depth)
+{
+    if (end - begin < 2) {
+        return;
+    }
+    const int axis = depth % 3;
+    const int node = (begin + end) / 2;
+    std::nth_element(
+        m_tree.begin() + begin,
+        m_tree.begin() + node,
+        m_tree.begin() + end,
+        [this, axis](const int first, const int second) {
+            return coordinate(m_colors.at(first), axis)
+                < coordinate(m_colors.at(second), axis);
+        }
+    );
+    build(begin, node, depth + 1);
+    build(node + 1, end, depth + 1);
+}
+
+/** @brief Number of indexed colors */
+int LabIndex::count() const
+{
+    return m_colors.count();
+}
+
+/** @brief An indexed color
+ * 
+ * @param index the index in the list given to the constructor
+ * @returns the color */
+cmsCIELab LabIndex::color(const int index) const
+{
+    return m_colors.at(index);
+}
+
+/** @brief Recursive k-nearest-neighbor search
+ * 
+ * @param lab the query color
+ * @param k the number of requested neighbors
+ * @param begin begin of the subtree range
+ * @param end end of the subtree range
+ * @param depth depth of the subtree
+ * @param heap the best matches so far, as max-heap (by lessThan()).
+ * Match::deltaE contains the @em squared distance here. */
+void LabIndex::searchNearest(
+    const cmsCIELab &lab,
+    const int k,
+    const int begin,
+    const int end,
+    const int depth,
+    QVector<Match> *heap
+) const
+{
+    if (begin >= end) {
+        return;
+    }
+    const int node = (begin + end) / 2;
+    const int colorIndex = m_tree.at(node);
+    const Match candidate {
+        colorIndex,
+        distanceSquared(lab, m_colors.at(colorIndex))
+    };
+    if (heap->count() < k) {
+        heap->append(candidate);
+        std::push_heap(heap->begin(), heap->end(), lessThan);
+    } else if (lessThan(candidate, heap->first())) {
+        std::pop_heap(heap->begin(), heap->end(), lessThan);
+        heap->last() = candidate;
+        std::push_heap(heap->begin(), heap->end(), lessThan);
+    }
+
+    const int axis = depth % 3;
+    const cmsFloat64Number offset =
+        coordinate(lab, axis) - coordinate(m_colors.at(colorIndex), axis);
+    // Search first the side of the split plane that contains the query
+    // color, and the other side only if it can contain better matches.
+    if (offset < 0) {
+        searchNearest(lab, k, begin, node, depth + 1, heap);
+        if ((heap->count() < k) || (offset * offset <= heap->first().deltaE)) {
+            searchNearest(lab, k, node + 1, end, depth + 1, heap);
+        }
+    } else {
+        searchNearest(lab, k, node + 1, end, depth + 1, heap);
+        if ((heap->count() < k) || (offset * offset <= heap->first().deltaE)) {
+            searchNearest(lab, k, begin, node, depth + 1, heap);
+        }
+    }
+}
+
+/** @brief The nearest colors by ΔE*76
+ * 
+ * @param lab the query color
+ * @param k the number of requested colors
+ * @returns The <em>k</em> nearest colors (or less if the index contains
+ * less colors), sorted by ascending ΔE*76. */
+QVector<LabIndex::Match> LabIndex::nearest(const cmsCIELab &lab, const int k) const
+{
+    QVector<Match> result;
+    if (k <= 0) {
+        return result;
+    }
+    result.reserve(qMin(k, count()));
+    searchNearest(lab, k, 0, m_tree.count(), 0, &result);
+    std::sort_heap(result.begin(), result.end(), lessThan);
+    for (Match &match : result) {
+        match.deltaE = std::sqrt(match.deltaE);
+    }
+    return result;
+}
+
+/** @brief The nearest colors by CIEDE2000
+ * 
+ * The index itself works with ΔE*76. This function takes the nearest
+ * candidates by ΔE*76 and re-ranks them by CIEDE2000. As both metrics
+ * agree well for small color differences, this finds the nearest colors
+ * by CIEDE2000 in practice, but it is not guaranteed.
+ * 
+ * @param lab the query color
+ * @param k the number of requested colors
+ * @param candidates the number of candidates taken from the index. If
+ * smaller than @em k, <tt>4 × k + 16</tt> is used.
+ * @returns The <em>k</em> nearest colors (or less if the index contains
+ * less colors), sorted by ascending CIEDE2000. */
+QVector<LabIndex::Match> LabIndex::nearestDeltaE2000(
+    const cmsCIELab &lab,
+    const int k,
+    const int candidates
+) const
+{
+    QVector<Match> result = nearest(
+        lab,
+        (candidates < k) ? (4 * k + 16) : candidates
+    );
+    for (Match &match : result) {
+        match.deltaE = ColorDifference::deltaE2000(lab, m_colors.at(match.index));
+    }
+    std::sort(result.begin(), result.end(), lessThan);
+    if (result.count() > k) {
+        result.resize(qMax(k, 0));
+    }
+    return result;
+}
+
+/** @brief Recursive radius search
+ * 
+ * @param lab the query color
+ * @param radiusSquared the squared radius
+ * @param begin begin of the subtree range
+ * @param end end of the subtree range
+ * @param depth depth of the subtree
+ * @param result the matches. Match::deltaE contains the @em squared
+ * distance here. */
+void LabIndex::searchRadius(
+    const cmsCIELab &lab,
+    const cmsFloat64Number radiusSquared,
+    const int begin,
+    const int end,
+    const int depth,
+    QVector<Match> *result
+) const
+{
+    if (begin >= end) {
+        return;
+    }
+    const int node = (begin + end) / 2;
+    const int colorIndex = m_tree.at(node);
+    const cmsFloat64Number distance = distanceSquared(lab, m_colors.at(colorIndex));
+    if (distance <= radiusSquared) {
+        result->append(Match {colorIndex, distance});
+    }
+    const int axis = depth % 3;
+    const cmsFloat64Number offset =
+        coordinate(lab, axis) - coordinate(m_colors.at(colorIndex), axis);
+    if ((offset < 0) || (offset * offset <= radiusSquared)) {
+        searchRadius(lab, radiusSquared, begin, node, depth + 1, result);
+    }
+    if ((offset >= 0) || (offset * offset <= radiusSquared)) {
+        searchRadius(lab, radiusSquared, node + 1, end, depth + 1, result);
+    }
+}
+
+/** @brief All colors within a given ΔE*76 radius
+ * 
+ * @param lab the query color
+ * @param radius the radius
+ * @returns All colors with a ΔE*76 ≤ @em radius, sorted by ascending
+ * ΔE*76. */
+QVector<LabIndex::Match> LabIndex::withinRadius(
+    const cmsCIELab &lab,
+    const cmsFloat64Number radius
+) const
+{
+    QVector<Match> result;
+    if (radius < 0) {
+        return result;
+    }
+    searchRadius(lab, radius * radius, 0, m_tree.count(), 0, &result);
+    std::sort(result.begin(), result.end(), lessThan);
+    for (Match &match : result) {
+        match.deltaE = std::sqrt(match.deltaE);
+    }
+    return result;
+}
+
+}
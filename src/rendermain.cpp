@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/diagramrenderer.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+#include <QCommandLineParser>
+#include <QFile>
+#include <QGuiApplication>
+#include <QTextStream>
+#include <QThreadPool>
+
+/** @file
+ * 
+ * Command line tool that renders the diagrams of this library to files,
+ * without any widget. It runs also without a window system: If no platform
+ * plugin is requested explicitly, the <tt>offscreen</tt> plugin is used.
+ * 
+ * Single diagram:
+ * <tt>perceptualcolor-render --type wheel --size 300 --output wheel.png</tt>
+ * 
+ * Batch: Each line of the batch file describes a job by means of
+ * <tt>key=value</tt> pairs separated by spaces. The keys are the long names
+ * of the command line options. Missing keys default to the command line
+ * options. Empty lines and lines starting with <tt>#</tt> are ignored.
+ * <tt>type=chromalightness hue=120 size=400x300 output=hue120.png</tt>
+ */
+
+namespace {
+
+using PerceptualColor::DiagramRenderer;
+
+/** @brief Applies a single option value to a job
+ * 
+ * @param key the option name
+ * @param value the option value
+ * @param job the job that will be modified
+ * @returns @c true on success, @c false if the key is unknown or the
+ * value is invalid. */
+bool applyOption(
+    const QString &key,
+    const QString &value,
+    DiagramRenderer::Job *job
+)
+{
+    bool ok = true;
+    if (key == QStringLiteral("type")) {
+        if (value == QStringLiteral("chromahue")) {
+            job->type = DiagramRenderer::DiagramType::chromaHue;
+        } else if (value == QStringLiteral("chromalightness")) {
+            job->type = DiagramRenderer::DiagramType::chromaLightness;
+        } else if (value == QStringLiteral("wheel")) {
+            job->type = DiagramRenderer::DiagramType::colorWheel;
+        } else {
+            ok = false;
+        }
+    } else if (key == QStringLiteral("size")) {
+        const QStringList parts = value.split(QLatin1Char('x'));
+        bool widthOk = false;
+        bool heightOk = false;
+        const int width = parts.value(0).toInt(&widthOk);
+        const int height = parts.value(parts.count() - 1).toInt(&heightOk);
+        job->size = QSize(width, height);
+        ok = widthOk && heightOk && (parts.count() <= 2);
+    } else if (key == QStringLiteral("lightness")) {
+        job->lightness = value.toDouble(&ok);
+    } else if (key == QStringLiteral("hue")) {
+        job->hue = value.toDouble(&ok);
+    } else if (key == QStringLiteral("chroma")) {
+        job->chroma = value.toDouble(&ok);
+    } else if (key == QStringLiteral("max-chroma")) {
+        job->maxChroma = value.toInt(&ok);
+    } else if (key == QStringLiteral("border")) {
+        job->border = value.toInt(&ok);
+    } else if (key == QStringLiteral("thickness")) {
+        job->wheelThickness = value.toInt(&ok);
+    } else if (key == QStringLiteral("output")) {
+        job->fileName = value;
+    } else {
+        ok = false;
+    }
+    return ok;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("perceptualcolor-render"));
+    QTextStream errorStream(stderr);
+
+    const QStringList jobKeys {
+        QStringLiteral("type"),
+        QStringLiteral("size"),
+        QStringLiteral("lightness"),
+        QStringLiteral("hue"),
+        QStringLiteral("chroma"),
+        QStringLiteral("max-chroma"),
+        QStringLiteral("border"),
+        QStringLiteral("thickness"),
+        QStringLiteral("output")
+    };
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Renders perceptual color diagrams to files.")
+    );
+    parser.addHelpOption();
+    parser.addOptions({
+        {
+            QStringLiteral("type"),
+            QStringLiteral("Diagram type: chromahue, chromalightness or wheel."),
+            QStringLiteral("type"),
+            QStringLiteral("chromahue")
+        },
+        {
+            QStringLiteral("size"),
+            QStringLiteral("Image size: N or WIDTHxHEIGHT."),
+            QStringLiteral("size"),
+            QStringLiteral("256")
+        },
+        {
+            QStringLiteral("lightness"),
+            QStringLiteral("LCh lightness (chromahue, wheel)."),
+            QStringLiteral("lightness")
+        },
+        {
+            QStringLiteral("hue"),
+            QStringLiteral("LCh hue (chromalightness)."),
+            QStringLiteral("hue")
+        },
+        {
+            QStringLiteral("chroma"),
+            QStringLiteral("LCh chroma (wheel)."),
+            QStringLiteral("chroma")
+        },
+        {
+            QStringLiteral("max-chroma"),
+            QStringLiteral("Chroma at the border of the circle (chromahue)."),
+            QStringLiteral("chroma")
+        },
+        {
+            QStringLiteral("border"),
+            QStringLiteral("Border in pixel (chromahue, wheel)."),
+            QStringLiteral("pixel")
+        },
+        {
+            QStringLiteral("thickness"),
+            QStringLiteral("Wheel thickness in pixel (wheel)."),
+            QStringLiteral("pixel")
+        },
+        {
+            QStringLiteral("output"),
+            QStringLiteral("Output file name."),
+            QStringLiteral("file")
+        },
+        {
+            QStringLiteral("format"),
+            QStringLiteral(
+                "Output format: png or raw (RGBA, 8 bit per channel, "
+                "not premultiplied, no header)."
+            ),
+            QStringLiteral("format"),
+            QStringLiteral("png")
+        },
+        {
+            QStringLiteral("batch"),
+            QStringLiteral("File with one job per line (key=value pairs)."),
+            QStringLiteral("file")
+        },
+        {
+            QStringLiteral("threads"),
+            QStringLiteral("Maximum number of worker threads."),
+            QStringLiteral("count")
+        }
+    });
+    parser.process(app);
+
+    // Defaults from the command line
+    DiagramRenderer::Job defaultJob;
+    for (const QString &key : jobKeys) {
+        // Options without value keep the defaults of DiagramRenderer::Job
+        if (!parser.value(key).isEmpty()) {
+            if (!applyOption(key, parser.value(key), &defaultJob)) {
+                errorStream << "Invalid value for --" << key << '\n';
+                errorStream.flush();
+                return 1;
+            }
+        }
+    }
+
+    DiagramRenderer::OutputFormat format;
+    if (parser.value(QStringLiteral("format")) == QStringLiteral("png")) {
+        format = DiagramRenderer::OutputFormat::png;
+    } else if (parser.value(QStringLiteral("format")) == QStringLiteral("raw")) {
+        format = DiagramRenderer::OutputFormat::raw;
+    } else {
+        errorStream << "Invalid value for --format\n";
+        errorStream.flush();
+        return 1;
+    }
+
+    if (parser.isSet(QStringLiteral("threads"))) {
+        bool ok;
+        const int threads = parser.value(QStringLiteral("threads")).toInt(&ok);
+        if ((!ok) || (threads < 1)) {
+            errorStream << "Invalid value for --threads\n";
+            errorStream.flush();
+            return 1;
+        }
+        QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    }
+
+    // Collect the jobs
+    QList<DiagramRenderer::Job> jobs;
+    if (parser.isSet(QStringLiteral("batch"))) {
+        QFile batchFile(parser.value(QStringLiteral("batch")));
+        if (!batchFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            errorStream << "Cannot open " << batchFile.fileName() << '\n';
+            errorStream.flush();
+            return 1;
+        }
+        QTextStream batchStream(&batchFile);
+        QString line;
+        int lineNumber = 0;
+        while (batchStream.readLineInto(&line)) {
+            ++lineNumber;
+            line = line.trimmed();
+            if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+                continue;
+            }
+            DiagramRenderer::Job job = defaultJob;
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
+            const QStringList pairs =
+                line.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+#else
+            const QStringList pairs =
+                line.split(QLatin1Char(' '), QString::SkipEmptyParts);
+#endif
+            for (const QString &pair : pairs) {
+                const int separator = pair.indexOf(QLatin1Char('='));
+                if ((separator < 1) || !applyOption(
+                        pair.left(separator),
+                        pair.mid(separator + 1),
+                        &job
+                    )
+                ) {
+                    errorStream << batchFile.fileName() << ":" << lineNumber
+                        << ": Invalid entry " << pair << '\n';
+                    errorStream.flush();
+                    return 1;
+                }
+            }
+            jobs.append(job);
+        }
+    } else {
+        jobs.append(defaultJob);
+    }
+    for (const DiagramRenderer::Job &job : jobs) {
+        if (job.fileName.isEmpty()) {
+            errorStream << "No output file name given\n";
+            errorStream.flush();
+            return 1;
+        }
+    }
+
+    // Render
+    PerceptualColor::RgbColorSpace colorSpace;
+    const DiagramRenderer renderer(&colorSpace);
+    const int written = renderer.writeBatch(jobs, format);
+    if (written != jobs.count()) {
+        errorStream << (jobs.count() - written) << " of " << jobs.count()
+            << " images could not be written\n";
+        errorStream.flush();
+        return 1;
+    }
+    return 0;
+}
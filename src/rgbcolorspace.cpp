@@ -27,53 +27,515 @@
 // Own header
 #include "PerceptualColor/rgbcolorspace.h"
 
+#include "PerceptualColor/cachefile.h"
+#include "PerceptualColor/gamutvolume.h"
 #include "PerceptualColor/helper.h"
 
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSharedMemory>
+#include <QVector>
+#include <QtConcurrent>
+#include <QtMath>
+
+#include <cstring>
 
 namespace PerceptualColor {
 
+namespace {
+
+/** @brief An entry of the conversion cache.
+ * 
+ * @sa RgbColorSpace::lookupConversion() */
+struct ConversionCacheEntry {
+    /** RgbColorSpace::m_instanceId of the owner. @c 0 means: unused entry. */
+    quint64 instanceId;
+    /** Quantized LCh lightness of the requested color */
+    qint64 lightness;
+    /** Quantized LCh chroma of the requested color */
+    qint64 chroma;
+    /** Quantized LCh hue of the requested color */
+    qint64 hue;
+    /** If gamut mapping was requested */
+    bool sacrifyChroma;
+    /** If the gamut mapping has actually changed the LCh value */
+    bool modified;
+    /** The cached result */
+    RgbColorSpace::LchConversion conversion;
+};
+
+/** @brief Number of entries of the conversion cache. Must be a power
+ * of two. */
+constexpr int conversionCacheSize = 256;
+
+/** @brief The conversion cache.
+ * 
+ * A small direct-mapped cache. Each thread has its own copy, so no locking
+ * is necessary. It is shared by all RgbColorSpace objects of the thread;
+ * the entries are distinguished by RgbColorSpace::m_instanceId. */
+thread_local ConversionCacheEntry conversionCache[conversionCacheSize];
+
+/** @brief Version of the data that RgbColorSpace stores in its CacheFile.
+ * 
+ * Increase this whenever the layout of the payload or the algorithm that
+ * computes it changes. */
+constexpr quint32 cacheVersion = 1;
+
+/** @brief Protects RgbColorSpace::transformCache() and its statistics */
+QMutex transformCacheMutex;
+
+/** @brief Storage for RgbColorSpace::transformCacheHits() */
+quint64 transformCacheHitCount = 0;
+
+/** @brief Storage for RgbColorSpace::transformCacheMisses() */
+quint64 transformCacheMissCount = 0;
+
+/** @brief Storage for RgbColorSpace::isDeviceLinkCacheEnabled() */
+QAtomicInt deviceLinkCacheEnabled {0};
+
+/** @brief Version of the device links that RgbColorSpace stores in its
+ * CacheFile.
+ * 
+ * Increase this whenever the way the device links are created changes. */
+constexpr quint32 deviceLinkVersion = 1;
+
+/** @brief Maximum difference between the results of a device link and of
+ * the original transform.
+ * 
+ * For Lab→RGB, this is in RGB units (0..1). For RGB→Lab, it is scaled by
+ * 100, the range of the lightness. */
+constexpr cmsFloat64Number deviceLinkTolerance = 0.00001;
+
+/** @brief File name of a device link in the CacheFile directory
+ * 
+ * @param profileId the ID of the RGB profile
+ * @param direction "labtorgb" or "rgbtolab" */
+QString deviceLinkCacheName(const QByteArray &profileId, const char *direction)
+{
+    return QStringLiteral("devicelink-%1-%2.icc").arg(
+        QString::fromLatin1(profileId.toHex()),
+        QString::fromLatin1(direction)
+    );
+}
+
+/** @brief Key of the device link cache files */
+QByteArray deviceLinkCacheKey(const QByteArray &profileId)
+{
+    const quint32 lcmsVersion = static_cast<quint32>(cmsGetEncodedCMMversion());
+    QByteArray result = QByteArrayLiteral("DeviceLink");
+    result.append(
+        reinterpret_cast<const char *>(&deviceLinkVersion),
+        sizeof(deviceLinkVersion)
+    );
+    result.append(
+        reinterpret_cast<const char *>(&lcmsVersion),
+        sizeof(lcmsVersion)
+    );
+    result.append(profileId);
+    return result;
+}
+
+/** @brief Loads a device link from the cache
+ * 
+ * @param name the name of the cache file
+ * @param profileId the ID of the RGB profile
+ * @param usable Output parameter. Is set to @c false if the cache file
+ * records that this transform cannot be represented as device link,
+ * and to @c true otherwise.
+ * @returns the device link profile (must be closed by the caller), or
+ * @c nullptr if there is no usable device link in the cache. */
+cmsHPROFILE loadDeviceLink(
+    const QString &name,
+    const QByteArray &profileId,
+    bool *usable
+)
+{
+    *usable = true;
+    CacheFile cache(name, deviceLinkCacheKey(profileId));
+    if (!cache.isValid()) {
+        return nullptr;
+    }
+    if (cache.payloadSize() == 0) {
+        *usable = false;
+        return nullptr;
+    }
+    // LittleCMS makes its own copy of the data.
+    return cmsOpenProfileFromMem(
+        cache.payload(),
+        static_cast<cmsUInt32Number>(cache.payloadSize())
+    );
+}
+
+/** @brief Creates a transform from a device link
+ * 
+ * The pipeline of the device link has been optimized before it was
+ * stored, so it is not optimized again.
+ * 
+ * @returns the transform, or @c nullptr on failure */
+cmsHTRANSFORM transformFromDeviceLink(
+    cmsHPROFILE deviceLink,
+    const cmsUInt32Number inputFormat,
+    const cmsUInt32Number outputFormat
+)
+{
+    return cmsCreateTransform(
+        deviceLink,                   // device link profile handle
+        inputFormat,                  // input buffer format
+        NULL,                         // no output profile for device links
+        outputFormat,                 // output buffer format
+        INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
+        cmsFLAGS_NOOPTIMIZE           // flags
+    );
+}
+
+/** @brief Sample values for the verification of device links
+ * 
+ * @param labInput @c true for Lab values, @c false for RGB values
+ * @returns the values, three cmsFloat64Number per color */
+QVector<cmsFloat64Number> deviceLinkSamples(const bool labInput)
+{
+    QVector<cmsFloat64Number> result;
+    if (labInput) {
+        for (int lightness = 0; lightness <= 100; lightness += 10) {
+            for (int a = -120; a <= 120; a += 30) {
+                for (int b = -120; b <= 120; b += 30) {
+                    result << lightness << a << b;
+                }
+            }
+        }
+    } else {
+        for (int red = 0; red <= 10; ++red) {
+            for (int green = 0; green <= 10; ++green) {
+                for (int blue = 0; blue <= 10; ++blue) {
+                    result << red / 10.0 << green / 10.0 << blue / 10.0;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/** @brief Stores a transform as device link in the cache
+ * 
+ * The device link is only stored if it reproduces the transform within
+ * deviceLinkTolerance. Otherwise, an empty file is stored, so that the
+ * (expensive) test is not repeated at the next start.
+ * 
+ * @param transform the transform, with the given formats
+ * @param inputFormat the input format of @em transform (a DBL format)
+ * @param outputFormat the output format of @em transform (a DBL format)
+ * @param name the name of the cache file
+ * @param profileId the ID of the RGB profile */
+void storeDeviceLink(
+    cmsHTRANSFORM transform,
+    const cmsUInt32Number inputFormat,
+    const cmsUInt32Number outputFormat,
+    const QString &name,
+    const QByteArray &profileId
+)
+{
+    if (transform == nullptr) {
+        return;
+    }
+    QByteArray payload;
+    cmsHPROFILE deviceLink = cmsTransform2DeviceLink(transform, 4.3, 0);
+    if (deviceLink != nullptr) {
+        cmsHTRANSFORM candidate = transformFromDeviceLink(
+            deviceLink,
+            inputFormat,
+            outputFormat
+        );
+        if (candidate != nullptr) {
+            const bool labInput = (inputFormat == TYPE_Lab_DBL);
+            const cmsFloat64Number tolerance =
+                labInput ? deviceLinkTolerance : deviceLinkTolerance * 100;
+            const QVector<cmsFloat64Number> input = deviceLinkSamples(labInput);
+            const cmsUInt32Number count =
+                static_cast<cmsUInt32Number>(input.count() / 3);
+            QVector<cmsFloat64Number> expected(input.count());
+            QVector<cmsFloat64Number> actual(input.count());
+            cmsDoTransform(transform, input.constData(), expected.data(), count);
+            cmsDoTransform(candidate, input.constData(), actual.data(), count);
+            cmsDeleteTransform(candidate);
+            bool isEqual = true;
+            for (int i = 0; i < expected.count(); ++i) {
+                isEqual = isEqual
+                    && (qAbs(expected.at(i) - actual.at(i)) <= tolerance);
+            }
+            cmsUInt32Number size = 0;
+            if (isEqual && cmsSaveProfileToMem(deviceLink, NULL, &size)) {
+                payload.resize(static_cast<int>(size));
+                if (!cmsSaveProfileToMem(deviceLink, payload.data(), &size)) {
+                    payload.clear();
+                }
+            }
+        }
+        cmsCloseProfile(deviceLink);
+    }
+    CacheFile::write(name, deviceLinkCacheKey(profileId), payload);
+}
+
+/** @brief Storage for RgbColorSpace::isSharedGamutTableEnabled() */
+QAtomicInt sharedGamutTableEnabled {0};
+
+/** @brief Number of lightness rows of the gamut table (L* 0..100, step 1) */
+constexpr int gamutTableLightnessCount = 101;
+
+/** @brief Number of hue columns of the gamut table (h 0..359, step 1) */
+constexpr int gamutTableHueCount = 360;
+
+/** @brief Number of entries of the gamut table */
+constexpr int gamutTableSize = gamutTableLightnessCount * gamutTableHueCount;
+
+/** @brief Half width of the bracket that RgbColorSpace::boundaryChroma()
+ * tries around the estimate of the gamut table. */
+constexpr cmsFloat64Number gamutTableMargin = 0.5;
+
+/** @brief Version of the layout of the gamut table in shared memory.
+ * 
+ * Increase this whenever the layout or the content changes. */
+constexpr quint32 gamutTableVersion = 1;
+
+/** @brief Magic number of the gamut table in shared memory ("PCGT") */
+constexpr quint32 gamutTableMagic = 0x50434754;
+
+/** @brief Maximum size of RgbColorSpace::cacheKey() */
+constexpr int gamutTableKeyCapacity = 64;
+
+/** @brief Header of the gamut table in shared memory
+ * 
+ * It is followed by the table itself: gamutTableSize float values,
+ * row by row (lightness), each row containing all hues.
+ * 
+ * Only the process that has created the segment writes the header and
+ * the table, and only while the QSharedMemory::lock() is hold. Once
+ * @c ready is set, the table is never written again, so consumers can
+ * read it without locking. A crashed producer leaves a segment with
+ * @c ready not set. Processes that attach to such a segment do not
+ * touch it, but compute the table in their local memory. */
+struct SharedGamutTableHeader {
+    /** Always gamutTableMagic */
+    quint32 magic;
+    /** gamutTableVersion */
+    quint32 version;
+    /** @c 1 if the table is complete, @c 0 otherwise */
+    quint32 ready;
+    /** qChecksum() of the table */
+    quint32 checksum;
+    /** Size of the key in bytes */
+    quint32 keySize;
+    /** Padding */
+    quint32 reserved;
+    /** RgbColorSpace::cacheKey() */
+    char key[gamutTableKeyCapacity];
+};
+
+/** @brief Checksum of a gamut table */
+quint32 gamutTableChecksum(const float *table)
+{
+    return qChecksum(
+        reinterpret_cast<const char *>(table),
+        static_cast<uint>(gamutTableSize * sizeof(float))
+    );
+}
+
+/** @brief Source for RgbColorSpace::m_instanceId. */
+QAtomicInteger<quint64> instanceCounter {0};
+
+/** @brief Quantizes a value for the conversion cache key. */
+qint64 quantizeForConversionCache(const cmsFloat64Number value)
+{
+    return qRound64(value / RgbColorSpace::conversionCacheQuantum);
+}
+
+/** @brief Index of a quantized key within the conversion cache. */
+int conversionCacheIndex(
+    const qint64 lightness,
+    const qint64 chroma,
+    const qint64 hue,
+    const bool sacrifyChroma
+)
+{
+    quint64 hash = static_cast<quint64>(lightness) * 73856093u;
+    hash ^= static_cast<quint64>(chroma) * 19349663u;
+    hash ^= static_cast<quint64>(hue) * 83492791u;
+    hash ^= (hash >> 17);
+    if (sacrifyChroma) {
+        hash = ~hash;
+    }
+    return static_cast<int>(hash & (conversionCacheSize - 1));
+}
+
+}
+
+/** @brief The LittleCMS transforms of an RGB profile
+ * 
+ * LittleCMS transforms are thread-safe (the 16-bit transform works on a
+ * local copy of its cache), so they can be used from several threads and
+ * several RgbColorSpace objects at the same time.
+ * 
+ * @sa transformsForProfile() */
+struct RgbColorSpace::Transforms {
+    cmsHTRANSFORM labToRgb16 = nullptr;
+    cmsHTRANSFORM labToRgb = nullptr;
+    cmsHTRANSFORM labToRgbFloat32 = nullptr;
+    cmsHTRANSFORM rgbToLab = nullptr;
+    /** @brief If all transforms have been created from cached device
+     * links
+     * 
+     * @sa usesDeviceLinks() */
+    bool fromDeviceLinks = false;
+    ~Transforms()
+    {
+        if (labToRgbFloat32 != nullptr) {
+            cmsDeleteTransform(labToRgbFloat32);
+        }
+        if (labToRgb16 != nullptr) {
+            cmsDeleteTransform(labToRgb16);
+        }
+        if (labToRgb != nullptr) {
+            cmsDeleteTransform(labToRgb);
+        }
+        if (rgbToLab != nullptr) {
+            cmsDeleteTransform(rgbToLab);
+        }
+    }
+};
+
 /** @brief Default constructor
  * 
  * Creates an sRGB color space.
  */
 RgbColorSpace::RgbColorSpace(QObject *parent) : QObject(parent)
 {
-    // Create an ICC v4 profile object for the Lab color space.
-    // NULL means: Default white point (D50) // TODO Does this make sense? sRGB white point is D65!
-    cmsHPROFILE labProfileHandle = cmsCreateLab4Profile(NULL);
     // Create an ICC profile object for the sRGB color space.
     cmsHPROFILE rgbProfileHandle = cmsCreate_sRGBProfile();
-    m_description = getInformationFromProfile(rgbProfileHandle, cmsInfoDescription);
-    m_description = tr("sRGB"); // TODO Do this only if the build-in sRGB is used, not when an actual external ICC profile is used.
-    // Create the transforms
-    m_transformLabToRgbHandle = cmsCreateTransform(
-        labProfileHandle,             // input profile handle
-        TYPE_Lab_DBL,                 // input buffer format
-        rgbProfileHandle,             // output profile handle
-        TYPE_RGB_DBL,                 // output buffer format
-        INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
-        0                             // flags
-    );
-    m_transformLabToRgb16Handle = cmsCreateTransform(
-        labProfileHandle,             // input profile handle
-        TYPE_Lab_DBL,                 // input buffer format
-        rgbProfileHandle,             // output profile handle
-        TYPE_RGB_16,                  // output buffer format
-        INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
-        0                             // flags
-    );
-    m_transformRgbToLabHandle = cmsCreateTransform(
-        rgbProfileHandle,             // input profile handle
-        TYPE_RGB_DBL,                 // input buffer format
-        labProfileHandle,             // output profile handle
-        TYPE_Lab_DBL,                 // output buffer format
-        INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
-        0                             // flags
+    try {
+        initialize(rgbProfileHandle);
+    } catch (...) {
+        cmsCloseProfile(rgbProfileHandle);
+        throw;
+    }
+    cmsCloseProfile(rgbProfileHandle);
+    // The build-in profile has no useful description.
+    m_description = tr("sRGB");
+}
+
+/** @brief Constructor for an ICC profile file
+ * 
+ * Creates a color space for an arbitrary RGB ICC profile, like Display P3,
+ * Adobe RGB or a monitor profile.
+ * 
+ * The file is memory-mapped and parsed directly from the mapping, so no
+ * intermediate copy of the whole file is necessary. The transforms are
+ * cached by profile ID (see profileId()): Opening a profile that has
+ * already been opened before (also by another RgbColorSpace object) does
+ * not create and optimize the LittleCMS pipelines again.
+ * 
+ * Throws an exception if the file cannot be read or if it does not
+ * contain a usable RGB profile.
+ * 
+ * @param profileFileName the ICC profile file
+ * @param parent the parent object */
+RgbColorSpace::RgbColorSpace(
+    const QString &profileFileName,
+    QObject *parent
+) : QObject(parent)
+{
+    QFile file(profileFileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Unable to open ICC profile" << profileFileName;
+        throw 0;
+    }
+    cmsHPROFILE rgbProfileHandle = nullptr;
+    // LittleCMS makes its own copy of the memory block, so the mapping
+    // can be released immediately afterwards.
+    uchar *mapping = file.map(0, file.size());
+    if (mapping != nullptr) {
+        rgbProfileHandle = cmsOpenProfileFromMem(
+            mapping,
+            static_cast<cmsUInt32Number>(file.size())
+        );
+        file.unmap(mapping);
+    } else {
+        // Some file systems do not support memory mapping.
+        const QByteArray data = file.readAll();
+        rgbProfileHandle = cmsOpenProfileFromMem(
+            data.constData(),
+            static_cast<cmsUInt32Number>(data.size())
+        );
+    }
+    file.close();
+    if (rgbProfileHandle == nullptr) {
+        qCritical() << "Unable to parse ICC profile" << profileFileName;
+        throw 0;
+    }
+    if (cmsGetColorSpace(rgbProfileHandle) != cmsSigRgbData) {
+        qCritical() << "Not an RGB ICC profile:" << profileFileName;
+        cmsCloseProfile(rgbProfileHandle);
+        throw 0;
+    }
+    try {
+        initialize(rgbProfileHandle);
+    } catch (...) {
+        cmsCloseProfile(rgbProfileHandle);
+        throw;
+    }
+    m_description = getInformationFromProfile(
+        rgbProfileHandle,
+        cmsInfoDescription
     );
-    // Close profile (free memory)
-    cmsCloseProfile(labProfileHandle);
     cmsCloseProfile(rgbProfileHandle);
+}
+
+/** @brief Initialization that is common to all constructors
+ * 
+ * Gets the transforms and searches blackpoint and whitepoint. Throws an
+ * exception on failure.
+ * 
+ * @param rgbProfileHandle the RGB profile. It is not closed by this
+ * function. */
+void RgbColorSpace::initialize(cmsHPROFILE rgbProfileHandle)
+{
+    m_instanceId = instanceCounter.fetchAndAddRelaxed(1) + 1;
+    m_profileId = getProfileId(rgbProfileHandle);
+    m_transforms = transformsForProfile(rgbProfileHandle, m_profileId);
+    initializeGrayAxis();
+    if (isSharedGamutTableEnabled()) {
+        initializeGamutTable();
+    }
+}
+
+/** @brief Searches blackpoint and whitepoint
+ * 
+ * Throws an exception on failure. */
+void RgbColorSpace::initializeGrayAxis()
+{
+    // The search for blackpoint and whitepoint needs many transforms. Its
+    // result is therefore stored on disk and reused at the next start.
+    const QString cacheName = QStringLiteral("rgbcolorspace-%1.cache")
+        .arg(QString::fromLatin1(m_profileId.toHex()));
+    const QByteArray key = cacheKey();
+    {
+        CacheFile cache(cacheName, key);
+        if (cache.isValid()
+            && (cache.payloadSize() == static_cast<qint64>(2 * sizeof(qreal)))
+        ) {
+            std::memcpy(&m_blackpointL, cache.payload(), sizeof(qreal));
+            std::memcpy(
+                &m_whitepointL,
+                cache.payload() + sizeof(qreal),
+                sizeof(qreal)
+            );
+            if (m_whitepointL > m_blackpointL) {
+                return;
+            }
+        }
+    }
 
     // Now we know for sure that lowerChroma is in-gamut and upperChroma is out-of-gamut…
     cmsCIELCh candidate;
@@ -93,14 +555,598 @@ RgbColorSpace::RgbColorSpace(QObject *parent) : QObject(parent)
         qCritical() << "Unable to find blackpoint and whitepoint on gray axis.";
         throw 0;
     }
+    QByteArray payload;
+    payload.append(reinterpret_cast<const char *>(&m_blackpointL), sizeof(qreal));
+    payload.append(reinterpret_cast<const char *>(&m_whitepointL), sizeof(qreal));
+    CacheFile::write(cacheName, key, payload);
+}
+
+/** @brief Key for the on-disk cache
+ * 
+ * Contains everything the cached data depends on: the profile ID, the
+ * LittleCMS version, Helper::gamutPrecision and the version of the
+ * algorithms of this class.
+ * 
+ * @sa CacheFile */
+QByteArray RgbColorSpace::cacheKey() const
+{
+    const quint32 lcmsVersion = static_cast<quint32>(cmsGetEncodedCMMversion());
+    const qreal precision = Helper::gamutPrecision;
+    QByteArray result = QByteArrayLiteral("RgbColorSpace");
+    result.append(
+        reinterpret_cast<const char *>(&cacheVersion),
+        sizeof(cacheVersion)
+    );
+    result.append(
+        reinterpret_cast<const char *>(&lcmsVersion),
+        sizeof(lcmsVersion)
+    );
+    result.append(
+        reinterpret_cast<const char *>(&precision),
+        sizeof(precision)
+    );
+    result.append(m_profileId);
+    return result;
+}
+
+/** @brief The MD5 profile ID of an ICC profile
+ * 
+ * Uses the ID stored in the profile header. Many profiles (including the
+ * build-in sRGB profile of LittleCMS) do not store an ID; for those, it is
+ * calculated following the ICC specification.
+ * 
+ * @param profileHandle the profile
+ * @returns the 16-byte profile ID */
+QByteArray RgbColorSpace::getProfileId(cmsHPROFILE profileHandle)
+{
+    cmsUInt8Number id[16];
+    cmsGetHeaderProfileID(profileHandle, id);
+    bool isZero = true;
+    for (cmsUInt8Number byte : id) {
+        isZero = isZero && (byte == 0);
+    }
+    if (isZero) {
+        // Writes the calculated ID to the header of the profile object.
+        cmsMD5computeID(profileHandle);
+        cmsGetHeaderProfileID(profileHandle, id);
+    }
+    return QByteArray(reinterpret_cast<const char *>(id), 16);
+}
+
+/** @brief The process-wide transform cache
+ * 
+ * Must only be accessed while transformCacheMutex is locked.
+ * 
+ * @returns the transforms, keyed by profile ID */
+QHash<QByteArray, QSharedPointer<const RgbColorSpace::Transforms>> &
+RgbColorSpace::transformCache()
+{
+    static QHash<QByteArray, QSharedPointer<const Transforms>> cache;
+    return cache;
+}
+
+/** @brief Clears the process-wide transform cache
+ * 
+ * Existing RgbColorSpace objects keep their transforms. New objects will
+ * create their transforms again (or load them from the device link cache,
+ * see setDeviceLinkCacheEnabled()). This is useful to free memory, and to
+ * measure the startup time. */
+void RgbColorSpace::clearTransformCache()
+{
+    QMutexLocker locker(&transformCacheMutex);
+    transformCache().clear();
+}
+
+/** @brief Number of cache hits of the process-wide transform cache
+ * 
+ * Counted since the start of the process. A hit means that an
+ * RgbColorSpace object got the transforms of an earlier object with the
+ * same profile, without creating and optimizing LittleCMS pipelines.
+ * 
+ * @returns the number of cache hits
+ * 
+ * @sa transformCacheMisses() */
+quint64 RgbColorSpace::transformCacheHits()
+{
+    QMutexLocker locker(&transformCacheMutex);
+    return transformCacheHitCount;
+}
+
+/** @brief Number of cache misses of the process-wide transform cache
+ * 
+ * Counted since the start of the process. Each miss creates (or loads
+ * from device links) new LittleCMS transforms.
+ * 
+ * @returns the number of cache misses
+ * 
+ * @sa transformCacheHits() */
+quint64 RgbColorSpace::transformCacheMisses()
+{
+    QMutexLocker locker(&transformCacheMutex);
+    return transformCacheMissCount;
+}
+
+/** @brief If optimized transforms are persisted as device links
+ * 
+ * @sa setDeviceLinkCacheEnabled() */
+bool RgbColorSpace::isDeviceLinkCacheEnabled()
+{
+    return (deviceLinkCacheEnabled.loadAcquire() != 0);
+}
+
+/** @brief Enables or disables the device link cache
+ * 
+ * If enabled, the optimized Lab→RGB and RGB→Lab pipelines are stored as
+ * ICC device link profiles (see CacheFile), and at later starts the
+ * transforms are built from these device links without optimizing the
+ * pipelines again.
+ * 
+ * A device link is only used if it reproduces the original transform
+ * (tested on a grid of sample values) within deviceLinkTolerance.
+ * Otherwise, an empty file is stored to remember that the profile is not
+ * suitable, and the transforms are always created from the profile.
+ * 
+ * Only pipelines that ICC can store as they are (curves, matrices and
+ * lookup tables, but no conversion between CIELab and CIEXYZ) survive
+ * this test. For matrix/shaper profiles like the build-in sRGB, LittleCMS
+ * resamples the pipeline into a 16-bit lookup table that is rejected, so
+ * these profiles never use device links. Use usesDeviceLinks() to find
+ * out if a given object does.
+ * 
+ * Disabled by default.
+ * 
+ * @param enabled the new value */
+void RgbColorSpace::setDeviceLinkCacheEnabled(bool enabled)
+{
+    deviceLinkCacheEnabled.storeRelease(enabled ? 1 : 0);
+}
+
+/** @brief The transforms for a given profile
+ * 
+ * Transforms are cached for the lifetime of the process, keyed by the
+ * profile ID. On a cache hit, no LittleCMS pipeline is created and
+ * optimized. This function is thread-safe. Throws an exception if the
+ * transforms cannot be created.
+ * 
+ * @param rgbProfileHandle the RGB profile
+ * @param profileId the ID of @em rgbProfileHandle as returned by
+ * getProfileId()
+ * @returns the (possibly shared) transforms */
+QSharedPointer<const RgbColorSpace::Transforms>
+RgbColorSpace::transformsForProfile(
+    cmsHPROFILE rgbProfileHandle,
+    const QByteArray &profileId
+)
+{
+    QMutexLocker locker(&transformCacheMutex);
+    QSharedPointer<const Transforms> result =
+        transformCache().value(profileId);
+    if (!result.isNull()) {
+        ++transformCacheHitCount;
+        return result;
+    }
+    ++transformCacheMissCount;
+
+    QSharedPointer<Transforms> transforms(new Transforms);
+    const bool useDeviceLinks = isDeviceLinkCacheEnabled();
+    const QString labToRgbName = deviceLinkCacheName(profileId, "labtorgb");
+    const QString rgbToLabName = deviceLinkCacheName(profileId, "rgbtolab");
+    bool labToRgbUsable = true;
+    bool rgbToLabUsable = true;
+    if (useDeviceLinks) {
+        cmsHPROFILE labToRgbLink = loadDeviceLink(
+            labToRgbName,
+            profileId,
+            &labToRgbUsable
+        );
+        if (labToRgbLink != nullptr) {
+            transforms->labToRgb = transformFromDeviceLink(
+                labToRgbLink,
+                TYPE_Lab_DBL,
+                TYPE_RGB_DBL
+            );
+            transforms->labToRgb16 = transformFromDeviceLink(
+                labToRgbLink,
+                TYPE_Lab_DBL,
+                TYPE_RGB_16
+            );
+            transforms->labToRgbFloat32 = transformFromDeviceLink(
+                labToRgbLink,
+                TYPE_Lab_FLT,
+                TYPE_RGB_FLT
+            );
+            cmsCloseProfile(labToRgbLink);
+        }
+        cmsHPROFILE rgbToLabLink = loadDeviceLink(
+            rgbToLabName,
+            profileId,
+            &rgbToLabUsable
+        );
+        if (rgbToLabLink != nullptr) {
+            transforms->rgbToLab = transformFromDeviceLink(
+                rgbToLabLink,
+                TYPE_RGB_DBL,
+                TYPE_Lab_DBL
+            );
+            cmsCloseProfile(rgbToLabLink);
+        }
+    }
+
+    transforms->fromDeviceLinks = (transforms->labToRgb != nullptr)
+        && (transforms->labToRgb16 != nullptr)
+        && (transforms->labToRgbFloat32 != nullptr)
+        && (transforms->rgbToLab != nullptr);
+
+    // Create an ICC v4 profile object for the Lab color space.
+    // NULL means: Default white point (D50) // TODO Does this make sense? sRGB white point is D65!
+    cmsHPROFILE labProfileHandle = cmsCreateLab4Profile(NULL);
+    // Create the transforms that could not be loaded from device links
+    if ((transforms->labToRgb == nullptr)
+        || (transforms->labToRgb16 == nullptr)
+        || (transforms->labToRgbFloat32 == nullptr)
+    ) {
+        if (transforms->labToRgb != nullptr) {
+            cmsDeleteTransform(transforms->labToRgb);
+        }
+        if (transforms->labToRgb16 != nullptr) {
+            cmsDeleteTransform(transforms->labToRgb16);
+        }
+        if (transforms->labToRgbFloat32 != nullptr) {
+            cmsDeleteTransform(transforms->labToRgbFloat32);
+        }
+        transforms->labToRgb = cmsCreateTransform(
+            labProfileHandle,             // input profile handle
+            TYPE_Lab_DBL,                 // input buffer format
+            rgbProfileHandle,             // output profile handle
+            TYPE_RGB_DBL,                 // output buffer format
+            INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
+            0                             // flags
+        );
+        transforms->labToRgb16 = cmsCreateTransform(
+            labProfileHandle,             // input profile handle
+            TYPE_Lab_DBL,                 // input buffer format
+            rgbProfileHandle,             // output profile handle
+            TYPE_RGB_16,                  // output buffer format
+            INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
+            0                             // flags
+        );
+        transforms->labToRgbFloat32 = cmsCreateTransform(
+            labProfileHandle,             // input profile handle
+            TYPE_Lab_FLT,                 // input buffer format
+            rgbProfileHandle,             // output profile handle
+            TYPE_RGB_FLT,                 // output buffer format
+            INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
+            0                             // flags
+        );
+        if (useDeviceLinks && labToRgbUsable) {
+            storeDeviceLink(
+                transforms->labToRgb,
+                TYPE_Lab_DBL,
+                TYPE_RGB_DBL,
+                labToRgbName,
+                profileId
+            );
+        }
+    }
+    if (transforms->rgbToLab == nullptr) {
+        transforms->rgbToLab = cmsCreateTransform(
+            rgbProfileHandle,             // input profile handle
+            TYPE_RGB_DBL,                 // input buffer format
+            labProfileHandle,             // output profile handle
+            TYPE_Lab_DBL,                 // output buffer format
+            INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
+            0                             // flags
+        );
+        if (useDeviceLinks && rgbToLabUsable) {
+            storeDeviceLink(
+                transforms->rgbToLab,
+                TYPE_RGB_DBL,
+                TYPE_Lab_DBL,
+                rgbToLabName,
+                profileId
+            );
+        }
+    }
+    // Close profile (free memory)
+    cmsCloseProfile(labProfileHandle);
+    if ((transforms->labToRgb == nullptr)
+        || (transforms->labToRgb16 == nullptr)
+        || (transforms->labToRgbFloat32 == nullptr)
+        || (transforms->rgbToLab == nullptr)
+    ) {
+        qCritical() << "Unable to create LittleCMS transforms.";
+        throw 0;
+    }
+
+    transformCache().insert(profileId, transforms);
+    return transforms;
 }
 
 /** @brief Destructor */
 RgbColorSpace::~RgbColorSpace()
 {
-    cmsDeleteTransform(m_transformLabToRgb16Handle);
-    cmsDeleteTransform(m_transformLabToRgbHandle);
-    cmsDeleteTransform(m_transformRgbToLabHandle);
+    // The background build of gamutVolume() uses this object.
+    m_gamutVolumeBuild.waitForFinished();
+    // Detaching from the last process destroys the shared memory segment.
+    delete m_sharedMemory;
+}
+
+/** @brief If the transforms of this object have been created from cached
+ * device links
+ * 
+ * @returns @c true if all LittleCMS transforms of this object have been
+ * loaded from the device link cache. @c false if the device link cache
+ * was disabled, if it did not contain the device links yet, or if the
+ * profile is not suitable for device links.
+ * 
+ * @sa setDeviceLinkCacheEnabled() */
+bool RgbColorSpace::usesDeviceLinks() const
+{
+    return m_transforms->fromDeviceLinks;
+}
+
+/** @brief If the gamut table is published in shared memory
+ * 
+ * @sa setSharedGamutTableEnabled() */
+bool RgbColorSpace::isSharedGamutTableEnabled()
+{
+    return (sharedGamutTableEnabled.loadAcquire() != 0);
+}
+
+/** @brief Enables or disables the shared gamut table
+ * 
+ * The gamut table contains the maximum chroma for each integer lightness
+ * and hue. boundaryChroma() uses it to start its search with a narrow
+ * bracket, which saves transforms. Computing the table is expensive, so
+ * RgbColorSpace objects created while this option is enabled publish it
+ * in a named shared memory segment (QSharedMemory), and all processes
+ * that use the same profile attach to this segment without copying it
+ * instead of computing the table again. This is useful when many worker
+ * processes use the same color space. The process that creates the
+ * segment reads the table from a CacheFile, so it is computed only once
+ * for each profile and not again at each start.
+ * 
+ * Disabled by default.
+ * 
+ * @param enabled the new value
+ * 
+ * @sa isGamutTableShared() */
+void RgbColorSpace::setSharedGamutTableEnabled(bool enabled)
+{
+    sharedGamutTableEnabled.storeRelease(enabled ? 1 : 0);
+}
+
+/** @brief If this object uses a gamut table in shared memory
+ * 
+ * @returns @c true if the gamut table of this object is in shared memory.
+ * @c false if the shared gamut table is disabled, or if shared memory is
+ * not available on this system (then the table is held in the local
+ * memory of the process). */
+bool RgbColorSpace::isGamutTableShared() const
+{
+    return (m_sharedMemory != nullptr);
+}
+
+/** @brief Computes the gamut table
+ * 
+ * The work is done in parallel. This function blocks until it is finished.
+ * 
+ * @param table pointer to gamutTableSize values that will be written */
+void RgbColorSpace::computeGamutTable(float *table) const
+{
+    QVector<int> rows;
+    for (int row = 0; row < gamutTableLightnessCount; ++row) {
+        rows.append(row);
+    }
+    QtConcurrent::blockingMap(
+        rows,
+        [this, table](const int &row) {
+            cmsCIELCh lch;
+            lch.L = row;
+            lch.C = Helper::LchBoundaries::physicalMaximumChroma;
+            for (int hue = 0; hue < gamutTableHueCount; ++hue) {
+                lch.h = hue;
+                table[row * gamutTableHueCount + hue] =
+                    static_cast<float>(boundaryChroma(lch));
+            }
+        }
+    );
+}
+
+/** @brief Reads the gamut table from the CacheFile, or computes it
+ * 
+ * If the CacheFile does not contain a valid table for cacheKey(), the
+ * table is computed with computeGamutTable() and stored in the CacheFile
+ * for the next start.
+ * 
+ * @param table pointer to gamutTableSize values that will be written */
+void RgbColorSpace::loadGamutTable(float *table) const
+{
+    const QString cacheName =
+        QStringLiteral("rgbcolorspace-%1-gamuttable.cache")
+            .arg(QString::fromLatin1(m_profileId.toHex()));
+    const QByteArray key = cacheKey();
+    const qint64 byteCount =
+        static_cast<qint64>(gamutTableSize * sizeof(float));
+    {
+        CacheFile cache(cacheName, key);
+        if (cache.isValid() && (cache.payloadSize() == byteCount)) {
+            std::memcpy(
+                table,
+                cache.payload(),
+                static_cast<size_t>(byteCount)
+            );
+            return;
+        }
+    }
+    computeGamutTable(table);
+    CacheFile::write(
+        cacheName,
+        key,
+        QByteArray(
+            reinterpret_cast<const char *>(table),
+            static_cast<int>(byteCount)
+        )
+    );
+}
+
+/** @brief Gets the gamut table
+ * 
+ * Attaches to the shared memory segment for cacheKey(), or creates it.
+ * If the segment is new, the table is read with loadGamutTable() and
+ * written to the segment. An existing segment is never written. If shared
+ * memory is not available, or if the segment does not contain a complete and valid
+ * table for cacheKey() (for example because its producer has crashed),
+ * the table is read with loadGamutTable() into local memory.
+ * 
+ * @sa setSharedGamutTableEnabled() */
+void RgbColorSpace::initializeGamutTable()
+{
+    const QByteArray key = cacheKey();
+    const int size = static_cast<int>(
+        sizeof(SharedGamutTableHeader) + gamutTableSize * sizeof(float)
+    );
+    if (key.size() <= gamutTableKeyCapacity) {
+        // The name depends on the whole key, so that processes with
+        // different keys (for example with different LittleCMS versions)
+        // never use the same segment.
+        QSharedMemory *memory = new QSharedMemory(
+            QStringLiteral("perceptualcolor-gamuttable-%1-%2").arg(
+                gamutTableVersion
+            ).arg(
+                QString::fromLatin1(
+                    QCryptographicHash::hash(key, QCryptographicHash::Md5)
+                        .toHex()
+                )
+            )
+        );
+        // A new segment is filled with zeros, so it is not “ready”.
+        const bool isCreated = memory->create(size);
+        const bool isAvailable = isCreated
+            || ((memory->error() == QSharedMemory::AlreadyExists)
+                && memory->attach());
+        if (isAvailable && (memory->size() >= size) && memory->lock()) {
+            SharedGamutTableHeader *header =
+                static_cast<SharedGamutTableHeader *>(memory->data());
+            float *table = reinterpret_cast<float *>(header + 1);
+            if (isCreated) {
+                // Nobody else reads or writes a new segment yet.
+                loadGamutTable(table);
+                header->magic = gamutTableMagic;
+                header->version = gamutTableVersion;
+                header->keySize = static_cast<quint32>(key.size());
+                std::memcpy(
+                    header->key,
+                    key.constData(),
+                    static_cast<size_t>(key.size())
+                );
+                header->checksum = gamutTableChecksum(table);
+                header->ready = 1;
+            }
+            // Other processes might read a ready table without locking,
+            // so it is never written again. If it is not ready (the
+            // producer has crashed) or does not match (hash collision or
+            // corruption), this object uses local memory.
+            const bool isValid = (header->ready == 1)
+                && (header->magic == gamutTableMagic)
+                && (header->version == gamutTableVersion)
+                && (header->keySize == static_cast<quint32>(key.size()))
+                && (std::memcmp(
+                        header->key,
+                        key.constData(),
+                        static_cast<size_t>(key.size())
+                    ) == 0)
+                && (header->checksum == gamutTableChecksum(table));
+            memory->unlock();
+            if (isValid) {
+                m_sharedMemory = memory;
+                m_gamutTable = table;
+                return;
+            }
+        }
+        delete memory;
+    }
+
+    // Fallback without shared memory
+    m_localGamutTable.resize(gamutTableSize);
+    loadGamutTable(m_localGamutTable.data());
+    m_gamutTable = m_localGamutTable.constData();
+}
+
+/** @brief Estimate of the maximum chroma from the gamut table
+ * 
+ * Bilinear interpolation of the gamut table.
+ * 
+ * @param lightness the lightness
+ * @param hue the hue
+ * @returns the estimated maximum chroma, or @c -1 if there is no gamut
+ * table or if the neighbourhood of the value contains gray-axis points
+ * that are out of gamut. */
+cmsFloat64Number RgbColorSpace::gamutTableChroma(
+    const cmsFloat64Number lightness,
+    const cmsFloat64Number hue
+) const
+{
+    if (m_gamutTable == nullptr) {
+        return -1;
+    }
+    const cmsFloat64Number row =
+        qBound<cmsFloat64Number>(0, lightness, gamutTableLightnessCount - 1);
+    const cmsFloat64Number column = hue - 360 * qFloor(hue / 360);
+    const int row0 = qMin(qFloor(row), gamutTableLightnessCount - 2);
+    const int column0 = qMin(qFloor(column), gamutTableHueCount - 1);
+    const int column1 = (column0 + 1) % gamutTableHueCount;
+    const cmsFloat64Number rowFraction = row - row0;
+    const cmsFloat64Number columnFraction = column - column0;
+    const float *first = m_gamutTable + row0 * gamutTableHueCount;
+    const float *second = first + gamutTableHueCount;
+    if ((first[column0] < 0) || (first[column1] < 0)
+        || (second[column0] < 0) || (second[column1] < 0)
+    ) {
+        return -1;
+    }
+    const cmsFloat64Number upper = first[column0]
+        + (first[column1] - first[column0]) * columnFraction;
+    const cmsFloat64Number lower = second[column0]
+        + (second[column1] - second[column0]) * columnFraction;
+    return upper + (lower - upper) * rowFraction;
+}
+
+/** @brief The MD5 profile ID of the ICC profile
+ * 
+ * Two RgbColorSpace objects with the same profile ID share their
+ * LittleCMS transforms.
+ * 
+ * @returns the 16-byte profile ID as defined by the ICC specification */
+QByteArray RgbColorSpace::profileId() const
+{
+    return m_profileId;
+}
+
+/** @brief The gamut volume of this color space, if it is ready
+ * 
+ * The first call starts to build GamutVolume::forColorSpace() with the
+ * default resolution in the background, on QThreadPool::globalInstance().
+ * The build starts again if CacheManager has released the volume
+ * meanwhile. This function never waits for the build, so it can be called
+ * while painting. It is thread-safe.
+ * 
+ * The destructor of this object waits until a running build has finished.
+ * 
+ * @returns the volume, or a null pointer while it is not ready */
+QSharedPointer<const GamutVolume> RgbColorSpace::gamutVolume() const
+{
+    const QSharedPointer<const GamutVolume> result =
+        GamutVolume::cachedForColorSpace(this);
+    if (result.isNull()) {
+        QMutexLocker locker(&m_gamutVolumeMutex);
+        if (m_gamutVolumeBuild.isFinished()) {
+            m_gamutVolumeBuild = QtConcurrent::run([this]() {
+                GamutVolume::forColorSpace(this);
+            });
+        }
+    }
+    return result;
 }
 
 /** @brief The darkest in-gamut point on the L* axis.
@@ -143,10 +1189,33 @@ cmsCIELab RgbColorSpace::colorLab(const QColor &rgbColor) const
 cmsCIELab RgbColorSpace::colorLab(const Helper::cmsRGB &rgb) const
 {
     cmsCIELab lab;
-    cmsDoTransform(m_transformRgbToLabHandle, &rgb, &lab, 1); // convert exactly 1 value
+    cmsDoTransform(m_transforms->rgbToLab, &rgb, &lab, 1); // convert exactly 1 value
     return lab;
 }
 
+/** @brief Calculates the Lab values of many colors at once
+ * 
+ * This is the batch version of colorLab(const Helper::cmsRGB &rgb). It
+ * does a single LittleCMS transform call for all colors, which is much
+ * faster than converting the colors one by one. This function is
+ * thread-safe.
+ * 
+ * @param rgb pointer to the first of @em count RGB values (range 0..1)
+ * @param Lab pointer to the first of @em count Lab values that will be
+ * written
+ * @param count the number of colors */
+void RgbColorSpace::colorLab(
+    const Helper::cmsRGB *rgb,
+    cmsCIELab *Lab,
+    const int count
+) const
+{
+    if (count <= 0) {
+        return;
+    }
+    cmsDoTransform(m_transforms->rgbToLab, rgb, Lab, count);
+}
+
 /** @brief Calculates the RGB value
  * 
  * @param Lab a L*a*b* color
@@ -157,7 +1226,7 @@ QColor RgbColorSpace::colorRgb(const cmsCIELab &Lab) const
 {
     QColor temp; // By default, without initialization this is an invalid color
     Helper::cmsRGB rgb;
-    cmsDoTransform(m_transformLabToRgbHandle, &Lab, &rgb, 1); // convert exactly 1 value
+    cmsDoTransform(m_transforms->labToRgb, &Lab, &rgb, 1); // convert exactly 1 value
     if (Helper::inRange<cmsFloat64Number>(0, rgb.red, 1) &&
         Helper::inRange<cmsFloat64Number>(0, rgb.green, 1) &&
         Helper::inRange<cmsFloat64Number>(0, rgb.blue, 1)) {
@@ -181,10 +1250,33 @@ QColor RgbColorSpace::colorRgb(const cmsCIELCh &LCh) const
     return colorRgb(Lab);
 }
 
+/** @brief Calculates the RGB values of many colors at once, without
+ * forcing them into the gamut
+ * 
+ * This function does a single LittleCMS transform call for all colors.
+ * It is thread-safe.
+ * 
+ * @param Lab pointer to the first of @em count Lab values
+ * @param rgb pointer to the first of @em count RGB values that will be
+ * written. Values outside the range 0..1 mean that the color is
+ * out-of-gamut.
+ * @param count the number of colors */
+void RgbColorSpace::colorRgbUnbounded(
+    const cmsCIELab *Lab,
+    Helper::cmsRGB *rgb,
+    const int count
+) const
+{
+    if (count <= 0) {
+        return;
+    }
+    cmsDoTransform(m_transforms->labToRgb, Lab, rgb, count);
+}
+
 Helper::cmsRGB RgbColorSpace::colorRgbBoundSimple(const cmsCIELab &Lab) const
 {
     cmsUInt16Number rgb_int[3];
-    cmsDoTransform(m_transformLabToRgb16Handle, &Lab, rgb_int, 1); // convert exactly 1 value
+    cmsDoTransform(m_transforms->labToRgb16, &Lab, rgb_int, 1); // convert exactly 1 value
     Helper::cmsRGB temp;
     temp.red = rgb_int[0] / static_cast<qreal>(65535);
     temp.green = rgb_int[1] / static_cast<qreal>(65535);
@@ -192,6 +1284,297 @@ Helper::cmsRGB RgbColorSpace::colorRgbBoundSimple(const cmsCIELab &Lab) const
     return temp;
 }
 
+/** @brief Calculates the RGB values of many colors at once
+ * 
+ * This is the batch version of colorRgbBoundSimple(const cmsCIELab &Lab)
+ * and gives identical results. The LittleCMS transform is called once
+ * per chunk of colors instead of once per color. This function is
+ * thread-safe and does not allocate memory on the heap.
+ * 
+ * @param Lab pointer to the first of @em count Lab values
+ * @param rgb pointer to the first of @em count RGB values that will be
+ * written
+ * @param count the number of colors */
+void RgbColorSpace::colorRgbBoundSimple(
+    const cmsCIELab *Lab,
+    Helper::cmsRGB *rgb,
+    const int count
+) const
+{
+    constexpr int chunkSize = 256;
+    cmsUInt16Number rgb_int[3 * chunkSize];
+    int chunkCount;
+    for (int start = 0; start < count; start += chunkSize) {
+        chunkCount = qMin(chunkSize, count - start);
+        cmsDoTransform(
+            m_transforms->labToRgb16,
+            Lab + start,
+            rgb_int,
+            chunkCount
+        );
+        for (int i = 0; i < chunkCount; ++i) {
+            rgb[start + i].red = rgb_int[3 * i] / static_cast<qreal>(65535);
+            rgb[start + i].green = rgb_int[3 * i + 1] / static_cast<qreal>(65535);
+            rgb[start + i].blue = rgb_int[3 * i + 2] / static_cast<qreal>(65535);
+        }
+    }
+}
+
+/** @brief Calculates the RGB values of many colors at once, without
+ * forcing them into the gamut, in single precision
+ * 
+ * This is the TransformPrecision::float32 version of
+ * colorRgbUnbounded(const cmsCIELab *, Helper::cmsRGB *, const int) const.
+ * It is thread-safe.
+ * 
+ * @param Lab pointer to the first of @em count Lab values
+ * @param rgb pointer to the first of @em count RGB values that will be
+ * written. Values outside the range 0..1 mean that the color is
+ * out-of-gamut.
+ * @param count the number of colors */
+void RgbColorSpace::colorRgbUnbounded(
+    const Helper::cmsLabFloat32 *Lab,
+    Helper::cmsRGBFloat32 *rgb,
+    const int count
+) const
+{
+    if (count <= 0) {
+        return;
+    }
+    cmsDoTransform(m_transforms->labToRgbFloat32, Lab, rgb, count);
+}
+
+/** @brief Renders a scan line
+ * 
+ * Converts many colors at once into pixels, like colorRgb() does for a
+ * single color, but much faster. This function is thread-safe.
+ * 
+ * @param Lab pointer to the first of @em count Lab values
+ * @param pixels pointer to the first of @em count pixels that will be
+ * written (QImage::Format_ARGB32). In-gamut colors become opaque pixels,
+ * out-of-gamut colors become transparent pixels.
+ * @param count the number of colors
+ * @param precision the precision of the transform
+ * @param outOfGamutMask If not a null pointer, pointer to the first of
+ * @em count mask values that will be written: @c 1 for out-of-gamut
+ * colors, @c 0 for in-gamut colors. */
+void RgbColorSpace::colorRgbScanLine(
+    const cmsCIELab *Lab,
+    QRgb *pixels,
+    const int count,
+    const TransformPrecision precision,
+    quint8 *outOfGamutMask
+) const
+{
+    constexpr int chunkSize = 256;
+    QVector<Helper::cmsLabFloat32> labFloat32(chunkSize);
+    QVector<Helper::cmsRGBFloat32> rgbFloat32(chunkSize);
+    QVector<Helper::cmsRGB> rgb(chunkSize);
+    cmsFloat64Number red;
+    cmsFloat64Number green;
+    cmsFloat64Number blue;
+    bool outOfGamut;
+    int chunkCount;
+    for (int start = 0; start < count; start += chunkSize) {
+        chunkCount = qMin(chunkSize, count - start);
+        if (precision == TransformPrecision::float32) {
+            for (int i = 0; i < chunkCount; ++i) {
+                labFloat32[i].L = static_cast<cmsFloat32Number>(Lab[start + i].L);
+                labFloat32[i].a = static_cast<cmsFloat32Number>(Lab[start + i].a);
+                labFloat32[i].b = static_cast<cmsFloat32Number>(Lab[start + i].b);
+            }
+            colorRgbUnbounded(labFloat32.constData(), rgbFloat32.data(), chunkCount);
+        } else {
+            colorRgbUnbounded(Lab + start, rgb.data(), chunkCount);
+        }
+        for (int i = 0; i < chunkCount; ++i) {
+            if (precision == TransformPrecision::float32) {
+                red = rgbFloat32.at(i).red;
+                green = rgbFloat32.at(i).green;
+                blue = rgbFloat32.at(i).blue;
+            } else {
+                red = rgb.at(i).red;
+                green = rgb.at(i).green;
+                blue = rgb.at(i).blue;
+            }
+            outOfGamut = !(
+                Helper::inRange<cmsFloat64Number>(0, red, 1) &&
+                Helper::inRange<cmsFloat64Number>(0, green, 1) &&
+                Helper::inRange<cmsFloat64Number>(0, blue, 1)
+            );
+            if (outOfGamutMask != nullptr) {
+                outOfGamutMask[start + i] = outOfGamut ? 1 : 0;
+            }
+            if (outOfGamut) {
+                pixels[start + i] = qRgba(0, 0, 0, 0);
+            } else {
+                pixels[start + i] = qRgb(
+                    qRound(red * 255),
+                    qRound(green * 255),
+                    qRound(blue * 255)
+                );
+            }
+        }
+    }
+}
+
+/** @brief Renders a scan line of equidistant colors
+ * 
+ * Like the other overload, but the Lab values are not read from memory.
+ * Instead, they are generated incrementally: The first color is
+ * @em first, and each following color is the previous color plus
+ * @em step. This fits scan lines of diagrams that are linear in Lab.
+ * 
+ * @param first the first Lab value
+ * @param step the difference between two neighbour Lab values
+ * @param pixels pointer to the first of @em count pixels that will be
+ * written (QImage::Format_ARGB32)
+ * @param count the number of colors
+ * @param precision the precision of the transform
+ * @param outOfGamutMask If not a null pointer, pointer to the first of
+ * @em count mask values that will be written */
+void RgbColorSpace::colorRgbScanLine(
+    const cmsCIELab &first,
+    const cmsCIELab &step,
+    QRgb *pixels,
+    const int count,
+    const TransformPrecision precision,
+    quint8 *outOfGamutMask
+) const
+{
+    constexpr int chunkSize = 256;
+    QVector<cmsCIELab> Lab(chunkSize);
+    cmsCIELab current = first;
+    int chunkCount;
+    for (int start = 0; start < count; start += chunkSize) {
+        chunkCount = qMin(chunkSize, count - start);
+        for (int i = 0; i < chunkCount; ++i) {
+            Lab[i] = current;
+            current.L += step.L;
+            current.a += step.a;
+            current.b += step.b;
+        }
+        colorRgbScanLine(
+            Lab.constData(),
+            pixels + start,
+            chunkCount,
+            precision,
+            (outOfGamutMask == nullptr) ? nullptr : outOfGamutMask + start
+        );
+    }
+}
+
+/** @brief Anti-aliases the gamut boundary of a rendered image
+ * 
+ * Pixels whose out-of-gamut mask value differs from the value of one of
+ * their four neighbours are on the gamut boundary. Only these pixels are
+ * supersampled, with antialiasingSamples × antialiasingSamples samples
+ * that are transformed in a single call. The pixel gets the mean color of
+ * the in-gamut samples, and the part of in-gamut samples as alpha. All
+ * other pixels are not touched.
+ * 
+ * @param image the image (QImage::Format_ARGB32)
+ * @param outOfGamutMask One value for each pixel of the image, row by row:
+ * @c 0 for in-gamut pixels, @c 1 for out-of-gamut pixels. Any other value
+ * marks pixels that do not belong to the diagram; they are ignored.
+ * @param pixelToLab Function that returns the Lab value at a given
+ * position in pixel coordinates. The position <tt>(x, y)</tt> must
+ * correspond to the color of pixel <tt>(x, y)</tt>.
+ * @param precision the precision of the transform */
+void RgbColorSpace::antialiasGamutBoundary(
+    QImage *image,
+    const QVector<quint8> &outOfGamutMask,
+    const std::function<cmsCIELab(const qreal x, const qreal y)> &pixelToLab,
+    const TransformPrecision precision
+) const
+{
+    const int width = image->width();
+    const int height = image->height();
+    if (outOfGamutMask.count() != width * height) {
+        return;
+    }
+    auto isBoundary = [&outOfGamutMask](const int index, const int neighbour) {
+        const quint8 value = outOfGamutMask.at(neighbour);
+        return (value <= 1) && (value != outOfGamutMask.at(index));
+    };
+    QVector<QPoint> boundaryPixels;
+    int index;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            index = y * width + x;
+            if (outOfGamutMask.at(index) > 1) {
+                continue;
+            }
+            if (((x > 0) && isBoundary(index, index - 1)) ||
+                ((x < width - 1) && isBoundary(index, index + 1)) ||
+                ((y > 0) && isBoundary(index, index - width)) ||
+                ((y < height - 1) && isBoundary(index, index + width))) {
+                boundaryPixels.append(QPoint(x, y));
+            }
+        }
+    }
+    if (boundaryPixels.isEmpty()) {
+        return;
+    }
+
+    constexpr int samplesPerPixel = antialiasingSamples * antialiasingSamples;
+    QVector<cmsCIELab> Lab;
+    Lab.reserve(boundaryPixels.count() * samplesPerPixel);
+    for (const QPoint &pixel : boundaryPixels) {
+        for (int sampleY = 0; sampleY < antialiasingSamples; ++sampleY) {
+            for (int sampleX = 0; sampleX < antialiasingSamples; ++sampleX) {
+                Lab.append(pixelToLab(
+                    pixel.x() + (sampleX + 0.5) / antialiasingSamples - 0.5,
+                    pixel.y() + (sampleY + 0.5) / antialiasingSamples - 0.5
+                ));
+            }
+        }
+    }
+    QVector<QRgb> samples(Lab.count());
+    QVector<quint8> samplesMask(Lab.count());
+    colorRgbScanLine(
+        Lab.constData(),
+        samples.data(),
+        Lab.count(),
+        precision,
+        samplesMask.data()
+    );
+
+    int red;
+    int green;
+    int blue;
+    int inGamutCount;
+    QRgb sample;
+    for (int i = 0; i < boundaryPixels.count(); ++i) {
+        red = 0;
+        green = 0;
+        blue = 0;
+        inGamutCount = 0;
+        for (int j = i * samplesPerPixel; j < (i + 1) * samplesPerPixel; ++j) {
+            if (samplesMask.at(j) == 0) {
+                sample = samples.at(j);
+                red += qRed(sample);
+                green += qGreen(sample);
+                blue += qBlue(sample);
+                ++inGamutCount;
+            }
+        }
+        QRgb *pixel = reinterpret_cast<QRgb *>(
+            image->scanLine(boundaryPixels.at(i).y())
+        ) + boundaryPixels.at(i).x();
+        if (inGamutCount == 0) {
+            *pixel = qRgba(0, 0, 0, 0);
+        } else {
+            *pixel = qRgba(
+                qRound(static_cast<qreal>(red) / inGamutCount),
+                qRound(static_cast<qreal>(green) / inGamutCount),
+                qRound(static_cast<qreal>(blue) / inGamutCount),
+                qRound(static_cast<qreal>(255) * inGamutCount / samplesPerPixel)
+            );
+        }
+    }
+}
+
 /** @brief Calculates the RGB value
  * 
  * @param Lab a L*a*b* color
@@ -254,7 +1637,7 @@ bool RgbColorSpace::inGamut(const cmsCIELCh &LCh)
 
     // code
     cmsLCh2Lab(&Lab, &LCh); // TODO no normalization necessary previously?
-    cmsDoTransform(m_transformLabToRgbHandle, &Lab, &rgb, 1); // convert exactly 1 value
+    cmsDoTransform(m_transforms->labToRgb, &Lab, &rgb, 1); // convert exactly 1 value
 
     return (
         Helper::inRange<cmsFloat64Number>(0, rgb.red, 1) &&
@@ -263,6 +1646,259 @@ bool RgbColorSpace::inGamut(const cmsCIELCh &LCh)
     );
 }
 
+/** @brief Looks up a conversion in the conversion cache
+ * 
+ * During interactive use (for example mouse dragging), the same or nearly
+ * the same LCh values are converted again and again. The conversion cache
+ * remembers the most recent conversions (including the expensive gamut
+ * mapping), so they do not need to be calculated again.
+ * 
+ * The cache is thread-local, so this function is thread-safe and lock-free.
+ * 
+ * @param lch the requested (normalized) LCh value
+ * @param sacrifyChroma if gamut mapping has been requested
+ * @param result pointer to an object that receives the result
+ * @returns @c true if a cached conversion was found and written to
+ * @em result. @c false otherwise. In this case, @em result is not changed.
+ * If the cached conversion did not modify the LCh value, the LCh value of
+ * the result is exactly @em lch (and not the value that was originally used
+ * to create the cache entry, which might differ by less than
+ * conversionCacheQuantum).
+ * 
+ * @sa storeConversion()
+ * @sa conversionCacheHits()
+ * @sa conversionCacheMisses() */
+bool RgbColorSpace::lookupConversion(
+    const cmsCIELCh &lch,
+    const bool sacrifyChroma,
+    LchConversion *result
+) const
+{
+    const qint64 lightness = quantizeForConversionCache(lch.L);
+    const qint64 chroma = quantizeForConversionCache(lch.C);
+    const qint64 hue = quantizeForConversionCache(lch.h);
+    const ConversionCacheEntry &entry = conversionCache[
+        conversionCacheIndex(lightness, chroma, hue, sacrifyChroma)
+    ];
+    if (
+        (entry.instanceId == m_instanceId) &&
+        (entry.lightness == lightness) &&
+        (entry.chroma == chroma) &&
+        (entry.hue == hue) &&
+        (entry.sacrifyChroma == sacrifyChroma)
+    ) {
+        m_conversionCacheHits.fetchAndAddRelaxed(1);
+        *result = entry.conversion;
+        if (!entry.modified) {
+            result->lch = lch;
+        }
+        return true;
+    }
+    m_conversionCacheMisses.fetchAndAddRelaxed(1);
+    return false;
+}
+
+/** @brief Stores a conversion in the conversion cache
+ * 
+ * @param lch the requested (normalized) LCh value
+ * @param sacrifyChroma if gamut mapping has been requested
+ * @param conversion the result of the conversion
+ * 
+ * @sa lookupConversion() */
+void RgbColorSpace::storeConversion(
+    const cmsCIELCh &lch,
+    const bool sacrifyChroma,
+    const LchConversion &conversion
+) const
+{
+    const qint64 lightness = quantizeForConversionCache(lch.L);
+    const qint64 chroma = quantizeForConversionCache(lch.C);
+    const qint64 hue = quantizeForConversionCache(lch.h);
+    ConversionCacheEntry &entry = conversionCache[
+        conversionCacheIndex(lightness, chroma, hue, sacrifyChroma)
+    ];
+    entry.instanceId = m_instanceId;
+    entry.lightness = lightness;
+    entry.chroma = chroma;
+    entry.hue = hue;
+    entry.sacrifyChroma = sacrifyChroma;
+    entry.modified = (
+        (conversion.lch.L != lch.L) ||
+        (conversion.lch.C != lch.C) ||
+        (conversion.lch.h != lch.h)
+    );
+    entry.conversion = conversion;
+}
+
+/** @brief Number of cache hits of lookupConversion()
+ * 
+ * Counted over all threads since construction or since the last call
+ * of resetConversionCacheStatistics(). Useful for tuning.
+ * @returns the number of cache hits */
+quint64 RgbColorSpace::conversionCacheHits() const
+{
+    return m_conversionCacheHits.loadAcquire();
+}
+
+/** @brief Number of cache misses of lookupConversion()
+ * 
+ * @returns the number of cache misses
+ * @sa conversionCacheHits() */
+quint64 RgbColorSpace::conversionCacheMisses() const
+{
+    return m_conversionCacheMisses.loadAcquire();
+}
+
+/** @brief Resets conversionCacheHits() and conversionCacheMisses() to 0. */
+void RgbColorSpace::resetConversionCacheStatistics()
+{
+    m_conversionCacheHits.storeRelease(0);
+    m_conversionCacheMisses.storeRelease(0);
+}
+
+/** @brief Signed distance to the gamut boundary in RGB
+ * 
+ * @param LCh the color to test
+ * @returns How far the unbounded RGB value of @em LCh is outside the
+ * range <tt>0..1</tt>, measured on the worst channel. A value > 0 means
+ * out-of-gamut. A value ≤ 0 means in-gamut; the absolute value is then
+ * the margin to the nearest channel limit. This is a continuous function
+ * of the LCh value, which makes it suitable for root finding.
+ * 
+ * @sa inGamut() */
+cmsFloat64Number RgbColorSpace::gamutDistance(const cmsCIELCh &LCh) const
+{
+    cmsCIELab Lab; // uses cmsFloat64Number internally
+    Helper::cmsRGB rgb;
+    cmsLCh2Lab(&Lab, &LCh);
+    cmsDoTransform(m_transforms->labToRgb, &Lab, &rgb, 1); // convert exactly 1 value
+    return qMax(
+        qMax(qMax(rgb.red - 1, -rgb.red), qMax(rgb.green - 1, -rgb.green)),
+        qMax(rgb.blue - 1, -rgb.blue)
+    );
+}
+
+/** @brief Searches the highest in-gamut chroma
+ * 
+ * @param LCh the color. Lightness and hue are preserved.
+ * @param algorithm the search algorithm. Both algorithms have the same
+ * precision guarantee; the default one needs less transforms.
+ * @param transformCount If not a @c nullptr, the number of LittleCMS
+ * transforms that have been done is written here. (For benchmarks.)
+ * @returns
+ * - @em LCh.C if @em LCh is in-gamut.
+ * - @c -1 if even chroma @c 0 is out-of-gamut at this lightness and hue.
+ * - Otherwise an in-gamut chroma value between @c 0 and @em LCh.C that is
+ *   less than Helper::gamutPrecision away from the gamut boundary. (Like
+ *   all gamut boundary search in this library, this assumes that the gamut
+ *   is continuous between chroma @c 0 and the boundary.) */
+cmsFloat64Number RgbColorSpace::boundaryChroma(
+    const cmsCIELCh &LCh,
+    const BoundarySearch algorithm,
+    int *transformCount
+) const
+{
+    int count = 0;
+    cmsCIELCh candidate = LCh;
+
+    // Bracket: lower is in-gamut (distance ≤ 0), upper is out-of-gamut
+    // (distance > 0).
+    cmsFloat64Number upper = LCh.C;
+    cmsFloat64Number upperDistance = gamutDistance(candidate);
+    ++count;
+    cmsFloat64Number lower = 0;
+    cmsFloat64Number lowerDistance = 0;
+    cmsFloat64Number result = upper;
+    cmsFloat64Number candidateDistance;
+    if (upperDistance <= 0) {
+        lower = upper; // Yet in-gamut. Skip the search.
+    } else {
+        candidate.C = lower;
+        lowerDistance = gamutDistance(candidate);
+        ++count;
+        if (lowerDistance > 0) {
+            result = -1;
+            upper = lower; // Skip the search
+        }
+    }
+
+    // Narrow the bracket with the estimate of the gamut table. Both probes
+    // are tested, so the bracket stays valid even if the estimate is bad.
+    const cmsFloat64Number estimate = (upper - lower > 2 * gamutTableMargin)
+        ? gamutTableChroma(LCh.L, LCh.h)
+        : -1;
+    if (estimate >= 0) {
+        for (const cmsFloat64Number probe :
+            {estimate - gamutTableMargin, estimate + gamutTableMargin}
+        ) {
+            if ((probe > lower) && (probe < upper)) {
+                candidate.C = probe;
+                candidateDistance = gamutDistance(candidate);
+                ++count;
+                if (candidateDistance > 0) {
+                    upper = probe;
+                    upperDistance = candidateDistance;
+                } else {
+                    lower = probe;
+                    lowerDistance = candidateDistance;
+                    result = lower;
+                }
+            }
+        }
+    }
+
+    // Number of consecutive iterations where the same bracket end was
+    // retained, with the sign of the retained end (+: upper, -: lower).
+    int retained = 0;
+    cmsFloat64Number widthBefore = upper - lower;
+    bool forceBisection = false;
+    while (upper - lower > Helper::gamutPrecision) {
+        if ((algorithm == BoundarySearch::bisection) || forceBisection) {
+            candidate.C = (lower + upper) / 2;
+        } else {
+            // Secant through both bracket ends, kept away from the ends
+            // by half the precision to guarantee progress.
+            candidate.C = upper
+                - upperDistance * (upper - lower)
+                    / (upperDistance - lowerDistance);
+            candidate.C = qBound(
+                lower + Helper::gamutPrecision / 2,
+                candidate.C,
+                upper - Helper::gamutPrecision / 2
+            );
+        }
+        candidateDistance = gamutDistance(candidate);
+        ++count;
+        if (candidateDistance > 0) {
+            upper = candidate.C;
+            upperDistance = candidateDistance;
+            if (retained < 0) {
+                // Illinois modification: the lower end has been retained
+                // twice, so halve its weight.
+                lowerDistance /= 2;
+            }
+            retained = -1;
+        } else {
+            lower = candidate.C;
+            lowerDistance = candidateDistance;
+            if (retained > 0) {
+                upperDistance /= 2;
+            }
+            retained = 1;
+        }
+        // Safeguard: If the secant steps do not shrink the bracket at least
+        // as fast as bisection would do, fall back to one bisection step.
+        forceBisection = (!forceBisection) && ((upper - lower) > widthBefore / 2);
+        widthBefore = upper - lower;
+        result = lower;
+    }
+
+    if (transformCount != nullptr) {
+        *transformCount = count;
+    }
+    return result;
+}
+
 /** Returns the description of the RGB color space. */
 QString RgbColorSpace::description() const
 {
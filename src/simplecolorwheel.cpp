@@ -27,14 +27,17 @@
 // Own header
 #include "PerceptualColor/simplecolorwheel.h"
 
+#include "PerceptualColor/cachemanager.h"
 #include "PerceptualColor/helper.h"
 #include "PerceptualColor/polarpointf.h"
 
 #include <math.h>
 
+#include <QBitArray>
 #include <QDebug>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QVector>
 #include <QtMath>
 
 namespace PerceptualColor {
@@ -62,6 +65,36 @@ SimpleColorWheel::SimpleColorWheel(RgbColorSpace *colorSpace, QWidget *parent) :
     m_markerThickness = default_markerThickness;
     m_wheelThickness = default_wheelThickness;
     m_mouseEventActive = false;
+
+    // Resize debouncing
+    m_resizeTimer.setSingleShot(true);
+    m_resizeTimer.setInterval(Helper::resizeDebounceInterval);
+    connect(
+        &m_resizeTimer, &QTimer::timeout,
+        this, QOverload<>::of(&QWidget::update)
+    );
+
+    // Memory budget
+    CacheManager::instance()->registerWidget(
+        this,
+        [this]() -> qint64 {
+            return m_wheelImage.sizeInBytes();
+        },
+        [this]() {
+            m_wheelImage = QImage();
+            m_wheelImageReady = false;
+        }
+    );
+}
+
+/** @brief Destructor
+ * 
+ * Unregisters the caches from CacheManager. This cannot wait for the
+ * @c destroyed() signal, because when it is emitted, the members that
+ * the callbacks of CacheManager access are already destroyed. */
+SimpleColorWheel::~SimpleColorWheel()
+{
+    CacheManager::instance()->unregisterWidget(this);
 }
 
 /** @brief Return the corresponding height for a given width of this widget.
@@ -313,15 +346,28 @@ void SimpleColorWheel::paintEvent(QPaintEvent* event)
     //       the platform independent QImage as paint device; i.e. using QImage
     //       will ensure that the result has an identical pixel representation
     //       on any platform.”
-    QImage paintBuffer(size(), QImage::Format_ARGB32);
+    //
+    // On high-dpi screens, the buffer has the native resolution of the
+    // screen (within the render-cost budget), and QPainter works on it
+    // with logical coordinates.
+    const qreal ratio = Helper::cacheDevicePixelRatio(this, size());
+    QImage paintBuffer(size() * ratio, QImage::Format_ARGB32);
+    paintBuffer.setDevicePixelRatio(ratio);
     paintBuffer.fill(Qt::transparent);
     QPainter painter(&paintBuffer);
 
-    // paint the wheel from the cache
-    if (!m_wheelImageReady) {
+    // paint the wheel from the cache. While the widget is being resized,
+    // the previous cache is scaled to the new geometry instead of
+    // regenerating it.
+    if (m_resizeTimer.isActive() && !m_wheelImage.isNull()) {
+        const int diameter = qMin(size().width(), size().height());
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.drawImage(QRectF(0, 0, diameter, diameter), m_wheelImage);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    } else {
         updateWheelImage();
+        painter.drawImage(0, 0, m_wheelImage);
     }
-    painter.drawImage(0, 0, m_wheelImage);
 
     // paint the marker
     qreal radius = contentDiameter() / static_cast<qreal>(2) - border();
@@ -366,6 +412,21 @@ void SimpleColorWheel::paintEvent(QPaintEvent* event)
     QPainter(this).drawImage(0, 0, paintBuffer);
 }
 
+/** @brief React on a hide event.
+ * 
+ * Reimplemented from base class.
+ * 
+ * Releases the caches by means of CacheManager, so that hidden widgets do
+ * not occupy memory.
+ * 
+ * @param event the hide event
+ */
+void SimpleColorWheel::hideEvent(QHideEvent *event)
+{
+    CacheManager::instance()->notifyHidden(this);
+    QWidget::hideEvent(event);
+}
+
 /** @brief React on a resive event.
  *
  * Reimplemented from base class.
@@ -375,6 +436,7 @@ void SimpleColorWheel::paintEvent(QPaintEvent* event)
 void SimpleColorWheel::resizeEvent(QResizeEvent* event)
 {
     m_wheelImageReady = false;
+    m_resizeTimer.start();
     // As by Qt documentation: The widget will be erased and receive a paint event immediately after processing the resize event. No drawing need be (or should be) done inside this handler.
 }
 
@@ -474,20 +536,29 @@ QSize SimpleColorWheel::minimumSizeHint() const
  */
 void SimpleColorWheel::updateWheelImage()
 {
-    if (m_wheelImageReady) {
+    // TODO How to treat QSize(0, 0)? Also in ChromaLightnessDiagram!!
+    const int diameter = qMin(size().width(), size().height());
+    const qreal ratio = Helper::cacheDevicePixelRatio(
+        this,
+        QSize(diameter, diameter)
+    );
+    // The device pixel ratio changes when the widget is moved to another
+    // screen.
+    if (m_wheelImageReady && (m_wheelImage.devicePixelRatio() == ratio)) {
         return;
     }
 
     m_wheelImage = generateWheelImage(
         m_rgbColorSpace,
-        // TODO How to treat QSize(0, 0)? Also in ChromaLightnessDiagram!!
-        qMin(size().width(), size().height()),
-        border(),
-        m_wheelThickness,
+        qRound(diameter * ratio),
+        qRound(border() * ratio),
+        qRound(m_wheelThickness * ratio),
         Helper::LchBoundaries::defaultLightness,
         wheelRibbonChroma()
     );
+    m_wheelImage.setDevicePixelRatio(ratio);
     m_wheelImageReady = true;
+    CacheManager::instance()->notifyUsed(this);
 }
 
 /** @brief Reset the hue() property. */
@@ -560,101 +631,164 @@ int SimpleColorWheel::border() const
 
 /** @brief Generates an image of a color wheel
 * 
+* This function does not need a widget instance and is thread-safe.
+* 
+* @param colorSpace the color space
 * @param outerDiameter the outer diameter of the wheel in pixel
+* @param border the border between the image border and the wheel
 * @param thickness the thickness of the wheel
 * @param lightness the  (LCh lightness, range 0..100)
 * @param chroma the LCh chroma value
-* @param colorTransform the color transform that is used
+* @param precision the precision of the color transforms
+* @param outOfGamutMask If not a null pointer, this bit array is resized
+* to <tt>outerDiameter * outerDiameter</tt> bits, one for each pixel, row
+* by row. A bit is set for pixels that are out-of-gamut or that are less
+* than half covered by the wheel.
 * @returns Generates a square image of a color wheel. Its size
 * is <tt>QSize(outerDiameter, outerDiameter)</tt>. All pixels
 * that do not belong to the wheel itself will be transparent.
 * Antialiasing is used, so there is no sharp border between
-* transparent and non-transparent parts. Depending on the
-* values for lightness and chroma, there may be some hue
+* transparent and non-transparent parts: The inner and outer border get
+* an analytic coverage, and the gamut boundary is supersampled. Depending
+* on the values for lightness and chroma, there may be some hue
 * who is out of gamut; if so, it will be transparent. TODO
 * Out-of-gamut situations should automatically be handled.
 */
 QImage SimpleColorWheel::generateWheelImage(
-    RgbColorSpace *colorSpace,
+    const RgbColorSpace *colorSpace,
     const int outerDiameter,
     const int border,
     const int thickness,
     const qreal lightness,
-    const qreal chroma)
+    const qreal chroma,
+    const RgbColorSpace::TransformPrecision precision,
+    QBitArray *outOfGamutMask)
 {
+    if (outOfGamutMask != nullptr) {
+        outOfGamutMask->fill(
+            true,
+            qMax(outerDiameter, 0) * qMax(outerDiameter, 0)
+        );
+    }
     if (outerDiameter <= 0) {
         return QImage();
     }
 
-    // Firsts of all, generate a non-antialised, intermediate, color wheel, but
-    // with some pixels extra at the inner and outer side. The overlap defines
-    // an overlap for the wheel, so there are some more pixels that are drawn
-    // at the outer and at the inner border of the wheel, to allow later
-    // clipping with antialising
-    constexpr int overlap = 1;
     PolarPointF polarCoordinates;
     int x;
     int y;
-    QColor rgbColor;
+    int count;
     cmsCIELCh LCh; // uses cmsFloat64Number internally
-    int maxExtension = outerDiameter - 1; // maximum value for x index and y index
-    qreal center = maxExtension / static_cast<qreal>(2);
-    QImage rawWheel = QImage(QSize(outerDiameter, outerDiameter), QImage::Format_ARGB32);
+    const qreal center = outerDiameter / static_cast<qreal>(2);
+    const qreal outerRadius = center - border;
+    const qreal innerRadius = outerRadius - thickness;
+    QImage result = QImage(QSize(outerDiameter, outerDiameter), QImage::Format_ARGB32);
     // Because there may be out-of-gamut colors for some hue (depending on the given
     // lightness and chroma value) which are drawn transparent, it is important to
     // initialize this image with a transparent background.
-    rawWheel.fill(Qt::transparent);
+    result.fill(Qt::transparent);
     LCh.L = lightness;
     LCh.C = chroma;
-    // minimalRadial: Adding "+ 1" would reduce thw workload (less pixel to
-    // process) and still work mostly, but not completly. It creates sometimes
-    // artefacts in the antialiasing process. So we don't do that.
-    qreal minimumRadial = center - thickness - border - overlap;
-    qreal maximumRadial = center - border + overlap;
-    for (x = 0; x <= maxExtension; ++x) {
-        for (y = 0; y <= maxExtension; ++y) {
-            polarCoordinates = PolarPointF(QPoint(x - center, center - y));
-            if (Helper::inRange<qreal>(minimumRadial, polarCoordinates.radial(), maximumRadial)) {
+    // Pixels that are not covered by the wheel are not rendered. They are
+    // marked in the mask so that antialiasGamutBoundary() ignores them.
+    constexpr quint8 notRendered = 2;
+    QVector<quint8> mask(outerDiameter * outerDiameter, notRendered);
+    // The analytic coverage of each rendered pixel, in the same order as
+    // the pixels are rendered.
+    QVector<qreal> coverage;
+    QVector<QPoint> coveredPixels;
+    qreal pixelCoverage;
+    // The pixels of a row that are covered by the wheel are collected and
+    // converted with a single transform call. (Along a row, the hue does
+    // not change by a constant step, so the Lab values cannot be
+    // generated incrementally like in the diagrams.)
+    QVector<cmsCIELab> labRow(outerDiameter);
+    QVector<QRgb> rgbRow(outerDiameter);
+    QVector<int> xRow(outerDiameter);
+    QRgb *scanLine;
+    for (y = 0; y < outerDiameter; ++y) {
+        count = 0;
+        for (x = 0; x < outerDiameter; ++x) {
+            polarCoordinates = PolarPointF(QPointF(x + 0.5 - center, center - y - 0.5));
+            pixelCoverage =
+                Helper::discCoverage(polarCoordinates.radial(), outerRadius)
+                - Helper::discCoverage(polarCoordinates.radial(), innerRadius);
+            if (pixelCoverage > 0) {
                 // We are within the wheel
                 LCh.h = polarCoordinates.angleDegree();
-                rgbColor = colorSpace->colorRgb(LCh);
-                if (rgbColor.isValid())
-                {
-                    rawWheel.setPixelColor(
-                        x,
-                        y,
-                        rgbColor
-                    );
-                }
+                cmsLCh2Lab(&labRow[count], &LCh);
+                xRow[count] = x;
+                ++count;
+                coverage.append(pixelCoverage);
+                coveredPixels.append(QPoint(x, y));
+            }
+        }
+        colorSpace->colorRgbScanLine(
+            labRow.constData(),
+            rgbRow.data(),
+            count,
+            precision,
+            mask.data() + y * outerDiameter
+        );
+        // The mask values have been written to the beginning of the row.
+        // Move them to their pixels, from right to left, so that no value
+        // is overwritten before it is moved.
+        for (x = count - 1; x >= 0; --x) {
+            mask[y * outerDiameter + xRow.at(x)] = mask.at(y * outerDiameter + x);
+            if (xRow.at(x) != x) {
+                mask[y * outerDiameter + x] = notRendered;
             }
         }
+        scanLine = reinterpret_cast<QRgb *>(result.scanLine(y));
+        for (x = 0; x < count; ++x) {
+            // Out-of-gamut colors are transparent in rgbRow.
+            scanLine[xRow.at(x)] = rgbRow.at(x);
+        }
     }
 
-    // construct our final QImage with transparent background
-    QImage finalWheel = QImage(QSize(outerDiameter, outerDiameter), QImage::Format_ARGB32);
-    finalWheel.fill(Qt::transparent);
-    
-    // paint an anti-alised circle with the raw (non-antialiased) color wheel as brush
-    QPainter myPainter(&finalWheel);
-    myPainter.setRenderHint(QPainter::Antialiasing, true);
-    myPainter.setPen(QPen(Qt::NoPen));
-    myPainter.setBrush(QBrush(rawWheel));
-    myPainter.drawEllipse(border, border, outerDiameter - 2 * border, outerDiameter - 2 * border);
-    
-    // set the inner circle of the wheel to antialised transparency
-    myPainter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
-    myPainter.setRenderHint(QPainter::Antialiasing, true);
-    myPainter.setPen(QPen(Qt::NoPen));
-    myPainter.setBrush(QBrush(Qt::SolidPattern));
-    myPainter.drawEllipse(
-        thickness + border,
-        thickness + border,
-        outerDiameter - 2 * (thickness + border),
-        outerDiameter - 2 * (thickness + border)
+    // Anti-aliasing of the gamut boundary
+    colorSpace->antialiasGamutBoundary(
+        &result,
+        mask,
+        [center, lightness, chroma](const qreal x, const qreal y) {
+            cmsCIELCh temp;
+            temp.L = lightness;
+            temp.C = chroma;
+            temp.h = PolarPointF(
+                QPointF(x + 0.5 - center, center - y - 0.5)
+            ).angleDegree();
+            cmsCIELab Lab;
+            cmsLCh2Lab(&Lab, &temp);
+            return Lab;
+        },
+        precision
     );
-    
-    // return
-    return finalWheel;
+
+    // Anti-aliasing of the inner and outer border: The analytic coverage
+    // is applied to the alpha channel.
+    QRgb pixel;
+    for (int i = 0; i < coveredPixels.count(); ++i) {
+        x = coveredPixels.at(i).x();
+        y = coveredPixels.at(i).y();
+        if (coverage.at(i) < 1) {
+            scanLine = reinterpret_cast<QRgb *>(result.scanLine(y));
+            pixel = scanLine[x];
+            scanLine[x] = qRgba(
+                qRed(pixel),
+                qGreen(pixel),
+                qBlue(pixel),
+                qRound(qAlpha(pixel) * coverage.at(i))
+            );
+        }
+        if ((outOfGamutMask != nullptr) &&
+            (mask.at(y * outerDiameter + x) == 0) &&
+            (coverage.at(i) >= 0.5)
+        ) {
+            outOfGamutMask->clearBit(y * outerDiameter + x);
+        }
+    }
+
+    return result;
 }
 
 }
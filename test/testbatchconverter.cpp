@@ -0,0 +1,297 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include <QTest>
+#include <QBuffer>
+#include <QObject>
+#include <QtEndian>
+#include "PerceptualColor/batchconverter.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestBatchConverter : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+    static QByteArray binaryRecord(
+        const double value0,
+        const double value1,
+        const double value2
+    ) {
+        QByteArray result;
+        for (const double value : {value0, value1, value2}) {
+            quint64 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            uchar data[8];
+            qToLittleEndian<quint64>(bits, data);
+            result.append(reinterpret_cast<const char *>(data), 8);
+        }
+        return result;
+    }
+
+    static double readDouble(const QByteArray &data, const int index) {
+        const quint64 bits = qFromLittleEndian<quint64>(
+            reinterpret_cast<const uchar *>(data.constData() + index * 8)
+        );
+        double result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    static QList<QByteArray> readAll(
+        const QByteArray &data,
+        const PerceptualColor::BatchConverter::RecordFormat recordFormat
+    ) {
+        QBuffer buffer;
+        buffer.setData(data);
+        buffer.open(QIODevice::ReadOnly);
+        QList<QByteArray> result;
+        QList<QByteArray> chunk =
+            PerceptualColor::BatchConverter::readChunk(&buffer, recordFormat);
+        while (!chunk.isEmpty()) {
+            result.append(chunk);
+            chunk = PerceptualColor::BatchConverter::readChunk(
+                &buffer,
+                recordFormat
+            );
+        }
+        return result;
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testParseColorFormat() {
+        PerceptualColor::BatchConverter::ColorFormat format;
+        QVERIFY(PerceptualColor::BatchConverter::parseColorFormat(
+            QStringLiteral("lab"),
+            &format
+        ));
+        QCOMPARE(format, PerceptualColor::BatchConverter::ColorFormat::lab);
+        QVERIFY(!PerceptualColor::BatchConverter::parseColorFormat(
+            QStringLiteral("xyz"),
+            &format
+        ));
+    };
+
+    void testReadChunkText() {
+        const QList<QByteArray> lines = readAll(
+            QByteArrayLiteral("a,1\r\nb,2\n\nc"),
+            PerceptualColor::BatchConverter::RecordFormat::csv
+        );
+        QCOMPARE(lines.count(), 4);
+        QCOMPARE(lines.at(0), QByteArrayLiteral("a,1"));
+        QCOMPARE(lines.at(1), QByteArrayLiteral("b,2"));
+        QCOMPARE(lines.at(2), QByteArray());
+        QCOMPARE(lines.at(3), QByteArrayLiteral("c"));
+    };
+
+    void testReadChunkTextSize() {
+        QByteArray data;
+        for (int i = 0; i <= PerceptualColor::BatchConverter::chunkSize; ++i) {
+            data.append("1,2,3\n");
+        }
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        const PerceptualColor::BatchConverter::RecordFormat format =
+            PerceptualColor::BatchConverter::RecordFormat::tsv;
+        QCOMPARE(
+            PerceptualColor::BatchConverter::readChunk(&buffer, format).count(),
+            static_cast<int>(PerceptualColor::BatchConverter::chunkSize)
+        );
+        QCOMPARE(
+            PerceptualColor::BatchConverter::readChunk(&buffer, format).count(),
+            1
+        );
+        QVERIFY(
+            PerceptualColor::BatchConverter::readChunk(&buffer, format).isEmpty()
+        );
+    };
+
+    void testReadChunkBinary() {
+        QByteArray data;
+        for (int i = 0; i <= PerceptualColor::BatchConverter::chunkSize; ++i) {
+            data.append(binaryRecord(i, 0, 0));
+        }
+        data.append("12345");
+        const QList<QByteArray> chunks = readAll(
+            data,
+            PerceptualColor::BatchConverter::RecordFormat::binary
+        );
+        // Only complete records, except at the end of the input
+        QCOMPARE(chunks.count(), 2);
+        QCOMPARE(
+            chunks.at(0).size(),
+            PerceptualColor::BatchConverter::chunkSize
+                * PerceptualColor::BatchConverter::binaryRecordSize
+        );
+        QCOMPARE(
+            chunks.at(1).size(),
+            PerceptualColor::BatchConverter::binaryRecordSize + 5
+        );
+    };
+
+    void testConvertHex() {
+        PerceptualColor::BatchConverter converter(m_rgbColorSpace);
+        PerceptualColor::BatchConverter::Settings settings;
+        settings.from = PerceptualColor::BatchConverter::ColorFormat::hex;
+        settings.to = PerceptualColor::BatchConverter::ColorFormat::rgb;
+        const PerceptualColor::BatchConverter::ChunkResult result =
+            converter.convertChunk(
+                settings,
+                {
+                    QByteArrayLiteral("#FF8000,orange"),
+                    QByteArrayLiteral("0080ff")
+                }
+            );
+        QCOMPARE(result.count, 2);
+        QCOMPARE(result.invalidCount, 0);
+        QCOMPARE(
+            result.output,
+            QByteArrayLiteral("255,128,0,orange\n0,128,255\n")
+        );
+    };
+
+    void testConvertText() {
+        PerceptualColor::BatchConverter converter(m_rgbColorSpace);
+        PerceptualColor::BatchConverter::Settings settings;
+        settings.from = PerceptualColor::BatchConverter::ColorFormat::rgb;
+        settings.to = PerceptualColor::BatchConverter::ColorFormat::lab;
+        settings.recordFormat =
+            PerceptualColor::BatchConverter::RecordFormat::tsv;
+        PerceptualColor::BatchConverter::ChunkResult result =
+            converter.convertChunk(
+                settings,
+                {QByteArrayLiteral("255\t128\t0\tid")}
+            );
+        QCOMPARE(result.count, 1);
+        QCOMPARE(result.invalidCount, 0);
+        QVERIFY(result.output.endsWith("\tid\n"));
+        // Round trip
+        QByteArray lab = result.output;
+        lab.chop(1);
+        settings.from = PerceptualColor::BatchConverter::ColorFormat::lab;
+        settings.to = PerceptualColor::BatchConverter::ColorFormat::hex;
+        result = converter.convertChunk(settings, {lab});
+        QCOMPARE(result.output, QByteArrayLiteral("#FF8000\tid\n"));
+    };
+
+    void testConvertMalformed() {
+        PerceptualColor::BatchConverter converter(m_rgbColorSpace);
+        PerceptualColor::BatchConverter::Settings settings;
+        settings.from = PerceptualColor::BatchConverter::ColorFormat::lab;
+        settings.to = PerceptualColor::BatchConverter::ColorFormat::lch;
+        const PerceptualColor::BatchConverter::ChunkResult result =
+            converter.convertChunk(
+                settings,
+                {
+                    QByteArrayLiteral("50,x,0"),
+                    QByteArrayLiteral("50,0"),
+                    QByteArray(),
+                    QByteArrayLiteral("50,0,0")
+                }
+            );
+        QCOMPARE(result.count, 4);
+        QCOMPARE(result.invalidCount, 3);
+        // Invalid lines produce empty lines, so that the line numbers of
+        // input and output correspond.
+        QVERIFY(result.output.startsWith("\n\n\n50.0000,0.0000,"));
+        settings.from = PerceptualColor::BatchConverter::ColorFormat::hex;
+        QCOMPARE(
+            converter.convertChunk(
+                settings,
+                {QByteArrayLiteral("#12345"), QByteArrayLiteral("#12345G")}
+            ).invalidCount,
+            2
+        );
+    };
+
+    void testConvertBinary() {
+        PerceptualColor::BatchConverter converter(m_rgbColorSpace);
+        PerceptualColor::BatchConverter::Settings settings;
+        settings.from = PerceptualColor::BatchConverter::ColorFormat::lab;
+        settings.to = PerceptualColor::BatchConverter::ColorFormat::lch;
+        settings.recordFormat =
+            PerceptualColor::BatchConverter::RecordFormat::binary;
+        QByteArray data = binaryRecord(50, 0, 20);
+        data.append(binaryRecord(70, -20, 0));
+        const PerceptualColor::BatchConverter::ChunkResult result =
+            converter.convertChunk(settings, {data});
+        QCOMPARE(result.count, 2);
+        QCOMPARE(result.invalidCount, 0);
+        QCOMPARE(
+            result.output.size(),
+            2 * PerceptualColor::BatchConverter::binaryRecordSize
+        );
+        QVERIFY(qAbs(readDouble(result.output, 0) - 50) < 0.0001);
+        QVERIFY(qAbs(readDouble(result.output, 1) - 20) < 0.0001);
+        QVERIFY(qAbs(readDouble(result.output, 2) - 90) < 0.0001);
+        QVERIFY(qAbs(readDouble(result.output, 3) - 70) < 0.0001);
+        QVERIFY(qAbs(readDouble(result.output, 4) - 20) < 0.0001);
+        QVERIFY(qAbs(readDouble(result.output, 5) - 180) < 0.0001);
+    };
+
+    void testConvertBinaryTruncated() {
+        PerceptualColor::BatchConverter converter(m_rgbColorSpace);
+        PerceptualColor::BatchConverter::Settings settings;
+        settings.from = PerceptualColor::BatchConverter::ColorFormat::lab;
+        settings.to = PerceptualColor::BatchConverter::ColorFormat::lab;
+        settings.recordFormat =
+            PerceptualColor::BatchConverter::RecordFormat::binary;
+        QByteArray data = binaryRecord(50, 10, 20);
+        data.append("12345");
+        const PerceptualColor::BatchConverter::ChunkResult result =
+            converter.convertChunk(settings, {data});
+        // The incomplete record is invalid and produces no output.
+        QCOMPARE(result.count, 2);
+        QCOMPARE(result.invalidCount, 1);
+        QCOMPARE(
+            result.output,
+            data.left(PerceptualColor::BatchConverter::binaryRecordSize)
+        );
+    };
+};
+
+QTEST_MAIN(TestBatchConverter);
+#include "testbatchconverter.moc" // necessary because we do not use a header file
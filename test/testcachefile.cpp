@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QFile>
+#include <QObject>
+#include <QStandardPaths>
+#include "PerceptualColor/cachefile.h"
+#include "PerceptualColor/gamutvolume.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestCacheFile : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        // Do not touch the real cache of the user.
+        QStandardPaths::setTestModeEnabled(true);
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+        QFile::remove(PerceptualColor::CacheFile::filePath("test.cache"));
+    };
+    void cleanup() {
+        // Called after every testfunction
+        QFile::remove(PerceptualColor::CacheFile::filePath("test.cache"));
+    };
+
+    void testMissing() {
+        PerceptualColor::CacheFile cache("test.cache", "key");
+        QVERIFY(!cache.isValid());
+        QVERIFY(cache.payload() == nullptr);
+        QCOMPARE(cache.payloadSize(), static_cast<qint64>(0));
+    };
+
+    void testRoundTrip() {
+        const QByteArray payload("0123456789abcdef");
+        QVERIFY(PerceptualColor::CacheFile::write("test.cache", "key", payload));
+        PerceptualColor::CacheFile cache("test.cache", "key");
+        QVERIFY(cache.isValid());
+        QCOMPARE(cache.payloadSize(), static_cast<qint64>(payload.size()));
+        QCOMPARE(
+            QByteArray(
+                reinterpret_cast<const char *>(cache.payload()),
+                static_cast<int>(cache.payloadSize())
+            ),
+            payload
+        );
+        QVERIFY(reinterpret_cast<quintptr>(cache.payload()) % 8 == 0);
+    };
+
+    void testEmptyPayload() {
+        QVERIFY(PerceptualColor::CacheFile::write("test.cache", "key", QByteArray()));
+        PerceptualColor::CacheFile cache("test.cache", "key");
+        QVERIFY(cache.isValid());
+        QCOMPARE(cache.payloadSize(), static_cast<qint64>(0));
+    };
+
+    void testWrongKey() {
+        QVERIFY(PerceptualColor::CacheFile::write("test.cache", "key", "payload"));
+        PerceptualColor::CacheFile cache1("test.cache", "yek");
+        QVERIFY(!cache1.isValid());
+        PerceptualColor::CacheFile cache2("test.cache", "longer key");
+        QVERIFY(!cache2.isValid());
+    };
+
+    void testCorrupted() {
+        QVERIFY(PerceptualColor::CacheFile::write("test.cache", "key", "payload"));
+        QFile file(PerceptualColor::CacheFile::filePath("test.cache"));
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QByteArray data = file.readAll();
+        data[data.size() - 1] = 'X';
+        QVERIFY(file.seek(0));
+        QCOMPARE(file.write(data), static_cast<qint64>(data.size()));
+        file.close();
+        PerceptualColor::CacheFile cache("test.cache", "key");
+        QVERIFY(!cache.isValid());
+    };
+
+    void testTruncated() {
+        QVERIFY(PerceptualColor::CacheFile::write("test.cache", "key", "payload"));
+        QVERIFY(QFile::resize(PerceptualColor::CacheFile::filePath("test.cache"), 10));
+        PerceptualColor::CacheFile cache("test.cache", "key");
+        QVERIFY(!cache.isValid());
+    };
+
+    void testRgbColorSpace() {
+        // The first object computes blackpoint and whitepoint and writes
+        // the cache, the second one reads it.
+        PerceptualColor::RgbColorSpace computed;
+        const QString cacheName = QStringLiteral("rgbcolorspace-%1.cache")
+            .arg(QString::fromLatin1(computed.profileId().toHex()));
+        QVERIFY(
+            PerceptualColor::CacheFile(cacheName, computed.cacheKey()).isValid()
+        );
+        PerceptualColor::RgbColorSpace cached;
+        QCOMPARE(cached.blackpointL(), computed.blackpointL());
+        QCOMPARE(cached.whitepointL(), computed.whitepointL());
+    };
+
+    void testGamutTable() {
+        const qint64 tableSize = 101 * 360 * static_cast<qint64>(sizeof(float));
+        PerceptualColor::RgbColorSpace::setSharedGamutTableEnabled(true);
+        QByteArray table;
+        cmsCIELCh candidate;
+        candidate.L = 40;
+        candidate.C = 150;
+        candidate.h = 250;
+        cmsFloat64Number chroma;
+        {
+            // The first object computes the gamut table and writes the
+            // cache, the second one reads it.
+            PerceptualColor::RgbColorSpace computed;
+            const QString cacheName =
+                QStringLiteral("rgbcolorspace-%1-gamuttable.cache")
+                    .arg(QString::fromLatin1(computed.profileId().toHex()));
+            PerceptualColor::CacheFile cache(cacheName, computed.cacheKey());
+            QVERIFY(cache.isValid());
+            QCOMPARE(cache.payloadSize(), tableSize);
+            table = QByteArray(
+                reinterpret_cast<const char *>(cache.payload()),
+                static_cast<int>(cache.payloadSize())
+            );
+            chroma = computed.boundaryChroma(candidate);
+        }
+        PerceptualColor::RgbColorSpace cached;
+        PerceptualColor::RgbColorSpace::setSharedGamutTableEnabled(false);
+        const QString cacheName =
+            QStringLiteral("rgbcolorspace-%1-gamuttable.cache")
+                .arg(QString::fromLatin1(cached.profileId().toHex()));
+        PerceptualColor::CacheFile cache(cacheName, cached.cacheKey());
+        QVERIFY(cache.isValid());
+        QCOMPARE(
+            QByteArray(
+                reinterpret_cast<const char *>(cache.payload()),
+                static_cast<int>(cache.payloadSize())
+            ),
+            table
+        );
+        QCOMPARE(cached.boundaryChroma(candidate), chroma);
+    };
+
+    void testGamutVolume() {
+        PerceptualColor::RgbColorSpace colorSpace;
+        PerceptualColor::GamutVolume::clearCache();
+        // The first call builds the volume and writes the cache.
+        const QSharedPointer<const PerceptualColor::GamutVolume> built =
+            PerceptualColor::GamutVolume::forColorSpace(&colorSpace, 32);
+        QVERIFY(
+            QFile::exists(
+                PerceptualColor::CacheFile::filePath(
+                    QStringLiteral("gamutvolume-%1-32.cache").arg(
+                        QString::fromLatin1(colorSpace.profileId().toHex())
+                    )
+                )
+            )
+        );
+        // After clearing the memory cache, the volume is read from disk.
+        PerceptualColor::GamutVolume::clearCache();
+        const QSharedPointer<const PerceptualColor::GamutVolume> read =
+            PerceptualColor::GamutVolume::forColorSpace(&colorSpace, 32);
+        QVERIFY(read.data() != built.data());
+        QCOMPARE(read->resolution(), built->resolution());
+        QCOMPARE(read->abRange(), built->abRange());
+        QCOMPARE(read->byteSize(), built->byteSize());
+        cmsCIELab lab;
+        for (lab.L = 0; lab.L <= 100; lab.L += 5) {
+            for (lab.a = -120; lab.a <= 120; lab.a += 7) {
+                for (lab.b = -120; lab.b <= 120; lab.b += 7) {
+                    QCOMPARE(read->coverage(lab), built->coverage(lab));
+                }
+            }
+        }
+        // A volume with another resolution does not use this file.
+        const QSharedPointer<const PerceptualColor::GamutVolume> other =
+            PerceptualColor::GamutVolume::forColorSpace(&colorSpace, 16);
+        QCOMPARE(other->resolution(), 16);
+        PerceptualColor::GamutVolume::clearCache();
+    };
+};
+
+QTEST_MAIN(TestCacheFile);
+#include "testcachefile.moc" // necessary because we do not use a header file
@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QObject>
+#include <QStandardPaths>
+#include <QWidget>
+#include "PerceptualColor/cachemanager.h"
+#include "PerceptualColor/gamutvolume.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestCacheManager : public QObject
+{
+    Q_OBJECT
+
+private:
+    /** @brief Registers a widget with a fake cache of the given size
+     * 
+     * @param widget the widget
+     * @param cacheSize pointer to the size of the fake cache in bytes. It
+     * is set to @c 0 when the cache is released. */
+    void registerFakeCache(QWidget *widget, qint64 *cacheSize) {
+        PerceptualColor::CacheManager::instance()->registerWidget(
+            widget,
+            [cacheSize]() { return *cacheSize; },
+            [cacheSize]() { *cacheSize = 0; }
+        );
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        // Do not touch the real cache of the user.
+        QStandardPaths::setTestModeEnabled(true);
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+        PerceptualColor::CacheManager::instance()->setBudget(
+            PerceptualColor::CacheManager::defaultBudget
+        );
+        PerceptualColor::CacheManager::instance()->setReleaseOnHide(true);
+    };
+
+    void testUsage() {
+        PerceptualColor::CacheManager *manager =
+            PerceptualColor::CacheManager::instance();
+        const qint64 usageBefore = manager->usage();
+        qint64 size = 1000;
+        {
+            QWidget widget;
+            registerFakeCache(&widget, &size);
+            QCOMPARE(manager->usage(), usageBefore + 1000);
+            QCOMPARE(
+                manager->usageByType().value(QStringLiteral("QWidget")),
+                static_cast<qint64>(1000)
+            );
+        }
+        // Destroyed widgets are unregistered automatically.
+        QCOMPARE(manager->usage(), usageBefore);
+        QCOMPARE(
+            manager->usageByType().value(QStringLiteral("QWidget")),
+            static_cast<qint64>(0)
+        );
+    };
+
+    void testBudget() {
+        PerceptualColor::CacheManager *manager =
+            PerceptualColor::CacheManager::instance();
+        manager->setBudget(1500);
+        QWidget first;
+        QWidget second;
+        QWidget third;
+        qint64 firstSize = 1000;
+        qint64 secondSize = 1000;
+        qint64 thirdSize = 1000;
+        registerFakeCache(&first, &firstSize);
+        registerFakeCache(&second, &secondSize);
+        registerFakeCache(&third, &thirdSize);
+        // Registering alone does not release anything.
+        QCOMPARE(firstSize + secondSize + thirdSize, static_cast<qint64>(3000));
+        manager->notifyUsed(&second);
+        // The caches of “second” are never released, because it has been
+        // used most recently. First and third have the same (older) use,
+        // so both are released until the budget is met.
+        QCOMPARE(secondSize, static_cast<qint64>(1000));
+        QCOMPARE(firstSize + thirdSize, static_cast<qint64>(0));
+        QVERIFY(manager->usage() <= manager->budget());
+    };
+
+    void testLeastRecentlyUsed() {
+        PerceptualColor::CacheManager *manager =
+            PerceptualColor::CacheManager::instance();
+        QWidget first;
+        QWidget second;
+        QWidget third;
+        qint64 firstSize = 1000;
+        qint64 secondSize = 1000;
+        qint64 thirdSize = 1000;
+        registerFakeCache(&first, &firstSize);
+        registerFakeCache(&second, &secondSize);
+        registerFakeCache(&third, &thirdSize);
+        manager->notifyUsed(&first);
+        manager->notifyUsed(&second);
+        manager->notifyUsed(&third);
+        // Only the least recently used cache has to be released.
+        manager->setBudget(manager->usage() - 500);
+        QCOMPARE(firstSize, static_cast<qint64>(0));
+        QCOMPARE(secondSize, static_cast<qint64>(1000));
+        QCOMPARE(thirdSize, static_cast<qint64>(1000));
+    };
+
+    void testHiddenFirst() {
+        PerceptualColor::CacheManager *manager =
+            PerceptualColor::CacheManager::instance();
+        manager->setReleaseOnHide(false);
+        QWidget parent;
+        QWidget *visible = new QWidget(&parent);
+        QWidget *hidden = new QWidget(&parent);
+        qint64 visibleSize = 1000;
+        qint64 hiddenSize = 1000;
+        registerFakeCache(visible, &visibleSize);
+        registerFakeCache(hidden, &hiddenSize);
+        parent.show();
+        hidden->hide();
+        // The hidden widget has been used more recently, but is
+        // released first.
+        manager->notifyUsed(visible);
+        manager->notifyUsed(hidden);
+        QCOMPARE(hiddenSize, static_cast<qint64>(1000));
+        manager->setBudget(manager->usage() - 500);
+        QCOMPARE(hiddenSize, static_cast<qint64>(0));
+        QCOMPARE(visibleSize, static_cast<qint64>(1000));
+    };
+
+    void testReleaseOnHide() {
+        PerceptualColor::CacheManager *manager =
+            PerceptualColor::CacheManager::instance();
+        QWidget widget;
+        qint64 size = 1000;
+        registerFakeCache(&widget, &size);
+        manager->notifyHidden(&widget);
+        QCOMPARE(size, static_cast<qint64>(0));
+        size = 1000;
+        manager->setReleaseOnHide(false);
+        manager->notifyHidden(&widget);
+        QCOMPARE(size, static_cast<qint64>(1000));
+        manager->unregisterWidget(&widget);
+        manager->setReleaseOnHide(true);
+        manager->notifyHidden(&widget);
+        QCOMPARE(size, static_cast<qint64>(1000));
+    };
+
+    void testSharedVolumes() {
+        PerceptualColor::CacheManager *manager =
+            PerceptualColor::CacheManager::instance();
+        PerceptualColor::GamutVolume::clearCache();
+        const qint64 usageBefore = manager->usage();
+        PerceptualColor::RgbColorSpace colorSpace;
+        const QSharedPointer<const PerceptualColor::GamutVolume> volume =
+            PerceptualColor::GamutVolume::forColorSpace(&colorSpace, 16);
+        QVERIFY(volume->byteSize() > 0);
+        QCOMPARE(manager->usage(), usageBefore + volume->byteSize());
+        QCOMPARE(
+            manager->usageByType().value(
+                QStringLiteral("PerceptualColor::GamutVolume")
+            ),
+            volume->byteSize()
+        );
+        // Exceeding the budget releases the shared volumes, but the
+        // volume that is still in use stays valid.
+        manager->setBudget(manager->usage() - 1);
+        QCOMPARE(
+            PerceptualColor::GamutVolume::cacheByteSize(),
+            static_cast<qint64>(0)
+        );
+        QCOMPARE(manager->usage(), usageBefore);
+        QCOMPARE(volume->resolution(), 16);
+    };
+};
+
+QTEST_MAIN(TestCacheManager);
+#include "testcachemanager.moc" // necessary because we do not use a header file
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QObject>
+#include <QWidget>
+#include "PerceptualColor/cachemanager.h"
+#include "PerceptualColor/chromahuediagram.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestChromaHueDiagram : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+    /** @brief Number of cache generations of all ChromaHueDiagram objects */
+    qint64 generations() const {
+        return PerceptualColor::CacheManager::instance()->generationsByType()
+            .value(QStringLiteral("PerceptualColor::ChromaHueDiagram"));
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testResizeDebounce() {
+        // A child of a visible window receives its resize events
+        // synchronously, and repaint() paints synchronously. So the
+        // debounce timer cannot fire during the burst below, because no
+        // event loop runs, whatever the speed of the test system.
+        QWidget window;
+        window.resize(400, 400);
+        PerceptualColor::ChromaHueDiagram *diagram =
+            new PerceptualColor::ChromaHueDiagram(m_rgbColorSpace, &window);
+        diagram->resize(201, 201);
+        window.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&window));
+        // Without a previous cache, the first paint generates it at once.
+        QTRY_VERIFY(generations() > 0);
+        const qint64 generationsBefore = generations();
+        // Each resize restarts the debounce timer, so that during an
+        // interactive resize the stale cache is only scaled.
+        for (int i = 1; i <= 10; ++i) {
+            diagram->resize(201 + 2 * i, 201 + 2 * i);
+            diagram->repaint();
+            QCOMPARE(generations(), generationsBefore);
+        }
+        // Once the timer has fired, the diagram image and the wheel image
+        // are generated again, each exactly once.
+        QTRY_VERIFY(generations() > generationsBefore);
+        QCOMPARE(generations(), generationsBefore + 2);
+    };
+};
+
+QTEST_MAIN(TestChromaHueDiagram);
+#include "testchromahuediagram.moc" // necessary because we do not use a header file
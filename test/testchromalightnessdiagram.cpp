@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QObject>
+#include "PerceptualColor/cachemanager.h"
+#include "PerceptualColor/chromalightnessdiagram.h"
+#include "PerceptualColor/fullcolordescription.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestChromaLightnessDiagram : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+    /** @brief Number of cache generations of all ChromaLightnessDiagram
+     * objects */
+    qint64 generations() const {
+        return PerceptualColor::CacheManager::instance()->generationsByType()
+            .value(QStringLiteral("PerceptualColor::ChromaLightnessDiagram"));
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testKeyPressWithoutCache() {
+        PerceptualColor::ChromaLightnessDiagram diagram(m_rgbColorSpace);
+        diagram.resize(200, 200);
+        cmsCIELCh lch;
+        lch.L = 50;
+        lch.C = 10;
+        lch.h = 50;
+        diagram.setColor(
+            PerceptualColor::FullColorDescription(
+                m_rgbColorSpace,
+                lch,
+                PerceptualColor::FullColorDescription::outOfGamutBehaviour::preserve
+            )
+        );
+        const qint64 generationsBefore = generations();
+        // The widget has never been painted, so there is no cache. The
+        // keyboard navigation must not generate it.
+        QTest::keyClick(&diagram, Qt::Key_Up);
+        QVERIFY(diagram.color().toLch().L > lch.L);
+        QTest::keyClick(&diagram, Qt::Key_PageUp);
+        QVERIFY(diagram.color().toLch().L > 80);
+        QVERIFY(m_rgbColorSpace->inGamut(diagram.color().toLch()));
+        QCOMPARE(generations(), generationsBefore);
+    };
+};
+
+QTEST_MAIN(TestChromaLightnessDiagram);
+#include "testchromalightnessdiagram.moc" // necessary because we do not use a header file
@@ -29,7 +29,10 @@
 #include <QSignalSpy>
 #include <QTest>
 #include <qtestcase.h>
+#include <QTabWidget>
+#include "PerceptualColor/cachemanager.h"
 #include "PerceptualColor/colordialog.h"
+#include "PerceptualColor/helper.h"
 
 class TestColorDialog : public QObject
 {
@@ -857,6 +860,54 @@ private Q_SLOTS:
         QCOMPARE(m_color, Qt::red);
     }
 
+    void testNoDiagramForInvisibleTab() {
+        const QString chromaHueType =
+            QStringLiteral("PerceptualColor::ChromaHueDiagram");
+        PerceptualColor::CacheManager *manager =
+            PerceptualColor::CacheManager::instance();
+        m_perceptualDialog = new PerceptualColor::ColorDialog;
+        QTabWidget *tabWidget = m_perceptualDialog->findChild<QTabWidget *>();
+        QVERIFY(tabWidget != nullptr);
+        PerceptualColor::ChromaHueDiagram *diagram =
+            m_perceptualDialog->findChild<PerceptualColor::ChromaHueDiagram *>();
+        QVERIFY(diagram != nullptr);
+        // The ChromaHueDiagram is on the second tab, which is not visible.
+        tabWidget->setCurrentIndex(0);
+        m_perceptualDialog->show();
+        QVERIFY(QTest::qWaitForWindowExposed(m_perceptualDialog));
+        const qint64 generationsBefore =
+            manager->generationsByType().value(chromaHueType);
+        m_perceptualDialog->setCurrentColor(Qt::red);
+        m_perceptualDialog->setCurrentColor(Qt::darkGreen);
+        m_perceptualDialog->setCurrentColor(QColor(20, 40, 200));
+        // Give pending paint events and timers the chance to run.
+        QTest::qWait(
+            2 * PerceptualColor::Helper::resizeDebounceInterval
+        );
+        QCOMPARE(
+            manager->generationsByType().value(chromaHueType),
+            generationsBefore
+        );
+        // The invisible diagram has not even received the color yet.
+        QVERIFY(
+            diagram->color().toRgbQColor().name() != QColor(20, 40, 200).name()
+        );
+        // When the tab becomes visible, the diagram is updated and generated.
+        tabWidget->setCurrentIndex(1);
+        QCOMPARE(
+            diagram->color().toRgbQColor().name(),
+            QColor(20, 40, 200).name()
+        );
+        QTRY_VERIFY(
+            manager->generationsByType().value(chromaHueType)
+                > generationsBefore
+        );
+        QCOMPARE(
+            m_perceptualDialog->currentColor().name(),
+            QColor(20, 40, 200).name()
+        );
+    }
+
 };
 
 QTEST_MAIN(TestColorDialog);
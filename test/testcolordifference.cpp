@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QObject>
+#include <QVector>
+#include "PerceptualColor/colordifference.h"
+
+namespace {
+
+/** @brief A test pair with the expected CIEDE2000 color difference */
+struct SharmaPair {
+    cmsCIELab first;
+    cmsCIELab second;
+    cmsFloat64Number deltaE2000;
+};
+
+/** @brief Test data from Sharma, Wu, Dalal: “The CIEDE2000 Color-Difference
+ * Formula: Implementation Notes, Supplementary Test Data, and Mathematical
+ * Observations”, Table 1 */
+QVector<SharmaPair> sharmaData()
+{
+    return QVector<SharmaPair> {
+            {{50.0000, 2.6772, -79.7751}, {50.0000, 0.0000, -82.7485}, 2.0425},
+            {{50.0000, 3.1571, -77.2803}, {50.0000, 0.0000, -82.7485}, 2.8615},
+            {{50.0000, 2.8361, -74.0200}, {50.0000, 0.0000, -82.7485}, 3.4412},
+            {{50.0000, -1.3802, -84.2814}, {50.0000, 0.0000, -82.7485}, 1.0000},
+            {{50.0000, -1.1848, -84.8006}, {50.0000, 0.0000, -82.7485}, 1.0000},
+            {{50.0000, -0.9009, -85.5211}, {50.0000, 0.0000, -82.7485}, 1.0000},
+            {{50.0000, 0.0000, 0.0000}, {50.0000, -1.0000, 2.0000}, 2.3669},
+            {{50.0000, -1.0000, 2.0000}, {50.0000, 0.0000, 0.0000}, 2.3669},
+            {{50.0000, 2.4900, -0.0010}, {50.0000, -2.4900, 0.0009}, 7.1792},
+            {{50.0000, 2.4900, -0.0010}, {50.0000, -2.4900, 0.0010}, 7.1792},
+            {{50.0000, 2.4900, -0.0010}, {50.0000, -2.4900, 0.0011}, 7.2195},
+            {{50.0000, 2.4900, -0.0010}, {50.0000, -2.4900, 0.0012}, 7.2195},
+            {{50.0000, -0.0010, 2.4900}, {50.0000, 0.0009, -2.4900}, 4.8045},
+            {{50.0000, -0.0010, 2.4900}, {50.0000, 0.0010, -2.4900}, 4.8045},
+            {{50.0000, -0.0010, 2.4900}, {50.0000, 0.0011, -2.4900}, 4.7461},
+            {{50.0000, 2.5000, 0.0000}, {50.0000, 0.0000, -2.5000}, 4.3065},
+            {{50.0000, 2.5000, 0.0000}, {73.0000, 25.0000, -18.0000}, 27.1492},
+            {{50.0000, 2.5000, 0.0000}, {61.0000, -5.0000, 29.0000}, 22.8977},
+            {{50.0000, 2.5000, 0.0000}, {56.0000, -27.0000, -3.0000}, 31.9030},
+            {{50.0000, 2.5000, 0.0000}, {58.0000, 24.0000, 15.0000}, 19.4535},
+            {{50.0000, 2.5000, 0.0000}, {50.0000, 3.1736, 0.5854}, 1.0000},
+            {{50.0000, 2.5000, 0.0000}, {50.0000, 3.2972, 0.0000}, 1.0000},
+            {{50.0000, 2.5000, 0.0000}, {50.0000, 1.8634, 0.5757}, 1.0000},
+            {{50.0000, 2.5000, 0.0000}, {50.0000, 3.2592, 0.3350}, 1.0000},
+            {{60.2574, -34.0099, 36.2677}, {60.4626, -34.1751, 39.4387}, 1.2644},
+            {{63.0109, -31.0961, -5.8663}, {62.8187, -29.7946, -4.0864}, 1.2630},
+            {{61.2901, 3.7196, -5.3901}, {61.4292, 2.2480, -4.9620}, 1.8731},
+            {{35.0831, -44.1164, 3.7933}, {35.0232, -40.0716, 1.5901}, 1.8645},
+            {{22.7233, 20.0904, -46.6940}, {23.0331, 14.9730, -42.5619}, 2.0373},
+            {{36.4612, 47.8580, 18.3852}, {36.2715, 50.5065, 21.2231}, 1.4146},
+            {{90.8027, -2.0831, 1.4410}, {91.1528, -1.6435, 0.0447}, 1.4441},
+            {{90.9257, -0.5406, -0.9208}, {88.6381, -0.8985, -0.7239}, 1.5381},
+            {{6.7747, -0.2908, -2.4247}, {5.8714, -0.0985, -2.2286}, 0.6377},
+            {{2.0776, 0.0795, -1.1350}, {0.9033, -0.0636, -0.5514}, 0.9082},
+    };
+}
+
+}
+
+class TestColorDifference : public QObject
+{
+    Q_OBJECT
+
+private:
+    /** @brief Colors for the batch tests. (An odd number, so that the
+     * scalar tail of the SIMD implementation is tested too.) */
+    QVector<cmsCIELab> m_colors;
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        for (const SharmaPair &pair : sharmaData()) {
+            m_colors.append(pair.first);
+            m_colors.append(pair.second);
+        }
+        m_colors.append(cmsCIELab {50, 0, 0});
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testDeltaE76() {
+        QCOMPARE(
+            PerceptualColor::ColorDifference::deltaE76(
+                cmsCIELab {50, 1, 2},
+                cmsCIELab {52, 4, 8}
+            ),
+            static_cast<cmsFloat64Number>(7)
+        );
+    };
+
+    void testDeltaE94() {
+        // Reference value calculated independently
+        QVERIFY(
+            qAbs(
+                PerceptualColor::ColorDifference::deltaE94(
+                    cmsCIELab {50, 2.6772, -79.7751},
+                    cmsCIELab {50, 0, -82.7485}
+                ) - 1.3950388679
+            ) < 0.0000000001
+        );
+    };
+
+    void testDeltaE2000Sharma() {
+        for (const SharmaPair &pair : sharmaData()) {
+            // The test data has four decimals.
+            QVERIFY(
+                qAbs(
+                    PerceptualColor::ColorDifference::deltaE2000(pair.first, pair.second)
+                        - pair.deltaE2000
+                ) < 0.00005
+            );
+            // CIEDE2000 is symmetric.
+            QVERIFY(
+                qAbs(
+                    PerceptualColor::ColorDifference::deltaE2000(pair.second, pair.first)
+                        - pair.deltaE2000
+                ) < 0.00005
+            );
+        }
+    };
+
+    void testBatchOneToMany() {
+        const int count = m_colors.count();
+        QVector<cmsFloat64Number> result(count);
+        const cmsCIELab reference {60, 20, -10};
+        PerceptualColor::ColorDifference::deltaE76(reference, m_colors.constData(), result.data(), count);
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(qAbs(result.at(i) - PerceptualColor::ColorDifference::deltaE76(reference, m_colors.at(i))) < 1e-12);
+        }
+        PerceptualColor::ColorDifference::deltaE94(reference, m_colors.constData(), result.data(), count);
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(qAbs(result.at(i) - PerceptualColor::ColorDifference::deltaE94(reference, m_colors.at(i))) < 1e-12);
+        }
+        PerceptualColor::ColorDifference::deltaE2000(reference, m_colors.constData(), result.data(), count);
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(qAbs(result.at(i) - PerceptualColor::ColorDifference::deltaE2000(reference, m_colors.at(i))) < 1e-10);
+        }
+    };
+
+    void testBatchDeltaE2000() {
+        // Compare the batch implementation with the scalar reference on a
+        // grid that covers all hue quadrants, achromatic colors and pairs
+        // with opposite hues.
+        QVector<cmsCIELab> first;
+        QVector<cmsCIELab> second;
+        for (int L = 0; L <= 100; L += 25) {
+            for (int a = -120; a <= 120; a += 15) {
+                for (int b = -120; b <= 120; b += 15) {
+                    first.append(cmsCIELab {
+                        static_cast<cmsFloat64Number>(L),
+                        static_cast<cmsFloat64Number>(a),
+                        static_cast<cmsFloat64Number>(b)
+                    });
+                    second.append(cmsCIELab {
+                        static_cast<cmsFloat64Number>(100 - L),
+                        static_cast<cmsFloat64Number>(b) / 2,
+                        static_cast<cmsFloat64Number>(-a)
+                    });
+                    first.append(first.last());
+                    second.append(cmsCIELab {
+                        static_cast<cmsFloat64Number>(L),
+                        static_cast<cmsFloat64Number>(-a),
+                        static_cast<cmsFloat64Number>(-b)
+                    });
+                }
+            }
+        }
+        const int count = first.count();
+        QVector<cmsFloat64Number> result(count);
+        PerceptualColor::ColorDifference::deltaE2000(first.constData(), second.constData(), result.data(), count);
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(qAbs(result.at(i) - PerceptualColor::ColorDifference::deltaE2000(first.at(i), second.at(i))) < 1e-10);
+        }
+        // Sharma data in both directions, through the batch function
+        const QVector<SharmaPair> data = sharmaData();
+        first.clear();
+        second.clear();
+        for (const SharmaPair &pair : data) {
+            first.append(pair.first);
+            second.append(pair.second);
+            first.append(pair.second);
+            second.append(pair.first);
+        }
+        result.resize(first.count());
+        PerceptualColor::ColorDifference::deltaE2000(first.constData(), second.constData(), result.data(), first.count());
+        for (int i = 0; i < first.count(); ++i) {
+            // The test data has four decimals.
+            QVERIFY(qAbs(result.at(i) - data.at(i / 2).deltaE2000) < 0.00005);
+        }
+    };
+
+    void testBatchPairwise() {
+        const QVector<SharmaPair> data = sharmaData();
+        QVector<cmsCIELab> first;
+        QVector<cmsCIELab> second;
+        for (const SharmaPair &pair : data) {
+            first.append(pair.first);
+            second.append(pair.second);
+        }
+        // An odd number of pairs
+        first.removeLast();
+        second.removeLast();
+        const int count = first.count();
+        QVector<cmsFloat64Number> result(count);
+        PerceptualColor::ColorDifference::deltaE76(first.constData(), second.constData(), result.data(), count);
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(qAbs(result.at(i) - PerceptualColor::ColorDifference::deltaE76(first.at(i), second.at(i))) < 1e-12);
+        }
+        PerceptualColor::ColorDifference::deltaE94(first.constData(), second.constData(), result.data(), count);
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(qAbs(result.at(i) - PerceptualColor::ColorDifference::deltaE94(first.at(i), second.at(i))) < 1e-12);
+        }
+        PerceptualColor::ColorDifference::deltaE2000(first.constData(), second.constData(), result.data(), count);
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(qAbs(result.at(i) - data.at(i).deltaE2000) < 0.00005);
+        }
+    };
+
+    void benchmarkDeltaE2000() {
+        QVector<cmsCIELab> colors;
+        for (int i = 0; i < 10000; ++i) {
+            colors.append(m_colors.at(i % m_colors.count()));
+        }
+        QVector<cmsFloat64Number> result(colors.count());
+        const cmsCIELab reference {60, 20, -10};
+        QBENCHMARK {
+            PerceptualColor::ColorDifference::deltaE2000(reference, colors.constData(), result.data(), colors.count());
+        }
+    };
+
+    void benchmarkDeltaE2000Scalar() {
+        QVector<cmsCIELab> colors;
+        for (int i = 0; i < 10000; ++i) {
+            colors.append(m_colors.at(i % m_colors.count()));
+        }
+        QVector<cmsFloat64Number> result(colors.count());
+        const cmsCIELab reference {60, 20, -10};
+        QBENCHMARK {
+            for (int i = 0; i < colors.count(); ++i) {
+                result[i] = PerceptualColor::ColorDifference::deltaE2000(reference, colors.at(i));
+            }
+        }
+    };
+
+    void benchmarkDeltaE94() {
+        QVector<cmsCIELab> colors;
+        for (int i = 0; i < 10000; ++i) {
+            colors.append(m_colors.at(i % m_colors.count()));
+        }
+        QVector<cmsFloat64Number> result(colors.count());
+        const cmsCIELab reference {60, 20, -10};
+        QBENCHMARK {
+            PerceptualColor::ColorDifference::deltaE94(reference, colors.constData(), result.data(), colors.count());
+        }
+    };
+};
+
+QTEST_MAIN(TestColorDifference);
+#include "testcolordifference.moc" // necessary because we do not use a header file
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QObject>
+#include <QVector>
+#include "PerceptualColor/colormapgenerator.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestColormapGenerator : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+    void compareEntry(const quint16 *entry, const cmsCIELCh &lch) {
+        const PerceptualColor::Helper::cmsRGB expected =
+            m_rgbColorSpace->colorRgbBoundSimple(PerceptualColor::Helper::toLab(lch));
+        QCOMPARE(entry[0], static_cast<quint16>(qRound(expected.red * 65535)));
+        QCOMPARE(entry[1], static_cast<quint16>(qRound(expected.green * 65535)));
+        QCOMPARE(entry[2], static_cast<quint16>(qRound(expected.blue * 65535)));
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testStops() {
+        PerceptualColor::ColormapGenerator generator(m_rgbColorSpace);
+        QCOMPARE(generator.stops().count(), 2);
+        QCOMPARE(generator.setStops(QVector<cmsCIELCh> {{50, 20, 30}}), false);
+        QCOMPARE(generator.stops().count(), 2);
+        QCOMPARE(
+            generator.setStops(QVector<cmsCIELCh> {{20, 20, 30}, {50, 20, 60}, {80, 20, 90}}),
+            true
+        );
+        QCOMPARE(generator.stops().count(), 3);
+    };
+
+    void testInterpolation() {
+        PerceptualColor::ColormapGenerator generator(m_rgbColorSpace);
+        // The hue goes from 350 over 0 to 10.
+        generator.setStops(QVector<cmsCIELCh> {{40, 20, 350}, {60, 20, 10}});
+        QVector<quint16> rgb(3 * 257);
+        generator.generate(257, rgb.data());
+        compareEntry(rgb.constData(), cmsCIELCh {40, 20, 350});
+        compareEntry(rgb.constData() + 3 * 128, cmsCIELCh {50, 20, 0});
+        compareEntry(rgb.constData() + 3 * 256, cmsCIELCh {60, 20, 10});
+    };
+
+    void testFormats() {
+        PerceptualColor::ColormapGenerator generator(m_rgbColorSpace);
+        generator.setStops(QVector<cmsCIELCh> {{30, 40, 270}, {70, 40, 90}});
+        QVector<quint8> rgb8(3 * 300);
+        QVector<quint16> rgb16(3 * 300);
+        QVector<float> rgbFloat(3 * 300);
+        generator.generate(300, rgb8.data());
+        generator.generate(300, rgb16.data());
+        generator.generate(300, rgbFloat.data());
+        for (int i = 0; i < rgb8.count(); ++i) {
+            QCOMPARE(rgb8.at(i), static_cast<quint8>(qRound(rgbFloat.at(i) * 255)));
+            QVERIFY(qAbs(rgb16.at(i) / 65535.0 - rgbFloat.at(i)) < 0.0001);
+        }
+    };
+
+    void testGamutMapping() {
+        PerceptualColor::ColormapGenerator generator(m_rgbColorSpace);
+        generator.setGamutBehaviour(
+            PerceptualColor::FullColorDescription::outOfGamutBehaviour::sacrifyChroma
+        );
+        // Far out-of-gamut
+        generator.setStops(QVector<cmsCIELCh> {{50, 150, 0}, {50, 150, 180}});
+        QVector<float> rgb(3 * 64);
+        generator.generate(64, rgb.data());
+        for (const float value : rgb) {
+            QVERIFY(value >= 0);
+            QVERIFY(value <= 1);
+        }
+    };
+
+    void benchmarkGenerate() {
+        PerceptualColor::ColormapGenerator generator(m_rgbColorSpace);
+        generator.setStops(QVector<cmsCIELCh> {{20, 40, 270}, {60, 50, 150}, {90, 60, 90}});
+        QVector<quint16> rgb(3 * 65536);
+        QBENCHMARK {
+            generator.generate(65536, rgb.data());
+        }
+    };
+};
+
+QTEST_MAIN(TestColormapGenerator);
+#include "testcolormapgenerator.moc" // necessary because we do not use a header file
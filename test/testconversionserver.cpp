@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QCoreApplication>
+#include <QFuture>
+#include <QObject>
+#include <QVector>
+#include <QtConcurrent>
+#include "PerceptualColor/conversionclient.h"
+#include "PerceptualColor/conversionserver.h"
+#include "PerceptualColor/gamutmapper.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestConversionServer : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+    PerceptualColor::ConversionServer *m_server = nullptr;
+
+    /** @brief Lab values that cover in-gamut and out-of-gamut colors */
+    QVector<cmsCIELab> labSamples() const {
+        QVector<cmsCIELab> result;
+        cmsCIELab lab;
+        for (int lightness = 0; lightness <= 100; lightness += 5) {
+            for (int a = -100; a <= 100; a += 20) {
+                for (int b = -100; b <= 100; b += 25) {
+                    lab.L = lightness;
+                    lab.a = a;
+                    lab.b = b;
+                    result.append(lab);
+                }
+            }
+        }
+        return result;
+    }
+
+    /** @brief Starts a conversion with a ConversionClient in another
+     * thread
+     * 
+     * The server needs the event loop of this thread, while the client
+     * blocks. @em input and @em output must stay alive until the future
+     * has finished. */
+    QFuture<bool> startRemote(
+        const PerceptualColor::ConversionProtocol::Operation operation,
+        const QVector<double> &input,
+        QVector<double> *output,
+        const quint16 flags = 0,
+        const int batchSize = 100
+    ) {
+        output->resize(input.count());
+        const QString name = m_server->serverName();
+        return QtConcurrent::run(
+            [name, operation, &input, output, flags, batchSize]() {
+                PerceptualColor::ConversionClient client;
+                // Small batches by default, so that pipelining is
+                // actually used.
+                client.setBatchSize(batchSize);
+                client.setPipelineDepth(3);
+                if (!client.connectToServer(name)) {
+                    return false;
+                }
+                return client.convert(
+                    operation,
+                    input.constData(),
+                    output->data(),
+                    input.count() / 3,
+                    flags
+                );
+            }
+        );
+    }
+
+    /** @brief Converts with a ConversionClient in another thread
+     * 
+     * @sa startRemote() */
+    bool convertRemote(
+        const PerceptualColor::ConversionProtocol::Operation operation,
+        const QVector<double> &input,
+        QVector<double> *output,
+        const quint16 flags = 0,
+        const int batchSize = 100
+    ) {
+        QFuture<bool> future =
+            startRemote(operation, input, output, flags, batchSize);
+        while (!future.isFinished()) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        }
+        return future.result();
+    }
+
+    /** @brief Many Lab values, as input for large requests */
+    QVector<double> largeInput() const {
+        const QVector<cmsCIELab> lab = labSamples();
+        QVector<double> result;
+        for (int i = 0; i < 10; ++i) {
+            for (const cmsCIELab &value : lab) {
+                result << value.L << value.a << value.b;
+            }
+        }
+        return result;
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+        m_server = new PerceptualColor::ConversionServer(m_rgbColorSpace);
+        QVERIFY(m_server->listen(
+            QStringLiteral("testconversionserver-%1").arg(
+                QCoreApplication::applicationPid()
+            )
+        ));
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_server;
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testLabToRgb() {
+        const QVector<cmsCIELab> lab = labSamples();
+        QVector<double> input;
+        for (const cmsCIELab &value : lab) {
+            input << value.L << value.a << value.b;
+        }
+        QVector<double> output;
+        QVERIFY(convertRemote(
+            PerceptualColor::ConversionProtocol::Operation::labToRgb,
+            input,
+            &output
+        ));
+        QVector<PerceptualColor::Helper::cmsRGB> expected(lab.count());
+        m_rgbColorSpace->colorRgbBoundSimple(
+            lab.constData(),
+            expected.data(),
+            lab.count()
+        );
+        for (int i = 0; i < lab.count(); ++i) {
+            QCOMPARE(output.at(3 * i), expected.at(i).red);
+            QCOMPARE(output.at(3 * i + 1), expected.at(i).green);
+            QCOMPARE(output.at(3 * i + 2), expected.at(i).blue);
+        }
+    };
+
+    void testLchToRgbSacrifyChroma() {
+        const QVector<cmsCIELab> lab = labSamples();
+        QVector<double> input;
+        cmsCIELCh lch;
+        for (const cmsCIELab &value : lab) {
+            lch = PerceptualColor::Helper::toLch(value);
+            input << lch.L << lch.C << lch.h;
+        }
+        QVector<double> output;
+        QVERIFY(convertRemote(
+            PerceptualColor::ConversionProtocol::Operation::lchToRgb,
+            input,
+            &output,
+            PerceptualColor::ConversionProtocol::sacrifyChroma
+        ));
+        QVector<PerceptualColor::Helper::cmsRGB> expected(lab.count());
+        PerceptualColor::GamutMapper(m_rgbColorSpace).map(
+            lab.constData(),
+            expected.data(),
+            lab.count()
+        );
+        for (int i = 0; i < lab.count(); ++i) {
+            QVERIFY(qAbs(output.at(3 * i) - expected.at(i).red) < 0.0001);
+            QVERIFY(qAbs(output.at(3 * i + 1) - expected.at(i).green) < 0.0001);
+            QVERIFY(qAbs(output.at(3 * i + 2) - expected.at(i).blue) < 0.0001);
+        }
+    };
+
+    void testRgbToLch() {
+        QVector<double> input;
+        for (int i = 0; i <= 10; ++i) {
+            input << i / 10.0 << 1 - i / 10.0 << 0.5;
+        }
+        QVector<double> output;
+        QVERIFY(convertRemote(
+            PerceptualColor::ConversionProtocol::Operation::rgbToLch,
+            input,
+            &output
+        ));
+        PerceptualColor::Helper::cmsRGB rgb;
+        cmsCIELCh expected;
+        for (int i = 0; i < input.count() / 3; ++i) {
+            rgb.red = input.at(3 * i);
+            rgb.green = input.at(3 * i + 1);
+            rgb.blue = input.at(3 * i + 2);
+            expected = PerceptualColor::Helper::toLch(
+                m_rgbColorSpace->colorLab(rgb)
+            );
+            QCOMPARE(output.at(3 * i), expected.L);
+            QCOMPARE(output.at(3 * i + 1), expected.C);
+            QCOMPARE(output.at(3 * i + 2), expected.h);
+        }
+    };
+
+    void testConcurrentConnections() {
+        // The large batches are converted in the background, while the
+        // other connection is served.
+        const QVector<double> large = largeInput();
+        const QVector<cmsCIELab> lab = labSamples();
+        QVector<double> small;
+        for (const cmsCIELab &value : lab) {
+            small << value.L << value.a << value.b;
+        }
+        QVector<double> largeOutput;
+        QVector<double> smallOutput;
+        QFuture<bool> largeFuture = startRemote(
+            PerceptualColor::ConversionProtocol::Operation::labToRgb,
+            large,
+            &largeOutput,
+            PerceptualColor::ConversionProtocol::sacrifyChroma,
+            large.count() / 3
+        );
+        QFuture<bool> smallFuture = startRemote(
+            PerceptualColor::ConversionProtocol::Operation::labToRgb,
+            small,
+            &smallOutput
+        );
+        while (!largeFuture.isFinished() || !smallFuture.isFinished()) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        }
+        QVERIFY(largeFuture.result());
+        QVERIFY(smallFuture.result());
+
+        QVector<PerceptualColor::Helper::cmsRGB> expected(lab.count());
+        m_rgbColorSpace->colorRgbBoundSimple(
+            lab.constData(),
+            expected.data(),
+            lab.count()
+        );
+        for (int i = 0; i < lab.count(); ++i) {
+            QCOMPARE(smallOutput.at(3 * i), expected.at(i).red);
+            QCOMPARE(smallOutput.at(3 * i + 1), expected.at(i).green);
+            QCOMPARE(smallOutput.at(3 * i + 2), expected.at(i).blue);
+        }
+        PerceptualColor::GamutMapper(m_rgbColorSpace).map(
+            lab.constData(),
+            expected.data(),
+            lab.count()
+        );
+        // The large input repeats the small one.
+        for (int i = 0; i < large.count() / 3; ++i) {
+            const int j = i % lab.count();
+            QVERIFY(qAbs(largeOutput.at(3 * i) - expected.at(j).red) < 0.0001);
+            QVERIFY(qAbs(largeOutput.at(3 * i + 1) - expected.at(j).green) < 0.0001);
+            QVERIFY(qAbs(largeOutput.at(3 * i + 2) - expected.at(j).blue) < 0.0001);
+        }
+    };
+
+    void testUnknownOperation() {
+        QVector<double> input {50, 0, 0};
+        QVector<double> output;
+        QVERIFY(!convertRemote(
+            static_cast<PerceptualColor::ConversionProtocol::Operation>(99),
+            input,
+            &output
+        ));
+    };
+
+    void benchmarkLabToRgbLocal() {
+        const QVector<double> input = largeInput();
+        QVector<cmsCIELab> lab;
+        for (int i = 0; i < input.count(); i += 3) {
+            lab.append(cmsCIELab {input.at(i), input.at(i + 1), input.at(i + 2)});
+        }
+        QVector<PerceptualColor::Helper::cmsRGB> output(lab.count());
+        QBENCHMARK {
+            m_rgbColorSpace->colorRgbBoundSimple(
+                lab.constData(),
+                output.data(),
+                lab.count()
+            );
+        }
+    };
+
+    void benchmarkLabToRgbRemote() {
+        // Same conversion as benchmarkLabToRgbLocal(), through the server,
+        // in batches that are converted in the background.
+        const QVector<double> input = largeInput();
+        QVector<double> output;
+        QBENCHMARK {
+            QVERIFY(convertRemote(
+                PerceptualColor::ConversionProtocol::Operation::labToRgb,
+                input,
+                &output,
+                0,
+                16384
+            ));
+        }
+    };
+
+    void testNotConnected() {
+        PerceptualColor::ConversionClient client;
+        QVERIFY(!client.isConnected());
+        const double input[3] = {50, 0, 0};
+        double output[3];
+        QVERIFY(!client.convert(
+            PerceptualColor::ConversionProtocol::Operation::labToRgb,
+            input,
+            output,
+            1
+        ));
+    };
+};
+
+QTEST_MAIN(TestConversionServer);
+#include "testconversionserver.moc" // necessary because we do not use a header file
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QObject>
+#include "PerceptualColor/diagramrenderer.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestDiagramRenderer : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testRender() {
+        PerceptualColor::DiagramRenderer renderer(m_rgbColorSpace);
+        PerceptualColor::DiagramRenderer::Job job;
+        job.size = QSize(40, 30);
+        job.type = PerceptualColor::DiagramRenderer::DiagramType::chromaHue;
+        QCOMPARE(renderer.render(job).size(), QSize(30, 30));
+        job.type = PerceptualColor::DiagramRenderer::DiagramType::colorWheel;
+        QCOMPARE(renderer.render(job).size(), QSize(30, 30));
+        job.type = PerceptualColor::DiagramRenderer::DiagramType::chromaLightness;
+        QCOMPARE(renderer.render(job).size(), QSize(40, 30));
+        job.size = QSize(0, 0);
+        QVERIFY(renderer.render(job).isNull());
+    };
+
+    void testRenderBatch() {
+        PerceptualColor::DiagramRenderer renderer(m_rgbColorSpace);
+        QList<PerceptualColor::DiagramRenderer::Job> jobs;
+        PerceptualColor::DiagramRenderer::Job job;
+        job.size = QSize(20, 20);
+        job.type = PerceptualColor::DiagramRenderer::DiagramType::chromaLightness;
+        for (int hue = 0; hue < 360; hue += 45) {
+            job.hue = hue;
+            jobs.append(job);
+        }
+        const QList<QImage> images = renderer.renderBatch(jobs);
+        QCOMPARE(images.count(), jobs.count());
+        for (int i = 0; i < jobs.count(); ++i) {
+            // Same result and same order as the single-threaded rendering
+            QCOMPARE(images.at(i), renderer.render(jobs.at(i)));
+        }
+    };
+
+    void testRawBuffer() {
+        QImage image(3, 2, QImage::Format_ARGB32);
+        image.fill(QColor(10, 20, 30, 255));
+        const QByteArray buffer =
+            PerceptualColor::DiagramRenderer::rawBuffer(image);
+        QCOMPARE(buffer.size(), 3 * 2 * 4);
+        QCOMPARE(static_cast<quint8>(buffer.at(0)), static_cast<quint8>(10));
+        QCOMPARE(static_cast<quint8>(buffer.at(1)), static_cast<quint8>(20));
+        QCOMPARE(static_cast<quint8>(buffer.at(2)), static_cast<quint8>(30));
+        QCOMPARE(static_cast<quint8>(buffer.at(3)), static_cast<quint8>(255));
+    };
+};
+
+QTEST_MAIN(TestDiagramRenderer);
+#include "testdiagramrenderer.moc" // necessary because we do not use a header file
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QObject>
+#include <QPainter>
+#include "PerceptualColor/dominantcolorextractor.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestDominantColorExtractor : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+    /** @brief An image with three colored areas: 50 % red, 30 % green,
+     * 20 % blue */
+    QImage threeColorImage(const QSize size, const QImage::Format format) const {
+        QImage image(size, format);
+        QPainter painter(&image);
+        const int width = size.width();
+        painter.fillRect(0, 0, width / 2, size.height(), QColor(200, 30, 30));
+        painter.fillRect(width / 2, 0, width * 3 / 10, size.height(), QColor(30, 160, 60));
+        painter.fillRect(width * 8 / 10, 0, width - width * 8 / 10, size.height(), QColor(40, 60, 190));
+        return image;
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testThreeColors() {
+        PerceptualColor::DominantColorExtractor extractor(m_rgbColorSpace);
+        const QVector<PerceptualColor::DominantColorExtractor::Cluster> clusters =
+            extractor.extract(threeColorImage(QSize(200, 50), QImage::Format_RGB32), 3);
+        QCOMPARE(clusters.count(), 3);
+        QVERIFY(qAbs(clusters.at(0).weight - 0.5) < 0.02);
+        QVERIFY(qAbs(clusters.at(1).weight - 0.3) < 0.02);
+        QVERIFY(qAbs(clusters.at(2).weight - 0.2) < 0.02);
+        const QColor red = clusters.at(0).color.toRgbQColor();
+        QVERIFY(qAbs(red.red() - 200) <= 1);
+        QVERIFY(qAbs(red.green() - 30) <= 1);
+        QVERIFY(qAbs(red.blue() - 30) <= 1);
+    };
+
+    void testFewerColorsThanClusters() {
+        PerceptualColor::DominantColorExtractor extractor(m_rgbColorSpace);
+        QImage image(10, 10, QImage::Format_RGB32);
+        image.fill(QColor(100, 100, 100));
+        const QVector<PerceptualColor::DominantColorExtractor::Cluster> clusters =
+            extractor.extract(image, 5);
+        QCOMPARE(clusters.count(), 1);
+        QCOMPARE(clusters.at(0).weight, static_cast<qreal>(1));
+    };
+
+    void testTransparentAndSubsampled() {
+        PerceptualColor::DominantColorExtractor extractor(m_rgbColorSpace);
+        QImage transparent(10, 10, QImage::Format_ARGB32);
+        transparent.fill(Qt::transparent);
+        QCOMPARE(extractor.extract(transparent, 3).count(), 0);
+        // Other format and subsampling
+        extractor.setMaximumSamples(1000);
+        const QVector<PerceptualColor::DominantColorExtractor::Cluster> clusters =
+            extractor.extract(threeColorImage(QSize(1000, 400), QImage::Format_RGB888), 3);
+        QCOMPARE(clusters.count(), 3);
+        QVERIFY(qAbs(clusters.at(0).weight - 0.5) < 0.05);
+    };
+
+    void benchmarkExtract() {
+        PerceptualColor::DominantColorExtractor extractor(m_rgbColorSpace);
+        const QImage image = threeColorImage(QSize(4000, 3000), QImage::Format_RGB32);
+        QBENCHMARK {
+            extractor.extract(image, 8);
+        }
+    };
+};
+
+QTEST_MAIN(TestDominantColorExtractor);
+#include "testdominantcolorextractor.moc" // necessary because we do not use a header file
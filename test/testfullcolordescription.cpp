@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QObject>
+#include <QtMath>
+#include "PerceptualColor/fullcolordescription.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestFullColorDescription : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testCompactSize() {
+        // LCh + RGB (each three cmsFloat64Number) + alpha + validity
+        // + the original HSV value
+        QVERIFY(
+            sizeof(PerceptualColor::FullColorDescription)
+                <= 8 * sizeof(cmsFloat64Number) + sizeof(QColor)
+        );
+    };
+
+    void testInvalid() {
+        PerceptualColor::FullColorDescription invalid1;
+        PerceptualColor::FullColorDescription invalid2(m_rgbColorSpace, QColor());
+        QCOMPARE(invalid1.isValid(), false);
+        QCOMPARE(invalid2.isValid(), false);
+        QVERIFY(invalid1 == invalid2);
+        QCOMPARE(invalid1.toRgbQColor().isValid(), false);
+    };
+
+    void testEquality() {
+        cmsCIELCh lch;
+        lch.L = 50;
+        lch.C = 20;
+        lch.h = 120;
+        PerceptualColor::FullColorDescription color1(
+            m_rgbColorSpace,
+            lch,
+            PerceptualColor::FullColorDescription::outOfGamutBehaviour::preserve
+        );
+        PerceptualColor::FullColorDescription color2 = color1;
+        QVERIFY(color1 == color2);
+        color2.setAlpha(0.5);
+        QVERIFY(color1 != color2);
+        lch.h = 121;
+        PerceptualColor::FullColorDescription color3(
+            m_rgbColorSpace,
+            lch,
+            PerceptualColor::FullColorDescription::outOfGamutBehaviour::preserve
+        );
+        QVERIFY(color1 != color3);
+        QVERIFY(color1 != PerceptualColor::FullColorDescription());
+    };
+
+    void testDerivedRepresentations() {
+        QColor rgb = QColor::fromRgbF(0.1, 0.2, 0.3, 0.4);
+        PerceptualColor::FullColorDescription color(m_rgbColorSpace, rgb);
+        QCOMPARE(color.toRgbQColor(), rgb);
+        QCOMPARE(color.toRgbQColor().spec(), QColor::Spec::Rgb);
+        QCOMPARE(color.toHsvQColor(), rgb.toHsv());
+        QCOMPARE(color.toHsvQColor().spec(), QColor::Spec::Hsv);
+        QCOMPARE(color.alpha(), rgb.alphaF());
+        cmsCIELab lab = color.toLab();
+        cmsCIELCh lch = color.toLch();
+        QVERIFY(qAbs(lab.L - lch.L) < 0.000001);
+        QVERIFY(
+            qAbs(qSqrt(lab.a * lab.a + lab.b * lab.b) - lch.C) < 0.000001
+        );
+        // HSV input is converted to RGB
+        QColor hsv = QColor::fromHsvF(0.2, 0.3, 0.4);
+        PerceptualColor::FullColorDescription color2(m_rgbColorSpace, hsv);
+        QCOMPARE(color2.toRgbQColor(), hsv.toRgb());
+    };
+
+    void testHsvInputIsPreserved() {
+        // Achromatic color with a hue
+        QColor hsv = QColor::fromHsvF(0.6, 0, 0.5, 0.7);
+        PerceptualColor::FullColorDescription color(m_rgbColorSpace, hsv);
+        QCOMPARE(color.toHsvQColor(), hsv);
+        QCOMPARE(color.toHsvQColor().hsvHueF(), hsv.hsvHueF());
+        // The alpha channel follows setAlpha()
+        color.setAlpha(0.2);
+        QCOMPARE(color.toHsvQColor().alphaF(), color.alpha());
+        QCOMPARE(color.toHsvQColor().hsvHueF(), hsv.hsvHueF());
+        // Chromatic color: No precision is lost by a RGB round trip
+        QColor hsv2 = QColor::fromHsv(359, 1, 254);
+        PerceptualColor::FullColorDescription color2(m_rgbColorSpace, hsv2);
+        QCOMPARE(color2.toHsvQColor().hsvHue(), 359);
+        QCOMPARE(color2.toHsvQColor().hsvSaturation(), 1);
+        QCOMPARE(color2.toHsvQColor().value(), 254);
+    };
+
+    void testConversionCache() {
+        cmsCIELCh lch;
+        lch.L = 50;
+        lch.C = 150; // out-of-gamut
+        lch.h = 33;
+        m_rgbColorSpace->resetConversionCacheStatistics();
+        PerceptualColor::FullColorDescription color1(
+            m_rgbColorSpace,
+            lch,
+            PerceptualColor::FullColorDescription::outOfGamutBehaviour::sacrifyChroma
+        );
+        QCOMPARE(m_rgbColorSpace->conversionCacheHits(), static_cast<quint64>(0));
+        QCOMPARE(m_rgbColorSpace->conversionCacheMisses(), static_cast<quint64>(1));
+        PerceptualColor::FullColorDescription color2(
+            m_rgbColorSpace,
+            lch,
+            PerceptualColor::FullColorDescription::outOfGamutBehaviour::sacrifyChroma
+        );
+        QCOMPARE(m_rgbColorSpace->conversionCacheHits(), static_cast<quint64>(1));
+        QVERIFY(color1 == color2);
+        QVERIFY(color2.toLch().C < lch.C);
+        // A different out-of-gamut behaviour must not hit the cache.
+        PerceptualColor::FullColorDescription color3(
+            m_rgbColorSpace,
+            lch,
+            PerceptualColor::FullColorDescription::outOfGamutBehaviour::preserve
+        );
+        QCOMPARE(color3.toLch().C, lch.C);
+        QCOMPARE(m_rgbColorSpace->conversionCacheMisses(), static_cast<quint64>(2));
+        // In-gamut values are preserved exactly on cache hits.
+        lch.C = 10;
+        PerceptualColor::FullColorDescription color4(
+            m_rgbColorSpace,
+            lch,
+            PerceptualColor::FullColorDescription::outOfGamutBehaviour::sacrifyChroma
+        );
+        lch.C = 10 + PerceptualColor::RgbColorSpace::conversionCacheQuantum / 10;
+        PerceptualColor::FullColorDescription color5(
+            m_rgbColorSpace,
+            lch,
+            PerceptualColor::FullColorDescription::outOfGamutBehaviour::sacrifyChroma
+        );
+        QCOMPARE(m_rgbColorSpace->conversionCacheHits(), static_cast<quint64>(2));
+        QCOMPARE(color5.toLch().C, lch.C);
+    };
+};
+
+QTEST_MAIN(TestFullColorDescription);
+#include "testfullcolordescription.moc" // necessary because we do not use a header file
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QObject>
+#include <QVector>
+#include "PerceptualColor/fullcolordescription.h"
+#include "PerceptualColor/gamutmapper.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestGamutMapper : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+    /** @brief A Lab image that covers in-gamut and out-of-gamut colors */
+    QVector<cmsCIELab> labImage(const QSize size) const {
+        QVector<cmsCIELab> result;
+        cmsCIELab lab;
+        for (int y = 0; y < size.height(); ++y) {
+            for (int x = 0; x < size.width(); ++x) {
+                lab.L = 100.0 * y / size.height();
+                lab.a = 200.0 * x / size.width() - 100;
+                lab.b = 100 - 200.0 * x / size.width();
+                result.append(lab);
+            }
+        }
+        return result;
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testMap() {
+        // More than one tile, and a partial last tile
+        const QVector<cmsCIELab> lab = labImage(QSize(101, 97));
+        QVector<PerceptualColor::Helper::cmsRGB> rgb(lab.count());
+        PerceptualColor::GamutMapper mapper(m_rgbColorSpace);
+        mapper.map(lab.constData(), rgb.data(), lab.count());
+        PerceptualColor::Helper::cmsRGB expected;
+        for (int i = 0; i < lab.count(); ++i) {
+            QColor exact = m_rgbColorSpace->colorRgb(lab.at(i));
+            if (exact.isValid()) {
+                expected.red = exact.redF();
+                expected.green = exact.greenF();
+                expected.blue = exact.blueF();
+            } else {
+                expected = PerceptualColor::FullColorDescription(
+                    m_rgbColorSpace,
+                    lab.at(i),
+                    PerceptualColor::FullColorDescription::outOfGamutBehaviour::sacrifyChroma
+                ).toRgb();
+            }
+            // QColor has only 16 bit precision.
+            QVERIFY(qAbs(rgb.at(i).red - expected.red) < 0.001);
+            QVERIFY(qAbs(rgb.at(i).green - expected.green) < 0.001);
+            QVERIFY(qAbs(rgb.at(i).blue - expected.blue) < 0.001);
+        }
+    };
+
+    void testMapToImage() {
+        const QSize size(67, 89);
+        const QVector<cmsCIELab> lab = labImage(size);
+        QVector<PerceptualColor::Helper::cmsRGB> rgb(lab.count());
+        PerceptualColor::GamutMapper mapper(m_rgbColorSpace);
+        mapper.map(lab.constData(), rgb.data(), lab.count());
+        const QImage image = mapper.mapToImage(lab.constData(), size);
+        QCOMPARE(image.size(), size);
+        for (int i = 0; i < lab.count(); i += 13) {
+            QCOMPARE(
+                image.pixel(i % size.width(), i / size.width()),
+                qRgb(
+                    qRound(rgb.at(i).red * 255),
+                    qRound(rgb.at(i).green * 255),
+                    qRound(rgb.at(i).blue * 255)
+                )
+            );
+        }
+        QVERIFY(mapper.mapToImage(lab.constData(), QSize(0, 0)).isNull());
+    };
+
+    void benchmarkMapToImage() {
+        const QSize size(2000, 1500);
+        const QVector<cmsCIELab> lab = labImage(size);
+        PerceptualColor::GamutMapper mapper(m_rgbColorSpace);
+        QBENCHMARK {
+            mapper.mapToImage(lab.constData(), size);
+        }
+    };
+};
+
+QTEST_MAIN(TestGamutMapper);
+#include "testgamutmapper.moc" // necessary because we do not use a header file
@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QFile>
+#include <QObject>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include "PerceptualColor/gamutmesh.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestGamutMesh : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+    PerceptualColor::GamutMesh *m_mesh = nullptr;
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+        m_mesh = new PerceptualColor::GamutMesh(m_rgbColorSpace);
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_mesh;
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testClosedSurface() {
+        QVERIFY(m_mesh->triangleCount() > 0);
+        QCOMPARE(m_mesh->triangles().count(), 3 * m_mesh->triangleCount());
+        // Each directed edge exists exactly once, and its reverse also:
+        // The mesh is closed and consistently oriented.
+        QSet<QPair<int, int>> directedEdges;
+        const QVector<int> &triangles = m_mesh->triangles();
+        for (int i = 0; i < triangles.count(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                const QPair<int, int> edge(
+                    triangles.at(i + k),
+                    triangles.at(i + (k + 1) % 3)
+                );
+                QVERIFY(!directedEdges.contains(edge));
+                directedEdges.insert(edge);
+            }
+        }
+        for (const QPair<int, int> &edge : directedEdges) {
+            QVERIFY(directedEdges.contains(qMakePair(edge.second, edge.first)));
+        }
+        // Euler characteristic of a sphere
+        QCOMPARE(
+            m_mesh->vertexCount() - directedEdges.count() / 2 + m_mesh->triangleCount(),
+            2
+        );
+    };
+
+    void testVerticesOnBoundary() {
+        QCOMPARE(m_mesh->vertexRgb().count(), m_mesh->vertexCount());
+        for (int i = 0; i < m_mesh->vertexCount(); ++i) {
+            const PerceptualColor::Helper::cmsRGB rgb = m_mesh->vertexRgb().at(i);
+            QVERIFY(
+                (rgb.red == 0) || (rgb.red == 1) ||
+                (rgb.green == 0) || (rgb.green == 1) ||
+                (rgb.blue == 0) || (rgb.blue == 1)
+            );
+            const cmsCIELab expected = m_rgbColorSpace->colorLab(rgb);
+            QCOMPARE(m_mesh->vertices().at(i).L, expected.L);
+            QCOMPARE(m_mesh->vertices().at(i).a, expected.a);
+            QCOMPARE(m_mesh->vertices().at(i).b, expected.b);
+        }
+    };
+
+    void testAdaptiveRefinement() {
+        PerceptualColor::GamutMesh coarse(m_rgbColorSpace, 4);
+        PerceptualColor::GamutMesh fine(m_rgbColorSpace, 0.25);
+        QVERIFY(coarse.triangleCount() < m_mesh->triangleCount());
+        QVERIFY(m_mesh->triangleCount() < fine.triangleCount());
+        // Without refinement, there are only the initial triangles.
+        PerceptualColor::GamutMesh initial(m_rgbColorSpace, 0.5, 3, 0);
+        QCOMPARE(initial.triangleCount(), 6 * 3 * 3 * 2);
+        QCOMPARE(initial.vertexCount(), 6 * 3 * 3 + 2);
+    };
+
+    void testBoundaryChroma() {
+        cmsCIELCh lch;
+        lch.C = PerceptualColor::Helper::LchBoundaries::physicalMaximumChroma;
+        for (int lightness = 5; lightness <= 95; lightness += 10) {
+            for (int hue = 0; hue < 360; hue += 15) {
+                lch.L = lightness;
+                lch.h = hue;
+                const cmsFloat64Number exact = m_rgbColorSpace->boundaryChroma(lch);
+                const cmsFloat64Number mesh = m_mesh->boundaryChroma(lightness, hue);
+                QVERIFY(mesh >= 0);
+                QVERIFY(qAbs(mesh - exact) < 3 * PerceptualColor::GamutMesh::defaultTolerance);
+            }
+        }
+        QCOMPARE(m_mesh->boundaryChroma(101, 0), static_cast<cmsFloat64Number>(-1));
+    };
+
+    void testBoundaryChromaConcavity() {
+        // Near yellow, the ray at this lightness leaves the gamut at
+        // about chroma 37, enters it again at about 93 and leaves it
+        // for good at about 94. The first exit counts.
+        cmsCIELCh lch;
+        lch.L = 97;
+        lch.C = PerceptualColor::Helper::LchBoundaries::physicalMaximumChroma;
+        lch.h = 99;
+        const cmsFloat64Number exact = m_rgbColorSpace->boundaryChroma(lch);
+        const cmsFloat64Number mesh = m_mesh->boundaryChroma(lch.L, lch.h);
+        QVERIFY(exact < 50);
+        QVERIFY(qAbs(mesh - exact) < 10 * PerceptualColor::GamutMesh::defaultTolerance);
+    };
+
+    void testIsInGamut() {
+        cmsCIELab lab;
+        lab.L = 50;
+        lab.a = 0;
+        lab.b = 0;
+        QVERIFY(m_mesh->isInGamut(lab));
+        lab.a = 10;
+        lab.b = -10;
+        QVERIFY(m_mesh->isInGamut(lab));
+        lab.a = 100;
+        lab.b = 100;
+        QVERIFY(!m_mesh->isInGamut(lab));
+    };
+
+    void testExport() {
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+
+        const QString plyFileName = directory.filePath("gamut.ply");
+        QVERIFY(m_mesh->exportPly(plyFileName));
+        QFile plyFile(plyFileName);
+        QVERIFY(plyFile.open(QIODevice::ReadOnly | QIODevice::Text));
+        const QString ply = QTextStream(&plyFile).readAll();
+        QVERIFY(ply.startsWith(QStringLiteral("ply\n")));
+        QVERIFY(ply.contains(
+            QStringLiteral("element vertex %1\n").arg(m_mesh->vertexCount())
+        ));
+        QVERIFY(ply.contains(
+            QStringLiteral("element face %1\n").arg(m_mesh->triangleCount())
+        ));
+
+        const QString objFileName = directory.filePath("gamut.obj");
+        QVERIFY(m_mesh->exportObj(objFileName));
+        QFile objFile(objFileName);
+        QVERIFY(objFile.open(QIODevice::ReadOnly | QIODevice::Text));
+        int vertexLines = 0;
+        int faceLines = 0;
+        QTextStream obj(&objFile);
+        QString line;
+        while (obj.readLineInto(&line)) {
+            if (line.startsWith(QStringLiteral("v "))) {
+                ++vertexLines;
+            } else if (line.startsWith(QStringLiteral("f "))) {
+                ++faceLines;
+            }
+        }
+        QCOMPARE(vertexLines, m_mesh->vertexCount());
+        QCOMPARE(faceLines, m_mesh->triangleCount());
+
+        QVERIFY(!m_mesh->exportPly(directory.filePath("missing/gamut.ply")));
+    };
+
+    void benchmarkConstruction() {
+        QBENCHMARK {
+            PerceptualColor::GamutMesh mesh(m_rgbColorSpace);
+        }
+    };
+
+    void benchmarkBoundaryChroma() {
+        cmsFloat64Number sum = 0;
+        QBENCHMARK {
+            for (int hue = 0; hue < 360; ++hue) {
+                sum += m_mesh->boundaryChroma(50, hue);
+            }
+        }
+        QVERIFY(sum > 0);
+    };
+};
+
+QTEST_MAIN(TestGamutMesh);
+#include "testgamutmesh.moc" // necessary because we do not use a header file
@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QBitArray>
+#include <QObject>
+#include <QStandardPaths>
+#include <QVector>
+#include "PerceptualColor/chromahuediagram.h"
+#include "PerceptualColor/chromalightnessdiagram.h"
+#include "PerceptualColor/gamutvolume.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestGamutVolume : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        // Do not touch the real cache of the user.
+        QStandardPaths::setTestModeEnabled(true);
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        PerceptualColor::GamutVolume::clearCache();
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testInGamut() {
+        PerceptualColor::GamutVolume volume(m_rgbColorSpace, 64);
+        QCOMPARE(volume.resolution(), 64);
+        // One bit for each grid point, and one bit for each of the 63³
+        // grid cells, rounded up to 64-bit words.
+        QCOMPARE(
+            volume.byteSize(),
+            static_cast<qint64>(64 * 64 * 64 / 8 + (63 * 63 * 63 + 63) / 64 * 8)
+        );
+        cmsCIELab lab;
+        lab.L = 50;
+        lab.a = 0;
+        lab.b = 0;
+        QVERIFY(volume.isInGamut(lab));
+        QCOMPARE(volume.coverage(lab), static_cast<qreal>(1));
+        lab.a = 100;
+        lab.b = 100;
+        QVERIFY(!volume.isInGamut(lab));
+        lab.a = volume.abRange() + 1;
+        lab.b = 0;
+        QCOMPARE(volume.coverage(lab), static_cast<qreal>(0));
+        lab.L = 101;
+        lab.a = 0;
+        QCOMPARE(volume.coverage(lab), static_cast<qreal>(0));
+    };
+
+    void testMaskScanLine() {
+        PerceptualColor::GamutVolume volume(m_rgbColorSpace, 32);
+        cmsCIELab first;
+        first.L = 60;
+        first.a = -120;
+        first.b = 30;
+        cmsCIELab step;
+        step.L = 0;
+        step.a = 0.5;
+        step.b = 0;
+        constexpr int count = 480;
+        QVector<quint8> mask(count);
+        volume.maskScanLine(first, step, mask.data(), count);
+        cmsCIELab lab = first;
+        for (int i = 0; i < count; ++i) {
+            lab.a = first.a + i * step.a;
+            QCOMPARE(mask.at(i) == 0, volume.isInGamut(lab));
+        }
+        // Rendering gives the same result as without volume.
+        QVector<QRgb> pixels(count);
+        QVector<quint8> renderMask(count);
+        volume.renderScanLine(
+            m_rgbColorSpace,
+            first,
+            step,
+            pixels.data(),
+            count,
+            PerceptualColor::RgbColorSpace::TransformPrecision::float32,
+            renderMask.data()
+        );
+        QVector<QRgb> exactPixels(count);
+        QVector<quint8> exactMask(count);
+        m_rgbColorSpace->colorRgbScanLine(
+            first,
+            step,
+            exactPixels.data(),
+            count,
+            PerceptualColor::RgbColorSpace::TransformPrecision::float32,
+            exactMask.data()
+        );
+        QCOMPARE(renderMask, exactMask);
+        QCOMPARE(pixels, exactPixels);
+    };
+
+    void testForColorSpace() {
+        QSharedPointer<const PerceptualColor::GamutVolume> first =
+            PerceptualColor::GamutVolume::forColorSpace(m_rgbColorSpace, 16);
+        QSharedPointer<const PerceptualColor::GamutVolume> second =
+            PerceptualColor::GamutVolume::forColorSpace(m_rgbColorSpace, 16);
+        QVERIFY(first.data() == second.data());
+        QSharedPointer<const PerceptualColor::GamutVolume> other =
+            PerceptualColor::GamutVolume::forColorSpace(m_rgbColorSpace, 17);
+        QVERIFY(first.data() != other.data());
+        PerceptualColor::GamutVolume::clearCache();
+        QSharedPointer<const PerceptualColor::GamutVolume> third =
+            PerceptualColor::GamutVolume::forColorSpace(m_rgbColorSpace, 16);
+        QVERIFY(first.data() != third.data());
+        QCOMPARE(first->resolution(), 16);
+    };
+
+    void testAccuracyReport() {
+        PerceptualColor::GamutVolume coarse(m_rgbColorSpace, 16);
+        PerceptualColor::GamutVolume fine(m_rgbColorSpace, 64);
+        const PerceptualColor::GamutVolume::AccuracyReport coarseReport =
+            coarse.accuracyReport(m_rgbColorSpace);
+        const PerceptualColor::GamutVolume::AccuracyReport fineReport =
+            fine.accuracyReport(m_rgbColorSpace);
+        QVERIFY(fineReport.boundarySamples > 0);
+        QCOMPARE(fineReport.classifiedColors, 63 * 63 * 63);
+        // The boundary is precise to about one grid spacing.
+        const qreal gridSpacing = 2 * fine.abRange() / 63;
+        QVERIFY(fineReport.meanChromaError < gridSpacing);
+        QVERIFY(fineReport.maximumChromaError >= fineReport.meanChromaError);
+        QVERIFY(fineReport.misclassifiedColors * 20 < fineReport.classifiedColors);
+        // A finer grid is more precise.
+        QVERIFY(fineReport.meanChromaError < coarseReport.meanChromaError);
+    };
+
+    void testDiagram() {
+        QSharedPointer<const PerceptualColor::GamutVolume> volume =
+            PerceptualColor::GamutVolume::forColorSpace(m_rgbColorSpace);
+        QBitArray exactMask;
+        QBitArray volumeMask;
+        QImage exactImage;
+        QImage volumeImage;
+        // Also the cells where all grid points are out-of-gamut, but a thin
+        // part of the gamut passes between them, are rendered exactly.
+        for (int lightness = 1; lightness < 100; ++lightness) {
+            exactImage =
+                PerceptualColor::ChromaHueDiagram::generateDiagramImage(
+                    m_rgbColorSpace,
+                    201,
+                    150,
+                    lightness,
+                    0,
+                    PerceptualColor::RgbColorSpace::TransformPrecision::float32,
+                    &exactMask
+                );
+            volumeImage =
+                PerceptualColor::ChromaHueDiagram::generateDiagramImage(
+                    m_rgbColorSpace,
+                    201,
+                    150,
+                    lightness,
+                    0,
+                    PerceptualColor::RgbColorSpace::TransformPrecision::float32,
+                    &volumeMask,
+                    volume.data()
+                );
+            QCOMPARE(volumeMask, exactMask);
+            QCOMPARE(volumeImage, exactImage);
+        }
+        for (int hue = 0; hue < 360; hue += 5) {
+            exactImage =
+                PerceptualColor::ChromaLightnessDiagram::generateDiagramImage(
+                    m_rgbColorSpace,
+                    hue,
+                    QSize(150, 101),
+                    PerceptualColor::RgbColorSpace::TransformPrecision::float32,
+                    &exactMask
+                );
+            volumeImage =
+                PerceptualColor::ChromaLightnessDiagram::generateDiagramImage(
+                    m_rgbColorSpace,
+                    hue,
+                    QSize(150, 101),
+                    PerceptualColor::RgbColorSpace::TransformPrecision::float32,
+                    &volumeMask,
+                    volume.data()
+                );
+            QCOMPARE(volumeMask, exactMask);
+            QCOMPARE(volumeImage, exactImage);
+        }
+    };
+
+    void testColorSpaceVolume() {
+        PerceptualColor::GamutVolume::clearCache();
+        // The first call starts the build in the background.
+        QVERIFY(m_rgbColorSpace->gamutVolume().isNull());
+        QTRY_VERIFY_WITH_TIMEOUT(
+            !m_rgbColorSpace->gamutVolume().isNull(),
+            60000
+        );
+        QSharedPointer<const PerceptualColor::GamutVolume> volume =
+            m_rgbColorSpace->gamutVolume();
+        QCOMPARE(
+            volume->resolution(),
+            PerceptualColor::GamutVolume::defaultResolution
+        );
+        QVERIFY(
+            volume.data()
+                == PerceptualColor::GamutVolume::forColorSpace(m_rgbColorSpace).data()
+        );
+        // A color space that is destroyed during the build waits for it.
+        PerceptualColor::GamutVolume::clearCache();
+        PerceptualColor::RgbColorSpace *temporary =
+            new PerceptualColor::RgbColorSpace();
+        QVERIFY(temporary->gamutVolume().isNull());
+        delete temporary;
+    };
+
+    void benchmarkConstruction() {
+        QBENCHMARK {
+            PerceptualColor::GamutVolume volume(m_rgbColorSpace);
+        }
+    };
+
+    void benchmarkDiagram_data() {
+        QTest::addColumn<bool>("useVolume");
+        QTest::newRow("transform") << false;
+        QTest::newRow("volume") << true;
+    };
+
+    void benchmarkDiagram() {
+        QFETCH(bool, useVolume);
+        QSharedPointer<const PerceptualColor::GamutVolume> volume =
+            PerceptualColor::GamutVolume::forColorSpace(m_rgbColorSpace);
+        QBENCHMARK {
+            PerceptualColor::ChromaHueDiagram::generateDiagramImage(
+                m_rgbColorSpace,
+                400,
+                150,
+                80,
+                0,
+                PerceptualColor::RgbColorSpace::TransformPrecision::float32,
+                nullptr,
+                useVolume ? volume.data() : nullptr
+            );
+        }
+    };
+};
+
+QTEST_MAIN(TestGamutVolume);
+#include "testgamutvolume.moc" // necessary because we do not use a header file
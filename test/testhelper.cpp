@@ -188,6 +188,49 @@ private Q_SLOTS:
         QCOMPARE(PerceptualColor::Helper::inRange<double>(-3, -4, -1), false);
         QCOMPARE(PerceptualColor::Helper::inRange<double>(-3, 0, -1), false);
     };
+
+    void testCacheDevicePixelRatio() {
+        QWidget widget;
+        // Within the budget, the native ratio of the screen is used.
+        QCOMPARE(
+            PerceptualColor::Helper::cacheDevicePixelRatio(
+                &widget,
+                QSize(100, 100)
+            ),
+            qMax(widget.devicePixelRatioF(), static_cast<qreal>(1))
+        );
+        // Above the budget, the cache is rendered at logical resolution.
+        QCOMPARE(
+            PerceptualColor::Helper::cacheDevicePixelRatio(
+                &widget,
+                QSize(5000, 5000)
+            ),
+            static_cast<qreal>(1)
+        );
+    };
+
+    void testCacheDevicePixelRatioHighDpi() {
+        // A QImage can have a device pixel ratio above 1 independently of
+        // the screens of the test system.
+        QImage device(1, 1, QImage::Format_ARGB32_Premultiplied);
+        device.setDevicePixelRatio(2);
+        const QSize smallSize(100, 100);
+        const qreal smallRatio =
+            PerceptualColor::Helper::cacheDevicePixelRatio(&device, smallSize);
+        QCOMPARE(smallRatio, static_cast<qreal>(2));
+        QCOMPARE((smallSize * smallRatio), QSize(200, 200));
+        // 1500 × 1500 × 2² device pixels exceed the budget, but
+        // 1500 × 1500 logical pixels do not.
+        const QSize largeSize(1500, 1500);
+        QVERIFY(
+            qint64(largeSize.width()) * largeSize.height()
+                <= PerceptualColor::Helper::renderCostBudget
+        );
+        const qreal largeRatio =
+            PerceptualColor::Helper::cacheDevicePixelRatio(&device, largeSize);
+        QCOMPARE(largeRatio, static_cast<qreal>(1));
+        QCOMPARE((largeSize * largeRatio), largeSize);
+    };
 };
 
 QTEST_MAIN(TestHelper);
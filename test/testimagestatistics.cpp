@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QObject>
+#include <QPainter>
+#include "PerceptualColor/imagestatistics.h"
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestImageStatistics : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+    quint64 sum(const QVector<quint64> &histogram) const {
+        quint64 result = 0;
+        for (const quint64 value : histogram) {
+            result += value;
+        }
+        return result;
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testScanLine() {
+        PerceptualColor::ImageStatistics statistics(m_rgbColorSpace);
+        const QVector<QRgb> line {
+            qRgb(128, 128, 128),   // gray: achromatic
+            qRgb(255, 0, 0),       // red: near the boundary
+            qRgba(0, 0, 255, 0)    // transparent: ignored
+        };
+        statistics.addScanLine(line.constData(), line.count());
+        QCOMPARE(statistics.pixelCount(), static_cast<quint64>(2));
+        QCOMPARE(sum(statistics.lightnessHistogram()), static_cast<quint64>(2));
+        QCOMPARE(sum(statistics.chromaHistogram()), static_cast<quint64>(2));
+        QCOMPARE(sum(statistics.hueHistogram()), static_cast<quint64>(1));
+        QCOMPARE(statistics.nearBoundaryShare(), 0.5);
+        const cmsCIELCh red = PerceptualColor::Helper::toLch(
+            m_rgbColorSpace->colorLab(QColor(255, 0, 0))
+        );
+        const int sector = static_cast<int>(
+            red.h * PerceptualColor::ImageStatistics::hueSectorCount / 360
+        );
+        QVERIFY(qAbs(statistics.maximumChromaPerHueSector().at(sector) - red.C) < 0.000001);
+    };
+
+    void testImageEqualsScanLines() {
+        QImage image(123, 77, QImage::Format_ARGB32);
+        for (int y = 0; y < image.height(); ++y) {
+            for (int x = 0; x < image.width(); ++x) {
+                image.setPixel(x, y, qRgba(x * 2, y * 3, (x + y) % 256, 255));
+            }
+        }
+        PerceptualColor::ImageStatistics parallel(m_rgbColorSpace);
+        parallel.addImage(image);
+        PerceptualColor::ImageStatistics serial(m_rgbColorSpace);
+        for (int y = 0; y < image.height(); ++y) {
+            serial.addScanLine(
+                reinterpret_cast<const QRgb *>(image.constScanLine(y)),
+                image.width()
+            );
+        }
+        QCOMPARE(parallel.pixelCount(), static_cast<quint64>(123 * 77));
+        QCOMPARE(parallel.lightnessHistogram(), serial.lightnessHistogram());
+        QCOMPARE(parallel.chromaHistogram(), serial.chromaHistogram());
+        QCOMPARE(parallel.hueHistogram(), serial.hueHistogram());
+        QCOMPARE(parallel.maximumChromaPerHueSector(), serial.maximumChromaPerHueSector());
+        QCOMPARE(parallel.nearBoundaryShare(), serial.nearBoundaryShare());
+        // Other image formats
+        PerceptualColor::ImageStatistics converted(m_rgbColorSpace);
+        converted.addImage(image.convertToFormat(QImage::Format_RGB888));
+        QCOMPARE(converted.lightnessHistogram(), serial.lightnessHistogram());
+        QCOMPARE(converted.chromaHistogram(), serial.chromaHistogram());
+        QCOMPARE(converted.hueHistogram(), serial.hueHistogram());
+        QCOMPARE(converted.maximumChromaPerHueSector(), serial.maximumChromaPerHueSector());
+        QCOMPARE(converted.nearBoundaryShare(), serial.nearBoundaryShare());
+        QImage indexed(5, 3, QImage::Format_Indexed8);
+        indexed.setColorTable({qRgb(255, 0, 0), qRgb(0, 0, 255)});
+        indexed.fill(1);
+        indexed.setPixel(0, 0, 0);
+        PerceptualColor::ImageStatistics indexedStatistics(m_rgbColorSpace);
+        indexedStatistics.addImage(indexed);
+        QCOMPARE(indexedStatistics.pixelCount(), static_cast<quint64>(15));
+        const QRgb blue = qRgb(0, 0, 255);
+        PerceptualColor::ImageStatistics blueStatistics(m_rgbColorSpace);
+        blueStatistics.addScanLine(&blue, 1);
+        const int blueLightness =
+            blueStatistics.lightnessHistogram().indexOf(1);
+        QCOMPARE(
+            indexedStatistics.lightnessHistogram().at(blueLightness),
+            static_cast<quint64>(14)
+        );
+    };
+
+    void testConversionSlices() {
+        // So wide that each row is converted on its own
+        const int width = PerceptualColor::ImageStatistics::conversionPixelCount + 7;
+        QImage image(width, 5, QImage::Format_RGB888);
+        image.fill(QColor(10, 200, 30));
+        for (int y = 0; y < image.height(); ++y) {
+            image.setPixel(y, y, qRgb(250, 250, 250));
+        }
+        PerceptualColor::ImageStatistics statistics(m_rgbColorSpace);
+        statistics.addImage(image);
+        PerceptualColor::ImageStatistics reference(m_rgbColorSpace);
+        const QImage argb = image.convertToFormat(QImage::Format_ARGB32);
+        for (int y = 0; y < argb.height(); ++y) {
+            reference.addScanLine(
+                reinterpret_cast<const QRgb *>(argb.constScanLine(y)),
+                argb.width()
+            );
+        }
+        QCOMPARE(statistics.pixelCount(), static_cast<quint64>(width) * 5);
+        QCOMPARE(statistics.lightnessHistogram(), reference.lightnessHistogram());
+        QCOMPARE(statistics.hueHistogram(), reference.hueHistogram());
+    };
+
+    void testReset() {
+        PerceptualColor::ImageStatistics statistics(m_rgbColorSpace);
+        const QRgb pixel = qRgb(10, 20, 30);
+        statistics.addScanLine(&pixel, 1);
+        statistics.reset();
+        QCOMPARE(statistics.pixelCount(), static_cast<quint64>(0));
+        QCOMPARE(sum(statistics.lightnessHistogram()), static_cast<quint64>(0));
+        QCOMPARE(statistics.nearBoundaryShare(), static_cast<qreal>(0));
+    };
+
+    void benchmarkAddImage() {
+        QImage image(3000, 2000, QImage::Format_RGB32);
+        QPainter painter(&image);
+        QLinearGradient gradient(0, 0, 3000, 2000);
+        gradient.setColorAt(0, Qt::red);
+        gradient.setColorAt(0.5, Qt::green);
+        gradient.setColorAt(1, Qt::blue);
+        painter.fillRect(image.rect(), gradient);
+        painter.end();
+        QBENCHMARK {
+            PerceptualColor::ImageStatistics statistics(m_rgbColorSpace);
+            statistics.addImage(image);
+        }
+    };
+};
+
+QTEST_MAIN(TestImageStatistics);
+#include "testimagestatistics.moc" // necessary because we do not use a header file
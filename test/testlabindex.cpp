@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <QTest>
+#include <QObject>
+#include <QVector>
+#include <QtMath>
+#include "PerceptualColor/colordifference.h"
+#include "PerceptualColor/labindex.h"
+
+class TestLabIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    /** @brief A deterministic pseudo-random palette, with some duplicates */
+    QVector<cmsCIELab> m_palette;
+
+    /** @brief All palette entries, sorted by ΔE*76 to @em lab (brute force) */
+    QVector<PerceptualColor::LabIndex::Match> bruteForce(const cmsCIELab &lab) const {
+        QVector<PerceptualColor::LabIndex::Match> result;
+        for (int i = 0; i < m_palette.count(); ++i) {
+            result.append(PerceptualColor::LabIndex::Match {
+                i,
+                PerceptualColor::ColorDifference::deltaE76(lab, m_palette.at(i))
+            });
+        }
+        std::sort(
+            result.begin(),
+            result.end(),
+            [](const PerceptualColor::LabIndex::Match &first, const PerceptualColor::LabIndex::Match &second) {
+                if (first.deltaE != second.deltaE) {
+                    return first.deltaE < second.deltaE;
+                }
+                return first.index < second.index;
+            }
+        );
+        return result;
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        for (int i = 0; i < 3000; ++i) {
+            m_palette.append(cmsCIELab {
+                static_cast<cmsFloat64Number>((i * 37) % 101),
+                static_cast<cmsFloat64Number>((i * 53) % 201 - 100),
+                static_cast<cmsFloat64Number>((i * 71) % 197 - 98)
+            });
+        }
+        for (int i = 0; i < 20; ++i) {
+            m_palette.append(m_palette.at(i));
+        }
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testEmpty() {
+        PerceptualColor::LabIndex index;
+        QCOMPARE(index.count(), 0);
+        QCOMPARE(index.nearest(cmsCIELab {50, 0, 0}, 3).count(), 0);
+        QCOMPARE(index.withinRadius(cmsCIELab {50, 0, 0}, 10).count(), 0);
+    };
+
+    void testNearest() {
+        PerceptualColor::LabIndex index(m_palette);
+        QCOMPARE(index.count(), m_palette.count());
+        for (int i = 0; i < 50; ++i) {
+            const cmsCIELab query {i * 2.0, i * 3.0 - 70, 60 - i * 2.5};
+            const auto expected = bruteForce(query);
+            const auto actual = index.nearest(query, 5);
+            QCOMPARE(actual.count(), 5);
+            for (int j = 0; j < actual.count(); ++j) {
+                QCOMPARE(actual.at(j).index, expected.at(j).index);
+                QCOMPARE(actual.at(j).deltaE, expected.at(j).deltaE);
+            }
+        }
+    };
+
+    void testWithinRadius() {
+        PerceptualColor::LabIndex index(m_palette);
+        for (int i = 0; i < 50; ++i) {
+            const cmsCIELab query {i * 2.0, 50 - i * 3.0, i * 2.5 - 60};
+            const auto expected = bruteForce(query);
+            const auto actual = index.withinRadius(query, 12);
+            int expectedCount = 0;
+            while ((expectedCount < expected.count()) && (expected.at(expectedCount).deltaE <= 12)) {
+                ++expectedCount;
+            }
+            QCOMPARE(actual.count(), expectedCount);
+            for (int j = 0; j < actual.count(); ++j) {
+                QCOMPARE(actual.at(j).index, expected.at(j).index);
+            }
+        }
+    };
+
+    void testNearestDeltaE2000() {
+        PerceptualColor::LabIndex index(m_palette);
+        const cmsCIELab query {40, 20, -30};
+        const auto actual = index.nearestDeltaE2000(query, 3);
+        QCOMPARE(actual.count(), 3);
+        for (int j = 0; j < actual.count(); ++j) {
+            QCOMPARE(
+                actual.at(j).deltaE,
+                PerceptualColor::ColorDifference::deltaE2000(query, m_palette.at(actual.at(j).index))
+            );
+            if (j > 0) {
+                QVERIFY(actual.at(j - 1).deltaE <= actual.at(j).deltaE);
+            }
+        }
+    };
+
+    void benchmarkNearest() {
+        QVector<cmsCIELab> palette;
+        for (int i = 0; i < 100000; ++i) {
+            palette.append(cmsCIELab {
+                static_cast<cmsFloat64Number>((i * 37) % 1001) / 10,
+                static_cast<cmsFloat64Number>((i * 53) % 2001) / 10 - 100,
+                static_cast<cmsFloat64Number>((i * 71) % 1997) / 10 - 100
+            });
+        }
+        PerceptualColor::LabIndex index(palette);
+        QBENCHMARK {
+            index.nearestDeltaE2000(cmsCIELab {40, 20, -30}, 1);
+        }
+    };
+};
+
+QTEST_MAIN(TestLabIndex);
+#include "testlabindex.moc" // necessary because we do not use a header file
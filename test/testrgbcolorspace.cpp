@@ -0,0 +1,732 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer somerluk@gmail.com
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <QTest>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QImage>
+#include <QObject>
+#include <QSharedMemory>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QVector>
+#include "PerceptualColor/rgbcolorspace.h"
+
+class TestRgbColorSpace : public QObject
+{
+    Q_OBJECT
+
+private:
+    PerceptualColor::RgbColorSpace *m_rgbColorSpace = nullptr;
+
+    /** @brief Sample of out-of-gamut (and some in-gamut) LCh values */
+    QList<cmsCIELCh> boundarySamples() const {
+        QList<cmsCIELCh> result;
+        cmsCIELCh lch;
+        for (int lightness = 5; lightness <= 95; lightness += 10) {
+            for (int hue = 0; hue < 360; hue += 15) {
+                for (int chroma = 10; chroma <= 130; chroma += 40) {
+                    lch.L = lightness;
+                    lch.C = chroma;
+                    lch.h = hue;
+                    result.append(lch);
+                }
+            }
+        }
+        return result;
+    }
+
+    int totalTransformCount(
+        const PerceptualColor::RgbColorSpace::BoundarySearch algorithm
+    ) const {
+        int total = 0;
+        int count;
+        for (const cmsCIELCh &lch : boundarySamples()) {
+            m_rgbColorSpace->boundaryChroma(lch, algorithm, &count);
+            total += count;
+        }
+        return total;
+    }
+
+    /** @brief Writes an RGB profile whose PCS is CIELab
+     * 
+     * Both directions consist only of tone curves and a matrix. Unlike
+     * matrix/shaper profiles like sRGB, which need a conversion between
+     * CIEXYZ and CIELab, LittleCMS can therefore store the transforms of
+     * this profile as device links without resampling them.
+     * 
+     * @param fileName the file to write
+     * @returns @c true on success */
+    static bool writeLabMatrixProfile(const QString &fileName) {
+        // From RGB to the encoded CIELab of the PCS:
+        // L/100, (a+128)/255 and (b+128)/255
+        const cmsFloat64Number matrix[9] = {
+            0.3, 0.6, 0.1,
+            0.3, -0.3, 0,
+            0, 0.3, -0.3
+        };
+        const cmsFloat64Number offset[3] = {0, 128.0 / 255, 128.0 / 255};
+        const cmsFloat64Number inverseMatrix[9] = {
+            1, 7.0 / 3, 1.0 / 3,
+            1, -1, 1.0 / 3,
+            1, -1, -3
+        };
+        cmsFloat64Number inverseOffset[3];
+        for (int i = 0; i < 3; ++i) {
+            inverseOffset[i] = -(inverseMatrix[3 * i] * offset[0]
+                + inverseMatrix[3 * i + 1] * offset[1]
+                + inverseMatrix[3 * i + 2] * offset[2]);
+        }
+        cmsToneCurve *gamma[3];
+        cmsToneCurve *inverseGamma[3];
+        cmsToneCurve *identity[3];
+        for (int i = 0; i < 3; ++i) {
+            gamma[i] = cmsBuildGamma(nullptr, 2.2);
+            inverseGamma[i] = cmsBuildGamma(nullptr, 1 / 2.2);
+            identity[i] = cmsBuildGamma(nullptr, 1);
+        }
+        cmsPipeline *rgbToLab = cmsPipelineAlloc(nullptr, 3, 3);
+        cmsPipelineInsertStage(
+            rgbToLab,
+            cmsAT_END,
+            cmsStageAllocToneCurves(nullptr, 3, gamma)
+        );
+        cmsPipelineInsertStage(
+            rgbToLab,
+            cmsAT_END,
+            cmsStageAllocMatrix(nullptr, 3, 3, matrix, offset)
+        );
+        cmsPipelineInsertStage(
+            rgbToLab,
+            cmsAT_END,
+            cmsStageAllocToneCurves(nullptr, 3, identity)
+        );
+        cmsPipeline *labToRgb = cmsPipelineAlloc(nullptr, 3, 3);
+        cmsPipelineInsertStage(
+            labToRgb,
+            cmsAT_END,
+            cmsStageAllocToneCurves(nullptr, 3, identity)
+        );
+        cmsPipelineInsertStage(
+            labToRgb,
+            cmsAT_END,
+            cmsStageAllocMatrix(nullptr, 3, 3, inverseMatrix, inverseOffset)
+        );
+        cmsPipelineInsertStage(
+            labToRgb,
+            cmsAT_END,
+            cmsStageAllocToneCurves(nullptr, 3, inverseGamma)
+        );
+        cmsFreeToneCurveTriple(gamma);
+        cmsFreeToneCurveTriple(inverseGamma);
+        cmsFreeToneCurveTriple(identity);
+
+        cmsHPROFILE profile = cmsCreateProfilePlaceholder(nullptr);
+        cmsSetProfileVersion(profile, 4.3);
+        cmsSetDeviceClass(profile, cmsSigDisplayClass);
+        cmsSetColorSpace(profile, cmsSigRgbData);
+        cmsSetPCS(profile, cmsSigLabData);
+        bool result = cmsWriteTag(profile, cmsSigMediaWhitePointTag, cmsD50_XYZ())
+            && cmsWriteTag(profile, cmsSigAToB0Tag, rgbToLab)
+            && cmsWriteTag(profile, cmsSigBToA0Tag, labToRgb)
+            && cmsMD5computeID(profile)
+            && cmsSaveProfileToFile(profile, fileName.toLocal8Bit().constData());
+        cmsCloseProfile(profile);
+        cmsPipelineFree(rgbToLab);
+        cmsPipelineFree(labToRgb);
+        return result;
+    }
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Called before the first testfunction is executed
+        // Do not touch the real cache of the user.
+        QStandardPaths::setTestModeEnabled(true);
+        m_rgbColorSpace = new PerceptualColor::RgbColorSpace();
+    };
+    void cleanupTestCase() {
+        // Called after the last testfunction was executed
+        delete m_rgbColorSpace;
+    };
+
+    void init() {
+        // Called before each testfunction is executed
+    };
+    void cleanup() {
+        // Called after every testfunction
+    };
+
+    void testBoundaryChroma() {
+        cmsFloat64Number illinois;
+        cmsFloat64Number bisection;
+        cmsCIELCh candidate;
+        for (const cmsCIELCh &lch : boundarySamples()) {
+            illinois = m_rgbColorSpace->boundaryChroma(
+                lch,
+                PerceptualColor::RgbColorSpace::BoundarySearch::illinois
+            );
+            bisection = m_rgbColorSpace->boundaryChroma(
+                lch,
+                PerceptualColor::RgbColorSpace::BoundarySearch::bisection
+            );
+            if (bisection < 0) {
+                QCOMPARE(illinois, bisection);
+                continue;
+            }
+            QVERIFY(illinois >= 0);
+            QVERIFY(illinois <= lch.C);
+            QVERIFY(
+                qAbs(illinois - bisection) <= PerceptualColor::Helper::gamutPrecision
+            );
+            candidate = lch;
+            candidate.C = illinois;
+            QVERIFY(m_rgbColorSpace->inGamut(candidate));
+            if (illinois < lch.C) {
+                candidate.C = illinois + PerceptualColor::Helper::gamutPrecision;
+                QVERIFY(!m_rgbColorSpace->inGamut(candidate));
+            }
+        }
+    };
+
+    void testBoundaryChromaInGamut() {
+        cmsCIELCh lch;
+        lch.L = 50;
+        lch.C = 5;
+        lch.h = 30;
+        int count;
+        QCOMPARE(
+            m_rgbColorSpace->boundaryChroma(
+                lch,
+                PerceptualColor::RgbColorSpace::BoundarySearch::illinois,
+                &count
+            ),
+            lch.C
+        );
+        QCOMPARE(count, 1);
+    };
+
+    void testBoundaryChromaTransformCount() {
+        const int illinois = totalTransformCount(
+            PerceptualColor::RgbColorSpace::BoundarySearch::illinois
+        );
+        const int bisection = totalTransformCount(
+            PerceptualColor::RgbColorSpace::BoundarySearch::bisection
+        );
+        QVERIFY(illinois < bisection);
+    };
+
+    void testBatchConversion() {
+        QVector<cmsCIELab> lab;
+        for (const cmsCIELCh &lch : boundarySamples()) {
+            lab.append(PerceptualColor::Helper::toLab(lch));
+        }
+        QVector<PerceptualColor::Helper::cmsRGB> rgb(lab.count());
+        m_rgbColorSpace->colorRgbBoundSimple(lab.constData(), rgb.data(), lab.count());
+        PerceptualColor::Helper::cmsRGB single;
+        for (int i = 0; i < lab.count(); ++i) {
+            single = m_rgbColorSpace->colorRgbBoundSimple(lab.at(i));
+            QCOMPARE(rgb.at(i).red, single.red);
+            QCOMPARE(rgb.at(i).green, single.green);
+            QCOMPARE(rgb.at(i).blue, single.blue);
+        }
+        QVector<cmsCIELab> roundTrip(rgb.count());
+        m_rgbColorSpace->colorLab(rgb.constData(), roundTrip.data(), rgb.count());
+        cmsCIELab singleLab;
+        for (int i = 0; i < rgb.count(); ++i) {
+            singleLab = m_rgbColorSpace->colorLab(rgb.at(i));
+            QCOMPARE(roundTrip.at(i).L, singleLab.L);
+            QCOMPARE(roundTrip.at(i).a, singleLab.a);
+            QCOMPARE(roundTrip.at(i).b, singleLab.b);
+        }
+    };
+
+    void testScanLinePrecision() {
+        QVector<cmsCIELab> lab;
+        cmsCIELab temp;
+        for (int L = 0; L <= 100; L += 5) {
+            for (int a = -120; a <= 120; a += 10) {
+                for (int b = -120; b <= 120; b += 10) {
+                    temp.L = L;
+                    temp.a = a;
+                    temp.b = b;
+                    lab.append(temp);
+                }
+            }
+        }
+        QVector<QRgb> float64(lab.count());
+        QVector<QRgb> float32(lab.count());
+        m_rgbColorSpace->colorRgbScanLine(
+            lab.constData(),
+            float64.data(),
+            lab.count(),
+            PerceptualColor::RgbColorSpace::TransformPrecision::float64
+        );
+        m_rgbColorSpace->colorRgbScanLine(
+            lab.constData(),
+            float32.data(),
+            lab.count(),
+            PerceptualColor::RgbColorSpace::TransformPrecision::float32
+        );
+        QColor single;
+        for (int i = 0; i < lab.count(); ++i) {
+            single = m_rgbColorSpace->colorRgb(lab.at(i));
+            QCOMPARE(qAlpha(float64.at(i)) == 255, single.isValid());
+            if (single.isValid()) {
+                QVERIFY(qAbs(qRed(float64.at(i)) - single.red()) <= 1);
+                QVERIFY(qAbs(qGreen(float64.at(i)) - single.green()) <= 1);
+                QVERIFY(qAbs(qBlue(float64.at(i)) - single.blue()) <= 1);
+            }
+            // Single precision may only differ by one 8-bit step.
+            QCOMPARE(qAlpha(float32.at(i)), qAlpha(float64.at(i)));
+            QVERIFY(qAbs(qRed(float32.at(i)) - qRed(float64.at(i))) <= 1);
+            QVERIFY(qAbs(qGreen(float32.at(i)) - qGreen(float64.at(i))) <= 1);
+            QVERIFY(qAbs(qBlue(float32.at(i)) - qBlue(float64.at(i))) <= 1);
+        }
+    };
+
+    void testScanLineIncremental() {
+        constexpr int count = 1000;
+        cmsCIELab first;
+        first.L = 50;
+        first.a = -150;
+        first.b = 20;
+        cmsCIELab step;
+        step.L = 0.01;
+        step.a = 0.3;
+        step.b = -0.05;
+        QVector<cmsCIELab> lab(count);
+        for (int i = 0; i < count; ++i) {
+            lab[i].L = first.L + i * step.L;
+            lab[i].a = first.a + i * step.a;
+            lab[i].b = first.b + i * step.b;
+        }
+        QVector<QRgb> expected(count);
+        QVector<QRgb> actual(count);
+        QVector<quint8> mask(count);
+        m_rgbColorSpace->colorRgbScanLine(
+            lab.constData(),
+            expected.data(),
+            count
+        );
+        m_rgbColorSpace->colorRgbScanLine(
+            first,
+            step,
+            actual.data(),
+            count,
+            PerceptualColor::RgbColorSpace::TransformPrecision::float32,
+            mask.data()
+        );
+        bool hasInGamut = false;
+        bool hasOutOfGamut = false;
+        for (int i = 0; i < count; ++i) {
+            QCOMPARE(qAlpha(actual.at(i)), qAlpha(expected.at(i)));
+            QVERIFY(qAbs(qRed(actual.at(i)) - qRed(expected.at(i))) <= 1);
+            QVERIFY(qAbs(qGreen(actual.at(i)) - qGreen(expected.at(i))) <= 1);
+            QVERIFY(qAbs(qBlue(actual.at(i)) - qBlue(expected.at(i))) <= 1);
+            QCOMPARE(mask.at(i) == 1, qAlpha(actual.at(i)) == 0);
+            hasInGamut = hasInGamut || (mask.at(i) == 0);
+            hasOutOfGamut = hasOutOfGamut || (mask.at(i) == 1);
+        }
+        QVERIFY(hasInGamut);
+        QVERIFY(hasOutOfGamut);
+    };
+
+    void testAntialiasGamutBoundary() {
+        constexpr int size = 32;
+        constexpr qreal range = 150;
+        const auto pixelToLab = [](const qreal x, const qreal y) {
+            cmsCIELab Lab;
+            Lab.L = 50;
+            Lab.a = (x + 0.5) / size * 2 * range - range;
+            Lab.b = range - (y + 0.5) / size * 2 * range;
+            return Lab;
+        };
+        QImage image(size, size, QImage::Format_ARGB32);
+        QVector<quint8> mask(size * size);
+        QVector<cmsCIELab> lab(size);
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                lab[x] = pixelToLab(x, y);
+            }
+            m_rgbColorSpace->colorRgbScanLine(
+                lab.constData(),
+                reinterpret_cast<QRgb *>(image.scanLine(y)),
+                size,
+                PerceptualColor::RgbColorSpace::TransformPrecision::float32,
+                mask.data() + y * size
+            );
+        }
+        const QImage original = image;
+        m_rgbColorSpace->antialiasGamutBoundary(&image, mask, pixelToLab);
+        bool hasPartialAlpha = false;
+        bool isBoundary;
+        int index;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                index = y * size + x;
+                isBoundary =
+                    ((x > 0) && (mask.at(index - 1) != mask.at(index)))
+                    || ((x < size - 1) && (mask.at(index + 1) != mask.at(index)))
+                    || ((y > 0) && (mask.at(index - size) != mask.at(index)))
+                    || ((y < size - 1) && (mask.at(index + size) != mask.at(index)));
+                if (!isBoundary) {
+                    // Pixels away from the gamut boundary are unchanged.
+                    QCOMPARE(image.pixel(x, y), original.pixel(x, y));
+                }
+                hasPartialAlpha = hasPartialAlpha
+                    || ((qAlpha(image.pixel(x, y)) > 0)
+                        && (qAlpha(image.pixel(x, y)) < 255));
+            }
+        }
+        QVERIFY(hasPartialAlpha);
+    };
+
+    void testProfileFile() {
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QString fileName = directory.filePath("srgb.icc");
+        cmsHPROFILE profile = cmsCreate_sRGBProfile();
+        QVERIFY(cmsSaveProfileToFile(profile, fileName.toLocal8Bit().constData()));
+        cmsCloseProfile(profile);
+
+        PerceptualColor::RgbColorSpace fromFile(fileName);
+        QCOMPARE(fromFile.profileId().size(), 16);
+        // The MD5 ID does not depend on where the profile comes from.
+        QCOMPARE(fromFile.profileId(), m_rgbColorSpace->profileId());
+        QCOMPARE(fromFile.blackpointL(), m_rgbColorSpace->blackpointL());
+        QCOMPARE(fromFile.whitepointL(), m_rgbColorSpace->whitepointL());
+        cmsCIELab lab;
+        lab.L = 60;
+        lab.a = 20;
+        lab.b = -30;
+        QCOMPARE(fromFile.colorRgb(lab), m_rgbColorSpace->colorRgb(lab));
+
+        // Reopening the same file gives the same results.
+        PerceptualColor::RgbColorSpace again(fileName);
+        QCOMPARE(again.profileId(), fromFile.profileId());
+        QCOMPARE(again.colorRgb(lab), fromFile.colorRgb(lab));
+    };
+
+    void testTransformCache() {
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QString fileName = directory.filePath("srgb.icc");
+        cmsHPROFILE profile = cmsCreate_sRGBProfile();
+        QVERIFY(cmsSaveProfileToFile(profile, fileName.toLocal8Bit().constData()));
+        cmsCloseProfile(profile);
+
+        PerceptualColor::RgbColorSpace::clearTransformCache();
+        const quint64 hitsBefore =
+            PerceptualColor::RgbColorSpace::transformCacheHits();
+        const quint64 missesBefore =
+            PerceptualColor::RgbColorSpace::transformCacheMisses();
+        PerceptualColor::RgbColorSpace first(fileName);
+        QCOMPARE(
+            PerceptualColor::RgbColorSpace::transformCacheMisses(),
+            missesBefore + 1
+        );
+        QCOMPARE(
+            PerceptualColor::RgbColorSpace::transformCacheHits(),
+            hitsBefore
+        );
+        // Reopening the profile reuses the transforms.
+        PerceptualColor::RgbColorSpace second(fileName);
+        QCOMPARE(
+            PerceptualColor::RgbColorSpace::transformCacheMisses(),
+            missesBefore + 1
+        );
+        QCOMPARE(
+            PerceptualColor::RgbColorSpace::transformCacheHits(),
+            hitsBefore + 1
+        );
+        // The build-in sRGB profile has the same ID, so it reuses them too.
+        PerceptualColor::RgbColorSpace builtIn;
+        QCOMPARE(
+            PerceptualColor::RgbColorSpace::transformCacheMisses(),
+            missesBefore + 1
+        );
+        QCOMPARE(
+            PerceptualColor::RgbColorSpace::transformCacheHits(),
+            hitsBefore + 2
+        );
+    };
+
+    void testProfileFileInvalid() {
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        QVERIFY_EXCEPTION_THROWN(
+            PerceptualColor::RgbColorSpace colorSpace(
+                directory.filePath("missing.icc")
+            ),
+            int
+        );
+        const QString fileName = directory.filePath("garbage.icc");
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("This is not an ICC profile.");
+        file.close();
+        QVERIFY_EXCEPTION_THROWN(
+            PerceptualColor::RgbColorSpace colorSpace(fileName),
+            int
+        );
+    };
+
+    void testDeviceLinkCache() {
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QString fileName = directory.filePath("labmatrix.icc");
+        QVERIFY(writeLabMatrixProfile(fileName));
+
+        PerceptualColor::RgbColorSpace::setDeviceLinkCacheEnabled(true);
+        // The first object stores the device links (if suitable), the
+        // second one loads them.
+        PerceptualColor::RgbColorSpace::clearTransformCache();
+        PerceptualColor::RgbColorSpace firstSrgb;
+        PerceptualColor::RgbColorSpace first(fileName);
+        PerceptualColor::RgbColorSpace::clearTransformCache();
+        PerceptualColor::RgbColorSpace secondSrgb;
+        PerceptualColor::RgbColorSpace second(fileName);
+        PerceptualColor::RgbColorSpace::setDeviceLinkCacheEnabled(false);
+        PerceptualColor::RgbColorSpace::clearTransformCache();
+        PerceptualColor::RgbColorSpace reference(fileName);
+
+        // LittleCMS cannot store the transforms of sRGB without
+        // resampling them, so its device links are rejected.
+        QVERIFY(!secondSrgb.usesDeviceLinks());
+        QVERIFY(second.usesDeviceLinks());
+        QVERIFY(!reference.usesDeviceLinks());
+
+        PerceptualColor::Helper::cmsRGB expected;
+        PerceptualColor::Helper::cmsRGB actual;
+        for (const cmsCIELCh &lch : boundarySamples()) {
+            const cmsCIELab lab = PerceptualColor::Helper::toLab(lch);
+            expected = reference.colorRgbBoundSimple(lab);
+            actual = second.colorRgbBoundSimple(lab);
+            QVERIFY(qAbs(actual.red - expected.red) < 0.0001);
+            QVERIFY(qAbs(actual.green - expected.green) < 0.0001);
+            QVERIFY(qAbs(actual.blue - expected.blue) < 0.0001);
+            QCOMPARE(second.inGamut(lch), reference.inGamut(lch));
+            QCOMPARE(secondSrgb.inGamut(lch), m_rgbColorSpace->inGamut(lch));
+        }
+        QCOMPARE(second.blackpointL(), reference.blackpointL());
+        QCOMPARE(second.whitepointL(), reference.whitepointL());
+        QCOMPARE(secondSrgb.blackpointL(), m_rgbColorSpace->blackpointL());
+        QCOMPARE(secondSrgb.whitepointL(), m_rgbColorSpace->whitepointL());
+    };
+
+    void testSharedGamutTable() {
+        QSharedMemory probe(QStringLiteral("perceptualcolor-test-probe"));
+        if (!probe.create(1)) {
+            QSKIP("Shared memory is not available on this system.");
+        }
+        probe.detach();
+        PerceptualColor::RgbColorSpace::setSharedGamutTableEnabled(true);
+        // The first object computes and publishes the gamut table, the
+        // second one attaches to it.
+        PerceptualColor::RgbColorSpace producer;
+        PerceptualColor::RgbColorSpace consumer;
+        PerceptualColor::RgbColorSpace::setSharedGamutTableEnabled(false);
+        QVERIFY(producer.isGamutTableShared());
+        QVERIFY(consumer.isGamutTableShared());
+        QVERIFY(!m_rgbColorSpace->isGamutTableShared());
+        int withTable = 0;
+        int withoutTable = 0;
+        int count;
+        cmsFloat64Number expected;
+        cmsFloat64Number actual;
+        cmsCIELCh candidate;
+        for (const cmsCIELCh &lch : boundarySamples()) {
+            expected = m_rgbColorSpace->boundaryChroma(
+                lch,
+                PerceptualColor::RgbColorSpace::BoundarySearch::illinois,
+                &count
+            );
+            withoutTable += count;
+            actual = consumer.boundaryChroma(
+                lch,
+                PerceptualColor::RgbColorSpace::BoundarySearch::illinois,
+                &count
+            );
+            withTable += count;
+            if (expected < 0) {
+                QCOMPARE(actual, expected);
+                continue;
+            }
+            QVERIFY(
+                qAbs(actual - expected) <= PerceptualColor::Helper::gamutPrecision
+            );
+            candidate = lch;
+            candidate.C = actual;
+            QVERIFY(m_rgbColorSpace->inGamut(candidate));
+        }
+        QVERIFY(withTable < withoutTable);
+    };
+
+    void testSharedGamutTableCrashedProducer() {
+        // A segment that exists, but has never been marked as ready, is
+        // what a producer leaves behind when it crashes while computing.
+        QSharedMemory crashed(
+            QStringLiteral("perceptualcolor-gamuttable-1-%1").arg(
+                QString::fromLatin1(
+                    QCryptographicHash::hash(
+                        m_rgbColorSpace->cacheKey(),
+                        QCryptographicHash::Md5
+                    ).toHex()
+                )
+            )
+        );
+        if (!crashed.create(1024 * 1024)) {
+            QSKIP("Shared memory is not available on this system.");
+        }
+        PerceptualColor::RgbColorSpace::setSharedGamutTableEnabled(true);
+        PerceptualColor::RgbColorSpace colorSpace;
+        PerceptualColor::RgbColorSpace::setSharedGamutTableEnabled(false);
+        QVERIFY(!colorSpace.isGamutTableShared());
+        cmsFloat64Number expected;
+        cmsFloat64Number actual;
+        for (const cmsCIELCh &lch : boundarySamples()) {
+            expected = m_rgbColorSpace->boundaryChroma(lch);
+            actual = colorSpace.boundaryChroma(lch);
+            QVERIFY(
+                qAbs(actual - expected) <= PerceptualColor::Helper::gamutPrecision
+            );
+        }
+        // The segment has not been touched.
+        const char *data = static_cast<const char *>(crashed.constData());
+        for (int i = 0; i < 64; ++i) {
+            QCOMPARE(data[i], '\0');
+        }
+    };
+
+    void benchmarkConstruction() {
+        QBENCHMARK {
+            PerceptualColor::RgbColorSpace::clearTransformCache();
+            PerceptualColor::RgbColorSpace colorSpace;
+        }
+    };
+
+    void benchmarkConstructionProfileFile() {
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QString fileName = directory.filePath("labmatrix.icc");
+        QVERIFY(writeLabMatrixProfile(fileName));
+        QBENCHMARK {
+            PerceptualColor::RgbColorSpace::clearTransformCache();
+            PerceptualColor::RgbColorSpace colorSpace(fileName);
+        }
+    };
+
+    void benchmarkConstructionDeviceLinkCache() {
+        // Same profile as benchmarkConstructionProfileFile(), but the
+        // transforms are loaded from device links.
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QString fileName = directory.filePath("labmatrix.icc");
+        QVERIFY(writeLabMatrixProfile(fileName));
+        PerceptualColor::RgbColorSpace::setDeviceLinkCacheEnabled(true);
+        {
+            // Make sure the device links are stored.
+            PerceptualColor::RgbColorSpace::clearTransformCache();
+            PerceptualColor::RgbColorSpace colorSpace(fileName);
+            PerceptualColor::RgbColorSpace::clearTransformCache();
+            PerceptualColor::RgbColorSpace check(fileName);
+            QVERIFY(check.usesDeviceLinks());
+        }
+        QBENCHMARK {
+            PerceptualColor::RgbColorSpace::clearTransformCache();
+            PerceptualColor::RgbColorSpace colorSpace(fileName);
+        }
+        PerceptualColor::RgbColorSpace::setDeviceLinkCacheEnabled(false);
+    };
+
+    void benchmarkConstructionMatrixShaper() {
+        // A matrix/shaper profile with XYZ PCS, like most display profiles
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QString fileName = directory.filePath("srgb.icc");
+        cmsHPROFILE profile = cmsCreate_sRGBProfile();
+        QVERIFY(cmsSaveProfileToFile(profile, fileName.toLocal8Bit().constData()));
+        cmsCloseProfile(profile);
+        QBENCHMARK {
+            PerceptualColor::RgbColorSpace::clearTransformCache();
+            PerceptualColor::RgbColorSpace colorSpace(fileName);
+        }
+    };
+
+    void benchmarkConstructionMatrixShaperDeviceLinkCache() {
+        // Same profile as benchmarkConstructionMatrixShaper(), with the
+        // device link cache enabled. The conversion between CIELab and
+        // CIEXYZ cannot be stored exactly in a device link, so after the
+        // first construction only the marker for unsuitable profiles is
+        // read, and the transforms are created from the profile.
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QString fileName = directory.filePath("srgb.icc");
+        cmsHPROFILE profile = cmsCreate_sRGBProfile();
+        QVERIFY(cmsSaveProfileToFile(profile, fileName.toLocal8Bit().constData()));
+        cmsCloseProfile(profile);
+        PerceptualColor::RgbColorSpace::setDeviceLinkCacheEnabled(true);
+        {
+            PerceptualColor::RgbColorSpace::clearTransformCache();
+            PerceptualColor::RgbColorSpace colorSpace(fileName);
+            PerceptualColor::RgbColorSpace::clearTransformCache();
+            PerceptualColor::RgbColorSpace check(fileName);
+            QVERIFY(!check.usesDeviceLinks());
+        }
+        QBENCHMARK {
+            PerceptualColor::RgbColorSpace::clearTransformCache();
+            PerceptualColor::RgbColorSpace colorSpace(fileName);
+        }
+        PerceptualColor::RgbColorSpace::setDeviceLinkCacheEnabled(false);
+    };
+
+    void benchmarkBoundaryChromaBisection() {
+        const QList<cmsCIELCh> samples = boundarySamples();
+        QBENCHMARK {
+            for (const cmsCIELCh &lch : samples) {
+                m_rgbColorSpace->boundaryChroma(
+                    lch,
+                    PerceptualColor::RgbColorSpace::BoundarySearch::bisection
+                );
+            }
+        }
+    };
+
+    void benchmarkBoundaryChromaIllinois() {
+        const QList<cmsCIELCh> samples = boundarySamples();
+        QBENCHMARK {
+            for (const cmsCIELCh &lch : samples) {
+                m_rgbColorSpace->boundaryChroma(
+                    lch,
+                    PerceptualColor::RgbColorSpace::BoundarySearch::illinois
+                );
+            }
+        }
+    };
+};
+
+QTEST_MAIN(TestRgbColorSpace);
+#include "testrgbcolorspace.moc" // necessary because we do not use a header file